@@ -503,35 +503,35 @@ static bool in_reverse;
   time they are expected to take (in microseconds)
  */
 static const AP_Scheduler::Task scheduler_tasks[] PROGMEM = {
-	{ read_radio,             1,   1000 },
-    { ahrs_update,            1,   6400 },
-    { read_sonars,            1,   2000 },
-    { update_current_mode,    1,   1500 },
-    { set_servos,             1,   1500 },
-    { update_GPS_50Hz,        1,   2500 },
-    { update_GPS_10Hz,        5,   2500 },
-    { update_alt,             5,   3400 },
-    { navigate,               5,   1600 },
-    { update_compass,         5,   2000 },
-    { update_commands,        5,   1000 },
-    { update_logging1,        5,   1000 },
-    { update_logging2,        5,   1000 },
-    { gcs_retry_deferred,     1,   1000 },
-    { gcs_update,             1,   1700 },
-    { gcs_data_stream_send,   1,   3000 },
-    { read_control_switch,   15,   1000 },
-    { read_trim_switch,       5,   1000 },
-    { read_battery,           5,   1000 },
-    { read_receiver_rssi,     5,   1000 },
-    { update_events,          1,   1000 },
-    { check_usb_mux,         15,   1000 },
-    { mount_update,           1,    600 },
-    { gcs_failsafe_check,     5,    600 },
-    { compass_accumulate,     1,    900 },
-    { update_notify,          1,    300 },
-    { one_second_loop,       50,   3000 },
+	SCHED_TASK(read_radio,             1,   1000),
+    SCHED_TASK(ahrs_update,            1,   6400),
+    SCHED_TASK(read_sonars,            1,   2000),
+    SCHED_TASK(update_current_mode,    1,   1500),
+    SCHED_TASK(set_servos,             1,   1500),
+    SCHED_TASK(update_GPS_50Hz,        1,   2500),
+    SCHED_TASK(update_GPS_10Hz,        5,   2500),
+    SCHED_TASK(update_alt,             5,   3400),
+    SCHED_TASK(navigate,               5,   1600),
+    SCHED_TASK(update_compass,         5,   2000),
+    SCHED_TASK(update_commands,        5,   1000),
+    SCHED_TASK(update_logging1,        5,   1000),
+    SCHED_TASK(update_logging2,        5,   1000),
+    SCHED_TASK(gcs_retry_deferred,     1,   1000),
+    SCHED_TASK(gcs_update,             1,   1700),
+    SCHED_TASK(gcs_data_stream_send,   1,   3000),
+    SCHED_TASK(read_control_switch,   15,   1000),
+    SCHED_TASK(read_trim_switch,       5,   1000),
+    SCHED_TASK(read_battery,           5,   1000),
+    SCHED_TASK(read_receiver_rssi,     5,   1000),
+    SCHED_TASK(update_events,          1,   1000),
+    SCHED_TASK(check_usb_mux,         15,   1000),
+    SCHED_TASK(mount_update,           1,    600),
+    SCHED_TASK(gcs_failsafe_check,     5,    600),
+    SCHED_TASK(compass_accumulate,     1,    900),
+    SCHED_TASK(update_notify,          1,    300),
+    SCHED_TASK(one_second_loop,       50,   3000),
 #if FRSKY_TELEM_ENABLED == ENABLED
-    { telemetry_send,        10,    100 }	
+    SCHED_TASK(telemetry_send,        10,    100)
 #endif
 };
 
@@ -570,6 +570,9 @@ void loop()
     // wait for an INS sample
     ins.wait_for_sample();
 
+    // mark the start of the loop
+    scheduler.loop_started();
+
     uint32_t timer = hal.scheduler->micros();
 
     delta_us_fast_loop	= timer - fast_loopTimer_us;
@@ -236,20 +236,20 @@ static struct {
   microseconds)
  */
 static const AP_Scheduler::Task scheduler_tasks[] PROGMEM = {
-    { update_ahrs,            1,   1000 },
-    { read_radio,             1,    200 },
-    { update_tracking,        1,   1000 },
-    { update_GPS,             5,   4000 },
-    { update_compass,         5,   1500 },
-    { update_barometer,       5,   1500 },
-    { gcs_update,             1,   1700 },
-    { gcs_data_stream_send,   1,   3000 },
-    { compass_accumulate,     1,   1500 },
-    { barometer_accumulate,   1,    900 },
-    { update_notify,          1,    100 },
-    { check_usb_mux,          5,    300 },
-    { gcs_retry_deferred,     1,   1000 },
-    { one_second_loop,       50,   3900 }
+    SCHED_TASK(update_ahrs,            1,   1000),
+    SCHED_TASK(read_radio,             1,    200),
+    SCHED_TASK(update_tracking,        1,   1000),
+    SCHED_TASK(update_GPS,             5,   4000),
+    SCHED_TASK(update_compass,         5,   1500),
+    SCHED_TASK(update_barometer,       5,   1500),
+    SCHED_TASK(gcs_update,             1,   1700),
+    SCHED_TASK(gcs_data_stream_send,   1,   3000),
+    SCHED_TASK(compass_accumulate,     1,   1500),
+    SCHED_TASK(barometer_accumulate,   1,    900),
+    SCHED_TASK(update_notify,          1,    100),
+    SCHED_TASK(check_usb_mux,          5,    300),
+    SCHED_TASK(gcs_retry_deferred,     1,   1000),
+    SCHED_TASK(one_second_loop,       50,   3900)
 };
 
 // setup the var_info table
@@ -284,6 +284,9 @@ void loop()
     // wait for an INS sample
     ins.wait_for_sample();
 
+    // mark the start of the loop
+    scheduler.loop_started();
+
     // tell the scheduler one tick has passed
     scheduler.tick();
 
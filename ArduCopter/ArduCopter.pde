@@ -156,6 +156,7 @@
 #include <AP_Parachute.h>		// Parachute release library
 #endif
 #include <AP_Terrain.h>
+#include <AP_MissionEstimator.h>   // mission time, energy and terrain clearance estimates
 
 // AP_HAL to Arduino compatibility layer
 #include "compat.h"
@@ -743,6 +744,12 @@ static AP_Parachute parachute(relay);
 AP_Terrain terrain(ahrs, mission, rally);
 #endif
 
+////////////////////////////////////////////////////////////////////////////////
+// mission estimates
+#if MISSION_ESTIMATOR == ENABLED
+static AP_MissionEstimator mission_estimator(mission);
+#endif
+
 ////////////////////////////////////////////////////////////////////////////////
 // function definitions to keep compiler from complaining about undeclared functions
 ////////////////////////////////////////////////////////////////////////////////
@@ -773,61 +780,67 @@ AP_Param param_loader(var_info);
   
  */
 static const AP_Scheduler::Task scheduler_tasks[] PROGMEM = {
-    { rc_loop,               4,     10 },
-    { throttle_loop,         8,     45 },
-    { update_GPS,            8,     90 },
+    SCHED_TASK(rc_loop,               4,     10),
+    SCHED_TASK(throttle_loop,         8,     45),
+    SCHED_TASK(update_GPS,            8,     90),
 #if OPTFLOW == ENABLED
-    { update_optflow,        8,     20 },
-#endif
-    { update_batt_compass,  40,     72 },
-    { read_aux_switches,    40,      5 },
-    { arm_motors_check,     40,      1 },
-    { auto_trim,            40,     14 },
-    { update_altitude,      40,    100 },
-    { run_nav_updates,      40,     80 },
-    { update_thr_cruise,    40,     10 },
-    { three_hz_loop,       133,      9 },
-    { compass_accumulate,    8,     42 },
-    { barometer_accumulate,  8,     25 },
+    SCHED_TASK(update_optflow,        8,     20),
+#endif
+    SCHED_TASK(update_batt_compass,  40,     72),
+#if COMPASS_CAL_ENABLED
+    SCHED_TASK(compass_cal_update,    8,    400),
+#endif
+    SCHED_TASK(read_aux_switches,    40,      5),
+    SCHED_TASK(arm_motors_check,     40,      1),
+    SCHED_TASK(auto_trim,            40,     14),
+    SCHED_TASK(update_altitude,      40,    100),
+    SCHED_TASK(run_nav_updates,      40,     80),
+    SCHED_TASK(update_thr_cruise,    40,     10),
+    SCHED_TASK(three_hz_loop,       133,      9),
+    SCHED_TASK(compass_accumulate,    8,     42),
+    SCHED_TASK(barometer_accumulate,  8,     25),
 #if FRAME_CONFIG == HELI_FRAME
-    { check_dynamic_flight,  8,     10 },
-#endif
-    { update_notify,         8,     10 },
-    { one_hz_loop,         400,     42 },
-    { ekf_dcm_check,        40,      2 },
-    { crash_check,          40,      2 },
-    { gcs_check_input,	     8,    550 },
-    { gcs_send_heartbeat,  400,    150 },
-    { gcs_send_deferred,     8,    720 },
-    { gcs_data_stream_send,  8,    950 },
+    SCHED_TASK(check_dynamic_flight,  8,     10),
+#endif
+    SCHED_TASK(update_notify,         8,     10),
+    SCHED_TASK(one_hz_loop,         400,     42),
+    SCHED_TASK(ekf_dcm_check,        40,      2),
+    SCHED_TASK(crash_check,          40,      2),
+    SCHED_TASK(gcs_check_input,	     8,    550),
+    SCHED_TASK(gcs_send_heartbeat,  400,    150),
+    SCHED_TASK(gcs_send_deferred,     8,    720),
+    SCHED_TASK(gcs_data_stream_send,  8,    950),
 #if COPTER_LEDS == ENABLED
-    { update_copter_leds,   40,      5 },
+    SCHED_TASK(update_copter_leds,   40,      5),
 #endif
-    { update_mount,          8,     45 },
-    { ten_hz_logging_loop,  40,     30 },
-    { fifty_hz_logging_loop, 8,     22 },
-    { perf_update,        4000,     20 },
-    { read_receiver_rssi,   40,      5 },
+    SCHED_TASK(update_mount,          8,     45),
+    SCHED_TASK(ten_hz_logging_loop,  40,     30),
+    SCHED_TASK(fifty_hz_logging_loop, 8,     22),
+    SCHED_TASK(perf_update,        4000,     20),
+    SCHED_TASK(read_receiver_rssi,   40,      5),
 #if FRSKY_TELEM_ENABLED == ENABLED
-    { telemetry_send,       80,     10 },	
+    SCHED_TASK(telemetry_send,       80,     10),
 #endif
 #if EPM_ENABLED == ENABLED
-    { epm_update,           40,     10 },
+    SCHED_TASK(epm_update,           40,     10),
+#endif
+#if MISSION_ESTIMATOR == ENABLED
+    SCHED_TASK(update_mission_estimate, 40,  100),
 #endif
 #ifdef USERHOOK_FASTLOOP
-    { userhook_FastLoop,     4,     10 },
+    SCHED_TASK(userhook_FastLoop,     4,     10),
 #endif
 #ifdef USERHOOK_50HZLOOP
-    { userhook_50Hz,         8,     10 },
+    SCHED_TASK(userhook_50Hz,         8,     10),
 #endif
 #ifdef USERHOOK_MEDIUMLOOP
-    { userhook_MediumLoop,  40,     10 },
+    SCHED_TASK(userhook_MediumLoop,  40,     10),
 #endif
 #ifdef USERHOOK_SLOWLOOP
-    { userhook_SlowLoop,    120,    10 },
+    SCHED_TASK(userhook_SlowLoop,    120,    10),
 #endif
 #ifdef USERHOOK_SUPERSLOWLOOP
-    { userhook_SuperSlowLoop,400,   10 },
+    SCHED_TASK(userhook_SuperSlowLoop,400,   10),
 #endif
 };
 #else
@@ -847,58 +860,61 @@ static const AP_Scheduler::Task scheduler_tasks[] PROGMEM = {
   1000 = 0.1hz
  */
 static const AP_Scheduler::Task scheduler_tasks[] PROGMEM = {
-    { rc_loop,               1,     100 },
-    { throttle_loop,         2,     450 },
-    { update_GPS,            2,     900 },
+    SCHED_TASK(rc_loop,               1,     100),
+    SCHED_TASK(throttle_loop,         2,     450),
+    SCHED_TASK(update_GPS,            2,     900),
 #if OPTFLOW == ENABLED
-    { update_optflow,        2,     100 },
-#endif
-    { update_batt_compass,  10,     720 },
-    { read_aux_switches,    10,      50 },
-    { arm_motors_check,     10,      10 },
-    { auto_trim,            10,     140 },
-    { update_altitude,      10,    1000 },
-    { run_nav_updates,      10,     800 },
-    { update_thr_cruise,     1,      50 },
-    { three_hz_loop,        33,      90 },
-    { compass_accumulate,    2,     420 },
-    { barometer_accumulate,  2,     250 },
+    SCHED_TASK(update_optflow,        2,     100),
+#endif
+    SCHED_TASK(update_batt_compass,  10,     720),
+#if COMPASS_CAL_ENABLED
+    SCHED_TASK(compass_cal_update,    2,     400),
+#endif
+    SCHED_TASK(read_aux_switches,    10,      50),
+    SCHED_TASK(arm_motors_check,     10,      10),
+    SCHED_TASK(auto_trim,            10,     140),
+    SCHED_TASK(update_altitude,      10,    1000),
+    SCHED_TASK(run_nav_updates,      10,     800),
+    SCHED_TASK(update_thr_cruise,     1,      50),
+    SCHED_TASK(three_hz_loop,        33,      90),
+    SCHED_TASK(compass_accumulate,    2,     420),
+    SCHED_TASK(barometer_accumulate,  2,     250),
 #if FRAME_CONFIG == HELI_FRAME
-    { check_dynamic_flight,  2,     100 },
-#endif
-    { update_notify,         2,     100 },
-    { one_hz_loop,         100,     420 },
-    { ekf_dcm_check,        10,      20 },
-    { crash_check,          10,      20 },
-    { gcs_check_input,	     2,     550 },
-    { gcs_send_heartbeat,  100,     150 },
-    { gcs_send_deferred,     2,     720 },
-    { gcs_data_stream_send,  2,     950 },
-    { update_mount,          2,     450 },
-    { ten_hz_logging_loop,  10,     300 },
-    { fifty_hz_logging_loop, 2,     220 },
-    { perf_update,        1000,     200 },
-    { read_receiver_rssi,   10,      50 },
+    SCHED_TASK(check_dynamic_flight,  2,     100),
+#endif
+    SCHED_TASK(update_notify,         2,     100),
+    SCHED_TASK(one_hz_loop,         100,     420),
+    SCHED_TASK(ekf_dcm_check,        10,      20),
+    SCHED_TASK(crash_check,          10,      20),
+    SCHED_TASK(gcs_check_input,	     2,     550),
+    SCHED_TASK(gcs_send_heartbeat,  100,     150),
+    SCHED_TASK(gcs_send_deferred,     2,     720),
+    SCHED_TASK(gcs_data_stream_send,  2,     950),
+    SCHED_TASK(update_mount,          2,     450),
+    SCHED_TASK(ten_hz_logging_loop,  10,     300),
+    SCHED_TASK(fifty_hz_logging_loop, 2,     220),
+    SCHED_TASK(perf_update,        1000,     200),
+    SCHED_TASK(read_receiver_rssi,   10,      50),
 #if FRSKY_TELEM_ENABLED == ENABLED
-    { telemetry_send,       20,     100 },	
+    SCHED_TASK(telemetry_send,       20,     100),
 #endif
 #if EPM_ENABLED == ENABLED
-    { epm_update,           10,      20 },
+    SCHED_TASK(epm_update,           10,      20),
 #endif
 #ifdef USERHOOK_FASTLOOP
-    { userhook_FastLoop,     1,    100  },
+    SCHED_TASK(userhook_FastLoop,     1,    100),
 #endif
 #ifdef USERHOOK_50HZLOOP
-    { userhook_50Hz,         2,    100  },
+    SCHED_TASK(userhook_50Hz,         2,    100),
 #endif
 #ifdef USERHOOK_MEDIUMLOOP
-    { userhook_MediumLoop,   10,    100 },
+    SCHED_TASK(userhook_MediumLoop,   10,    100),
 #endif
 #ifdef USERHOOK_SLOWLOOP
-    { userhook_SlowLoop,     30,    100 },
+    SCHED_TASK(userhook_SlowLoop,     30,    100),
 #endif
 #ifdef USERHOOK_SUPERSLOWLOOP
-    { userhook_SuperSlowLoop,100,   100 },
+    SCHED_TASK(userhook_SuperSlowLoop,100,   100),
 #endif
 };
 #endif
@@ -957,6 +973,9 @@ void loop()
     // wait for an INS sample
     ins.wait_for_sample();
 
+    // mark the start of the loop
+    scheduler.loop_started();
+
     uint32_t timer = micros();
 
     // check loop time
@@ -1013,6 +1032,24 @@ static void fast_loop()
     update_flight_mode();
 }
 
+#if EKF_THREAD == ENABLED && AP_AHRS_NAVEKF_AVAILABLE
+// ekf_loop - runs the EKF on the sensor data queued by read_AHRS()
+// called at EKF_THREAD_RATE from the EKF thread
+static void ekf_loop()
+{
+    ahrs.ekf_thread_update();
+}
+#endif
+
+#if COMPASS_CAL_THREAD == ENABLED && COMPASS_CAL_ENABLED
+// compass_cal_loop - runs the fits of the onboard compass calibration
+// called at COMPASS_CAL_THREAD_RATE from the compass calibration thread
+static void compass_cal_loop()
+{
+    compass.calibration_thread_update();
+}
+#endif
+
 // rc_loops - reads user input from transmitter/receiver
 // called at 100hz
 static void rc_loop()
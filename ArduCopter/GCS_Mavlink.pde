@@ -1117,6 +1117,14 @@ void GCS_MAVLINK::handleMessage(mavlink_message_t* msg)
                 ahrs.reset_gyro_drift();
                 result = MAV_RESULT_ACCEPTED;
             }
+#if COMPASS_CAL_ENABLED
+            if (packet.param2 == 1) {
+                // onboard compass calibration, saving the results on success
+                if (!motors.armed() && compass.start_calibration_all(false, true)) {
+                    result = MAV_RESULT_ACCEPTED;
+                }
+            }
+#endif
             if (packet.param3 == 1) {
                 init_barometer(false);                      // fast barometer calibration
                 result = MAV_RESULT_ACCEPTED;
@@ -1115,6 +1115,12 @@ const AP_Param::Info var_info[] PROGMEM = {
     GOBJECT(terrain,                "TERRAIN_", AP_Terrain),
 #endif
 
+#if MISSION_ESTIMATOR == ENABLED
+    // @Group: MIS_EST_
+    // @Path: ../libraries/AP_MissionEstimator/AP_MissionEstimator.cpp
+    GOBJECT(mission_estimator, "MIS_EST_", AP_MissionEstimator),
+#endif
+
 #if OPTFLOW == ENABLED
     // @Group: FLOW
     // @Path: ../libraries/AP_OpticalFlow/OpticalFlow.cpp
@@ -26,5 +26,49 @@ static void init_home()
     scaleLongUp   = 1.0f/scaleLongDown;
 }
 
+#if MISSION_ESTIMATOR == ENABLED
+// update_mission_estimate - continue estimating the mission's time, battery use and terrain clearance
+// should be called at 10hz
+static void update_mission_estimate()
+{
+    static uint32_t last_report_ms;
+
+    // nothing can be estimated until we know where the mission starts
+    if (!ap.home_is_set) {
+        return;
+    }
+
+    // model the mission with the current waypoint navigation limits
+    AP_MissionEstimator::Vehicle_Limits limits;
+    limits.speed_cms = wp_nav.get_speed_xy();
+    limits.accel_cmss = wp_nav.get_wp_acceleration();
+    limits.climb_cms = wp_nav.get_speed_up();
+    limits.descent_cms = wp_nav.get_speed_down();
+    limits.land_speed_cms = g.land_speed;
+    limits.loiter_radius_cm = circle_nav.get_radius();
+    limits.rtl_alt_cm = g.rtl_altitude;
+    mission_estimator.set_limits(limits);
+    mission_estimator.set_home(ahrs.get_home());
+
+    mission_estimator.update();
+
+    // report each new estimate to the ground station
+    if (mission_estimator.complete() && mission_estimator.last_change_time_ms() != last_report_ms) {
+        last_report_ms = mission_estimator.last_change_time_ms();
+        const AP_MissionEstimator::Estimate &estimate = mission_estimator.get_estimate();
+        if (estimate.num_legs > 0) {
+            gcs_send_text_fmt(PSTR("Mission %.0fm %.0fs %.0fmAh%s"),
+                              estimate.distance_m,
+                              estimate.time_s,
+                              estimate.energy_mah,
+                              estimate.unbounded ? " unbounded" : "");
+            if (estimate.clearance_m < AP_MISSION_ESTIMATOR_CLEARANCE_UNKNOWN) {
+                gcs_send_text_fmt(PSTR("Mission clearance %.0fm"), estimate.clearance_m);
+            }
+        }
+    }
+}
+#endif
+
 
 
@@ -130,6 +130,43 @@
  # define FRAME_CONFIG_STRING "UNKNOWN"
 #endif
 
+//////////////////////////////////////////////////////////////////////////////
+// EKF thread
+//
+// run the EKF from a low priority thread instead of inside read_AHRS(),
+// so a slow filter update does not make the main loop late. The main
+// loop queues the sensor data for the thread and reads the latest
+// published EKF outputs, with the attitude predicted forward using the
+// gyro data the EKF has not processed yet. The thread polls the queue
+// at EKF_THREAD_RATE
+#ifndef EKF_THREAD
+ # if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+  #  define EKF_THREAD ENABLED
+ # else
+  #  define EKF_THREAD DISABLED
+ # endif
+#endif
+#ifndef EKF_THREAD_RATE
+ # define EKF_THREAD_RATE   (MAIN_LOOP_RATE*2)
+#endif
+
+//////////////////////////////////////////////////////////////////////////////
+// Compass calibration thread
+//
+// run the fits of the onboard compass calibration from a low priority
+// thread. Without it they are time sliced, one fit step per call of
+// compass_cal_update()
+#ifndef COMPASS_CAL_THREAD
+ # if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+  #  define COMPASS_CAL_THREAD ENABLED
+ # else
+  #  define COMPASS_CAL_THREAD DISABLED
+ # endif
+#endif
+#ifndef COMPASS_CAL_THREAD_RATE
+ # define COMPASS_CAL_THREAD_RATE   50
+#endif
+
 /////////////////////////////////////////////////////////////////////////////////
 // TradHeli defaults
 #if FRAME_CONFIG == HELI_FRAME
@@ -443,6 +480,16 @@
  # define NAV_GUIDED    ENABLED
 #endif
 
+//////////////////////////////////////////////////////////////////////////////
+// Mission estimator - estimates mission time, battery use and terrain clearance before arming
+#ifndef MISSION_ESTIMATOR
+ #if HAL_CPU_CLASS < HAL_CPU_CLASS_75
+  # define MISSION_ESTIMATOR    DISABLED
+ #else
+  # define MISSION_ESTIMATOR    ENABLED
+ #endif
+#endif
+
 //////////////////////////////////////////////////////////////////////////////
 // RADIO CONFIGURATION
 //////////////////////////////////////////////////////////////////////////////
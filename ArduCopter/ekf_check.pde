@@ -51,6 +51,9 @@ void ekf_dcm_check()
         ekf_check_state.fail_count_compass = 0;
         ekf_check_state.bad_compass = false;
         AP_Notify::flags.ekf_bad = ekf_check_state.bad_compass;
+#if AP_AHRS_NAVEKF_AVAILABLE
+        ahrs.set_dcm_full_rate(false);
+#endif
         failsafe_ekf_off_event();   // clear failsafe
         return;
     }
@@ -99,6 +102,12 @@ void ekf_dcm_check()
     // set AP_Notify flags
     AP_Notify::flags.ekf_bad = ekf_check_state.bad_compass;
 
+#if AP_AHRS_NAVEKF_AVAILABLE
+    // keep DCM running at full rate while the EKF looks doubtful, so
+    // it is ready if we have to fall back to it
+    ahrs.set_dcm_full_rate(ekf_check_state.fail_count_compass > 0);
+#endif
+
     // To-Do: add ekf variances to extended status
 }
 
@@ -119,13 +128,9 @@ static bool ekf_over_threshold()
     }
 
     // use EKF to get variance
-    float posVar, hgtVar, tasVar;
-    Vector3f magVar;
-    Vector2f offset;
-    float compass_variance;
-    float vel_variance;
-    ahrs.get_NavEKF().getVariances(vel_variance, posVar, hgtVar, magVar, tasVar, offset);
-    compass_variance = magVar.length();
+    const AP_AHRS_NavEKF::ekf_outputs &ekf = ahrs.get_ekf_outputs();
+    float compass_variance = ekf.mag_variance.length();
+    float vel_variance = ekf.vel_variance;
 
     // return true if compass and velocity variance over the threshold
     return (compass_variance >= g.ekfcheck_thresh && vel_variance >= g.ekfcheck_thresh);
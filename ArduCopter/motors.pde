@@ -434,6 +434,20 @@ static void pre_arm_checks(bool display_failure)
         }
     }
 
+#if MISSION_ESTIMATOR == ENABLED
+    // check the mission can be flown with the remaining battery and clears the terrain
+    if (ap.home_is_set) {
+        const prog_char_t *failure_msg = NULL;
+        float battery_remaining_mah = battery.pack_capacity_mah() - battery.current_total_mah();
+        if (!mission_estimator.check(battery_remaining_mah, failure_msg)) {
+            if (display_failure) {
+                gcs_send_text_fmt(PSTR("PreArm: %S"), failure_msg);
+            }
+            return;
+        }
+    }
+#endif
+
     // if we've gotten this far then pre arm checks have completed
     set_pre_arm_check(true);
 }
@@ -89,6 +89,44 @@ static void init_compass()
     ahrs.set_compass(&compass);
 }
 
+#if COMPASS_CAL_ENABLED
+// compass_cal_update - pass compass readings to the onboard calibration
+// and report its progress. called at 50hz
+static void compass_cal_update()
+{
+    static uint8_t last_status[COMPASS_MAX_INSTANCES];
+
+    if (motors.armed() && compass.is_calibrating()) {
+        // the vehicle can't be rotated through all orientations in flight
+        compass.cancel_calibration_all();
+    }
+
+    compass.compass_cal_update();
+
+    for (uint8_t i=0; i<compass.get_count(); i++) {
+        CompassCalibrator::report r;
+        compass.get_calibration_report(i, r);
+        if (r.status == last_status[i]) {
+            continue;
+        }
+        last_status[i] = r.status;
+        switch (r.status) {
+        case CompassCalibrator::COMPASS_CAL_RUNNING_STEP_ONE:
+            gcs_send_text_fmt(PSTR("Compass %u calibrating, rotate vehicle"), (unsigned)i+1);
+            break;
+        case CompassCalibrator::COMPASS_CAL_SUCCESS:
+            gcs_send_text_fmt(PSTR("Compass %u calibrated, fitness %.1f"), (unsigned)i+1, r.fitness);
+            break;
+        case CompassCalibrator::COMPASS_CAL_FAILED:
+            gcs_send_text_fmt(PSTR("Compass %u calibration failed, fitness %.1f"), (unsigned)i+1, r.fitness);
+            break;
+        default:
+            break;
+        }
+    }
+}
+#endif
+
 // initialise optical flow sensor
 static void init_optflow()
 {
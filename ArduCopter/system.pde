@@ -276,6 +276,11 @@ static void init_ardupilot()
     heli_init();
 #endif
 
+#if MISSION_ESTIMATOR == ENABLED && AP_TERRAIN_AVAILABLE
+    // use terrain data for the mission's clearance estimates
+    mission_estimator.set_terrain(terrain);
+#endif
+
     startup_ground(true);
 
 #if LOGGING_ENABLED == ENABLED
@@ -292,6 +297,12 @@ static void init_ardupilot()
         hal.uartD->set_blocking_writes(false);
     }
 
+    // move the EKF to a background thread if the board supports it
+    init_ekf_loop();
+
+    // and the compass calibration fits
+    init_compass_cal_loop();
+
     cliSerial->print_P(PSTR("\nReady to FLY "));
 
     // flag that initialisation has completed
@@ -299,6 +310,24 @@ static void init_ardupilot()
 }
 
 
+// init_ekf_loop - start the EKF thread if the board supports it
+// otherwise the EKF keeps running in read_AHRS()
+static void init_ekf_loop()
+{
+#if EKF_THREAD == ENABLED && AP_AHRS_NAVEKF_AVAILABLE
+    ahrs.start_ekf_thread(ekf_loop, EKF_THREAD_RATE);
+#endif
+}
+
+// init_compass_cal_loop - start the compass calibration thread if the board
+// supports it, otherwise compass_cal_update() runs the fits
+static void init_compass_cal_loop()
+{
+#if COMPASS_CAL_THREAD == ENABLED && COMPASS_CAL_ENABLED
+    compass.start_calibration_thread(compass_cal_loop, COMPASS_CAL_THREAD_RATE);
+#endif
+}
+
 //******************************************************************************
 //This function does all the calibrations, etc. that we need during a ground start
 //******************************************************************************
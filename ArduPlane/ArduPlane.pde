@@ -84,6 +84,7 @@
 #include <AP_ServoRelayEvents.h>
 
 #include <AP_Rally.h>
+#include <AP_PolyFence.h>   // Polygon fence library
 
 // Pre-AP_HAL compatibility
 #include "compat.h"
@@ -765,45 +766,45 @@ static AP_Arming arming(ahrs, barometer, compass, home_is_set, gcs_send_text_P);
   they are expected to take (in microseconds)
  */
 static const AP_Scheduler::Task scheduler_tasks[] PROGMEM = {
-    { read_radio,             1,    700 }, // 0
-    { check_short_failsafe,   1,   1000 },
-    { ahrs_update,            1,   6400 },
-    { update_speed_height,    1,   1600 },
-    { update_flight_mode,     1,   1400 },
-    { stabilize,              1,   3500 },
-    { set_servos,             1,   1600 },
-    { read_control_switch,    7,   1000 },
-    { gcs_retry_deferred,     1,   1000 },
-    { update_GPS_50Hz,        1,   2500 },
-    { update_GPS_10Hz,        5,   2500 }, // 10
-    { navigate,               5,   3000 },
-    { update_compass,         5,   1200 },
-    { read_airspeed,          5,   1200 },
-    { update_alt,             5,   3400 },
-    { adjust_altitude_target, 5,   1000 },
-    { obc_fs_check,           5,   1000 },
-    { gcs_update,             1,   1700 },
-    { gcs_data_stream_send,   1,   3000 },
-    { update_events,		  1,   1500 }, // 20
-    { check_usb_mux,          5,    300 },
-    { read_battery,           5,   1000 },
-    { compass_accumulate,     1,   1500 },
-    { barometer_accumulate,   1,    900 },
-    { update_notify,          1,    300 },
-    { read_rangefinder,       1,    500 },
-    { one_second_loop,       50,   1000 },
-    { check_long_failsafe,   15,   1000 },
-    { read_receiver_rssi,     5,   1000 },
-    { airspeed_ratio_update, 50,   1000 }, // 30
-    { update_mount,           1,   1500 },
-    { log_perf_info,        500,   1000 },
-    { compass_save,        3000,   2500 },
-    { update_logging1,        5,   1700 },
-    { update_logging2,        5,   1700 },
+    SCHED_TASK(read_radio,             1,    700), // 0
+    SCHED_TASK(check_short_failsafe,   1,   1000),
+    SCHED_TASK(ahrs_update,            1,   6400),
+    SCHED_TASK(update_speed_height,    1,   1600),
+    SCHED_TASK(update_flight_mode,     1,   1400),
+    SCHED_TASK(stabilize,              1,   3500),
+    SCHED_TASK(set_servos,             1,   1600),
+    SCHED_TASK(read_control_switch,    7,   1000),
+    SCHED_TASK(gcs_retry_deferred,     1,   1000),
+    SCHED_TASK(update_GPS_50Hz,        1,   2500),
+    SCHED_TASK(update_GPS_10Hz,        5,   2500), // 10
+    SCHED_TASK(navigate,               5,   3000),
+    SCHED_TASK(update_compass,         5,   1200),
+    SCHED_TASK(read_airspeed,          5,   1200),
+    SCHED_TASK(update_alt,             5,   3400),
+    SCHED_TASK(adjust_altitude_target, 5,   1000),
+    SCHED_TASK(obc_fs_check,           5,   1000),
+    SCHED_TASK(gcs_update,             1,   1700),
+    SCHED_TASK(gcs_data_stream_send,   1,   3000),
+    SCHED_TASK(update_events,		  1,   1500), // 20
+    SCHED_TASK(check_usb_mux,          5,    300),
+    SCHED_TASK(read_battery,           5,   1000),
+    SCHED_TASK(compass_accumulate,     1,   1500),
+    SCHED_TASK(barometer_accumulate,   1,    900),
+    SCHED_TASK(update_notify,          1,    300),
+    SCHED_TASK(read_rangefinder,       1,    500),
+    SCHED_TASK(one_second_loop,       50,   1000),
+    SCHED_TASK(check_long_failsafe,   15,   1000),
+    SCHED_TASK(read_receiver_rssi,     5,   1000),
+    SCHED_TASK(airspeed_ratio_update, 50,   1000), // 30
+    SCHED_TASK(update_mount,           1,   1500),
+    SCHED_TASK(log_perf_info,        500,   1000),
+    SCHED_TASK(compass_save,        3000,   2500),
+    SCHED_TASK(update_logging1,        5,   1700),
+    SCHED_TASK(update_logging2,        5,   1700),
 #if FRSKY_TELEM_ENABLED == ENABLED
-    { telemetry_send,        10,    100 },	
+    SCHED_TASK(telemetry_send,        10,    100),
 #endif
-    { terrain_update,         5,    500 },
+    SCHED_TASK(terrain_update,         5,    500),
 };
 
 // setup the var_info table
@@ -832,6 +833,9 @@ void loop()
     // wait for an INS sample
     ins.wait_for_sample();
 
+    // mark the start of the loop
+    scheduler.loop_started();
+
     uint32_t timer = hal.scheduler->micros();
 
     delta_us_fast_loop  = timer - fast_loopTimer_us;
@@ -36,6 +36,8 @@ static struct GeofenceState {
     int32_t guided_lng;
     /* point 0 is the return point */
     Vector2l *boundary;
+    /* indexed polygons built from the boundary */
+    AP_PolyFence *polygons;
 } *geofence_state;
 
 
@@ -88,7 +90,7 @@ static void set_fence_point_with_index(Vector2l &point, unsigned i)
  */
 static void geofence_load(void)
 {
-    uint8_t i;
+    uint16_t i, start;
 
     if (geofence_state == NULL) {
         if (hal.util->available_memory() < 512 + sizeof(struct GeofenceState)) {
@@ -107,6 +109,14 @@ static void geofence_load(void)
             geofence_state = NULL;
             goto failed;
         }
+
+        geofence_state->polygons = new AP_PolyFence();
+        if (geofence_state->polygons == NULL) {
+            free(geofence_state->boundary);
+            free(geofence_state);
+            geofence_state = NULL;
+            goto failed;
+        }
         
         geofence_state->old_switch_position = 254;
     }
@@ -121,11 +131,43 @@ static void geofence_load(void)
     }
     geofence_state->num_points = i;
 
-    if (!Polygon_complete(&geofence_state->boundary[1], geofence_state->num_points-1)) {
-        // first point and last point must be the same
-        goto failed;
+    /*
+      the points after the return point are one or more closed
+      polygons, each ending with a copy of its first point. The first
+      polygon is the allowed area, any further polygons are exclusion
+      zones
+     */
+    geofence_state->polygons->clear();
+    if (Polygon_complete(&geofence_state->boundary[1], geofence_state->num_points-1)) {
+        // the last point matches the first, so this is a single
+        // polygon, whatever points it revisits on the way
+        if (!geofence_state->polygons->add_polygon(&geofence_state->boundary[1], geofence_state->num_points-1, true)) {
+            goto failed;
+        }
+    } else {
+        // split the points into polygons, each closing where it
+        // returns to its own first point
+        start = 1;
+        for (i=start+3; i<geofence_state->num_points; i++) {
+            if (geofence_state->boundary[i].x == geofence_state->boundary[start].x &&
+                geofence_state->boundary[i].y == geofence_state->boundary[start].y) {
+                if (!geofence_state->polygons->add_polygon(&geofence_state->boundary[start], i+1-start, start == 1)) {
+                    goto failed;
+                }
+                start = i+1;
+                i = start+2;
+            }
+        }
+        if (start != geofence_state->num_points || geofence_state->polygons->num_polygons() == 0) {
+            // first point and last point of each polygon must be the same
+            goto failed;
+        }
     }
-    if (Polygon_outside(geofence_state->boundary[0], &geofence_state->boundary[1], geofence_state->num_points-1)) {
+
+    // a failed index just means we check every edge
+    geofence_state->polygons->build_index();
+
+    if (geofence_state->polygons->breached(geofence_state->boundary[0])) {
         // return point needs to be inside the fence
         goto failed;
     }
@@ -300,7 +342,7 @@ static void geofence_check(bool altitude_check_only)
         Vector2l location;
         location.x = loc.lat;
         location.y = loc.lng;
-        outside = Polygon_outside(location, &geofence_state->boundary[1], geofence_state->num_points-1);
+        outside = geofence_state->polygons->breached(location);
         if (outside) {
             breach_type = FENCE_BREACH_BOUNDARY;
         }
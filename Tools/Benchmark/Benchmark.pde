@@ -0,0 +1,583 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  micro-benchmarks of the core libraries, for tracking performance
+  from commit to commit. Build and run with "make benchmark", which
+  builds for the native Linux board with optimisation and writes the
+  results as JSON to the file given as the first argument.
+
+  Each benchmark is run once to warm the caches, then timed over
+  BENCH_RUNS runs. The median time per call is the figure to compare,
+  the minimum and mean are given to show how noisy the machine was
+ */
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_Math.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+#include <AP_ADC.h>
+#include <AP_Declination.h>
+#include <AP_ADC_AnalogSource.h>
+#include <Filter.h>
+#include <AP_Buffer.h>
+#include <AP_Airspeed.h>
+#include <AP_Vehicle.h>
+#include <AP_Notify.h>
+#include <DataFlash.h>
+#include <GCS_MAVLink.h>
+#include <AP_GPS.h>
+#include <AP_AHRS.h>
+#include <SITL.h>
+#include <AP_Compass.h>
+#include <AP_Baro.h>
+#include <AP_InertialSensor.h>
+#include <AP_NavEKF.h>
+#include <AP_Mission.h>
+#include <AP_Rally.h>
+#include <AP_BattMonitor.h>
+#include <AP_Terrain.h>
+#include <LowPassFilter2p.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#if CONFIG_HAL_BOARD != HAL_BOARD_LINUX
+#error "Benchmark is built for the native Linux board, use make benchmark"
+#endif
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+static AP_InertialSensor ins;
+static AP_Baro_HIL barometer;
+static AP_GPS gps;
+static AP_Compass_HIL compass;
+static AP_AHRS_DCM ahrs(ins, barometer, gps);
+static NavEKF ekf(&ahrs, barometer);
+
+static bool mission_cmd(const AP_Mission::Mission_Command &cmd) { return true; }
+static void mission_complete(void) {}
+static AP_Mission mission(ahrs, &mission_cmd, &mission_cmd, &mission_complete);
+static AP_Rally rally(ahrs);
+static AP_Terrain terrain(ahrs, mission, rally);
+
+/*
+  a parameter table like a vehicle's, so AP_Param::find() has
+  something realistic to search
+ */
+enum {
+    k_param_format_version = 0,
+    k_param_barometer,
+    k_param_ins,
+    k_param_ahrs,
+    k_param_ekf,
+    k_param_compass,
+    k_param_gps,
+    k_param_mission,
+    k_param_rally,
+    k_param_terrain
+};
+static AP_Int16 format_version;
+
+#define GSCALAR(v, name, def) { v.vtype, name, k_param_ ## v, &v, {def_value : def} }
+#define GOBJECT(v, name, class) { AP_PARAM_GROUP, name, k_param_ ## v, &v, {group_info : class::var_info} }
+
+const AP_Param::Info var_info[] PROGMEM = {
+    GSCALAR(format_version, "FORMAT_VERSION", 0),
+    GOBJECT(barometer, "GND_",      AP_Baro),
+    GOBJECT(ins,       "INS_",      AP_InertialSensor),
+    GOBJECT(ahrs,      "AHRS_",     AP_AHRS),
+    GOBJECT(ekf,       "EKF_",      NavEKF),
+    GOBJECT(compass,   "COMPASS_",  Compass),
+    GOBJECT(gps,       "GPS_",      AP_GPS),
+    GOBJECT(mission,   "MIS_",      AP_Mission),
+    GOBJECT(rally,     "RALLY_",    AP_Rally),
+    GOBJECT(terrain,   "TERRAIN_",  AP_Terrain),
+    AP_VAREND
+};
+
+AP_Param param_loader(var_info);
+
+#define BENCH_RUNS      15
+#define BENCH_MAX       32
+#define NUM_INPUTS      64
+
+struct bench_result {
+    const char *name;
+    uint32_t iterations;
+    double min_ns;
+    double median_ns;
+    double mean_ns;
+};
+static struct bench_result results[BENCH_MAX];
+static uint8_t num_results;
+
+// inputs are varied from call to call, and outputs are summed into
+// volatile sinks, so the compiler can't hoist the work out of the loops
+static Vector3f vec_a[NUM_INPUTS];
+static Vector3f vec_b[NUM_INPUTS];
+static Matrix3f mat_a[NUM_INPUTS];
+static Matrix3f mat_b[NUM_INPUTS];
+static float samples[NUM_INPUTS];
+static Location locations[NUM_INPUTS];
+static volatile float sink_f;
+static volatile uint32_t sink_32;
+
+static uint64_t nanoseconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b)
+{
+    double da = *(const double *)a, db = *(const double *)b;
+    return da < db ? -1 : (da > db ? 1 : 0);
+}
+
+/*
+  time a benchmark function, which makes the given number of calls to
+  the code under test
+ */
+static void run_benchmark(const char *name, void (*fn)(uint32_t), uint32_t iterations)
+{
+    double ns_per_call[BENCH_RUNS];
+
+    if (num_results == BENCH_MAX) {
+        hal.scheduler->panic(PSTR("Too many benchmarks"));
+    }
+
+    // warm up
+    fn(iterations);
+
+    double sum = 0;
+    for (uint8_t i=0; i<BENCH_RUNS; i++) {
+        uint64_t start = nanoseconds();
+        fn(iterations);
+        ns_per_call[i] = (nanoseconds() - start) / (double)iterations;
+        sum += ns_per_call[i];
+    }
+    qsort(ns_per_call, BENCH_RUNS, sizeof(ns_per_call[0]), compare_double);
+
+    struct bench_result &r = results[num_results++];
+    r.name = name;
+    r.iterations = iterations;
+    r.min_ns = ns_per_call[0];
+    r.median_ns = ns_per_call[BENCH_RUNS/2];
+    r.mean_ns = sum / BENCH_RUNS;
+
+    ::printf("%-28s %10.1f ns/call  (min %.1f, mean %.1f)\n",
+             r.name, r.median_ns, r.min_ns, r.mean_ns);
+}
+
+/*
+  fill the inputs with repeatable pseudo-random values
+ */
+static float rand_float(void)
+{
+    static uint32_t seed = 0x12345678;
+    seed = seed * 1103515245UL + 12345UL;
+    return ((seed >> 8) & 0xFFFF) / 32768.0f - 1.0f;
+}
+
+static void setup_inputs(void)
+{
+    for (uint8_t i=0; i<NUM_INPUTS; i++) {
+        vec_a[i] = Vector3f(rand_float(), rand_float(), rand_float()) * 10;
+        vec_b[i] = Vector3f(rand_float(), rand_float(), rand_float()) * 10;
+        mat_a[i].from_euler(rand_float() * PI, rand_float() * 1.5f, rand_float() * PI);
+        mat_b[i].from_euler(rand_float() * PI, rand_float() * 1.5f, rand_float() * PI);
+        samples[i] = rand_float();
+        locations[i].lat = -353632610 + rand_float() * 100000;
+        locations[i].lng = 1491652300 + rand_float() * 100000;
+        locations[i].alt = 58400;
+        locations[i].options = 0;
+    }
+}
+
+/*
+  vector and matrix operations
+ */
+static void bench_vector3f_add(uint32_t n)
+{
+    Vector3f sum;
+    for (uint32_t i=0; i<n; i++) {
+        sum += vec_a[i % NUM_INPUTS] + vec_b[i % NUM_INPUTS];
+    }
+    sink_f = sum.x;
+}
+
+static void bench_vector3f_cross(uint32_t n)
+{
+    Vector3f sum;
+    for (uint32_t i=0; i<n; i++) {
+        sum += vec_a[i % NUM_INPUTS] % vec_b[i % NUM_INPUTS];
+    }
+    sink_f = sum.x;
+}
+
+static void bench_vector3f_normalize(uint32_t n)
+{
+    Vector3f sum;
+    for (uint32_t i=0; i<n; i++) {
+        Vector3f v = vec_a[i % NUM_INPUTS];
+        v.normalize();
+        sum += v;
+    }
+    sink_f = sum.x;
+}
+
+static void bench_vector3f_rotate(uint32_t n)
+{
+    Vector3f sum;
+    for (uint32_t i=0; i<n; i++) {
+        Vector3f v = vec_a[i % NUM_INPUTS];
+        v.rotate((enum Rotation)(i % ROTATION_MAX));
+        sum += v;
+    }
+    sink_f = sum.x;
+}
+
+static void bench_matrix3f_mul(uint32_t n)
+{
+    float sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        Matrix3f m = mat_a[i % NUM_INPUTS] * mat_b[i % NUM_INPUTS];
+        sum += m.a.x;
+    }
+    sink_f = sum;
+}
+
+static void bench_matrix3f_mul_vector(uint32_t n)
+{
+    Vector3f sum;
+    for (uint32_t i=0; i<n; i++) {
+        sum += mat_a[i % NUM_INPUTS] * vec_a[i % NUM_INPUTS];
+    }
+    sink_f = sum.x;
+}
+
+static void bench_matrix3f_mul_transpose(uint32_t n)
+{
+    Vector3f sum;
+    for (uint32_t i=0; i<n; i++) {
+        sum += mat_a[i % NUM_INPUTS].mul_transpose(vec_a[i % NUM_INPUTS]);
+    }
+    sink_f = sum.x;
+}
+
+static void bench_matrix3f_rotate(uint32_t n)
+{
+    float sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        Matrix3f m = mat_a[i % NUM_INPUTS];
+        m.rotate(vec_a[i % NUM_INPUTS] * 0.001f);
+        sum += m.a.x;
+    }
+    sink_f = sum;
+}
+
+static void bench_matrix3f_from_euler(uint32_t n)
+{
+    float sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        const Vector3f &v = vec_a[i % NUM_INPUTS];
+        Matrix3f m;
+        m.from_euler(v.x, v.y, v.z);
+        sum += m.a.x;
+    }
+    sink_f = sum;
+}
+
+static void bench_matrix3f_to_euler(uint32_t n)
+{
+    float sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        float roll, pitch, yaw;
+        mat_a[i % NUM_INPUTS].to_euler(&roll, &pitch, &yaw);
+        sum += roll + pitch + yaw;
+    }
+    sink_f = sum;
+}
+
+/*
+  filters
+ */
+static void bench_lowpassfilter2p(uint32_t n)
+{
+    static LowPassFilter2p filter(1000, 20);
+    float sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        sum += filter.apply(samples[i % NUM_INPUTS]);
+    }
+    sink_f = sum;
+}
+
+/*
+  MAVLink packing and parsing of an ATTITUDE message
+ */
+static void bench_mavlink_pack(uint32_t n)
+{
+    mavlink_message_t msg;
+    uint32_t sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        const Vector3f &v = vec_a[i % NUM_INPUTS];
+        sum += mavlink_msg_attitude_pack(1, 1, &msg, i, v.x, v.y, v.z, v.z, v.y, v.x);
+        sum += msg.checksum;
+    }
+    sink_32 = sum;
+}
+
+static void bench_mavlink_parse(uint32_t n)
+{
+    static uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+    static uint16_t len;
+    if (len == 0) {
+        mavlink_message_t msg;
+        mavlink_msg_attitude_pack(1, 1, &msg, 1234, 0.1f, 0.2f, 0.3f, 0.4f, 0.5f, 0.6f);
+        len = mavlink_msg_to_send_buffer(buf, &msg);
+    }
+    mavlink_message_t msg;
+    mavlink_status_t status;
+    uint32_t count = 0;
+    for (uint32_t i=0; i<n; i++) {
+        for (uint16_t j=0; j<len; j++) {
+            if (mavlink_parse_char(MAVLINK_COMM_0, buf[j], &msg, &status)) {
+                count++;
+            }
+        }
+    }
+    if (count != n) {
+        ::printf("mavlink_parse: parsed %u of %u messages\n", (unsigned)count, (unsigned)n);
+    }
+    sink_32 = count;
+}
+
+/*
+  reading the HAL clocks, as done many times in each main loop
+ */
+static void bench_hal_micros(uint32_t n)
+{
+    uint32_t sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        sum += hal.scheduler->micros();
+    }
+    sink_32 = sum;
+}
+
+static void bench_hal_nanos64(uint32_t n)
+{
+    uint64_t sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        sum += hal.scheduler->nanos64();
+    }
+    sink_32 = sum;
+}
+
+static void bench_hal_loop_start_millis(uint32_t n)
+{
+    uint32_t sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        sum += hal.scheduler->loop_start_millis();
+    }
+    sink_32 = sum;
+}
+
+/*
+  parameter lookup by name, including one name that is not found
+ */
+static void bench_param_find(uint32_t n)
+{
+    static const char *names[] = {
+        "FORMAT_VERSION", "GND_TEMP", "INS_GYROFFS_X", "AHRS_RP_P",
+        "EKF_ALT_NOISE", "COMPASS_DEC", "GPS_TYPE", "MIS_TOTAL",
+        "RALLY_LIMIT_KM", "TERRAIN_ENABLE", "EKF_NOT_A_PARAM"
+    };
+    const uint8_t num_names = sizeof(names)/sizeof(names[0]);
+    uint32_t found = 0;
+    for (uint32_t i=0; i<n; i++) {
+        enum ap_var_type ptype;
+        if (AP_Param::find(names[i % num_names], &ptype) != NULL) {
+            found++;
+        }
+    }
+    sink_32 = found;
+}
+
+/*
+  terrain height lookup. No terrain data is loaded, so this measures
+  the grid calculation and the cache search, which are the bulk of a
+  lookup
+ */
+static void bench_terrain_height_amsl(uint32_t n)
+{
+    float sum = 0;
+    for (uint32_t i=0; i<n; i++) {
+        float height;
+        if (terrain.height_amsl(locations[i % NUM_INPUTS], height)) {
+            sum += height;
+        }
+    }
+    sink_f = sum;
+}
+
+/*
+  NavEKF on canned data: a vehicle sitting level at a fixed location,
+  with a 400Hz IMU, 50Hz compass and baro and 5Hz GPS. The simulated
+  clock is stopped, and moved on by one IMU sample for each update
+ */
+static uint64_t canned_time_usec;
+
+static void canned_sensors_update(void)
+{
+    const uint32_t imu_period_usec = 2500;
+    canned_time_usec += imu_period_usec;
+    hal.scheduler->stop_clock(canned_time_usec);
+
+    uint32_t step = canned_time_usec / imu_period_usec;
+    const Vector3f &noise = vec_b[step % NUM_INPUTS];
+    ins.set_gyro(0, noise * 0.0001f);
+    ins.set_accel(0, Vector3f(0, 0, -GRAVITY_MSS) + noise * 0.001f);
+    ins.update();
+
+    if (step % 8 == 0) {
+        barometer.setHIL(584 + noise.z * 0.01f);
+        barometer.read();
+        compass.setHIL(0, 0, 0);
+        compass.read();
+    }
+    if (step % 80 == 0) {
+        Location loc;
+        loc.lat = -353632610;
+        loc.lng = 1491652300;
+        loc.alt = 58400;
+        loc.options = 0;
+        gps.setHIL(0, AP_GPS::GPS_OK_FIX_3D, 1400000000000ULL + canned_time_usec/1000,
+                   loc, Vector3f(0, 0, 0), 10, 121, true);
+    }
+}
+
+static void setup_canned_ekf(void)
+{
+    canned_time_usec = 1000000;
+    hal.scheduler->stop_clock(canned_time_usec);
+
+    ins.set_hil_mode();
+    ins.init(AP_InertialSensor::WARM_START, AP_InertialSensor::RATE_400HZ);
+    barometer.init();
+    barometer.setHIL(584);
+    barometer.read();
+    compass.init();
+    ahrs.set_compass(&compass);
+
+    // ten seconds of data so the baro is calibrated and GPS has a fix
+    for (uint16_t i=0; i<4000; i++) {
+        canned_sensors_update();
+        if (i == 400) {
+            barometer.update_calibration();
+        }
+    }
+    Location home = gps.location();
+    ahrs.set_home(home);
+    compass.set_initial_location(home.lat, home.lng);
+
+    ekf.InitialiseFilterBootstrap();
+}
+
+static void bench_navekf_update(uint32_t n)
+{
+    for (uint32_t i=0; i<n; i++) {
+        canned_sensors_update();
+        ekf.UpdateFilter();
+    }
+}
+
+/*
+  write the results as JSON, for Tools/scripts/benchmark_compare.py
+ */
+static void write_results(const char *filename)
+{
+    FILE *f = fopen(filename, "w");
+    if (f == NULL) {
+        perror(filename);
+        exit(1);
+    }
+    fprintf(f, "{\n  \"git_version\": \"%s\",\n  \"runs\": %u,\n  \"benchmarks\": [\n",
+            GIT_VERSION, (unsigned)BENCH_RUNS);
+    for (uint8_t i=0; i<num_results; i++) {
+        const struct bench_result &r = results[i];
+        fprintf(f, "    {\"name\": \"%s\", \"iterations\": %u, \"median_ns\": %.2f, \"min_ns\": %.2f, \"mean_ns\": %.2f}%s\n",
+                r.name, (unsigned)r.iterations, r.median_ns, r.min_ns, r.mean_ns,
+                i+1 < num_results ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+    fclose(f);
+    ::printf("Wrote %u results to %s\n", (unsigned)num_results, filename);
+}
+
+void setup()
+{
+    if (!AP_Param::check_var_info()) {
+        hal.scheduler->panic(PSTR("Bad parameter table"));
+    }
+    setup_inputs();
+}
+
+void loop()
+{
+    uint8_t argc;
+    char * const *argv;
+    hal.util->commandline_arguments(argc, argv);
+
+    ::printf("Benchmarks for %s, median of %u runs\n", GIT_VERSION, (unsigned)BENCH_RUNS);
+
+    run_benchmark("vector3f_add",           bench_vector3f_add,           1000000);
+    run_benchmark("vector3f_cross",         bench_vector3f_cross,         1000000);
+    run_benchmark("vector3f_normalize",     bench_vector3f_normalize,     1000000);
+    run_benchmark("vector3f_rotate",        bench_vector3f_rotate,        1000000);
+    run_benchmark("matrix3f_mul",           bench_matrix3f_mul,           1000000);
+    run_benchmark("matrix3f_mul_vector",    bench_matrix3f_mul_vector,    1000000);
+    run_benchmark("matrix3f_mul_transpose", bench_matrix3f_mul_transpose, 1000000);
+    run_benchmark("matrix3f_rotate",        bench_matrix3f_rotate,        1000000);
+    run_benchmark("matrix3f_from_euler",    bench_matrix3f_from_euler,    100000);
+    run_benchmark("matrix3f_to_euler",      bench_matrix3f_to_euler,      100000);
+    run_benchmark("lowpassfilter2p_apply",  bench_lowpassfilter2p,        1000000);
+    run_benchmark("mavlink_attitude_pack",  bench_mavlink_pack,           100000);
+    run_benchmark("mavlink_attitude_parse", bench_mavlink_parse,          100000);
+    run_benchmark("param_find",             bench_param_find,             100000);
+    run_benchmark("hal_micros",             bench_hal_micros,             1000000);
+    run_benchmark("hal_nanos64",            bench_hal_nanos64,            1000000);
+    hal.scheduler->set_loop_start_time();
+    run_benchmark("hal_loop_start_millis",  bench_hal_loop_start_millis,  1000000);
+    run_benchmark("terrain_height_amsl",    bench_terrain_height_amsl,    100000);
+
+    setup_canned_ekf();
+    run_benchmark("navekf_update_filter",   bench_navekf_update,          2000);
+
+    if (argc > 1) {
+        write_results(argv[1]);
+    }
+    exit(0);
+}
+
+AP_HAL_MAIN();
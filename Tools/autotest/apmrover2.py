@@ -69,7 +69,7 @@ def drive_mission(mavproxy, mav, filename):
     return True
 
 
-def drive_APMrover2(viewerip=None, map=False):
+def drive_APMrover2(viewerip=None, map=False, lockstep=False):
     '''drive APMrover2 in SIL
 
     you can pass viewerip as an IP address to optionally send fg and
@@ -97,13 +97,15 @@ def drive_APMrover2(viewerip=None, map=False):
 
     sim_cmd = util.reltopdir('Tools/autotest/pysim/sim_rover.py') + ' --rate=50 --home=%f,%f,%u,%u' % (
         HOME.lat, HOME.lng, HOME.alt, HOME.heading)
+    if lockstep:
+        sim_cmd += ' --lockstep'
 
     runsim = pexpect.spawn(sim_cmd, logfile=sys.stdout, timeout=10)
     runsim.delaybeforesend = 0
     util.pexpect_autoclose(runsim)
     runsim.expect('Starting at lat')
 
-    sil = util.start_SIL('APMrover2')
+    sil = util.start_SIL('APMrover2', lockstep=lockstep)
     mavproxy = util.start_MAVProxy_SIL('APMrover2', options=options)
     mavproxy.expect('Logging to (\S+)')
     logfile = mavproxy.match.group(1)
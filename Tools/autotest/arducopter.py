@@ -889,7 +889,7 @@ def setup_rc(mavproxy):
     mavproxy.send('rc 3 1000\n')
 
 
-def fly_ArduCopter(viewerip=None, map=False):
+def fly_ArduCopter(viewerip=None, map=False, lockstep=False):
     '''fly ArduCopter in SIL
 
     you can pass viewerip as an IP address to optionally send fg and
@@ -905,6 +905,8 @@ def fly_ArduCopter(viewerip=None, map=False):
     sim_cmd += ' --wind=6,45,.3'
     if viewerip:
         sim_cmd += ' --fgout=%s:5503' % viewerip
+    if lockstep:
+        sim_cmd += ' --lockstep'
 
     sil = util.start_SIL('ArduCopter', wipe=True)
     mavproxy = util.start_MAVProxy_SIL('ArduCopter', options='--sitl=127.0.0.1:5501 --out=127.0.0.1:19550 --quadcopter')
@@ -918,7 +920,7 @@ def fly_ArduCopter(viewerip=None, map=False):
     util.pexpect_close(mavproxy)
     util.pexpect_close(sil)
 
-    sil = util.start_SIL('ArduCopter', height=HOME.alt)
+    sil = util.start_SIL('ArduCopter', height=HOME.alt, lockstep=lockstep)
     sim = pexpect.spawn(sim_cmd, logfile=sys.stdout, timeout=10)
     sim.delaybeforesend = 0
     util.pexpect_autoclose(sim)
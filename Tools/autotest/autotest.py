@@ -128,6 +128,7 @@ parser.add_option("--viewerip", default=None, help='IP address to send MAVLink a
 parser.add_option("--map", action='store_true', default=False, help='show map')
 parser.add_option("--experimental", default=False, action='store_true', help='enable experimental tests')
 parser.add_option("--timeout", default=3000, type='int', help='maximum runtime in seconds')
+parser.add_option("--lockstep", action='store_true', default=False, help='run the simulations in lockstep, faster than realtime')
 
 opts, args = parser.parse_args()
 
@@ -211,7 +212,7 @@ def run_step(step):
         return get_default_params('APMrover2')
 
     if step == 'fly.ArduCopter':
-        return arducopter.fly_ArduCopter(viewerip=opts.viewerip, map=opts.map)
+        return arducopter.fly_ArduCopter(viewerip=opts.viewerip, map=opts.map, lockstep=opts.lockstep)
 
     if step == 'fly.CopterAVC':
         return arducopter.fly_CopterAVC(viewerip=opts.viewerip, map=opts.map)
@@ -220,7 +221,7 @@ def run_step(step):
         return arduplane.fly_ArduPlane(viewerip=opts.viewerip, map=opts.map)
 
     if step == 'drive.APMrover2':
-        return apmrover2.drive_APMrover2(viewerip=opts.viewerip, map=opts.map)
+        return apmrover2.drive_APMrover2(viewerip=opts.viewerip, map=opts.map, lockstep=opts.lockstep)
 
     if step == 'build.All':
         return build_all()
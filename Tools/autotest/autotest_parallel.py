@@ -0,0 +1,208 @@
+#!/usr/bin/env python
+# run the APM SITL test cases in parallel
+#
+# Each test case runs in its own network namespace, so the fixed
+# SITL, simulator and MAVProxy ports of every case stay apart, and in
+# its own working directory under buildlogs/parallel, so the eeprom,
+# dataflash and MAVProxy logs stay apart. The SITL binaries must
+# already be built, for example with "autotest.py build.ArduCopter"
+
+import os, sys, time, signal, subprocess, optparse, fnmatch, glob, shutil
+from xml.sax.saxutils import escape, quoteattr
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.realpath(__file__)), 'pysim'))
+
+import util
+
+# test case name, the prefix of the files it leaves in buildlogs, and
+# whether it can run in lockstep
+cases = [
+    ('fly.ArduPlane',   'ArduPlane',  False),
+    ('drive.APMrover2', 'APMrover2',  True),
+    ('fly.ArduCopter',  'ArduCopter', True),
+    ('fly.CopterAVC',   'CopterAVC',  False),
+    ]
+
+def run_case(name, lockstep):
+    '''run one test case in this process, returning True on success'''
+    import arducopter, arduplane, apmrover2
+    if name == 'fly.ArduCopter':
+        return arducopter.fly_ArduCopter(lockstep=lockstep)
+    if name == 'fly.CopterAVC':
+        return arducopter.fly_CopterAVC()
+    if name == 'fly.ArduPlane':
+        return arduplane.fly_ArduPlane()
+    if name == 'drive.APMrover2':
+        return apmrover2.drive_APMrover2(lockstep=lockstep)
+    raise RuntimeError("Unknown test case %s" % name)
+
+def have_netns():
+    '''check if we can create network namespaces as an ordinary user'''
+    try:
+        return subprocess.call(['unshare', '-rn', 'true'],
+                               stdout=open(os.devnull, 'w'),
+                               stderr=subprocess.STDOUT) == 0
+    except OSError:
+        return False
+
+class Case(object):
+    '''a test case being run by a worker process'''
+    def __init__(self, name, prefix, lockstep, rundir):
+        self.name = name
+        self.prefix = prefix
+        self.lockstep = lockstep
+        self.rundir = rundir
+        self.output = os.path.join(rundir, 'output.txt')
+        self.proc = None
+        self.start_time = 0
+        self.elapsed = 0
+        self.passed = False
+        self.timed_out = False
+        self.files = []
+
+    def start(self, use_netns):
+        '''start the worker process for this case'''
+        if os.path.exists(self.rundir):
+            shutil.rmtree(self.rundir)
+        util.mkdir_p(self.rundir)
+        cmd = [sys.executable, os.path.realpath(__file__), '--worker', self.name]
+        if self.lockstep:
+            cmd.append('--lockstep')
+        if use_netns:
+            # a new network namespace starts with the loopback device down
+            cmd = ['unshare', '-rn', 'sh', '-c', 'ip link set lo up && exec "$@"', 'sh'] + cmd
+        self.start_time = time.time()
+        self.proc = subprocess.Popen(cmd, cwd=self.rundir,
+                                     stdout=open(self.output, 'w'),
+                                     stderr=subprocess.STDOUT,
+                                     preexec_fn=os.setsid)
+
+    def poll(self, timeout):
+        '''check if the case has finished, killing it on timeout'''
+        if self.proc.poll() is None:
+            if time.time() - self.start_time < timeout:
+                return False
+            self.timed_out = True
+            os.killpg(self.proc.pid, signal.SIGKILL)
+            self.proc.wait()
+        self.elapsed = time.time() - self.start_time
+        self.passed = (self.proc.returncode == 0 and not self.timed_out)
+        self.files = sorted(glob.glob(util.reltopdir('../buildlogs/%s-*' % self.prefix)))
+        return True
+
+    def output_tail(self, lines=100):
+        '''the end of the output of the case'''
+        try:
+            return ''.join(open(self.output).readlines()[-lines:])
+        except IOError:
+            return ''
+
+def write_junit(filename, finished, elapsed):
+    '''write the results of all cases as one JUnit test suite'''
+    failures = len([c for c in finished if not c.passed])
+    f = open(filename, 'w')
+    f.write('<?xml version="1.0" encoding="UTF-8"?>\n')
+    f.write('<testsuites>\n')
+    f.write('  <testsuite name="autotest" tests="%u" failures="%u" time="%.1f">\n' % (
+        len(finished), failures, elapsed))
+    for c in finished:
+        f.write('    <testcase classname="autotest" name=%s time="%.1f">\n' % (quoteattr(c.name), c.elapsed))
+        if not c.passed:
+            message = 'TIMEOUT' if c.timed_out else 'FAILED'
+            f.write('      <failure message="%s">%s</failure>\n' % (message, escape(c.output_tail())))
+        f.write('      <system-out>output: %s\n%s</system-out>\n' % (
+            escape(c.output), escape('\n'.join(c.files))))
+        f.write('    </testcase>\n')
+    f.write('  </testsuite>\n')
+    f.write('</testsuites>\n')
+    f.close()
+
+def run_parallel(opts, names):
+    '''run the selected cases, at most opts.jobs at a time'''
+    use_netns = have_netns()
+    if not use_netns and opts.jobs > 1:
+        print("Network namespaces are not available - running one case at a time")
+        opts.jobs = 1
+
+    basedir = util.reltopdir('../buildlogs/parallel')
+    pending = []
+    for (name, prefix, can_lockstep) in cases:
+        if name in names:
+            pending.append(Case(name, prefix, opts.lockstep and can_lockstep,
+                                os.path.join(basedir, name)))
+
+    t0 = time.time()
+    running = []
+    finished = []
+    while pending or running:
+        while pending and len(running) < opts.jobs:
+            c = pending.pop(0)
+            print(">>>> STARTING CASE: %s in %s" % (c.name, c.rundir))
+            c.start(use_netns)
+            running.append(c)
+        time.sleep(0.5)
+        for c in running[:]:
+            if c.poll(opts.timeout):
+                running.remove(c)
+                finished.append(c)
+                if c.passed:
+                    result = 'PASSED'
+                elif c.timed_out:
+                    result = 'TIMEOUT'
+                else:
+                    result = 'FAILED'
+                print(">>>> %s CASE: %s in %.1fs (output in %s)" % (result, c.name, c.elapsed, c.output))
+    elapsed = time.time() - t0
+
+    junit = util.reltopdir('../buildlogs/autotest-parallel.xml')
+    write_junit(junit, finished, elapsed)
+
+    print("")
+    for c in finished:
+        print("%-16s %-8s %7.1fs" % (c.name, 'PASSED' if c.passed else 'FAILED', c.elapsed))
+    failed = [c.name for c in finished if not c.passed]
+    print("Ran %u cases in %.1fs, JUnit results in %s" % (len(finished), elapsed, junit))
+    if failed:
+        print("FAILED %u cases: %s" % (len(failed), failed))
+        return False
+    return True
+
+############## main program #############
+parser = optparse.OptionParser("autotest_parallel [options] [cases]")
+parser.add_option("--jobs", "-j", type='int', default=None,
+                  help='number of cases to run at once (default is the number of CPUs)')
+parser.add_option("--timeout", default=3000, type='int', help='maximum runtime of each case in seconds')
+parser.add_option("--lockstep", action='store_true', default=False, help='run the simulations in lockstep, faster than realtime')
+parser.add_option("--list", action='store_true', default=False, help='list the available cases')
+parser.add_option("--worker", default=None, help=optparse.SUPPRESS_HELP)
+
+opts, args = parser.parse_args()
+
+if opts.worker is not None:
+    # we are running a single case in its own directory
+    os.environ['PYTHONUNBUFFERED'] = '1'
+    os.putenv('TMPDIR', os.getcwd())
+    try:
+        ok = run_case(opts.worker, opts.lockstep)
+    finally:
+        util.pexpect_close_all()
+    sys.exit(0 if ok else 1)
+
+if opts.list:
+    for (name, prefix, can_lockstep) in cases:
+        print(name)
+    sys.exit(0)
+
+if opts.jobs is None:
+    import multiprocessing
+    opts.jobs = multiprocessing.cpu_count()
+
+names = [c[0] for c in cases]
+if len(args) > 0:
+    # allow a wildcard list of cases
+    names = [n for n in names if any(fnmatch.fnmatch(n.lower(), a.lower()) for a in args)]
+
+util.mkdir_p(util.reltopdir('../buildlogs'))
+
+if not run_parallel(opts, names):
+    sys.exit(1)
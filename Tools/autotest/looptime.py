@@ -0,0 +1,202 @@
+#!/usr/bin/env python
+# measure the main loop and scheduler task times of a vehicle in SITL
+#
+# The vehicle is run in lockstep with the built in simulator, so it
+# runs as fast as the CPU allows, with SCHED_LOOPTIME set so it
+# records the CPU time of every loop, of the fast loop and of each
+# scheduler task. A short scripted flight is flown over MAVLink, then
+# the median, 99th percentile and maximum of each are compared with a
+# stored baseline and with the loop time budget of the vehicle.
+#
+# Exits with status 1 if the loop goes over budget or if any time got
+# slower than the baseline by more than the threshold. Use
+# --save-baseline on a known good tree to store a new baseline
+
+import os, sys, time, json, shutil, signal, subprocess, optparse
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.realpath(__file__)), 'pysim'))
+
+import util
+from pymavlink import mavutil
+
+# for each vehicle the built in simulator model and the time budget
+# for one main loop in microseconds
+vehicles = {
+    'ArduCopter' : ('+',     2500),
+    'ArduPlane'  : ('plane', 20000),
+    'APMrover2'  : ('rover', 20000),
+    }
+
+HOME = '-35.362938,149.165085,584,270'
+
+# times faster than this in the baseline, in microseconds, are too
+# small to compare reliably
+MIN_COMPARE_USEC = 5.0
+
+def start_vehicle(vehicle, rundir):
+    '''start the vehicle in lockstep with the built in simulator, wiping
+    its parameters and turning on loop time recording'''
+    executable = util.reltopdir('tmp/%s.build/%s.elf' % (vehicle, vehicle))
+    if not os.path.exists(executable):
+        executable = '/tmp/%s.build/%s.elf' % (vehicle, vehicle)
+    cmd = [executable, '-w', '-L', '-S', '1',
+           '-M', vehicles[vehicle][0], '-O', HOME,
+           '-P', 'SCHED_LOOPTIME=1',
+           '-P', 'SR0_EXTRA1=10',
+           '-P', 'SR0_POSITION=10']
+    if vehicle == 'ArduCopter':
+        cmd.extend(['-P', 'ARMING_CHECK=0'])
+    return subprocess.Popen(cmd, cwd=rundir,
+                            stdout=open(os.path.join(rundir, 'output.txt'), 'w'),
+                            stderr=subprocess.STDOUT)
+
+def connect():
+    '''connect to the first SITL serial port, retrying until it is listening'''
+    for i in range(50):
+        try:
+            mav = mavutil.mavlink_connection('tcp:127.0.0.1:5760', robust_parsing=True)
+            mav.wait_heartbeat()
+            return mav
+        except Exception:
+            time.sleep(0.2)
+    raise RuntimeError("Failed to connect to SITL")
+
+def flight_plan(vehicle):
+    '''the flight as a list of (start time in seconds, mode,
+    rc channel overrides) steps'''
+    if vehicle == 'ArduCopter':
+        return [(0,  'STABILIZE', [1500, 1500, 1000, 1500]),
+                (10, 'ALT_HOLD',  [1500, 1500, 1800, 1500]),
+                (25, 'ALT_HOLD',  [1500, 1500, 1500, 1500]),
+                (35, 'ALT_HOLD',  [1600, 1400, 1500, 1600]),
+                (50, 'LAND',      [1500, 1500, 1500, 1500])]
+    if vehicle == 'ArduPlane':
+        return [(0,  'MANUAL',    [1500, 1500, 1000, 1500]),
+                (10, 'FBWA',      [1500, 1300, 2000, 1500]),
+                (30, 'FBWA',      [1700, 1500, 1800, 1500]),
+                (50, 'RTL',       [1500, 1500, 1500, 1500])]
+    return [(0,  'MANUAL',    [1500, 1500, 1500, 1500]),
+            (10, 'MANUAL',    [1600, 1500, 1700, 1500]),
+            (50, 'HOLD',      [1500, 1500, 1500, 1500])]
+
+def fly(mav, vehicle, duration):
+    '''fly the flight plan until the vehicle has run for duration
+    seconds of simulated time'''
+    plan = flight_plan(vehicle)
+    step = -1
+    start_ms = None
+    armed = False
+    while True:
+        m = mav.recv_match(type=['ATTITUDE', 'GLOBAL_POSITION_INT'], blocking=True, timeout=10)
+        if m is None:
+            raise RuntimeError("No messages from SITL")
+        if start_ms is None:
+            start_ms = m.time_boot_ms
+        t = (m.time_boot_ms - start_ms) * 0.001
+        if t >= duration:
+            return
+        if not armed and t >= 2:
+            # the sticks have been centred with throttle low for a while
+            mav.arducopter_arm()
+            armed = True
+        while step+1 < len(plan) and t >= plan[step+1][0]:
+            step += 1
+            (start, mode, rc) = plan[step]
+            print("%5.1fs %s %s" % (t, mode, rc))
+            mav.set_mode(mav.mode_mapping()[mode])
+        # overrides time out on the vehicle, so keep sending them
+        mav.mav.rc_channels_override_send(mav.target_system, mav.target_component,
+                                          *(plan[step][2] + [0, 0, 0, 0]))
+
+def load(filename):
+    '''load a loop time file, returning a dict of times by name'''
+    f = open(filename)
+    results = json.load(f)
+    f.close()
+    times = {}
+    for t in results['timers']:
+        times[t['name']] = t
+    return times
+
+def report(vehicle, times, baseline, threshold):
+    '''show the times against the baseline and budget, returning the
+    list of failures'''
+    budget = vehicles[vehicle][1]
+    failures = []
+    print("%-24s %7s %9s %9s %9s %9s" % ("timer", "count", "p50_usec", "p99_usec", "max_usec", "change"))
+    for name in sorted(times.keys(), key=lambda n: (n not in ['loop', 'fast_loop'], n)):
+        t = times[name]
+        if t['count'] == 0:
+            continue
+        change = ''
+        if name in baseline and baseline[name]['count'] != 0:
+            b = baseline[name]
+            for p in ['p50_usec', 'p99_usec']:
+                if b[p] < MIN_COMPARE_USEC:
+                    continue
+                pct = 100.0 * (t[p] - b[p]) / b[p]
+                change += ' %s%+.0f%%' % (p[:3], pct)
+                if pct > threshold:
+                    failures.append('%s %s %.1f was %.1f' % (name, p, t[p], b[p]))
+        print("%-24s %7u %9.1f %9.1f %9.1f %s" % (name, t['count'], t['p50_usec'], t['p99_usec'], t['max_usec'], change))
+    loop = times['loop']
+    print("loop budget %u usec" % budget)
+    if loop['p99_usec'] > budget:
+        failures.append('loop p99 %.1f over budget of %u' % (loop['p99_usec'], budget))
+    elif loop['max_usec'] > budget:
+        print("WARNING: loop max %.1f over budget of %u" % (loop['max_usec'], budget))
+    return failures
+
+parser = optparse.OptionParser("looptime.py [options]")
+parser.add_option("--vehicle", default='ArduCopter', help="vehicle to measure, one of %s" % ', '.join(sorted(vehicles.keys())))
+parser.add_option("--build", action='store_true', default=False, help="build the vehicle for SITL with optimisation first")
+parser.add_option("--duration", type='int', default=60, help="seconds of simulated time to fly for")
+parser.add_option("--threshold", type='float', default=20.0, help="percentage slowdown counted as a regression")
+parser.add_option("--baseline", default=None, help="baseline file, default Tools/autotest/looptime/VEHICLE.json")
+parser.add_option("--save-baseline", action='store_true', default=False, help="store the results as the new baseline")
+(opts, args) = parser.parse_args()
+
+if not opts.vehicle in vehicles:
+    parser.print_help()
+    sys.exit(2)
+
+if opts.baseline is None:
+    opts.baseline = util.reltopdir('Tools/autotest/looptime/%s.json' % opts.vehicle)
+
+if opts.build:
+    util.build_SIL(opts.vehicle, target='sitl-looptime')
+
+rundir = util.reltopdir('../buildlogs/looptime-%s' % opts.vehicle)
+if os.path.exists(rundir):
+    shutil.rmtree(rundir)
+util.mkdir_p(rundir)
+
+sil = start_vehicle(opts.vehicle, rundir)
+try:
+    mav = connect()
+    fly(mav, opts.vehicle, opts.duration)
+finally:
+    sil.send_signal(signal.SIGTERM)
+    sil.wait()
+
+results = os.path.join(rundir, 'looptime.json')
+if not os.path.exists(results):
+    print("No loop times written, is SCHED_LOOPTIME supported by this build?")
+    sys.exit(1)
+
+if opts.save_baseline:
+    util.mkdir_p(os.path.dirname(opts.baseline))
+    shutil.copy(results, opts.baseline)
+    print("Saved baseline %s" % opts.baseline)
+
+baseline = {}
+if os.path.exists(opts.baseline):
+    baseline = load(opts.baseline)
+else:
+    print("No baseline %s, only checking the loop budget" % opts.baseline)
+
+failures = report(opts.vehicle, load(results), baseline, opts.threshold)
+if failures:
+    for f in failures:
+        print("FAILED: %s" % f)
+    sys.exit(1)
@@ -1,4 +1,4 @@
-import math, util, rotmat
+import math, util, rotmat, time
 from rotmat import Vector3, Matrix3
 
 class Aircraft(object):
@@ -28,6 +28,21 @@ class Aircraft(object):
 
         self.wind = util.Wind('0,0,0')
 
+        # simulation time when running in lockstep with SITL, None
+        # when following the wall clock
+        self.lockstep_time = None
+
+    def enable_lockstep(self):
+        '''step time by the frame period rather than following the wall clock'''
+        self.lockstep_time = 0.0
+        self.last_time = 0.0
+
+    def time_now(self):
+        '''return the current simulation time in seconds'''
+        if self.lockstep_time is not None:
+            return self.lockstep_time
+        return time.time()
+
     def on_ground(self, position=None):
         '''return true if we are on the ground'''
         if position is None:
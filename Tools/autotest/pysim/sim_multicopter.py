@@ -1,7 +1,7 @@
 #!/usr/bin/env python
 
 from multicopter import MultiCopter
-import util, time, os, sys, math
+import util, time, os, sys, math, random
 import socket, struct
 import select, errno
 
@@ -45,6 +45,9 @@ def sim_send(m, a):
                       degrees(roll), degrees(pitch), degrees(yaw),
                       math.sqrt(a.velocity.x*a.velocity.x + a.velocity.y*a.velocity.y),
                       0x4c56414f)
+    if a.lockstep_time is not None:
+        # lockstep frames carry the simulation time in microseconds
+        buf += struct.pack('<Q', int(round(a.lockstep_time*1.0e6)))
     try:
         sim_out.send(buf)
     except socket.error as e:
@@ -53,16 +56,21 @@ def sim_send(m, a):
 
 
 def sim_recv(m):
-    '''receive control information from SITL'''
+    '''receive control information from SITL. Returns the timestamp
+    of the frame the controls respond to when in lockstep'''
     try:
-        buf = sim_in.recv(28)
+        buf = sim_in.recv(36)
     except socket.error as e:
         if not e.errno in [ errno.EAGAIN, errno.EWOULDBLOCK ]:
             raise
-        return
-        
+        return None
+
+    timestamp = None
+    if len(buf) == 36:
+        timestamp = struct.unpack('<Q', buf[28:])[0]
+        buf = buf[:28]
     if len(buf) != 28:
-        return
+        return None
     control = list(struct.unpack('<14H', buf))
     pwm = control[0:11]
 
@@ -76,7 +84,7 @@ def sim_recv(m):
     a.wind.speed = speed*0.01
     a.wind.direction = direction*0.01
     a.wind.turbulance = turbulance*0.01
-    
+    return timestamp
 
 
 def interpret_address(addrstr):
@@ -96,6 +104,7 @@ parser.add_option("--home", dest="home",  type='string', default=None, help="hom
 parser.add_option("--rate", dest="rate", type='int', help="SIM update rate", default=400)
 parser.add_option("--wind", dest="wind", help="Simulate wind (speed,direction,turbulance)", default='0,0,0')
 parser.add_option("--frame", dest="frame", help="frame type (+,X,octo)", default='+')
+parser.add_option("--lockstep", action='store_true', default=False, help="run in lockstep with SITL started with -L")
 
 (opts, args) = parser.parse_args()
 
@@ -165,6 +174,27 @@ print("Starting at lat=%f lon=%f alt=%.1f heading=%.1f" % (
 frame_time = 1.0/opts.rate
 sleep_overhead = 0
 
+if opts.lockstep:
+    # step the physics only once SITL has produced outputs for the
+    # previous frame, as fast as SITL can go
+    a.enable_lockstep()
+    random.seed(0)
+    lockstep_frames = 0
+    while True:
+        lockstep_frames += 1
+        a.lockstep_time = lockstep_frames * frame_time
+        a.update(m[:])
+        sim_send(m, a)
+        frame_usec = int(round(a.lockstep_time*1.0e6))
+        while True:
+            (rin, win, xin) = select.select([sim_in], [], [], 1.0)
+            if not rin:
+                # SITL may have missed the frame while starting
+                sim_send(m, a)
+                continue
+            if sim_recv(m) == frame_usec:
+                break
+
 while True:
     frame_start = time.time()
     sim_recv(m)
@@ -23,6 +23,9 @@ def sim_send(a):
                       degrees(roll), degrees(pitch), degrees(yaw),
                       math.sqrt(a.velocity.x*a.velocity.x + a.velocity.y*a.velocity.y),
                       0x4c56414f)
+    if a.lockstep_time is not None:
+        # lockstep frames carry the simulation time in microseconds
+        buf += struct.pack('<Q', int(round(a.lockstep_time*1.0e6)))
     try:
         sim_out.send(buf)
     except socket.error as e:
@@ -31,23 +34,29 @@ def sim_send(a):
 
 
 def sim_recv(state):
-    '''receive control information from SITL'''
+    '''receive control information from SITL. Returns the timestamp
+    of the frame the controls respond to when in lockstep'''
     try:
-        buf = sim_in.recv(28)
+        buf = sim_in.recv(36)
     except socket.error as e:
         if not e.errno in [ errno.EAGAIN, errno.EWOULDBLOCK ]:
             raise
-        return
-        
+        return None
+
+    timestamp = None
+    if len(buf) == 36:
+        timestamp = struct.unpack('<Q', buf[28:])[0]
+        buf = buf[:28]
     if len(buf) != 28:
         print('len=%u' % len(buf))
-        return
+        return None
     control = list(struct.unpack('<14H', buf))
     pwm = control[0:11]
 
     # map steering and throttle to -1/1
     state.steering = (pwm[0]-1500)/500.0
     state.throttle = (pwm[2]-1500)/500.0
+    return timestamp
 
 #    print("steering=%f throttle=%f pwm=%s" % (state.steering, state.throttle, str(pwm)))
     
@@ -75,6 +84,7 @@ parser.add_option("--simout", dest="simout",  help="SIM output (IP:port)",
 parser.add_option("--home", dest="home",  type='string', default=None, help="home lat,lng,alt,hdg (required)")
 parser.add_option("--rate", dest="rate", type='int', help="SIM update rate", default=100)
 parser.add_option("--skid-steering", action='store_true', default=False, help="Use skid steering")
+parser.add_option("--lockstep", action='store_true', default=False, help="run in lockstep with SITL started with -L")
 
 (opts, args) = parser.parse_args()
 
@@ -129,6 +139,26 @@ print("Starting at lat=%f lon=%f alt=%f heading=%.1f" % (
 frame_time = 1.0/opts.rate
 sleep_overhead = 0
 
+if opts.lockstep:
+    # step the physics only once SITL has produced outputs for the
+    # previous frame, as fast as SITL can go
+    a.enable_lockstep()
+    lockstep_frames = 0
+    while True:
+        lockstep_frames += 1
+        a.lockstep_time = lockstep_frames * frame_time
+        a.update(state)
+        sim_send(a)
+        frame_usec = int(round(a.lockstep_time*1.0e6))
+        while True:
+            (rin, win, xin) = select.select([sim_in], [], [], 1.0)
+            if not rin:
+                # SITL may have missed the frame while starting
+                sim_send(a)
+                continue
+            if sim_recv(state) == frame_usec:
+                break
+
 while True:
     frame_start = time.time()
     sim_recv(state)
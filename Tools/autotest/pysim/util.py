@@ -119,7 +119,7 @@ def pexpect_drain(p):
     except pexpect.TIMEOUT:
         pass
 
-def start_SIL(atype, valgrind=False, wipe=False, height=None):
+def start_SIL(atype, valgrind=False, wipe=False, height=None, lockstep=False):
     '''launch a SIL instance'''
     import pexpect
     cmd=""
@@ -133,6 +133,8 @@ def start_SIL(atype, valgrind=False, wipe=False, height=None):
         cmd += ' -w'
     if height is not None:
         cmd += ' -H %u' % height
+    if lockstep:
+        cmd += ' -L'
     ret = pexpect.spawn(cmd, logfile=sys.stdout, timeout=5)
     ret.delaybeforesend = 0
     pexpect_autoclose(ret)
@@ -0,0 +1,163 @@
+#!/bin/bash
+
+# start a swarm of SITL vehicles using the simulator built into the
+# SITL binary, so each vehicle is a single process. Each vehicle runs
+# in its own directory under swarm/ so that its eeprom and dataflash
+# are kept apart from the others
+
+# home location lat, lon, alt, heading
+LOCATION="CMAC"
+VEHICLE=""
+FRAME=""
+COUNT=2
+SPACING=5
+NUM_PROCS=1
+NO_REBUILD=0
+WIPE_EEPROM=0
+SWARM_DIR="swarm"
+
+usage()
+{
+cat <<EOF
+Usage: sim_swarm.sh [options]
+Options:
+    -v VEHICLE       vehicle type (ArduPlane, ArduCopter or APMrover2)
+                     vehicle type defaults to working directory
+    -n COUNT         number of vehicles (default 2)
+    -s SPACING       distance in meters between the vehicles along
+                     the home heading (default 5)
+    -L               select start location from Tools/autotest/locations.txt
+    -f FRAME         set built in simulator model, for example x, hexa,
+                     octa, y6, plane, rover or rover-skid
+    -d DIR           directory for the vehicle directories (default swarm)
+    -N               don't rebuild before starting the vehicles
+    -j NUM_PROC      number of processors to use during build (default 1)
+    -w               wipe EEPROM of each vehicle
+
+Vehicle i listens for MAVLink on tcp:127.0.0.1:(5760+10*i) and has
+SYSID_THISMAV set to i+1. Each vehicle waits for a connection on that
+port before it starts. Its console output goes to DIR/i/sitl.log
+EOF
+}
+
+while getopts ":v:n:s:L:f:d:Nj:wh" opt; do
+  case $opt in
+    v)
+      VEHICLE=$OPTARG
+      ;;
+    n)
+      COUNT=$OPTARG
+      ;;
+    s)
+      SPACING=$OPTARG
+      ;;
+    L)
+      LOCATION="$OPTARG"
+      ;;
+    f)
+      FRAME="$OPTARG"
+      ;;
+    d)
+      SWARM_DIR="$OPTARG"
+      ;;
+    N)
+      NO_REBUILD=1
+      ;;
+    j)
+      NUM_PROCS=$OPTARG
+      ;;
+    w)
+      WIPE_EEPROM=1
+      ;;
+    h)
+      usage
+      exit 0
+      ;;
+    \?)
+      echo "Invalid option -$OPTARG" >&2
+      usage
+      exit 1
+      ;;
+    :)
+      echo "Option -$OPTARG requires an argument." >&2
+      usage
+      exit 1
+  esac
+done
+
+[ -z "$VEHICLE" ] && {
+    VEHICLE=$(basename $PWD)
+}
+
+case $VEHICLE in
+    ArduPlane)
+        [ -z "$FRAME" ] && FRAME="plane"
+        ;;
+    ArduCopter)
+        [ -z "$FRAME" ] && FRAME="+"
+        ;;
+    APMrover2)
+        [ -z "$FRAME" ] && FRAME="rover"
+        ;;
+    *)
+        echo "Unknown vehicle simulation type $VEHICLE - please specify vehicle using -v VEHICLE_TYPE"
+        usage
+        exit 1
+        ;;
+esac
+
+autotest=$(dirname $(readlink -e $0))
+if [ $NO_REBUILD == 0 ]; then
+pushd $autotest/../../$VEHICLE || {
+    echo "Failed to change to vehicle directory for $VEHICLE"
+    usage
+    exit 1
+}
+make sitl -j$NUM_PROCS || {
+    make clean
+    make sitl -j$NUM_PROCS
+}
+popd
+fi
+
+SIMHOME=$(cat $autotest/locations.txt | grep -i "^$LOCATION=" | cut -d= -f2)
+[ -z "$SIMHOME" ] && {
+    echo "Unknown location $LOCATION"
+    usage
+    exit 1
+}
+echo "Starting $COUNT vehicles at $LOCATION : $SIMHOME"
+
+PIDS=""
+
+kill_swarm()
+{
+    [ -n "$PIDS" ] && kill $PIDS 2> /dev/null
+    exit 0
+}
+
+trap kill_swarm SIGINT SIGTERM
+
+for i in $(seq 0 $(($COUNT-1))); do
+    # line the vehicles up along the home heading
+    home=$(echo $SIMHOME | awk -F, -v i=$i -v spacing=$SPACING '{
+        d = i * spacing
+        hdg = $4 * 3.14159265358979 / 180
+        lat = $1 + (d * cos(hdg)) / 6378100.0 * 180 / 3.14159265358979
+        lng = $2 + (d * sin(hdg)) / (6378100.0 * cos($1 * 3.14159265358979 / 180)) * 180 / 3.14159265358979
+        printf("%.7f,%.7f,%s,%s", lat, lng, $3, $4)
+    }')
+
+    mkdir -p $SWARM_DIR/$i
+    # -w has to come first, or it would wipe the parameters set by -P
+    cmd="/tmp/$VEHICLE.build/$VEHICLE.elf"
+    if [ $WIPE_EEPROM == 1 ]; then
+        cmd="$cmd -w"
+    fi
+    cmd="$cmd -I$i -M$FRAME -O$home -PSYSID_THISMAV=$(($i+1))"
+    (cd $SWARM_DIR/$i && exec $cmd > sitl.log 2>&1) &
+    PIDS="$PIDS $!"
+    echo "Vehicle $i at $home on tcp:127.0.0.1:"$((5760+10*$i))
+done
+
+wait
@@ -21,6 +21,7 @@ NO_REBUILD=0
 START_HIL=0
 TRACKER_ARGS=""
 EXTERNAL_SIM=0
+BUILTIN_SIM=0
 
 usage()
 {
@@ -47,6 +48,7 @@ Options:
     -j NUM_PROC      number of processors to use during build (default 1)
     -H               start HIL
     -e               use external simulator
+    -B               use the simulator built into the SITL binary
 
 mavproxy_options:
     --map            start with a map
@@ -63,7 +65,7 @@ EOF
 
 
 # parse options. Thanks to http://wiki.bash-hackers.org/howto/getopts_tutorial
-while getopts ":I:VgGcj:TA:t:L:v:hwf:RNHe" opt; do
+while getopts ":I:VgGcj:TA:t:L:v:hwf:RNHeB" opt; do
   case $opt in
     v)
       VEHICLE=$OPTARG
@@ -118,6 +120,9 @@ while getopts ":I:VgGcj:TA:t:L:v:hwf:RNHe" opt; do
     e)
       EXTERNAL_SIM=1
       ;;
+    B)
+      BUILTIN_SIM=1
+      ;;
     h)
       usage
       exit 0
@@ -164,21 +169,25 @@ set -x
 
 EXTRA_PARM=""
 EXTRA_SIM=""
+BUILTIN_MODEL=""
 
 # modify build target based on copter frame type
 case $FRAME in
     +|quad)
 	BUILD_TARGET="sitl"
         EXTRA_SIM="--frame=quad"
+        BUILTIN_MODEL="+"
 	;;
     X)
 	BUILD_TARGET="sitl"
         EXTRA_PARM="param set FRAME 1;"
         EXTRA_SIM="--frame=X"
+        BUILTIN_MODEL="x"
 	;;
     octa)
 	BUILD_TARGET="sitl-octa"
         EXTRA_SIM="--frame=octa"
+        BUILTIN_MODEL="octa"
 	;;
     elevon*)
         EXTRA_PARM="param set ELEVON_OUTPUT 4;"
@@ -190,6 +199,7 @@ case $FRAME in
 	;;
     skid)
         EXTRA_SIM="--skid-steering"
+        BUILTIN_MODEL="rover-skid"
 	;;
     obc)
         BUILD_TARGET="sitl-obc"
@@ -268,6 +278,7 @@ case $VEHICLE in
         }
         RUNSIM="nice $autotest/jsbsim/runsim.py --home=$SIMHOME --simin=$SIMIN_PORT --simout=$SIMOUT_PORT --fgout=$FG_PORT $EXTRA_SIM"
         PARMS="ArduPlane.parm"
+        [ -z "$BUILTIN_MODEL" ] && BUILTIN_MODEL="plane"
         if [ $WIPE_EEPROM == 1 ]; then
             cmd="$cmd -PFORMAT_VERSION=13 -PSKIP_GYRO_CAL=1 -PRC3_MIN=1000 -PRC3_TRIM=1000"
         fi
@@ -275,10 +286,12 @@ case $VEHICLE in
     ArduCopter)
         RUNSIM="nice $autotest/pysim/sim_multicopter.py --home=$SIMHOME --simin=$SIMIN_PORT --simout=$SIMOUT_PORT --fgout=$FG_PORT $EXTRA_SIM"
         PARMS="copter_params.parm"
+        [ -z "$BUILTIN_MODEL" ] && BUILTIN_MODEL="+"
         ;;
     APMrover2)
         RUNSIM="nice $autotest/pysim/sim_rover.py --home=$SIMHOME --rate=400 $EXTRA_SIM"
         PARMS="Rover.parm"
+        [ -z "$BUILTIN_MODEL" ] && BUILTIN_MODEL="rover"
         ;;
     *)
         echo "Unknown vehicle simulation type $VEHICLE - please specify vehicle using -v VEHICLE_TYPE"
@@ -287,6 +300,10 @@ case $VEHICLE in
         ;;
 esac
 
+if [ $BUILTIN_SIM == 1 ]; then
+    cmd="$cmd -M$BUILTIN_MODEL -O$SIMHOME"
+fi
+
 if [ $START_HIL == 0 ]; then
 if [ $USE_VALGRIND == 1 ]; then
     echo "Using valgrind"
@@ -307,7 +324,9 @@ trap kill_tasks SIGINT
 
 sleep 2
 rm -f $tfile
-if [ $EXTERNAL_SIM == 0 ]; then
+if [ $BUILTIN_SIM == 1 ]; then
+    echo "Using built in simulator model $BUILTIN_MODEL"
+elif [ $EXTERNAL_SIM == 0 ]; then
     $autotest/run_in_terminal_window.sh "Simulator" $RUNSIM || {
         echo "Failed to start simulator: $RUNSIM"
         exit 1
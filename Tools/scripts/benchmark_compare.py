@@ -0,0 +1,53 @@
+#!/usr/bin/env python
+'''
+compare two sets of results from Tools/Benchmark, as written by
+"make benchmark", and show the change in the median time of each
+benchmark. Exits with status 1 if any benchmark got slower by more
+than the threshold, so it can be used to catch regressions
+'''
+
+import json, sys
+from optparse import OptionParser
+
+parser = OptionParser("benchmark_compare.py [options] BASELINE.json NEW.json")
+parser.add_option("--threshold", type='float', default=10.0,
+                  help="percentage slowdown counted as a regression")
+(opts, args) = parser.parse_args()
+
+if len(args) != 2:
+    parser.print_help()
+    sys.exit(2)
+
+def load(filename):
+    '''load a results file, returning the version and a dict of medians by name'''
+    f = open(filename)
+    results = json.load(f)
+    f.close()
+    medians = {}
+    for b in results['benchmarks']:
+        medians[b['name']] = b['median_ns']
+    return (results['git_version'], medians)
+
+(base_version, base) = load(args[0])
+(new_version, new) = load(args[1])
+
+print("%-28s %12s %12s %8s" % ("benchmark", base_version, new_version, "change"))
+regressions = []
+for name in sorted(set(base.keys()) | set(new.keys())):
+    if not name in base or not name in new:
+        print("%-28s %12s %12s" % (name,
+                                   "%.1f" % base[name] if name in base else "-",
+                                   "%.1f" % new[name] if name in new else "-"))
+        continue
+    change = 100.0 * (new[name] - base[name]) / base[name]
+    flag = ''
+    if change > opts.threshold:
+        flag = ' SLOWER'
+        regressions.append(name)
+    elif change < -opts.threshold:
+        flag = ' faster'
+    print("%-28s %12.1f %12.1f %+7.1f%%%s" % (name, base[name], new[name], change, flag))
+
+if regressions:
+    print("%u benchmarks slower by more than %.0f%%: %s" % (len(regressions), opts.threshold, ' '.join(regressions)))
+    sys.exit(1)
@@ -106,7 +106,9 @@ AC_WPNav::AC_WPNav(const AP_InertialNav& inav, const AP_AHRS& ahrs, AC_PosContro
     _track_leash_length(0.0f),
     _slow_down_dist(0.0f),
     _spline_time(0.0f),
-    _spline_time_scale(0.0f),
+    _spline_dist(0.0f),
+    _spline_table_built(0),
+    _spline_table_idx(0),
     _spline_vel_scaler(0.0f),
     _yaw(0.0f)
 {
@@ -724,7 +726,7 @@ void AC_WPNav::set_spline_origin_and_destination(const Vector3f& origin, const V
     if (stopped_at_start || !prev_segment_exists) {
     	// if vehicle is stopped at the origin, set origin velocity to 0.1 * distance vector from origin to destination
     	_spline_origin_vel = (destination - origin) * 0.1f;
-    	_spline_time = 0.0f;
+    	_spline_dist = 0.0f;
     	_spline_vel_scaler = 0.0f;
     }else{
     	// look at previous segment to determine velocity at origin
@@ -732,7 +734,7 @@ void AC_WPNav::set_spline_origin_and_destination(const Vector3f& origin, const V
             // previous segment is straight, vehicle is moving so vehicle should fly straight through the origin
             // before beginning it's spline path to the next waypoint. Note: we are using the previous segment's origin and destination
             _spline_origin_vel = (_destination - _origin);
-            _spline_time = 0.0f;	// To-Do: this should be set based on how much overrun there was from straight segment?
+            _spline_dist = 0.0f;	// To-Do: this should be set based on how much overrun there was from straight segment?
             _spline_vel_scaler = _pos_control.get_vel_target().length();    // start velocity target from current target velocity
         }else{
             // previous segment is splined, vehicle will fly through origin
@@ -740,10 +742,11 @@ void AC_WPNav::set_spline_origin_and_destination(const Vector3f& origin, const V
             // Note: previous segment will leave destination velocity parallel to position difference vector
             //       from previous segment's origin to this segment's destination)
             _spline_origin_vel = _spline_destination_vel;
-            if (_spline_time > 1.0f && _spline_time < 1.1f) {    // To-Do: remove hard coded 1.1f
-                _spline_time -= 1.0f;
+            float prev_length = _spline_arc_length[WPNAV_SPLINE_TABLE_SIZE];
+            if (_spline_table_built == WPNAV_SPLINE_TABLE_SIZE && _spline_dist > prev_length && _spline_dist < prev_length * 1.1f) {    // To-Do: remove hard coded 1.1f
+                _spline_dist -= prev_length;
             }else{
-                _spline_time = 0.0f;
+                _spline_dist = 0.0f;
             }
             // Note: we leave _spline_vel_scaler as it was from end of previous segment
         }
@@ -834,6 +837,9 @@ void AC_WPNav::update_spline()
     }else{
         // run horizontal position controller
         _pos_control.update_xy_controller(false);
+
+        // use the spare cycles to fill in more of the segment's arc length table
+        build_spline_table(WPNAV_SPLINE_TABLE_BUILD_STEP);
     }
 }
 
@@ -845,7 +851,62 @@ void AC_WPNav::update_spline_solution(const Vector3f& origin, const Vector3f& de
     _hermite_spline_solution[1] = origin_vel;
     _hermite_spline_solution[2] = -origin*3.0f -origin_vel*2.0f + dest*3.0f - dest_vel;
     _hermite_spline_solution[3] = origin*2.0f + origin_vel -dest*2.0f + dest_vel;
- }
+
+    // restart the arc length table.  It is filled in a few intervals at a time from update_spline
+    // and on demand as the target moves along the track
+    _spline_arc_length[0] = 0.0f;
+    _spline_table_built = 0;
+    _spline_table_idx = 0;
+}
+
+/// build_spline_table - fills in up to num_entries more intervals of the arc length table
+///     returns true once the table covers the whole segment
+bool AC_WPNav::build_spline_table(uint8_t num_entries)
+{
+    // each interval's length is integrated with two point gauss-legendre quadrature of the spline's speed
+    const float interval = 1.0f / WPNAV_SPLINE_TABLE_SIZE;
+    const float gauss_offset = interval * 0.211324865f;     // (1 - 1/sqrt(3)) / 2
+
+    while (num_entries > 0 && _spline_table_built < WPNAV_SPLINE_TABLE_SIZE) {
+        float t0 = _spline_table_built * interval;
+        float t1 = t0 + gauss_offset;
+        float t2 = t0 + interval - gauss_offset;
+        Vector3f vel1 = _hermite_spline_solution[1] + _hermite_spline_solution[2] * 2.0f * t1 + _hermite_spline_solution[3] * 3.0f * t1 * t1;
+        Vector3f vel2 = _hermite_spline_solution[1] + _hermite_spline_solution[2] * 2.0f * t2 + _hermite_spline_solution[3] * 3.0f * t2 * t2;
+        _spline_arc_length[_spline_table_built+1] = _spline_arc_length[_spline_table_built] + (vel1.length() + vel2.length()) * 0.5f * interval;
+        _spline_table_built++;
+        num_entries--;
+    }
+    return _spline_table_built == WPNAV_SPLINE_TABLE_SIZE;
+}
+
+/// spline_time_at_distance - returns the spline time at the given distance along the segment
+///     relies on the distance never decreasing within a segment
+float AC_WPNav::spline_time_at_distance(float dist)
+{
+    // move forward through the table, building any intervals not yet filled in
+    while (true) {
+        if (_spline_table_idx >= _spline_table_built && !build_spline_table(1)) {
+            continue;
+        }
+        if (_spline_table_idx >= WPNAV_SPLINE_TABLE_SIZE) {
+            return 1.0f;
+        }
+        if (dist < _spline_arc_length[_spline_table_idx+1]) {
+            break;
+        }
+        _spline_table_idx++;
+    }
+
+    // interpolate within the interval
+    float start = _spline_arc_length[_spline_table_idx];
+    float length = _spline_arc_length[_spline_table_idx+1] - start;
+    float fraction = 0.0f;
+    if (length > 0.0f && dist > start) {
+        fraction = (dist - start) / length;
+    }
+    return (_spline_table_idx + fraction) / WPNAV_SPLINE_TABLE_SIZE;
+}
 
 /// advance_spline_target_along_track - move target location along track from origin to destination
 void AC_WPNav::advance_spline_target_along_track(float dt)
@@ -853,6 +914,9 @@ void AC_WPNav::advance_spline_target_along_track(float dt)
     if (!_flags.reached_destination) {
         Vector3f target_pos, target_vel;
 
+        // look up the spline time for our distance along the track
+        _spline_time = spline_time_at_distance(_spline_dist);
+
         // update target position and velocity from spline calculator
         calc_spline_pos_vel(_spline_time, target_pos, target_vel);
 
@@ -873,24 +937,18 @@ void AC_WPNav::advance_spline_target_along_track(float dt)
             _spline_vel_scaler = _wp_speed_cms;
         }
 
-        // scale the spline_time by the velocity we've calculated vs the velocity that came out of the spline calculator
-        float target_vel_length = target_vel.length();
-        if (target_vel_length != 0.0f) {
-            _spline_time_scale = _spline_vel_scaler/target_vel_length;
-        }
-
         // update target position
         _pos_control.set_pos_target(target_pos);
 
         // update the yaw
         _yaw = RadiansToCentiDegrees(fast_atan2(target_vel.y,target_vel.x));
 
-        // advance spline time to next step
-        _spline_time += _spline_time_scale*dt;
+        // advance along the track to next step
+        _spline_dist += _spline_vel_scaler*dt;
 
         // we will reach the next waypoint in the next step so set reached_destination flag
         // To-Do: is this one step too early?
-        if (_spline_time >= 1.0f) {
+        if (spline_time_at_distance(_spline_dist) >= 1.0f) {
             _flags.reached_destination = true;
         }
     }
@@ -41,6 +41,14 @@
  # define WPNAV_WP_UPDATE_TIME          0.020f      // 50hz update rate on high speed CPUs (Pixhawk, Flymaple)
 #endif
 
+// spline segments are sampled into an arc length table when they are set
+#if HAL_CPU_CLASS < HAL_CPU_CLASS_75
+ # define WPNAV_SPLINE_TABLE_SIZE          16      // number of arc length intervals per spline segment on low speed CPUs
+#else
+ # define WPNAV_SPLINE_TABLE_SIZE          32      // number of arc length intervals per spline segment on high speed CPUs
+#endif
+#define WPNAV_SPLINE_TABLE_BUILD_STEP       2      // number of table intervals filled in on each spare run of update_spline
+
 #define WPNAV_LOITER_ACTIVE_TIMEOUT_MS     200      // loiter controller is considered active if it has been called within the past 200ms (0.2 seconds)
 
 #define WPNAV_YAW_DIST_MIN                 200      // minimum track length which will lead to target yaw being updated to point at next waypoint.  Under this distance the yaw target will be frozen at the current heading
@@ -265,6 +273,14 @@ protected:
     /// 	relies on update_spline_solution being called since the previous
     void calc_spline_pos_vel(float spline_time, Vector3f& position, Vector3f& velocity);
 
+    /// build_spline_table - fills in up to num_entries more intervals of the arc length table
+    ///     returns true once the table covers the whole segment
+    bool build_spline_table(uint8_t num_entries);
+
+    /// spline_time_at_distance - returns the spline time at the given distance along the segment
+    ///     relies on the distance never decreasing within a segment
+    float spline_time_at_distance(float dist);
+
     // references to inertial nav and ahrs libraries
     const AP_InertialNav&   _inav;
     const AP_AHRS&          _ahrs;
@@ -305,7 +321,10 @@ protected:
 
     // spline variables
     float       _spline_time;           // current spline time between origin and destination
-    float       _spline_time_scale;     // current spline time between origin and destination
+    float       _spline_dist;           // current distance in cm along the spline from origin
+    float       _spline_arc_length[WPNAV_SPLINE_TABLE_SIZE+1];  // distance in cm along the spline at evenly spaced spline times
+    uint8_t     _spline_table_built;    // number of intervals of _spline_arc_length filled in so far
+    uint8_t     _spline_table_idx;      // interval of _spline_arc_length holding _spline_dist
     Vector3f    _spline_origin_vel;     // the target velocity vector at the origin of the spline segment
     Vector3f    _spline_destination_vel;// the target velocity vector at the destination point of the spline segment
     Vector3f    _hermite_spline_solution[4]; // array describing spline path between origin and destination
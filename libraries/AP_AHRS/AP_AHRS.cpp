@@ -118,6 +118,15 @@ const AP_Param::GroupInfo AP_AHRS::var_info[] PROGMEM = {
     // @Values: 0:Disabled,1:Enabled
     // @User: Advanced
     AP_GROUPINFO("EKF_USE",  13, AP_AHRS, _ekf_use, 0),
+
+    // @Param: DCM_RATE
+    // @DisplayName: DCM update rate when using the EKF
+    // @Description: The rate the DCM attitude solution is updated at while the EKF is healthy and in use. DCM is then only a backup, so it is run less often than the main loop to save CPU time, with the gyro data integrated in between. It returns to the main loop rate when the EKF is not in use. Zero runs DCM at the main loop rate all the time
+    // @Units: Hz
+    // @Range: 0 400
+    // @Increment: 1
+    // @User: Advanced
+    AP_GROUPINFO("DCM_RATE",  14, AP_AHRS, _dcm_rate, 100),
 #endif
 
     AP_GROUPEND
@@ -182,14 +191,18 @@ Vector2f AP_AHRS::groundspeed_vector(void)
     if (gotAirspeed) {
 	    Vector3f wind = wind_estimate();
 	    Vector2f wind2d = Vector2f(wind.x, wind.y);
-	    Vector2f airspeed_vector = Vector2f(cosf(yaw), sinf(yaw)) * airspeed;
+	    float sin_yaw, cos_yaw;
+	    fast_sincosf(yaw, sin_yaw, cos_yaw);
+	    Vector2f airspeed_vector = Vector2f(cos_yaw, sin_yaw) * airspeed;
 	    gndVelADS = airspeed_vector - wind2d;
     }
     
     // Generate estimate of ground speed vector using GPS
     if (gotGPS) {
         float cog = radians(_gps.ground_course_cd()*0.01f);
-        gndVelGPS = Vector2f(cosf(cog), sinf(cog)) * _gps.ground_speed();
+        float sin_cog, cos_cog;
+        fast_sincosf(cog, sin_cog, cos_cog);
+        gndVelGPS = Vector2f(cos_cog, sin_cog) * _gps.ground_speed();
     }
     // If both ADS and GPS data is available, apply a complementary filter
     if (gotAirspeed && gotGPS) {
@@ -361,6 +361,7 @@ protected:
     AP_Int8 _gps_minsats;
     AP_Int8 _gps_delay;
     AP_Int8 _ekf_use;
+    AP_Int16 _dcm_rate;
 
     // flags structure
     struct ahrs_flags {
@@ -64,11 +64,31 @@ AP_AHRS_DCM::update(void)
     if (delta_t > 0.2f) {
         memset(&_ra_sum[0], 0, sizeof(_ra_sum));
         _ra_deltat = 0;
+        _gyro_sum.zero();
+        _gyro_sum_dt = 0;
+        _gyro_sum_count = 0;
         return;
     }
 
+    Vector3f gyro = gyro_average();
+    if (_decimation > 1 || _gyro_sum_count != 0) {
+        // integrate the gyros until it is time for an attitude
+        // update, then use the average rate over all the samples
+        _gyro_sum += gyro * delta_t;
+        _gyro_sum_dt += delta_t;
+        _gyro_sum_count++;
+        if (_gyro_sum_count < _decimation) {
+            return;
+        }
+        delta_t = _gyro_sum_dt;
+        gyro = _gyro_sum / delta_t;
+        _gyro_sum.zero();
+        _gyro_sum_dt = 0;
+        _gyro_sum_count = 0;
+    }
+
     // Integrate the DCM matrix using gyro inputs
-    matrix_update(delta_t);
+    matrix_update(gyro, delta_t);
 
     // Normalize the DCM matrix
     normalize();
@@ -86,30 +106,35 @@ AP_AHRS_DCM::update(void)
     update_trig();
 }
 
-// update the DCM matrix using only the gyros
-void
-AP_AHRS_DCM::matrix_update(float _G_Dt)
+// average across all healthy gyros. This reduces noise on systems
+// with more than one gyro
+Vector3f
+AP_AHRS_DCM::gyro_average(void) const
 {
-    // note that we do not include the P terms in _omega. This is
-    // because the spin_rate is calculated from _omega.length(),
-    // and including the P terms would give positive feedback into
-    // the _P_gain() calculation, which can lead to a very large P
-    // value
-    _omega.zero();
-
-    // average across all healthy gyros. This reduces noise on systems
-    // with more than one gyro    
+    Vector3f gyro;
     uint8_t healthy_count = 0;    
     for (uint8_t i=0; i<_ins.get_gyro_count(); i++) {
         if (_ins.get_gyro_health(i)) {
-            _omega += _ins.get_gyro(i);
+            gyro += _ins.get_gyro(i);
             healthy_count++;
         }
     }
     if (healthy_count > 1) {
-        _omega /= healthy_count;
+        gyro /= healthy_count;
     }
-    _omega += _omega_I;
+    return gyro;
+}
+
+// update the DCM matrix using only the gyros
+void
+AP_AHRS_DCM::matrix_update(const Vector3f &gyro, float _G_Dt)
+{
+    // note that we do not include the P terms in _omega. This is
+    // because the spin_rate is calculated from _omega.length(),
+    // and including the P terms would give positive feedback into
+    // the _P_gain() calculation, which can lead to a very large P
+    // value
+    _omega = gyro + _omega_I;
     _dcm_matrix.rotate((_omega + _omega_P + _omega_yaw_P) * _G_Dt);
 }
 
@@ -687,7 +712,9 @@ AP_AHRS_DCM::drift_correction(float deltat)
     float theta = atan2f(GA_b[besti].y, GA_b[besti].x);
 
     // equation 12
-    Vector3f GA_e2 = Vector3f(cosf(theta)*tilt, sinf(theta)*tilt, GA_e.z);
+    float sin_theta, cos_theta;
+    fast_sincosf(theta, sin_theta, cos_theta);
+    Vector3f GA_e2 = Vector3f(cos_theta*tilt, sin_theta*tilt, GA_e.z);
 
     // step 6
     error = GA_b[besti] % GA_e2;
@@ -822,8 +849,8 @@ void AP_AHRS_DCM::estimate_wind(void)
         Vector3f velocitySum = velocity + _last_vel;
 
         float theta = atan2f(velocityDiff.y, velocityDiff.x) - atan2f(fuselageDirectionDiff.y, fuselageDirectionDiff.x);
-        float sintheta = sinf(theta);
-        float costheta = cosf(theta);
+        float sintheta, costheta;
+        fast_sincosf(theta, sintheta, costheta);
 
         Vector3f wind = Vector3f();
         wind.x = velocitySum.x - V * (costheta * fuselageDirectionSum.x - sintheta * fuselageDirectionSum.y);
@@ -50,7 +50,10 @@ public:
         _last_wind_time(0),
         _last_airspeed(0.0f),
         _last_consistent_heading(0),
-        _last_failure_ms(0)
+        _last_failure_ms(0),
+        _decimation(1),
+        _gyro_sum_count(0),
+        _gyro_sum_dt(0.0f)
     {
         _dcm_matrix.identity();
 
@@ -110,12 +113,18 @@ public:
     // is the AHRS subsystem healthy?
     bool healthy(void);
 
+protected:
+    // run the attitude update on only one in decimation calls to
+    // update(), integrating the gyro data in between
+    void set_decimation(uint8_t decimation) { _decimation = decimation > 0 ? decimation : 1; }
+
 private:
     float _ki;
     float _ki_yaw;
 
     // Methods
-    void            matrix_update(float _G_Dt);
+    void            matrix_update(const Vector3f &gyro, float _G_Dt);
+    Vector3f        gyro_average(void) const;
     void            normalize(void);
     void            check_matrix(void);
     bool            renorm(Vector3f const &a, Vector3f &result);
@@ -197,6 +206,12 @@ private:
 
     // last time AHRS failed in milliseconds
     uint32_t _last_failure_ms;
+
+    // gyro data integrated between decimated updates
+    uint8_t _decimation;
+    uint8_t _gyro_sum_count;
+    Vector3f _gyro_sum;
+    float _gyro_sum_dt;
 };
 
 #endif // __AP_AHRS_DCM_H__
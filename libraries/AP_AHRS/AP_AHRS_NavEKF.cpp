@@ -58,7 +58,11 @@ void AP_AHRS_NavEKF::reset_gyro_drift(void)
     AP_AHRS_DCM::reset_gyro_drift();
 
     // reset the EKF gyro bias states
-    EKF.resetGyroBias();
+    if (_ekf_threaded) {
+        _gyro_reset_request++;
+    } else {
+        EKF.resetGyroBias();
+    }
 }
 
 void AP_AHRS_NavEKF::update(void)
@@ -71,6 +75,7 @@ void AP_AHRS_NavEKF::update(void)
     yaw = _dcm_attitude.z;
     update_cd_values();
 
+    set_decimation(dcm_decimation());
     AP_AHRS_DCM::update();
 
     // keep DCM attitude available for get_secondary_attitude()
@@ -89,21 +94,32 @@ void AP_AHRS_NavEKF::update(void)
         }
     }
     if (ekf_started) {
-        EKF.UpdateFilter();
-        EKF.getRotationBodyToNED(_dcm_matrix);
+        NavEKF::SensorFrame frame;
+        EKF.captureSensors(frame);
+        if (_ekf_threaded) {
+            queue_sensor_frame(frame);
+            read_published_outputs();
+            if (_output_reset_pending && _ekf_out.reset_count == _ekf_reset_request) {
+                // restart the output predictor from the reset filter
+                EKF.resetOutput();
+                _output_reset_pending = false;
+            }
+        } else {
+            EKF.UpdateFilter(frame);
+            read_ekf_outputs(_ekf_out);
+        }
+        update_output_predictor(frame);
+        _dcm_matrix = _ekf_out.dcm;
         if (using_EKF()) {
-            Vector3f eulers;
-            EKF.getEulerAngles(eulers);
-            roll  = eulers.x;
-            pitch = eulers.y;
-            yaw   = eulers.z;
+            roll  = _ekf_out.eulers.x;
+            pitch = _ekf_out.eulers.y;
+            yaw   = _ekf_out.eulers.z;
 
             update_cd_values();
             update_trig();
 
             // keep _gyro_bias for get_gyro_drift()
-            EKF.getGyroBias(_gyro_bias);
-            _gyro_bias = -_gyro_bias;
+            _gyro_bias = -_ekf_out.gyro_bias;
 
             // calculate corrected gryo estimate for get_gyro()
             _gyro_estimate.zero();
@@ -125,8 +141,16 @@ void AP_AHRS_NavEKF::update(void)
 void AP_AHRS_NavEKF::reset(bool recover_eulers)
 {
     AP_AHRS_DCM::reset(recover_eulers);
-    if (ekf_started) {
-        EKF.InitialiseFilterBootstrap();        
+    if (!ekf_started) {
+        return;
+    }
+    if (_ekf_threaded) {
+        _ekf_reset_request++;
+        _output_reset_pending = true;
+    } else {
+        EKF.InitialiseFilterBootstrap();
+        read_ekf_outputs(_ekf_out);
+        EKF.resetOutput();
     }
 }
 
@@ -134,15 +158,24 @@ void AP_AHRS_NavEKF::reset(bool recover_eulers)
 void AP_AHRS_NavEKF::reset_attitude(const float &_roll, const float &_pitch, const float &_yaw)
 {
     AP_AHRS_DCM::reset_attitude(_roll, _pitch, _yaw);
-    if (ekf_started) {
-        EKF.InitialiseFilterBootstrap();        
+    if (!ekf_started) {
+        return;
+    }
+    if (_ekf_threaded) {
+        _ekf_reset_request++;
+        _output_reset_pending = true;
+    } else {
+        EKF.InitialiseFilterBootstrap();
+        read_ekf_outputs(_ekf_out);
+        EKF.resetOutput();
     }
 }
 
 // dead-reckoning support
 bool AP_AHRS_NavEKF::get_position(struct Location &loc) const
 {
-    if (using_EKF() && EKF.getLLH(loc)) {
+    if (using_EKF()) {
+        loc = _ekf_out.loc;
         return true;
     }
     return AP_AHRS_DCM::get_position(loc);
@@ -167,9 +200,7 @@ Vector3f AP_AHRS_NavEKF::wind_estimate(void)
         // sensor active
         return AP_AHRS_DCM::wind_estimate();
     }
-    Vector3f wind;
-    EKF.getWind(wind);
-    return wind;
+    return _ekf_out.wind;
 }
 
 // return an airspeed estimate if available. return true
@@ -183,7 +214,7 @@ bool AP_AHRS_NavEKF::airspeed_estimate(float *airspeed_ret) const
 bool AP_AHRS_NavEKF::use_compass(void)
 {
     if (using_EKF()) {
-        return EKF.use_compass();
+        return _ekf_out.use_compass;
     }
     return AP_AHRS_DCM::use_compass();
 }
@@ -199,7 +230,7 @@ bool AP_AHRS_NavEKF::get_secondary_attitude(Vector3f &eulers)
     }
     if (ekf_started) {
         // EKF is secondary
-        EKF.getEulerAngles(eulers);
+        eulers = _ekf_out.eulers;
         return true;
     }
     // no secondary available
@@ -216,7 +247,7 @@ bool AP_AHRS_NavEKF::get_secondary_position(struct Location &loc)
     }    
     if (ekf_started) {
         // EKF is secondary
-        EKF.getLLH(loc);
+        loc = _ekf_out.loc;
         return true;
     }
     // no secondary available
@@ -229,9 +260,7 @@ Vector2f AP_AHRS_NavEKF::groundspeed_vector(void)
     if (!using_EKF()) {
         return AP_AHRS_DCM::groundspeed_vector();
     }
-    Vector3f vec;
-    EKF.getVelNED(vec);
-    return Vector2f(vec.x, vec.y);
+    return Vector2f(_ekf_out.vel_ned.x, _ekf_out.vel_ned.y);
 }
 
 void AP_AHRS_NavEKF::set_home(const Location &loc)
@@ -250,7 +279,7 @@ bool AP_AHRS_NavEKF::have_inertial_nav(void) const
 bool AP_AHRS_NavEKF::get_velocity_NED(Vector3f &vec) const
 {
     if (using_EKF()) {
-        EKF.getVelNED(vec);
+        vec = _ekf_out.vel_ned;
         return true;
     }
     return false;
@@ -261,14 +290,39 @@ bool AP_AHRS_NavEKF::get_velocity_NED(Vector3f &vec) const
 bool AP_AHRS_NavEKF::get_relative_position_NED(Vector3f &vec) const
 {
     if (using_EKF()) {
-        return EKF.getPosNED(vec);
+        vec = _ekf_out.pos_ned;
+        return _ekf_out.pos_ned_ok;
     }
     return false;
 }
 
 bool AP_AHRS_NavEKF::using_EKF(void) const
 {
-    return ekf_started && _ekf_use && EKF.healthy();
+    return ekf_started && _ekf_use && _ekf_out.healthy;
+}
+
+/*
+  DCM is only a backup while the EKF is healthy and in use, so it is
+  run at AHRS_DCM_RATE instead of the main loop rate to save CPU
+  time. It is back at the main loop rate on the next loop after the
+  EKF stops being used. The loop rate is taken from the measured IMU
+  period, so it follows whatever rate the vehicle's main loop runs at.
+  The ratio is rounded so that loop timing jitter doesn't change it
+ */
+uint8_t AP_AHRS_NavEKF::dcm_decimation(void) const
+{
+    if (!using_EKF() || _dcm_full_rate || _dcm_rate <= 0) {
+        return 1;
+    }
+    float dt = _ins.get_delta_time();
+    if (dt <= 0) {
+        return 1;
+    }
+    float decimation = 1.0f / (dt * _dcm_rate);
+    if (decimation <= 1.0f) {
+        return 1;
+    }
+    return (uint8_t)min(decimation + 0.5f, 255.0f);
 }
 
 /*
@@ -277,7 +331,7 @@ bool AP_AHRS_NavEKF::using_EKF(void) const
 bool AP_AHRS_NavEKF::healthy(void)
 {
     if (_ekf_use) {
-        return ekf_started && EKF.healthy();
+        return ekf_started && _ekf_out.healthy;
     }
     return AP_AHRS_DCM::healthy();    
 }
@@ -289,5 +343,157 @@ bool AP_AHRS_NavEKF::initialised(void) const
     return (ekf_started && (hal.scheduler->millis() - start_time_ms > AP_AHRS_NAVEKF_SETTLE_TIME_MS));
 };
 
+// copy the EKF outputs from the filter
+void AP_AHRS_NavEKF::read_ekf_outputs(ekf_outputs &out) const
+{
+    EKF.getRotationBodyToNED(out.dcm);
+    EKF.getEulerAngles(out.eulers);
+    EKF.getGyroBias(out.gyro_bias);
+    EKF.getVelNED(out.vel_ned);
+    out.pos_ned_ok = EKF.getPosNED(out.pos_ned);
+    EKF.getLLH(out.loc);
+    EKF.getWind(out.wind);
+    out.healthy = EKF.healthy();
+    out.use_compass = EKF.use_compass();
+
+    float posVar, hgtVar, tasVar;
+    Vector2f offset;
+    EKF.getVariances(out.vel_variance, posVar, hgtVar, out.mag_variance, tasVar, offset);
+    EKF.getFilterState(out.filter);
+    out.reset_count = _ekf_reset_done;
+}
+
+/*
+  run the output predictor on the newest sensor frame. Its solution
+  is at the time of that frame whether or not the filter has
+  processed it yet, and is smooth through measurement fusion
+ */
+void AP_AHRS_NavEKF::update_output_predictor(const NavEKF::SensorFrame &frame)
+{
+    EKF.predictOutput(frame);
+    if (_ekf_out.filter.imu_time_ms == 0) {
+        // no filter solution yet
+        return;
+    }
+    EKF.correctOutput(_ekf_out.filter);
+
+    EKF.getOutputRotationBodyToNED(_ekf_out.dcm);
+    EKF.getOutputEulerAngles(_ekf_out.eulers);
+    EKF.getOutputVelNED(_ekf_out.vel_ned);
+
+    // move the filter location by the output position correction
+    Vector3f pos_ned;
+    EKF.getOutputPosNED(pos_ned);
+    Vector3f pos_change = pos_ned - _ekf_out.filter.position;
+    location_offset(_ekf_out.loc, pos_change.x, pos_change.y);
+    _ekf_out.loc.alt -= pos_change.z * 100;
+    _ekf_out.pos_ned = pos_ned;
+}
+
+/*
+  run the EKF in a background thread. The thread is started before the
+  EKF is, and does nothing until update() queues the first frame
+ */
+bool AP_AHRS_NavEKF::start_ekf_thread(AP_HAL::Proc proc, uint16_t rate_hz)
+{
+    if (_ekf_threaded || ekf_started) {
+        return false;
+    }
+    _ekf_threaded = hal.scheduler->register_background_process(proc, rate_hz);
+    return _ekf_threaded;
+}
+
+// merge the IMU data of two consecutive sensor frames, keeping the
+// newer readings of the other sensors
+static void merge_sensor_frame(NavEKF::SensorFrame &older, const NavEKF::SensorFrame &newer)
+{
+    float dt = older.dtIMU + newer.dtIMU;
+    Vector3f angRate = older.angRate;
+    Vector3f accel1 = older.accel1;
+    Vector3f accel2 = older.accel2;
+    if (dt > 0) {
+        angRate = (older.angRate * older.dtIMU + newer.angRate * newer.dtIMU) / dt;
+        accel1 = (older.accel1 * older.dtIMU + newer.accel1 * newer.dtIMU) / dt;
+        accel2 = (older.accel2 * older.dtIMU + newer.accel2 * newer.dtIMU) / dt;
+    }
+    older = newer;
+    older.dtIMU = dt;
+    older.angRate = angRate;
+    older.accel1 = accel1;
+    older.accel2 = accel2;
+}
+
+// pass a sensor frame to the EKF thread
+void AP_AHRS_NavEKF::queue_sensor_frame(const NavEKF::SensorFrame &new_frame)
+{
+    NavEKF::SensorFrame frame = new_frame;
+    if (_frame_pending_valid) {
+        merge_sensor_frame(_frame_pending, frame);
+        frame = _frame_pending;
+    }
+
+    uint8_t tail = _frame_tail;
+    uint8_t next = (tail + 1) % AP_AHRS_NAVEKF_QUEUE_SIZE;
+    if (next == _frame_head) {
+        // the EKF thread is behind, hold the data until it catches up
+        _frame_pending = frame;
+        _frame_pending_valid = true;
+        return;
+    }
+    _frame_queue[tail] = frame;
+    _frame_pending_valid = false;
+
+    // the frame must be complete before the EKF thread can see it
+    __sync_synchronize();
+    _frame_tail = next;
+}
+
+// get the latest outputs published by the EKF thread
+void AP_AHRS_NavEKF::read_published_outputs(void)
+{
+    uint32_t seq;
+    do {
+        seq = _ekf_published_seq;
+        __sync_synchronize();
+        _ekf_out = _ekf_published[seq & 1];
+        __sync_synchronize();
+    } while (seq != _ekf_published_seq);
+}
+
+// run the EKF on the sensor frames queued by update()
+void AP_AHRS_NavEKF::ekf_thread_update(void)
+{
+    while (_frame_head != _frame_tail) {
+        uint8_t head = _frame_head;
+
+        // read the frame only after seeing the tail that covers it
+        __sync_synchronize();
+        const NavEKF::SensorFrame &frame = _frame_queue[head];
+
+        uint8_t reset_request = _ekf_reset_request;
+        uint8_t gyro_reset_request = _gyro_reset_request;
+        if (reset_request != _ekf_reset_done) {
+            _ekf_reset_done = reset_request;
+            EKF.InitialiseFilterBootstrap(frame);
+        } else {
+            if (gyro_reset_request != _gyro_reset_done) {
+                _gyro_reset_done = gyro_reset_request;
+                EKF.resetGyroBias();
+            }
+            EKF.UpdateFilter(frame);
+        }
+
+        // publish into the buffer update() is not reading
+        uint8_t next = (head + 1) % AP_AHRS_NAVEKF_QUEUE_SIZE;
+        uint32_t seq = _ekf_published_seq;
+        read_ekf_outputs(_ekf_published[(seq + 1) & 1]);
+
+        // finish with the frame and the outputs before handing them over
+        __sync_synchronize();
+        _frame_head = next;
+        _ekf_published_seq = seq + 1;
+    }
+}
+
 #endif // AP_AHRS_NAVEKF_AVAILABLE
 
@@ -29,6 +29,7 @@
 
 #define AP_AHRS_NAVEKF_AVAILABLE 1
 #define AP_AHRS_NAVEKF_SETTLE_TIME_MS 20000     // time in milliseconds the ekf needs to settle after being started
+#define AP_AHRS_NAVEKF_QUEUE_SIZE 8             // sensor frames queued for the EKF thread
 
 class AP_AHRS_NavEKF : public AP_AHRS_DCM
 {
@@ -38,10 +39,43 @@ public:
     AP_AHRS_DCM(ins, baro, gps),
         EKF(this, baro),
         ekf_started(false),
-        startup_delay_ms(10000)
+        startup_delay_ms(10000),
+        _ekf_threaded(false),
+        _frame_head(0),
+        _frame_tail(0),
+        _frame_pending_valid(false),
+        _ekf_published_seq(0),
+        _ekf_reset_request(0),
+        _ekf_reset_done(0),
+        _gyro_reset_request(0),
+        _gyro_reset_done(0),
+        _output_reset_pending(false),
+        _dcm_full_rate(false)
         {
         }
 
+    // the EKF outputs used by the AHRS and the vehicle code. They are
+    // read from the filter after each update, so they stay consistent
+    // when the filter runs in its own thread. The attitude, velocity
+    // and position are then replaced with the output predictor
+    // solution for the newest IMU frame
+    struct ekf_outputs {
+        Matrix3f dcm;           // body to NED rotation, with trim
+        Vector3f eulers;        // roll, pitch and yaw with trim (rad)
+        Vector3f gyro_bias;     // EKF gyro bias estimate (rad/s)
+        Vector3f vel_ned;       // NED velocity (m/s)
+        Vector3f pos_ned;       // NED position relative to home (m)
+        bool pos_ned_ok;
+        struct Location loc;
+        Vector3f wind;          // NED wind velocity (m/s)
+        bool healthy;
+        bool use_compass;
+        float vel_variance;     // velocity innovation test ratio
+        Vector3f mag_variance;  // magnetometer innovation test ratios
+        NavEKF::FilterState filter; // filter solution for the output predictor
+        uint8_t reset_count;    // filter resets done before this solution
+    };
+
     // return the smoothed gyro vector corrected for drift
     const Vector3f &get_gyro(void) const;
     const Matrix3f &get_dcm_matrix(void) const;
@@ -76,8 +110,24 @@ public:
     // true if compass is being used
     bool use_compass(void);
 
+    // direct access to the filter. When the EKF runs in its own
+    // thread its getters may be called while it is being updated, so
+    // this should only be used for logging and parameters
     NavEKF &get_NavEKF(void) { return EKF; }
 
+    // the outputs of the last EKF update
+    const ekf_outputs &get_ekf_outputs(void) const { return _ekf_out; }
+
+    // run the EKF from proc in a background thread at rate_hz instead
+    // of in update(). proc must call ekf_thread_update(). Returns
+    // false if the board has no background threads, in which case the
+    // EKF keeps running in update()
+    bool start_ekf_thread(AP_HAL::Proc proc, uint16_t rate_hz);
+
+    // run the EKF on the sensor frames queued by update(). Only to be
+    // called from the EKF thread
+    void ekf_thread_update(void);
+
     // return secondary attitude solution if available, as eulers in radians
     bool get_secondary_attitude(Vector3f &eulers);
 
@@ -97,6 +147,10 @@ public:
 
     void set_ekf_use(bool setting) { _ekf_use.set(setting); }
 
+    // run DCM at the main loop rate even while the EKF is healthy,
+    // for when the vehicle code may need to fall back to it
+    void set_dcm_full_rate(bool full_rate) { _dcm_full_rate = full_rate; }
+
     // is the AHRS subsystem healthy?
     bool healthy(void);
 
@@ -106,6 +160,22 @@ public:
 private:
     bool using_EKF(void) const;
 
+    // the number of main loops per DCM update
+    uint8_t dcm_decimation(void) const;
+
+    // copy the EKF outputs from the filter
+    void read_ekf_outputs(ekf_outputs &out) const;
+
+    // pass a sensor frame to the EKF thread
+    void queue_sensor_frame(const NavEKF::SensorFrame &frame);
+
+    // get the latest outputs published by the EKF thread
+    void read_published_outputs(void);
+
+    // run the output predictor on a sensor frame and use its solution
+    // for the attitude, velocity and position outputs
+    void update_output_predictor(const NavEKF::SensorFrame &frame);
+
     NavEKF EKF;
     bool ekf_started;
     Matrix3f _dcm_matrix;
@@ -114,6 +184,34 @@ private:
     Vector3f _gyro_estimate;
     const uint16_t startup_delay_ms;
     uint32_t start_time_ms;
+    ekf_outputs _ekf_out;
+
+    // state shared with the EKF thread. The frame queue has one
+    // writer, update(), and one reader, the EKF thread. If the queue
+    // is full update() merges frames into _frame_pending until there
+    // is room. The outputs are double buffered, with the EKF thread
+    // writing the buffer not selected by _ekf_published_seq and then
+    // incrementing it
+    bool _ekf_threaded;
+    NavEKF::SensorFrame _frame_queue[AP_AHRS_NAVEKF_QUEUE_SIZE];
+    volatile uint8_t _frame_head;
+    volatile uint8_t _frame_tail;
+    NavEKF::SensorFrame _frame_pending;
+    bool _frame_pending_valid;
+    ekf_outputs _ekf_published[2];
+    volatile uint32_t _ekf_published_seq;
+
+    // filter resets requested by the main thread
+    volatile uint8_t _ekf_reset_request;
+    uint8_t _ekf_reset_done;
+    volatile uint8_t _gyro_reset_request;
+    uint8_t _gyro_reset_done;
+
+    // the output predictor is reset once the EKF thread publishes a
+    // solution from after the filter reset
+    bool _output_reset_pending;
+
+    bool _dcm_full_rate;
 };
 #endif
 
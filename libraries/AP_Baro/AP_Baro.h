@@ -85,6 +85,9 @@ public:
     // get last time sample was taken (in ms)
     uint32_t        get_last_update() const { return _last_update; };
 
+    // the expected lag (in seconds) in the altitude readings from the barometer
+    float           get_lag() const { return 0.15f; }
+
     static const struct AP_Param::GroupInfo        var_info[];
 
 protected:
@@ -78,15 +78,20 @@ static void SimpleAtmosphere(
 }
 
 
-void AP_Baro_HIL::setHIL(float altitude_msl)
+void AP_Baro_HIL::altitude_to_pressure(float altitude_msl, float &pressure, float &temperature)
 {
     float sigma, delta, theta;
     const float p0 = 101325;
 
     SimpleAtmosphere(altitude_msl*0.001f, sigma, delta, theta);
-    float p = p0 * delta;
-    float T = 303.16f * theta - 273.16f; // Assume 30 degrees at sea level - converted to degrees Kelvin
+    pressure = p0 * delta;
+    temperature = 303.16f * theta - 273.16f; // Assume 30 degrees at sea level - converted to degrees Kelvin
+}
 
+void AP_Baro_HIL::setHIL(float altitude_msl)
+{
+    float p, T;
+    altitude_to_pressure(altitude_msl, p, T);
     setHIL(p, T);
 }
 
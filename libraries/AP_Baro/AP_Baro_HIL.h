@@ -21,6 +21,10 @@ public:
     float get_temperature();
     void setHIL(float altitude_msl);
     void setHIL(float pressure, float temperature);
+
+    // pressure in Pascal and temperature in degrees C of the standard
+    // atmosphere at an altitude
+    static void altitude_to_pressure(float altitude_msl, float &pressure, float &temperature);
 };
 
 #endif //  __AP_BARO__HIL_H__
@@ -131,6 +131,9 @@ public:
     /// capacity_remaining_pct - returns the % battery capacity remaining (0 ~ 100)
     uint8_t capacity_remaining_pct() const;
 
+    /// pack_capacity_mah - returns the battery pack capacity in mAh
+    int32_t pack_capacity_mah() const { return _pack_capacity; }
+
     /// exhausted - returns true if the voltage remains below the low_voltage for 10 seconds or remaining capacity falls below min_capacity
     bool exhausted(float low_voltage, float min_capacity_mah);
 
@@ -354,22 +354,15 @@ bool AP_Compass_HMC5843::read()
 
     last_update = hal.scheduler->micros(); // record time of update
 
-    // rotate to the desired orientation
-    if (product_id == AP_COMPASS_TYPE_HMC5883L) {
-        _field[0].rotate(ROTATION_YAW_90);
-    }
-
-    // apply default board orientation for this compass type. This is
-    // a noop on most boards
-    _field[0].rotate(MAG_BOARD_ORIENTATION);
-
-    // add user selectable orientation
-    _field[0].rotate((enum Rotation)_orientation[0].get());
-
-    if (!_external[0]) {
-        // and add in AHRS_ORIENTATION setting if not an external compass
-        _field[0].rotate(_board_orientation);
-    }
+    // rotate to the desired orientation, then apply the default board
+    // orientation for this compass type (a noop on most boards), the
+    // user selectable orientation and the AHRS_ORIENTATION setting if
+    // not an external compass
+    _rotation[0].set(product_id == AP_COMPASS_TYPE_HMC5883L ? ROTATION_YAW_90 : ROTATION_NONE,
+                     MAG_BOARD_ORIENTATION,
+                     (enum Rotation)_orientation[0].get(),
+                     _external[0] ? ROTATION_NONE : _board_orientation);
+    _rotation[0].rotate(_field[0]);
 
     apply_corrections(_field[0],0);
 
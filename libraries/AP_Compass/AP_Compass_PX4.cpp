@@ -104,17 +104,12 @@ bool AP_Compass_PX4::read(void)
         _sum[i] /= _count[i];
         _sum[i] *= 1000;
 
-        // apply default board orientation for this compass type. This is
-        // a noop on most boards
-        _sum[i].rotate(MAG_BOARD_ORIENTATION);
-
-        if (_external[i]) {
-            // add user selectable orientation
-            _sum[i].rotate((enum Rotation)_orientation[i].get());
-        } else {
-            // add in board orientation from AHRS
-            _sum[i].rotate(_board_orientation);
-        }
+        // apply default board orientation for this compass type (a
+        // noop on most boards), then the user selectable orientation
+        // for external compasses or the board orientation from AHRS
+        _rotation[i].set(MAG_BOARD_ORIENTATION,
+                         _external[i] ? (enum Rotation)_orientation[i].get() : _board_orientation);
+        _rotation[i].rotate(_sum[i]);
         
         _field[i] = _sum[i];
         apply_corrections(_field[i],i);
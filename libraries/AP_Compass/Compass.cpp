@@ -257,6 +257,126 @@ const AP_Param::GroupInfo Compass::var_info[] PROGMEM = {
     AP_GROUPINFO("EXTERNAL3",23, Compass, _external[2], 0),
 #endif
 
+#if COMPASS_CAL_ENABLED
+    // @Param: DIA_X
+    // @DisplayName: Compass soft iron diagonal X component
+    // @Description: X component of the diagonal of the soft iron correction matrix applied to the compass field after the offsets. Set by the onboard calibration. Zero disables the soft iron correction
+    // @Range: 0.2 5.0
+    // @User: Advanced
+
+    // @Param: DIA_Y
+    // @DisplayName: Compass soft iron diagonal Y component
+    // @Description: Y component of the diagonal of the soft iron correction matrix applied to the compass field after the offsets. Set by the onboard calibration. Zero disables the soft iron correction
+    // @Range: 0.2 5.0
+    // @User: Advanced
+
+    // @Param: DIA_Z
+    // @DisplayName: Compass soft iron diagonal Z component
+    // @Description: Z component of the diagonal of the soft iron correction matrix applied to the compass field after the offsets. Set by the onboard calibration. Zero disables the soft iron correction
+    // @Range: 0.2 5.0
+    // @User: Advanced
+    AP_GROUPINFO("DIA",    24, Compass, _diagonals[0], 0),
+
+    // @Param: ODI_X
+    // @DisplayName: Compass soft iron off-diagonal XY component
+    // @Description: XY component of the off-diagonals of the soft iron correction matrix applied to the compass field after the offsets. Set by the onboard calibration
+    // @Range: -1.0 1.0
+    // @User: Advanced
+
+    // @Param: ODI_Y
+    // @DisplayName: Compass soft iron off-diagonal XZ component
+    // @Description: XZ component of the off-diagonals of the soft iron correction matrix applied to the compass field after the offsets. Set by the onboard calibration
+    // @Range: -1.0 1.0
+    // @User: Advanced
+
+    // @Param: ODI_Z
+    // @DisplayName: Compass soft iron off-diagonal YZ component
+    // @Description: YZ component of the off-diagonals of the soft iron correction matrix applied to the compass field after the offsets. Set by the onboard calibration
+    // @Range: -1.0 1.0
+    // @User: Advanced
+    AP_GROUPINFO("ODI",    25, Compass, _offdiagonals[0], 0),
+
+#if COMPASS_MAX_INSTANCES > 1
+    // @Param: DIA2_X
+    // @DisplayName: Compass2 soft iron diagonal X component
+    // @Description: X component of the diagonal of the soft iron correction matrix applied to compass2's field after the offsets. Set by the onboard calibration. Zero disables the soft iron correction
+    // @Range: 0.2 5.0
+    // @User: Advanced
+
+    // @Param: DIA2_Y
+    // @DisplayName: Compass2 soft iron diagonal Y component
+    // @Description: Y component of the diagonal of the soft iron correction matrix applied to compass2's field after the offsets. Set by the onboard calibration. Zero disables the soft iron correction
+    // @Range: 0.2 5.0
+    // @User: Advanced
+
+    // @Param: DIA2_Z
+    // @DisplayName: Compass2 soft iron diagonal Z component
+    // @Description: Z component of the diagonal of the soft iron correction matrix applied to compass2's field after the offsets. Set by the onboard calibration. Zero disables the soft iron correction
+    // @Range: 0.2 5.0
+    // @User: Advanced
+    AP_GROUPINFO("DIA2",    26, Compass, _diagonals[1], 0),
+
+    // @Param: ODI2_X
+    // @DisplayName: Compass2 soft iron off-diagonal XY component
+    // @Description: XY component of the off-diagonals of the soft iron correction matrix applied to compass2's field after the offsets. Set by the onboard calibration
+    // @Range: -1.0 1.0
+    // @User: Advanced
+
+    // @Param: ODI2_Y
+    // @DisplayName: Compass2 soft iron off-diagonal XZ component
+    // @Description: XZ component of the off-diagonals of the soft iron correction matrix applied to compass2's field after the offsets. Set by the onboard calibration
+    // @Range: -1.0 1.0
+    // @User: Advanced
+
+    // @Param: ODI2_Z
+    // @DisplayName: Compass2 soft iron off-diagonal YZ component
+    // @Description: YZ component of the off-diagonals of the soft iron correction matrix applied to compass2's field after the offsets. Set by the onboard calibration
+    // @Range: -1.0 1.0
+    // @User: Advanced
+    AP_GROUPINFO("ODI2",    27, Compass, _offdiagonals[1], 0),
+#endif
+
+#if COMPASS_MAX_INSTANCES > 2
+    // @Param: DIA3_X
+    // @DisplayName: Compass3 soft iron diagonal X component
+    // @Description: X component of the diagonal of the soft iron correction matrix applied to compass3's field after the offsets. Set by the onboard calibration. Zero disables the soft iron correction
+    // @Range: 0.2 5.0
+    // @User: Advanced
+
+    // @Param: DIA3_Y
+    // @DisplayName: Compass3 soft iron diagonal Y component
+    // @Description: Y component of the diagonal of the soft iron correction matrix applied to compass3's field after the offsets. Set by the onboard calibration. Zero disables the soft iron correction
+    // @Range: 0.2 5.0
+    // @User: Advanced
+
+    // @Param: DIA3_Z
+    // @DisplayName: Compass3 soft iron diagonal Z component
+    // @Description: Z component of the diagonal of the soft iron correction matrix applied to compass3's field after the offsets. Set by the onboard calibration. Zero disables the soft iron correction
+    // @Range: 0.2 5.0
+    // @User: Advanced
+    AP_GROUPINFO("DIA3",    28, Compass, _diagonals[2], 0),
+
+    // @Param: ODI3_X
+    // @DisplayName: Compass3 soft iron off-diagonal XY component
+    // @Description: XY component of the off-diagonals of the soft iron correction matrix applied to compass3's field after the offsets. Set by the onboard calibration
+    // @Range: -1.0 1.0
+    // @User: Advanced
+
+    // @Param: ODI3_Y
+    // @DisplayName: Compass3 soft iron off-diagonal XZ component
+    // @Description: XZ component of the off-diagonals of the soft iron correction matrix applied to compass3's field after the offsets. Set by the onboard calibration
+    // @Range: -1.0 1.0
+    // @User: Advanced
+
+    // @Param: ODI3_Z
+    // @DisplayName: Compass3 soft iron off-diagonal YZ component
+    // @Description: YZ component of the off-diagonals of the soft iron correction matrix applied to compass3's field after the offsets. Set by the onboard calibration
+    // @Range: -1.0 1.0
+    // @User: Advanced
+    AP_GROUPINFO("ODI3",    29, Compass, _offdiagonals[2], 0),
+#endif
+#endif // COMPASS_CAL_ENABLED
+
     AP_GROUPEND
 };
 
@@ -270,6 +390,12 @@ Compass::Compass(void) :
     _null_init_done(false),
     _thr_or_curr(0.0f),
     _board_orientation(ROTATION_NONE)
+#if COMPASS_CAL_ENABLED
+    ,_cal_autosave(false),
+    _cal_threaded(false),
+    _cal_next(0),
+    _cal_last_sample(0)
+#endif
 {
     AP_Param::setup_object_defaults(this, var_info);
 
@@ -279,6 +405,12 @@ Compass::Compass(void) :
         _dev_id[i] = 0;
     }
 #endif
+
+#if COMPASS_CAL_ENABLED
+    for (uint8_t i=0; i<COMPASS_MAX_INSTANCES; i++) {
+        _cal_saved[i] = false;
+    }
+#endif
 }
 
 // Default init method, just returns success.
@@ -464,18 +596,33 @@ bool Compass::configured(void)
 }
 
 /*
-  apply offset and motor compensation corrections
+  apply offset, soft iron and motor compensation corrections
  */
 void Compass::apply_corrections(Vector3f &mag, uint8_t i)
 {
     const Vector3f &offsets = _offset[i].get();
     const Vector3f &mot = _motor_compensation[i].get();
 
+#if COMPASS_CAL_ENABLED
+    _raw_field[i] = mag;
+#endif
+
     /*
       note that _motor_offset[] is kept even if compensation is not
       being applied so it can be logged correctly
      */
     mag += offsets;
+#if COMPASS_CAL_ENABLED
+    const Vector3f &diagonals = _diagonals[i].get();
+    const Vector3f &offdiagonals = _offdiagonals[i].get();
+    if (!diagonals.is_zero()) {
+        Matrix3f mat(
+            diagonals.x,    offdiagonals.x, offdiagonals.y,
+            offdiagonals.x, diagonals.y,    offdiagonals.z,
+            offdiagonals.y, offdiagonals.z, diagonals.z);
+        mag = mat * mag;
+    }
+#endif
     if(_motor_comp_type != AP_COMPASS_MOT_COMP_DISABLED && _thr_or_curr != 0.0f) {
         _motor_offset[i] = mot * _thr_or_curr;
         mag += _motor_offset[i];
@@ -7,6 +7,7 @@
 #include <AP_Param.h>
 #include <AP_Math.h>
 #include <AP_Declination.h> // ArduPilot Mega Declination Helper Library
+#include "CompassCalibrator.h"
 
 // compass product id
 #define AP_COMPASS_TYPE_UNKNOWN  0x00
@@ -157,6 +158,56 @@ public:
     ///
     void learn_offsets(void);
 
+#if COMPASS_CAL_ENABLED
+    /// Start an onboard calibration of one or all healthy compasses.
+    /// The vehicle must then be rotated through all orientations
+    ///
+    /// @param  i                   compass instance
+    /// @param  retry               restart the calibration if it fails
+    /// @param  autosave            save the results as soon as the calibration succeeds
+    /// @param  delay               seconds to wait before collecting samples
+    ///
+    /// @returns                    True if a calibration was started
+    ///
+    bool start_calibration(uint8_t i, bool retry=false, bool autosave=false, float delay=0.0f);
+    bool start_calibration_all(bool retry=false, bool autosave=false, float delay=0.0f);
+
+    void cancel_calibration(uint8_t i);
+    void cancel_calibration_all(void);
+
+    /// Save the offsets and soft iron corrections of a successful calibration
+    ///
+    /// @returns                    True if the calibration succeeded, or all
+    ///                             started calibrations did
+    ///
+    bool accept_calibration(uint8_t i);
+    bool accept_calibration_all(void);
+
+    /// Returns True while any compass is being calibrated
+    bool is_calibrating(void) const;
+
+    void get_calibration_report(uint8_t i, CompassCalibrator::report &r) const {
+        _calibrator[i].get_report(r);
+    }
+
+    /// Pass new readings to the calibrations and save the results of
+    /// successful ones. Without a calibration thread this also runs a
+    /// fit step for one of the compasses, so it should be called from
+    /// the main loop more often than read()
+    ///
+    void compass_cal_update(void);
+
+    /// Run the calibration fits from proc in a background thread at
+    /// rate_hz instead of in compass_cal_update(). proc must call
+    /// calibration_thread_update(). Returns false if the board has no
+    /// background threads
+    ///
+    bool start_calibration_thread(AP_HAL::Proc proc, uint16_t rate_hz);
+
+    /// Run the calibration fits. Only to be called from the calibration thread
+    void calibration_thread_update(void);
+#endif
+
     /// return true if the compass should be used for yaw calculations
     bool use_for_yaw(uint8_t i) const;
     bool use_for_yaw(void) const;
@@ -282,7 +333,28 @@ protected:
 
     // board orientation from AHRS
     enum Rotation _board_orientation;
-    
+
+    // combined chip, board and user orientation of each instance
+    RotationCache _rotation[COMPASS_MAX_INSTANCES];
+
+#if COMPASS_CAL_ENABLED
+    // soft iron correction matrix from an ellipsoid fit. Zero
+    // diagonals mean no correction. Only boards that can run the
+    // calibration have them, so the others save the RAM and EEPROM
+    AP_Vector3f _diagonals[COMPASS_MAX_INSTANCES];
+    AP_Vector3f _offdiagonals[COMPASS_MAX_INSTANCES];
+
+    // rotated field before corrections, for calibration
+    Vector3f _raw_field[COMPASS_MAX_INSTANCES];
+
+    CompassCalibrator _calibrator[COMPASS_MAX_INSTANCES];
+    bool _cal_saved[COMPASS_MAX_INSTANCES];
+    bool _cal_autosave;
+    bool _cal_threaded;
+    uint8_t _cal_next;                          // calibrator to update next without a thread
+    uint32_t _cal_last_sample;                  // last_update of the last reading passed on
+#endif
+
     void apply_corrections(Vector3f &mag, uint8_t i);
 };
 #endif
@@ -0,0 +1,528 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+#include "CompassCalibrator.h"
+#include <matrixN.h>
+
+#if COMPASS_CAL_ENABLED
+
+extern const AP_HAL::HAL& hal;
+
+// limits on the fitted parameters for a calibration to be accepted
+#define COMPASS_CAL_MIN_RADIUS          150.0f
+#define COMPASS_CAL_MAX_RADIUS          950.0f
+#define COMPASS_CAL_MAX_OFFSET          1000.0f
+#define COMPASS_CAL_MIN_DIAGONAL        0.2f
+#define COMPASS_CAL_MAX_DIAGONAL        5.0f
+#define COMPASS_CAL_MAX_OFFDIAGONAL     1.0f
+
+CompassCalibrator::CompassCalibrator() :
+    _status(COMPASS_CAL_NOT_STARTED),
+    _status_start_ms(0),
+    _retry(false),
+    _delay_start_sec(0),
+    _tolerance(COMPASS_CAL_DEFAULT_TOLERANCE),
+    _attempt(0),
+    _fitness(0),
+    _sphere_lambda(1),
+    _ellipsoid_lambda(1),
+    _fit_step(0),
+    _samples_collected(0),
+    _cmd(CMD_CANCEL),
+    _cmd_retry(false),
+    _cmd_delay(0),
+    _cmd_tolerance(COMPASS_CAL_DEFAULT_TOLERANCE),
+    _cmd_seq(0),
+    _cmd_done(0),
+    _queue_head(0),
+    _queue_tail(0),
+    _published_seq(0)
+{
+    reset_params();
+    publish_report();
+}
+
+/*
+  calls from the main thread
+ */
+
+void CompassCalibrator::start(bool retry, float delay, float tolerance)
+{
+    _cmd = CMD_START;
+    _cmd_retry = retry;
+    _cmd_delay = delay;
+    _cmd_tolerance = tolerance;
+
+    // the arguments must be complete before update() sees the command
+    __sync_synchronize();
+    _cmd_seq = _cmd_seq + 1;
+}
+
+void CompassCalibrator::cancel(void)
+{
+    _cmd = CMD_CANCEL;
+    __sync_synchronize();
+    _cmd_seq = _cmd_seq + 1;
+}
+
+void CompassCalibrator::new_sample(const Vector3f &sample)
+{
+    uint8_t tail = _queue_tail;
+    uint8_t next = (tail + 1) % COMPASS_CAL_QUEUE_SIZE;
+    if (next == _queue_head) {
+        // update() is behind. Dropping the sample only slows the
+        // collection down
+        return;
+    }
+    _queue[tail] = sample;
+
+    // the sample must be complete before update() can see it
+    __sync_synchronize();
+    _queue_tail = next;
+}
+
+void CompassCalibrator::get_report(report &r) const
+{
+    uint32_t seq;
+    uint8_t cmd_done;
+    do {
+        seq = _published_seq;
+        __sync_synchronize();
+        r = _published[seq & 1].r;
+        cmd_done = _published[seq & 1].cmd_done;
+        __sync_synchronize();
+    } while (seq != _published_seq);
+
+    if (cmd_done != _cmd_seq) {
+        // update() has yet to act on the latest command
+        r.status = _cmd == CMD_START ? COMPASS_CAL_WAITING_TO_START : COMPASS_CAL_NOT_STARTED;
+        r.attempt = 0;
+        r.completion_pct = 0;
+        r.fitness = 0;
+        r.offsets.zero();
+        r.diagonals.zero();
+        r.offdiagonals.zero();
+    }
+}
+
+bool CompassCalibrator::running(void) const
+{
+    report r;
+    get_report(r);
+    return r.status == COMPASS_CAL_WAITING_TO_START ||
+        r.status == COMPASS_CAL_RUNNING_STEP_ONE ||
+        r.status == COMPASS_CAL_RUNNING_STEP_TWO;
+}
+
+/*
+  calls from update()
+ */
+
+void CompassCalibrator::update(void)
+{
+    uint8_t cmd_seq = _cmd_seq;
+    if (cmd_seq != _cmd_done) {
+        // read the arguments only after seeing the command number
+        __sync_synchronize();
+        _cmd_done = cmd_seq;
+        if (_cmd == CMD_START) {
+            _retry = _cmd_retry;
+            _delay_start_sec = _cmd_delay;
+            _tolerance = _cmd_tolerance;
+            _attempt = 1;
+            set_status(COMPASS_CAL_WAITING_TO_START);
+        } else {
+            set_status(COMPASS_CAL_NOT_STARTED);
+        }
+    }
+
+    bool collecting = (_status == COMPASS_CAL_RUNNING_STEP_ONE ||
+                       _status == COMPASS_CAL_RUNNING_STEP_TWO);
+    while (_queue_head != _queue_tail) {
+        uint8_t head = _queue_head;
+
+        // read the sample only after seeing the tail that covers it
+        __sync_synchronize();
+        Vector3f sample = _queue[head];
+        __sync_synchronize();
+        _queue_head = (head + 1) % COMPASS_CAL_QUEUE_SIZE;
+
+        if (collecting && _samples_collected < COMPASS_CAL_NUM_SAMPLES && accept_sample(sample)) {
+            _sample_buffer[_samples_collected++] = sample;
+        }
+    }
+
+    switch (_status) {
+    case COMPASS_CAL_WAITING_TO_START:
+        if (hal.scheduler->millis() - _status_start_ms > _delay_start_sec * 1000.0f) {
+            set_status(COMPASS_CAL_RUNNING_STEP_ONE);
+        }
+        break;
+
+    case COMPASS_CAL_RUNNING_STEP_ONE:
+        if (_samples_collected < COMPASS_CAL_NUM_SAMPLES) {
+            break;
+        }
+        if (_fit_step == 0) {
+            estimate_sphere();
+        }
+        if (_fit_step < COMPASS_CAL_SPHERE_ITERATIONS) {
+            run_sphere_fit();
+            _fit_step++;
+        } else if (fit_acceptable()) {
+            set_status(COMPASS_CAL_RUNNING_STEP_TWO);
+        } else {
+            fail();
+        }
+        break;
+
+    case COMPASS_CAL_RUNNING_STEP_TWO:
+        if (_samples_collected < COMPASS_CAL_NUM_SAMPLES) {
+            break;
+        }
+        if (_fit_step == 0) {
+            // the sphere fit on the refilled buffer is the starting point
+            _fitness = sqrtf(calc_mean_squared_residuals(_params));
+        }
+        if (_fit_step < COMPASS_CAL_ELLIPSOID_ITERATIONS) {
+            run_ellipsoid_fit();
+            _fit_step++;
+        } else if (_fitness <= _tolerance && fit_acceptable()) {
+            set_status(COMPASS_CAL_SUCCESS);
+        } else {
+            fail();
+        }
+        break;
+
+    default:
+        break;
+    }
+
+    publish_report();
+}
+
+void CompassCalibrator::set_status(enum cal_status status)
+{
+    switch (status) {
+    case COMPASS_CAL_WAITING_TO_START:
+        _status_start_ms = hal.scheduler->millis();
+        break;
+
+    case COMPASS_CAL_RUNNING_STEP_ONE:
+        reset_params();
+        _samples_collected = 0;
+        _fit_step = 0;
+        break;
+
+    case COMPASS_CAL_RUNNING_STEP_TWO:
+        // keep half the samples and collect the rest again, so the
+        // ellipsoid is fitted to a fresh set
+        thin_samples();
+        _fit_step = 0;
+        break;
+
+    default:
+        break;
+    }
+    _status = status;
+}
+
+// restart the collection if retrying, otherwise give up
+void CompassCalibrator::fail(void)
+{
+    if (_retry) {
+        if (_attempt < 255) {
+            _attempt++;
+        }
+        set_status(COMPASS_CAL_RUNNING_STEP_ONE);
+    } else {
+        set_status(COMPASS_CAL_FAILED);
+    }
+}
+
+void CompassCalibrator::reset_params(void)
+{
+    _params.radius = 200;
+    _params.offset.zero();
+    _params.diag = Vector3f(1, 1, 1);
+    _params.offdiag.zero();
+    _fitness = 0;
+    _sphere_lambda = 1;
+    _ellipsoid_lambda = 1;
+}
+
+/*
+  accept a sample only if it is far enough from all the others, so the
+  buffer fills with samples spread over the whole sphere rather than
+  with many samples of the same orientation. 100 samples a quarter of
+  the radius apart need about 40% of the sphere, and much more than
+  that cannot be packed in
+ */
+bool CompassCalibrator::accept_sample(const Vector3f &sample) const
+{
+    if (_samples_collected == 0) {
+        return true;
+    }
+
+    // the radius isn't known until the first fit, so estimate it from
+    // the extent of the samples so far
+    Vector3f smin = _sample_buffer[0];
+    Vector3f smax = _sample_buffer[0];
+    for (uint8_t i=1; i<_samples_collected; i++) {
+        const Vector3f &s = _sample_buffer[i];
+        smin.x = min(smin.x, s.x);
+        smin.y = min(smin.y, s.y);
+        smin.z = min(smin.z, s.z);
+        smax.x = max(smax.x, s.x);
+        smax.y = max(smax.y, s.y);
+        smax.z = max(smax.z, s.z);
+    }
+    Vector3f extent = smax - smin;
+    float radius = max(0.5f * max(extent.x, max(extent.y, extent.z)), COMPASS_CAL_MIN_RADIUS);
+    float min_distance = radius * sqrtf(6.0f / COMPASS_CAL_NUM_SAMPLES);
+
+    for (uint8_t i=0; i<_samples_collected; i++) {
+        if ((sample - _sample_buffer[i]).length() < min_distance) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// keep every other sample, which stay well spread over the sphere
+void CompassCalibrator::thin_samples(void)
+{
+    _samples_collected /= 2;
+    for (uint8_t i=0; i<_samples_collected; i++) {
+        _sample_buffer[i] = _sample_buffer[2*i];
+    }
+}
+
+// the residual of a sample is its distance from the fitted surface
+float CompassCalibrator::calc_residual(const Vector3f &sample, const param_t &params) const
+{
+    Matrix3f softiron(
+        params.diag.x,    params.offdiag.x, params.offdiag.y,
+        params.offdiag.x, params.diag.y,    params.offdiag.z,
+        params.offdiag.y, params.offdiag.z, params.diag.z);
+    return params.radius - (softiron * (sample + params.offset)).length();
+}
+
+float CompassCalibrator::calc_mean_squared_residuals(const param_t &params) const
+{
+    float sum = 0;
+    for (uint8_t i=0; i<_samples_collected; i++) {
+        float resid = calc_residual(_sample_buffer[i], params);
+        sum += resid * resid;
+    }
+    return sum / _samples_collected;
+}
+
+// start the sphere fit at the centre and mean radius of the samples
+void CompassCalibrator::estimate_sphere(void)
+{
+    Vector3f centre;
+    for (uint8_t i=0; i<_samples_collected; i++) {
+        centre += _sample_buffer[i];
+    }
+    centre /= _samples_collected;
+
+    float radius = 0;
+    for (uint8_t i=0; i<_samples_collected; i++) {
+        radius += (_sample_buffer[i] - centre).length();
+    }
+    _params.radius = radius / _samples_collected;
+    _params.offset = -centre;
+    _fitness = sqrtf(calc_mean_squared_residuals(_params));
+}
+
+// derivatives of the residual with respect to radius and offset
+void CompassCalibrator::calc_sphere_jacob(const Vector3f &sample, const param_t &params, VectorN<float,COMPASS_CAL_NUM_SPHERE_PARAMS> &ret) const
+{
+    Vector3f v = sample + params.offset;
+    float length = v.length();
+    if (length < 1.0e-6f) {
+        ret.zero();
+        ret[0] = 1;
+        return;
+    }
+    ret[0] = 1;
+    ret[1] = -v.x / length;
+    ret[2] = -v.y / length;
+    ret[3] = -v.z / length;
+}
+
+// derivatives of the residual with respect to offset, diagonal and
+// off-diagonal, with the radius held at the sphere fit's
+void CompassCalibrator::calc_ellipsoid_jacob(const Vector3f &sample, const param_t &params, VectorN<float,COMPASS_CAL_NUM_ELLIPSOID_PARAMS> &ret) const
+{
+    Matrix3f softiron(
+        params.diag.x,    params.offdiag.x, params.offdiag.y,
+        params.offdiag.x, params.diag.y,    params.offdiag.z,
+        params.offdiag.y, params.offdiag.z, params.diag.z);
+    Vector3f v = sample + params.offset;
+    Vector3f u = softiron * v;
+    float length = u.length();
+    if (length < 1.0e-6f) {
+        ret.zero();
+        return;
+    }
+
+    // the soft iron matrix is symmetric, so its transpose is itself
+    Vector3f d_offset = softiron * u;
+    ret[0] = -d_offset.x / length;
+    ret[1] = -d_offset.y / length;
+    ret[2] = -d_offset.z / length;
+    ret[3] = -u.x * v.x / length;
+    ret[4] = -u.y * v.y / length;
+    ret[5] = -u.z * v.z / length;
+    ret[6] = -(u.x * v.y + u.y * v.x) / length;
+    ret[7] = -(u.x * v.z + u.z * v.x) / length;
+    ret[8] = -(u.y * v.z + u.z * v.y) / length;
+}
+
+/*
+  one Levenberg-Marquardt iteration. The step is kept if it reduces the
+  residuals, and lambda moves the next step towards Gauss-Newton if it
+  does, or towards smaller gradient descent steps if not
+ */
+void CompassCalibrator::run_sphere_fit(void)
+{
+    const uint8_t n = COMPASS_CAL_NUM_SPHERE_PARAMS;
+    MatrixSym<float,n> JTJ;
+    VectorN<float,n> JTFI;
+    VectorN<float,n> jacob;
+
+    for (uint8_t k=0; k<_samples_collected; k++) {
+        const Vector3f &sample = _sample_buffer[k];
+        calc_sphere_jacob(sample, _params, jacob);
+        float resid = calc_residual(sample, _params);
+        for (uint8_t i=0; i<n; i++) {
+            for (uint8_t j=i; j<n; j++) {
+                JTJ(i,j) += jacob[i] * jacob[j];
+            }
+            JTFI[i] += jacob[i] * resid;
+        }
+    }
+
+    for (uint8_t i=0; i<n; i++) {
+        JTJ(i,i) += _sphere_lambda * JTJ(i,i);
+    }
+
+    MatrixLower<float,n> L;
+    if (!matrix_cholesky(JTJ, L)) {
+        _sphere_lambda *= 10;
+        return;
+    }
+    VectorN<float,n> step;
+    matrix_cholesky_solve(L, JTFI, step);
+
+    param_t new_params = _params;
+    new_params.radius -= step[0];
+    new_params.offset.x -= step[1];
+    new_params.offset.y -= step[2];
+    new_params.offset.z -= step[3];
+
+    float new_fitness = sqrtf(calc_mean_squared_residuals(new_params));
+    if (new_fitness < _fitness) {
+        _params = new_params;
+        _fitness = new_fitness;
+        _sphere_lambda *= 0.1f;
+    } else {
+        _sphere_lambda *= 10;
+    }
+}
+
+void CompassCalibrator::run_ellipsoid_fit(void)
+{
+    const uint8_t n = COMPASS_CAL_NUM_ELLIPSOID_PARAMS;
+    MatrixSym<float,n> JTJ;
+    VectorN<float,n> JTFI;
+    VectorN<float,n> jacob;
+
+    for (uint8_t k=0; k<_samples_collected; k++) {
+        const Vector3f &sample = _sample_buffer[k];
+        calc_ellipsoid_jacob(sample, _params, jacob);
+        float resid = calc_residual(sample, _params);
+        for (uint8_t i=0; i<n; i++) {
+            for (uint8_t j=i; j<n; j++) {
+                JTJ(i,j) += jacob[i] * jacob[j];
+            }
+            JTFI[i] += jacob[i] * resid;
+        }
+    }
+
+    for (uint8_t i=0; i<n; i++) {
+        JTJ(i,i) += _ellipsoid_lambda * JTJ(i,i);
+    }
+
+    MatrixLower<float,n> L;
+    if (!matrix_cholesky(JTJ, L)) {
+        _ellipsoid_lambda *= 10;
+        return;
+    }
+    VectorN<float,n> step;
+    matrix_cholesky_solve(L, JTFI, step);
+
+    param_t new_params = _params;
+    new_params.offset -= Vector3f(step[0], step[1], step[2]);
+    new_params.diag -= Vector3f(step[3], step[4], step[5]);
+    new_params.offdiag -= Vector3f(step[6], step[7], step[8]);
+
+    float new_fitness = sqrtf(calc_mean_squared_residuals(new_params));
+    if (new_fitness < _fitness) {
+        _params = new_params;
+        _fitness = new_fitness;
+        _ellipsoid_lambda *= 0.1f;
+    } else {
+        _ellipsoid_lambda *= 10;
+    }
+}
+
+bool CompassCalibrator::fit_acceptable(void) const
+{
+    return !isnan(_fitness) &&
+        _params.radius > COMPASS_CAL_MIN_RADIUS && _params.radius < COMPASS_CAL_MAX_RADIUS &&
+        fabsf(_params.offset.x) < COMPASS_CAL_MAX_OFFSET &&
+        fabsf(_params.offset.y) < COMPASS_CAL_MAX_OFFSET &&
+        fabsf(_params.offset.z) < COMPASS_CAL_MAX_OFFSET &&
+        _params.diag.x > COMPASS_CAL_MIN_DIAGONAL && _params.diag.x < COMPASS_CAL_MAX_DIAGONAL &&
+        _params.diag.y > COMPASS_CAL_MIN_DIAGONAL && _params.diag.y < COMPASS_CAL_MAX_DIAGONAL &&
+        _params.diag.z > COMPASS_CAL_MIN_DIAGONAL && _params.diag.z < COMPASS_CAL_MAX_DIAGONAL &&
+        fabsf(_params.offdiag.x) < COMPASS_CAL_MAX_OFFDIAGONAL &&
+        fabsf(_params.offdiag.y) < COMPASS_CAL_MAX_OFFDIAGONAL &&
+        fabsf(_params.offdiag.z) < COMPASS_CAL_MAX_OFFDIAGONAL;
+}
+
+// publish into the buffer get_report() is not reading
+void CompassCalibrator::publish_report(void)
+{
+    uint32_t seq = _published_seq;
+    report &r = _published[(seq + 1) & 1].r;
+
+    r.status = _status;
+    r.attempt = _attempt;
+    switch (_status) {
+    case COMPASS_CAL_RUNNING_STEP_ONE:
+        r.completion_pct = 33 * (uint16_t)_samples_collected / COMPASS_CAL_NUM_SAMPLES;
+        break;
+    case COMPASS_CAL_RUNNING_STEP_TWO:
+        r.completion_pct = 33 + 66 * (uint16_t)_samples_collected / COMPASS_CAL_NUM_SAMPLES;
+        break;
+    case COMPASS_CAL_SUCCESS:
+    case COMPASS_CAL_FAILED:
+        r.completion_pct = 100;
+        break;
+    default:
+        r.completion_pct = 0;
+        break;
+    }
+    r.fitness = _fitness;
+    r.offsets = _params.offset;
+    r.diagonals = _params.diag;
+    r.offdiagonals = _params.offdiag;
+    _published[(seq + 1) & 1].cmd_done = _cmd_done;
+
+    __sync_synchronize();
+    _published_seq = seq + 1;
+}
+
+#endif // COMPASS_CAL_ENABLED
@@ -0,0 +1,156 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+  onboard compass calibration
+
+  Samples of the raw field are collected while the vehicle is rotated
+  through all orientations. Once enough well spread samples have been
+  taken a sphere is fitted to them to find the offsets and field
+  strength, then more samples are taken and an ellipsoid is fitted to
+  find the soft iron scaling as well. Both fits use Levenberg-Marquardt,
+  one iteration per call to update(), so the work can be spread over
+  the main loop or run in a background thread.
+ */
+#ifndef __COMPASS_CALIBRATOR_H__
+#define __COMPASS_CALIBRATOR_H__
+
+#include <AP_HAL.h>
+#include <AP_Math.h>
+#include <vectorN.h>
+
+// the sample buffers need a few kB and a fit step a few hundred
+// microseconds with an FPU, so only calibrate on the larger boards
+#define COMPASS_CAL_ENABLED (HAL_CPU_CLASS >= HAL_CPU_CLASS_150)
+
+#define COMPASS_CAL_NUM_SAMPLES         100     // samples used for each fit
+#define COMPASS_CAL_QUEUE_SIZE          8       // samples queued for update()
+#define COMPASS_CAL_NUM_SPHERE_PARAMS   4
+#define COMPASS_CAL_NUM_ELLIPSOID_PARAMS 9
+#define COMPASS_CAL_SPHERE_ITERATIONS   10
+#define COMPASS_CAL_ELLIPSOID_ITERATIONS 15
+#define COMPASS_CAL_DEFAULT_TOLERANCE   5.0f    // RMS fit residual for success
+
+class CompassCalibrator {
+public:
+    enum cal_status {
+        COMPASS_CAL_NOT_STARTED = 0,
+        COMPASS_CAL_WAITING_TO_START,
+        COMPASS_CAL_RUNNING_STEP_ONE,
+        COMPASS_CAL_RUNNING_STEP_TWO,
+        COMPASS_CAL_SUCCESS,
+        COMPASS_CAL_FAILED
+    };
+
+    // progress and result of a calibration
+    struct report {
+        enum cal_status status;
+        uint8_t attempt;
+        uint8_t completion_pct;
+        float fitness;                  // RMS residual of the fit
+        Vector3f offsets;
+        Vector3f diagonals;             // soft iron matrix diagonal
+        Vector3f offdiagonals;          // soft iron matrix xy, xz and yz
+    };
+
+    CompassCalibrator();
+
+    /*
+      the calls from the main thread. Samples are raw fields, rotated
+      to the body frame but without any corrections
+     */
+
+    // start a calibration after delay seconds, retrying on failure
+    // if retry is set. A fit succeeds if its RMS residual is within
+    // tolerance
+    void start(bool retry, float delay, float tolerance);
+    void cancel(void);
+    void new_sample(const Vector3f &sample);
+
+    // get the latest report published by update()
+    void get_report(report &r) const;
+
+    // true from start() until the calibration succeeds, fails or is
+    // cancelled
+    bool running(void) const;
+
+    /*
+      take the queued samples and run one fit iteration. Called from
+      the calibration thread, or from the main loop on boards without
+      one
+     */
+    void update(void);
+
+private:
+    // sphere parameters, and the soft iron ones fitted in step two
+    struct param_t {
+        float radius;
+        Vector3f offset;
+        Vector3f diag;
+        Vector3f offdiag;
+    };
+
+    enum command {
+        CMD_START,
+        CMD_CANCEL
+    };
+
+    void set_status(enum cal_status status);
+    void reset_params(void);
+
+    // sample collection
+    bool accept_sample(const Vector3f &sample) const;
+    void thin_samples(void);
+
+    // the fits
+    float calc_residual(const Vector3f &sample, const param_t &params) const;
+    float calc_mean_squared_residuals(const param_t &params) const;
+    void calc_sphere_jacob(const Vector3f &sample, const param_t &params, VectorN<float,COMPASS_CAL_NUM_SPHERE_PARAMS> &ret) const;
+    void calc_ellipsoid_jacob(const Vector3f &sample, const param_t &params, VectorN<float,COMPASS_CAL_NUM_ELLIPSOID_PARAMS> &ret) const;
+    void run_sphere_fit(void);
+    void run_ellipsoid_fit(void);
+    void estimate_sphere(void);
+    bool fit_acceptable(void) const;
+    void fail(void);
+
+    void publish_report(void);
+
+    // state of the calibration, only used by update()
+    enum cal_status _status;
+    uint32_t _status_start_ms;
+    bool _retry;
+    float _delay_start_sec;
+    float _tolerance;
+    uint8_t _attempt;
+    param_t _params;
+    float _fitness;
+    float _sphere_lambda;
+    float _ellipsoid_lambda;
+    uint8_t _fit_step;
+    Vector3f _sample_buffer[COMPASS_CAL_NUM_SAMPLES];
+    uint8_t _samples_collected;
+
+    // commands from the main thread. The latest one wins, so it is
+    // written first and then _cmd_seq is incremented
+    volatile uint8_t _cmd;
+    volatile bool _cmd_retry;
+    volatile float _cmd_delay;
+    volatile float _cmd_tolerance;
+    volatile uint8_t _cmd_seq;
+    uint8_t _cmd_done;
+
+    // samples from new_sample(), with one writer and one reader
+    Vector3f _queue[COMPASS_CAL_QUEUE_SIZE];
+    volatile uint8_t _queue_head;
+    volatile uint8_t _queue_tail;
+
+    // reports are double buffered, with update() writing the buffer
+    // not selected by _published_seq and then incrementing it. The
+    // command number is published with the report so get_report()
+    // can tell if update() has yet to see a command
+    struct {
+        report r;
+        uint8_t cmd_done;
+    } _published[2];
+    volatile uint32_t _published_seq;
+};
+
+#endif // __COMPASS_CALIBRATOR_H__
@@ -0,0 +1,149 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+#include <AP_HAL.h>
+#include "Compass.h"
+
+#if COMPASS_CAL_ENABLED
+
+extern const AP_HAL::HAL& hal;
+
+/*
+  onboard calibration of the compasses. The main loop passes each new
+  reading to the calibrators, which fit the offsets and soft iron
+  corrections either in a background thread or a step at a time in
+  compass_cal_update(). Each compass has its own calibrator, so all of
+  them can be calibrated at once
+ */
+
+bool
+Compass::start_calibration(uint8_t i, bool retry, bool autosave, float delay)
+{
+    if (i >= get_count() || !healthy(i)) {
+        return false;
+    }
+    _cal_autosave = autosave;
+    _cal_saved[i] = false;
+    _calibrator[i].start(retry, delay, COMPASS_CAL_DEFAULT_TOLERANCE);
+    return true;
+}
+
+bool
+Compass::start_calibration_all(bool retry, bool autosave, float delay)
+{
+    bool started = false;
+    for (uint8_t i=0; i<get_count(); i++) {
+        if (start_calibration(i, retry, autosave, delay)) {
+            started = true;
+        }
+    }
+    return started;
+}
+
+void
+Compass::cancel_calibration(uint8_t i)
+{
+    if (i < COMPASS_MAX_INSTANCES) {
+        _calibrator[i].cancel();
+    }
+}
+
+void
+Compass::cancel_calibration_all(void)
+{
+    for (uint8_t i=0; i<COMPASS_MAX_INSTANCES; i++) {
+        cancel_calibration(i);
+    }
+}
+
+bool
+Compass::accept_calibration(uint8_t i)
+{
+    if (i >= COMPASS_MAX_INSTANCES) {
+        return false;
+    }
+    CompassCalibrator::report r;
+    _calibrator[i].get_report(r);
+    if (r.status != CompassCalibrator::COMPASS_CAL_SUCCESS) {
+        return false;
+    }
+    if (!_cal_saved[i]) {
+        set_and_save_offsets(i, r.offsets);
+        _diagonals[i].set_and_save(r.diagonals);
+        _offdiagonals[i].set_and_save(r.offdiagonals);
+        _cal_saved[i] = true;
+    }
+    return true;
+}
+
+bool
+Compass::accept_calibration_all(void)
+{
+    bool success = true;
+    for (uint8_t i=0; i<get_count(); i++) {
+        CompassCalibrator::report r;
+        _calibrator[i].get_report(r);
+        if (r.status == CompassCalibrator::COMPASS_CAL_NOT_STARTED) {
+            continue;
+        }
+        if (!accept_calibration(i)) {
+            success = false;
+        }
+    }
+    return success;
+}
+
+bool
+Compass::is_calibrating(void) const
+{
+    for (uint8_t i=0; i<get_count(); i++) {
+        if (_calibrator[i].running()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void
+Compass::compass_cal_update(void)
+{
+    bool new_reading = (last_update != _cal_last_sample);
+    _cal_last_sample = last_update;
+
+    for (uint8_t i=0; i<get_count(); i++) {
+        if (new_reading && healthy(i) && _calibrator[i].running()) {
+            _calibrator[i].new_sample(_raw_field[i]);
+        }
+    }
+
+    if (!_cal_threaded && get_count() > 0) {
+        // one fit step per call, with the compasses taking turns, to
+        // bound the time taken from the main loop
+        _cal_next = (_cal_next + 1) % get_count();
+        _calibrator[_cal_next].update();
+    }
+
+    if (_cal_autosave) {
+        for (uint8_t i=0; i<get_count(); i++) {
+            accept_calibration(i);
+        }
+    }
+}
+
+bool
+Compass::start_calibration_thread(AP_HAL::Proc proc, uint16_t rate_hz)
+{
+    if (_cal_threaded) {
+        return false;
+    }
+    _cal_threaded = hal.scheduler->register_background_process(proc, rate_hz);
+    return _cal_threaded;
+}
+
+void
+Compass::calibration_thread_update(void)
+{
+    for (uint8_t i=0; i<COMPASS_MAX_INSTANCES; i++) {
+        _calibrator[i].update();
+    }
+}
+
+#endif // COMPASS_CAL_ENABLED
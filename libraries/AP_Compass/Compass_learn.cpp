@@ -32,6 +32,13 @@ Compass::learn_offsets(void)
         return;
     }
 
+#if COMPASS_CAL_ENABLED
+    if (is_calibrating()) {
+        // the onboard calibration will replace the offsets
+        return;
+    }
+#endif
+
     // this gain is set so we converge on the offsets in about 5
     // minutes with a 10Hz compass
     const float gain = 0.01;
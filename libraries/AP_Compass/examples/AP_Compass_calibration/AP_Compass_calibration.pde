@@ -0,0 +1,170 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Unit tests for the onboard compass calibration. Samples of a known
+// distorted field are fed to a CompassCalibrator while the simulated
+// vehicle tumbles, and the fitted offsets and soft iron matrix are
+// checked against the distortion
+//
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+#include <AP_Math.h>
+#include <AP_Declination.h>
+#include <AP_Compass.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#if COMPASS_CAL_ENABLED
+
+// earth field in milligauss
+static const Vector3f earth_field(250, 30, 420);
+
+// sample noise in milligauss
+#define SAMPLE_NOISE        2.0f
+
+// give up if the calibration hasn't finished after this many samples
+#define MAX_SAMPLES         20000
+
+#define OFFSET_TOLERANCE    5.0f
+#define MATRIX_TOLERANCE    0.02f
+
+static const struct {
+    Vector3f offsets;
+    Vector3f diagonals;
+    Vector3f offdiagonals;
+} test_cases[] = {
+    { Vector3f(120, -80, -200), Vector3f(1, 1, 1),          Vector3f(0, 0, 0) },
+    { Vector3f(-30, 300, -10),  Vector3f(1.1f, 0.92f, 1.0f), Vector3f(0.05f, -0.02f, 0.03f) },
+    { Vector3f(0, 0, 0),        Vector3f(0.8f, 1.2f, 1.05f), Vector3f(0.1f, 0, 0) },
+};
+
+#define ARRAY_LENGTH(x) (sizeof((x))/sizeof((x)[0]))
+
+static CompassCalibrator calibrator;
+
+static bool all_passed = true;
+
+static void check(const char *name, float err, float tolerance)
+{
+    bool ok = fabsf(err) <= tolerance;
+    hal.console->printf_P(PSTR("  %-20s err=%.3f %s\n"), name, err, ok ? "PASS" : "FAIL");
+    if (!ok) {
+        all_passed = false;
+    }
+}
+
+// pseudo-random float in the range -1 to 1
+static float rand_float(void)
+{
+    static uint32_t seed = 12345;
+    seed = seed * 1664525UL + 1013904223UL;
+    return ((int32_t)(seed >> 8) - 0x800000) / (float)0x800000;
+}
+
+static Matrix3f soft_iron(const Vector3f &diag, const Vector3f &offdiag)
+{
+    return Matrix3f(diag.x,    offdiag.x, offdiag.y,
+                    offdiag.x, diag.y,    offdiag.z,
+                    offdiag.y, offdiag.z, diag.z);
+}
+
+// inverse of a 3x3 matrix from its adjugate
+static Matrix3f inverse(const Matrix3f &m)
+{
+    Matrix3f adj(m.b.y*m.c.z - m.b.z*m.c.y, m.a.z*m.c.y - m.a.y*m.c.z, m.a.y*m.b.z - m.a.z*m.b.y,
+                 m.b.z*m.c.x - m.b.x*m.c.z, m.a.x*m.c.z - m.a.z*m.c.x, m.a.z*m.b.x - m.a.x*m.b.z,
+                 m.b.x*m.c.y - m.b.y*m.c.x, m.a.y*m.c.x - m.a.x*m.c.y, m.a.x*m.b.y - m.a.y*m.b.x);
+    float det = m.a.x*adj.a.x + m.a.y*adj.b.x + m.a.z*adj.c.x;
+    return adj * (1.0f / det);
+}
+
+static void run_test(uint8_t n)
+{
+    hal.console->printf_P(PSTR("test case %u\n"), (unsigned)n);
+
+    // the raw field is the corrected field distorted by the inverse of
+    // the soft iron matrix, less the offsets
+    Matrix3f softiron = soft_iron(test_cases[n].diagonals, test_cases[n].offdiagonals);
+    Matrix3f distortion = inverse(softiron);
+
+    calibrator.start(false, 0, COMPASS_CAL_DEFAULT_TOLERANCE);
+
+    // random walk through all orientations
+    float roll = 0, pitch = 0, yaw = 0;
+    uint16_t count;
+    for (count=0; count<MAX_SAMPLES; count++) {
+        roll += rand_float() * 0.3f;
+        pitch += rand_float() * 0.3f;
+        yaw += rand_float() * 0.3f;
+        Matrix3f rot;
+        rot.from_euler(roll, pitch, yaw);
+        Vector3f noise(rand_float(), rand_float(), rand_float());
+        Vector3f raw = distortion * (rot.transposed() * earth_field) -
+            test_cases[n].offsets + noise * SAMPLE_NOISE;
+
+        calibrator.new_sample(raw);
+        calibrator.update();
+        if (!calibrator.running()) {
+            break;
+        }
+    }
+
+    CompassCalibrator::report r;
+    calibrator.get_report(r);
+    hal.console->printf_P(PSTR("  status %u after %u samples, fitness %.2f\n"),
+                          (unsigned)r.status, (unsigned)count, r.fitness);
+    if (r.status != CompassCalibrator::COMPASS_CAL_SUCCESS) {
+        hal.console->println("  status FAIL");
+        all_passed = false;
+        return;
+    }
+
+    check("offset x", r.offsets.x - test_cases[n].offsets.x, OFFSET_TOLERANCE);
+    check("offset y", r.offsets.y - test_cases[n].offsets.y, OFFSET_TOLERANCE);
+    check("offset z", r.offsets.z - test_cases[n].offsets.z, OFFSET_TOLERANCE);
+
+    // the fit only finds the soft iron matrix up to a scale, which
+    // depends on the fitted field strength, so compare after scaling
+    // to the same mean diagonal
+    float scale = (test_cases[n].diagonals.x + test_cases[n].diagonals.y + test_cases[n].diagonals.z) /
+        (r.diagonals.x + r.diagonals.y + r.diagonals.z);
+    Vector3f diag = r.diagonals * scale;
+    Vector3f offdiag = r.offdiagonals * scale;
+    check("diagonal x", diag.x - test_cases[n].diagonals.x, MATRIX_TOLERANCE);
+    check("diagonal y", diag.y - test_cases[n].diagonals.y, MATRIX_TOLERANCE);
+    check("diagonal z", diag.z - test_cases[n].diagonals.z, MATRIX_TOLERANCE);
+    check("offdiagonal xy", offdiag.x - test_cases[n].offdiagonals.x, MATRIX_TOLERANCE);
+    check("offdiagonal xz", offdiag.y - test_cases[n].offdiagonals.y, MATRIX_TOLERANCE);
+    check("offdiagonal yz", offdiag.z - test_cases[n].offdiagonals.z, MATRIX_TOLERANCE);
+}
+
+void setup(void)
+{
+    hal.console->println("Compass calibration unit tests\n");
+
+    for (uint8_t i=0; i<ARRAY_LENGTH(test_cases); i++) {
+        run_test(i);
+    }
+
+    hal.console->println(all_passed ? "ALL TESTS PASSED" : "TEST FAILED");
+}
+
+#else
+
+void setup(void)
+{
+    hal.console->println("Compass calibration is not available on this board");
+}
+
+#endif // COMPASS_CAL_ENABLED
+
+void loop(void){}
+
+AP_HAL_MAIN();
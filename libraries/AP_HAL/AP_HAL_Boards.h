@@ -136,9 +136,20 @@
 #define HAL_STORAGE_SIZE_AVAILABLE  HAL_STORAGE_SIZE
 #define HAL_BOARD_LOG_DIRECTORY "logs"
 #define HAL_BOARD_TERRAIN_DIRECTORY "terrain"
+// SITL_SENSOR_DRIVERS runs the real sensor drivers against simulated
+// chips on the SPI and I2C buses, instead of the HIL sensors
+#ifndef SITL_SENSOR_DRIVERS
+#define SITL_SENSOR_DRIVERS 0
+#endif
+#if SITL_SENSOR_DRIVERS
+#define HAL_INS_DEFAULT HAL_INS_MPU9250
+#define HAL_BARO_DEFAULT HAL_BARO_MS5611_SPI
+#define HAL_COMPASS_DEFAULT HAL_COMPASS_HMC5843
+#else
 #define HAL_INS_DEFAULT HAL_INS_HIL
 #define HAL_BARO_DEFAULT HAL_BARO_HIL
 #define HAL_COMPASS_DEFAULT HAL_COMPASS_HIL
+#endif
 
 #elif CONFIG_HAL_BOARD == HAL_BOARD_FLYMAPLE
 #define AP_HAL_BOARD_DRIVER AP_HAL_FLYMAPLE
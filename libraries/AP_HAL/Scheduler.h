@@ -10,7 +10,7 @@
 
 class AP_HAL::Scheduler {
 public:
-    Scheduler() {}
+    Scheduler() : _loop_start_valid(false) {}
     virtual void     init(void* implspecific) = 0;
     virtual void     delay(uint16_t ms) = 0;
     virtual uint32_t millis() = 0;
@@ -19,6 +19,13 @@ public:
     // offer non-wrapping 64 bit versions on faster CPUs
     virtual uint64_t millis64() = 0;
     virtual uint64_t micros64() = 0;
+
+    /**
+       monotonic time in nanoseconds, using only integer arithmetic.
+       Boards without a finer clock scale micros64(). Like the other
+       clocks this follows stop_clock() when the clock is stopped
+     */
+    virtual uint64_t nanos64() { return micros64() * 1000ULL; }
 #endif
     virtual void     delay_microseconds(uint16_t us) = 0;
     virtual void     register_delay_callback(AP_HAL::Proc,
@@ -52,8 +59,38 @@ public:
 
     /**
        optional function to stop clock at a given time, used by log replay
+       and benchmarks. Once called the clock is driven externally, only
+       moving on when stop_clock() is called again or by delay()
      */
     virtual void     stop_clock(uint64_t time_usec) {}
+
+    /**
+       record the start time of the current main loop. Code run from
+       the main loop that only needs the time to loop resolution can
+       then use loop_start_millis() rather than reading the clock.
+       Called by AP_Scheduler::loop_started() on the faster boards
+     */
+    void             set_loop_start_time(void) {
+        _loop_start_ms = millis();
+        _loop_start_valid = true;
+    }
+
+    // time the current main loop started, or the current time if the
+    // loop start isn't marked
+    uint32_t         loop_start_millis(void) { return _loop_start_valid ? _loop_start_ms : millis(); }
+
+    /**
+       optional function to run a low priority process at rate_hz in
+       its own thread, for work that is too slow to run in the main
+       loop and which the main loop must not wait for. The main loop
+       preempts it. Returns false if the board can't do this, in which
+       case the caller should keep running the work from the main loop
+     */
+    virtual bool     register_background_process(AP_HAL::Proc, uint16_t rate_hz) { return false; }
+
+private:
+    uint32_t _loop_start_ms;
+    bool     _loop_start_valid;
 };
 
 #endif // __AP_HAL_SCHEDULER_H__
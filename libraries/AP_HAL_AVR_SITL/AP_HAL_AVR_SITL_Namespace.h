@@ -13,6 +13,9 @@ namespace AVR_SITL {
     class ADCSource;
     class RCInput;
     class SITLUtil;
+    class SITLSPIDeviceDriver;
+    class SITLSPIDeviceManager;
+    class SITLI2CDriver;
 }
 
 #endif // __AP_HAL_AVR_SITL_NAMESPACE_H__
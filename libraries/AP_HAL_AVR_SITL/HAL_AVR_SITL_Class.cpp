@@ -17,6 +17,8 @@
 #include "RCOutput.h"
 #include "SITL_State.h"
 #include "Util.h"
+#include "SPIDriver.h"
+#include "I2CDriver.h"
 
 #include <AP_HAL_Empty.h>
 #include <AP_HAL_Empty_Private.h>
@@ -29,12 +31,11 @@ static SITL_State sitlState;
 static SITLRCInput  sitlRCInput(&sitlState);
 static SITLRCOutput sitlRCOutput(&sitlState);
 static SITLAnalogIn sitlAnalogIn(&sitlState);
+static SITLI2CDriver sitlI2C(&sitlState);
+static SITLSPIDeviceManager sitlSPI(&sitlState);
 
 // use the Empty HAL for hardware we don't emulate
 static Empty::EmptyGPIO emptyGPIO;
-static Empty::EmptySemaphore emptyI2Csemaphore;
-static Empty::EmptyI2CDriver emptyI2C(&emptyI2Csemaphore);
-static Empty::EmptySPIDeviceManager emptySPI;
 
 static SITLUARTDriver sitlUart0Driver(0, &sitlState);
 static SITLUARTDriver sitlUart1Driver(1, &sitlState);
@@ -51,8 +52,8 @@ HAL_AVR_SITL::HAL_AVR_SITL() :
         &sitlUart2Driver,  /* uartC */
         &sitlUart3Driver,  /* uartD */
         &sitlUart4Driver,  /* uartE */
-        &emptyI2C, /* i2c */
-        &emptySPI, /* spi */
+        &sitlI2C, /* i2c */
+        &sitlSPI, /* spi */
         &sitlAnalogIn, /* analogin */
         &sitlEEPROMStorage, /* storage */
         &sitlUart0Driver, /* console */
@@ -73,9 +74,9 @@ void HAL_AVR_SITL::init(int argc, char * const argv[]) const
     rcin->init(NULL);
     rcout->init(NULL);
 
-    //spi->init(NULL);
-    //i2c->begin();
-    //i2c->setTimeout(100);
+    spi->init(NULL);
+    i2c->begin();
+    i2c->setTimeout(100);
     analogin->init(NULL);
 }
 
@@ -0,0 +1,65 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#include <AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include "I2CDriver.h"
+#include "SITL_State.h"
+#include <string.h>
+
+using namespace AVR_SITL;
+
+/*
+  pass a transfer to the chip at addr, returning 0 on success like
+  the other I2C drivers
+ */
+uint8_t SITLI2CDriver::_transfer(uint8_t addr, const uint8_t *send, uint8_t send_len,
+                                 uint8_t *recv, uint8_t recv_len)
+{
+    I2CSlave *slave = _sitlState->i2c_device(addr);
+    if (slave == NULL || !slave->transfer(send, send_len, recv, recv_len)) {
+        if (recv != NULL) {
+            memset(recv, 0, recv_len);
+        }
+        return 1;
+    }
+    return 0;
+}
+
+uint8_t SITLI2CDriver::write(uint8_t addr, uint8_t len, uint8_t* data)
+{
+    return _transfer(addr, data, len, NULL, 0);
+}
+
+uint8_t SITLI2CDriver::writeRegister(uint8_t addr, uint8_t reg, uint8_t val)
+{
+    uint8_t buf[2] = { reg, val };
+    return _transfer(addr, buf, 2, NULL, 0);
+}
+
+uint8_t SITLI2CDriver::writeRegisters(uint8_t addr, uint8_t reg,
+                                      uint8_t len, uint8_t* data)
+{
+    uint8_t buf[len+1];
+    buf[0] = reg;
+    memcpy(&buf[1], data, len);
+    return _transfer(addr, buf, len+1, NULL, 0);
+}
+
+uint8_t SITLI2CDriver::read(uint8_t addr, uint8_t len, uint8_t* data)
+{
+    return _transfer(addr, NULL, 0, data, len);
+}
+
+uint8_t SITLI2CDriver::readRegister(uint8_t addr, uint8_t reg, uint8_t* data)
+{
+    return _transfer(addr, &reg, 1, data, 1);
+}
+
+uint8_t SITLI2CDriver::readRegisters(uint8_t addr, uint8_t reg,
+                                     uint8_t len, uint8_t* data)
+{
+    return _transfer(addr, &reg, 1, data, len);
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
@@ -0,0 +1,57 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#ifndef __AP_HAL_AVR_SITL_I2CDRIVER_H__
+#define __AP_HAL_AVR_SITL_I2CDRIVER_H__
+
+#include <AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+#include "AP_HAL_AVR_SITL_Namespace.h"
+#include "SIM_Device.h"
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_Empty_Private.h>
+
+/*
+  the simulated I2C bus, with the HMC5883L from SITL_State on it. A
+  transfer to any other address fails as if the chip did not
+  acknowledge
+ */
+class AVR_SITL::SITLI2CDriver : public AP_HAL::I2CDriver {
+public:
+    SITLI2CDriver(SITL_State *sitlState) : _sitlState(sitlState) {}
+    void begin() {}
+    void end() {}
+    void setTimeout(uint16_t ms) {}
+    void setHighSpeed(bool active) {}
+
+    /* write: for i2c devices which do not obey register conventions */
+    uint8_t write(uint8_t addr, uint8_t len, uint8_t* data);
+    /* writeRegister: write a single 8-bit value to a register */
+    uint8_t writeRegister(uint8_t addr, uint8_t reg, uint8_t val);
+    /* writeRegisters: write bytes to contigious registers */
+    uint8_t writeRegisters(uint8_t addr, uint8_t reg,
+                           uint8_t len, uint8_t* data);
+
+    /* read: for i2c devices which do not obey register conventions */
+    uint8_t read(uint8_t addr, uint8_t len, uint8_t* data);
+    /* readRegister: read from a device register - writes the register,
+     * then reads back an 8-bit value. */
+    uint8_t readRegister(uint8_t addr, uint8_t reg, uint8_t* data);
+    /* readRegisters: read contigious device registers - writes the first
+     * register, then reads back multiple bytes */
+    uint8_t readRegisters(uint8_t addr, uint8_t reg,
+                          uint8_t len, uint8_t* data);
+
+    uint8_t lockup_count() { return 0; }
+
+    AP_HAL::Semaphore* get_semaphore() { return &_semaphore; }
+
+private:
+    uint8_t _transfer(uint8_t addr, const uint8_t *send, uint8_t send_len,
+                      uint8_t *recv, uint8_t recv_len);
+
+    SITL_State *_sitlState;
+    Empty::EmptySemaphore _semaphore;
+};
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+#endif // __AP_HAL_AVR_SITL_I2CDRIVER_H__
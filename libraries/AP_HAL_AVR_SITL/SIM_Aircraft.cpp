@@ -0,0 +1,223 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  parent class for the built in flight dynamics models of SITL
+ */
+
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include "SIM_Aircraft.h"
+#include "SIM_Multicopter.h"
+#include "SIM_Plane.h"
+#include "SIM_Rover.h"
+#include "SITL_Random.h"
+
+#include <stdio.h>
+#include <string.h>
+
+using namespace AVR_SITL;
+
+// time constant of the wind turbulence random walk, seconds
+#define SIM_TURBULENCE_TIME_CONSTANT 5.0f
+
+/*
+  the home string is "lat,lng,alt,heading", the same format as
+  Tools/autotest/locations.txt
+ */
+Aircraft::Aircraft(const char *home_str) :
+    _home_lat(0),
+    _home_lng(0),
+    _home_alt(0),
+    _ground_level(0),
+    _frame_height(0),
+    _home_valid(false),
+    _airspeed(0),
+    _mass(0),
+    _turbulence_mul(1.0f),
+    _random_seed(0),
+    _random_index(0)
+{
+    float yaw_degrees = 0;
+    if (home_str != NULL &&
+        sscanf(home_str, "%lf,%lf,%f,%f", &_home_lat, &_home_lng, &_home_alt, &yaw_degrees) == 4) {
+        _home_valid = true;
+    }
+    _ground_level = _home_alt;
+    _dcm.from_euler(0, 0, radians(yaw_degrees));
+}
+
+/*
+  create a model given its name
+ */
+Aircraft *Aircraft::create(const char *model_str, const char *home_str)
+{
+    if (strcmp(model_str, "plane") == 0) {
+        return new Plane(home_str);
+    }
+    if (strcmp(model_str, "rover") == 0) {
+        return new Rover(home_str, false);
+    }
+    if (strcmp(model_str, "rover-skid") == 0) {
+        return new Rover(home_str, true);
+    }
+    if (MultiCopter::frame_valid(model_str)) {
+        return new MultiCopter(home_str, model_str);
+    }
+    return NULL;
+}
+
+/*
+  return true if we are on the ground. The heights are compared
+  relative to home, as float AMSL altitudes lose the small steps made
+  on lifting off
+ */
+bool Aircraft::on_ground(const Vector3f &pos) const
+{
+    return -pos.z <= ground_height();
+}
+
+/*
+  a sample from a normal distribution, by the Box-Muller method
+ */
+float Aircraft::rand_normal(float mean, float stddev)
+{
+    float u1 = 0.5f * (1.0f + sitl_random_float(_random_seed, SITL_RANDOM_WIND, _random_index++));
+    float u2 = 0.5f * (1.0f + sitl_random_float(_random_seed, SITL_RANDOM_WIND, _random_index++));
+    if (u1 < 1.0e-7f) {
+        u1 = 1.0e-7f;
+    }
+    return mean + stddev * sqrtf(-2.0f * logf(u1)) * cosf(2 * PI * u2);
+}
+
+/*
+  update the wind vector. The speed is scaled by a random walk
+  multiplier which decays back towards 1, as in pysim/util.py
+ */
+void Aircraft::update_wind(const struct sitl_input &input, float delta_time)
+{
+    float w_delta = sqrtf(delta_time) * (1.0f - rand_normal(1.0f, input.wind.turbulence));
+    w_delta -= (_turbulence_mul - 1.0f) * (delta_time / SIM_TURBULENCE_TIME_CONSTANT);
+    _turbulence_mul += w_delta;
+
+    float speed = input.wind.speed * fabsf(_turbulence_mul);
+    float direction = radians(input.wind.direction);
+    _wind_ef = Vector3f(-speed * cosf(direction), -speed * sinf(direction), 0);
+}
+
+/*
+  keep the rotation matrix orthonormal after it has been rotated
+ */
+static void dcm_normalize(Matrix3f &m)
+{
+    float error = m.a * m.b;
+    Vector3f t0 = m.a - (m.b * (0.5f * error));
+    Vector3f t1 = m.b - (m.a * (0.5f * error));
+    Vector3f t2 = t0 % t1;
+    m.a = t0 * (1.0f / t0.length());
+    m.b = t1 * (1.0f / t1.length());
+    m.c = t2 * (1.0f / t2.length());
+}
+
+/*
+  move the vehicle on by delta_time given its earth frame
+  acceleration. Attitude is updated from _gyro, and contact with the
+  ground is handled by ground_contact()
+ */
+void Aircraft::update_dynamics(const Vector3f &accel, float delta_time)
+{
+    Vector3f accel_earth = accel;
+
+    // update attitude
+    _dcm.rotate(_gyro * delta_time);
+    dcm_normalize(_dcm);
+
+    // if we're on the ground, then our vertical acceleration is limited
+    // to zero. This effectively adds the force of the ground on the aircraft
+    if (on_ground(_position) && accel_earth.z > 0) {
+        accel_earth.z = 0;
+    }
+
+    // work out acceleration as seen by the accelerometers. It sees the kinematic
+    // acceleration (ie. real movement), plus gravity
+    _accel_body = _dcm.mul_transpose(accel_earth + Vector3f(0, 0, -GRAVITY_MSS));
+
+    // new velocity and position vectors
+    Vector3f old_position = _position;
+    _velocity_ef += accel_earth * delta_time;
+    _position += _velocity_ef * delta_time;
+
+    // constrain height to the ground
+    if (on_ground(_position)) {
+        if (!on_ground(old_position) && _velocity_ef.z > 1.0f) {
+            printf("Hit ground at %f m/s\n", _velocity_ef.z);
+        }
+        _position.z = -ground_height();
+        ground_contact();
+    }
+}
+
+/*
+  default ground handling: the vehicle stops dead and sits level,
+  keeping its heading
+ */
+void Aircraft::ground_contact(void)
+{
+    float roll, pitch, yaw;
+    _velocity_ef.zero();
+    _dcm.to_euler(&roll, &pitch, &yaw);
+    _dcm.from_euler(0, 0, yaw);
+}
+
+/*
+  fill in a FDM packet, in the same form as the UDP simulators send it
+ */
+void Aircraft::fill_fdm(struct sitl_fdm &fdm) const
+{
+    float roll, pitch, yaw;
+    _dcm.to_euler(&roll, &pitch, &yaw);
+
+    // small offsets from home, on a flat earth
+    fdm.latitude  = _home_lat + (_position.x / RADIUS_OF_EARTH) * RAD_TO_DEG_DOUBLE;
+    fdm.longitude = _home_lng + (_position.y / (RADIUS_OF_EARTH * cos(_home_lat * DEG_TO_RAD_DOUBLE))) * RAD_TO_DEG_DOUBLE;
+    fdm.altitude  = _home_alt - _position.z;
+    fdm.heading   = degrees(yaw);
+    fdm.speedN    = _velocity_ef.x;
+    fdm.speedE    = _velocity_ef.y;
+    fdm.speedD    = _velocity_ef.z;
+    fdm.xAccel    = _accel_body.x;
+    fdm.yAccel    = _accel_body.y;
+    fdm.zAccel    = _accel_body.z;
+
+    // the FDM packet carries euler angle rates
+    float cos_pitch = cosf(pitch);
+    if (fabsf(cos_pitch) < 1.0e-6f) {
+        cos_pitch = 1.0e-6f;
+    }
+    float q_r = _gyro.y * sinf(roll) + _gyro.z * cosf(roll);
+    fdm.rollRate  = degrees(_gyro.x + tanf(pitch) * q_r);
+    fdm.pitchRate = degrees(_gyro.y * cosf(roll) - _gyro.z * sinf(roll));
+    fdm.yawRate   = degrees(q_r / cos_pitch);
+
+    fdm.rollDeg   = degrees(roll);
+    fdm.pitchDeg  = degrees(pitch);
+    fdm.yawDeg    = degrees(yaw);
+    fdm.airspeed  = _airspeed;
+    fdm.magic     = 0x4c56414f;
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
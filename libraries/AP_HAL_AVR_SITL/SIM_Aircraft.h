@@ -0,0 +1,112 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  parent class for the built in flight dynamics models of SITL. The
+  models are stepped directly by SITL_State, in place of an external
+  simulator talking over UDP
+ */
+
+#ifndef __AP_HAL_AVR_SITL_SIM_AIRCRAFT_H__
+#define __AP_HAL_AVR_SITL_SIM_AIRCRAFT_H__
+
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include <AP_Math.h>
+#include "../SITL/SITL.h"
+
+namespace AVR_SITL {
+
+class Aircraft {
+public:
+    Aircraft(const char *home_str);
+    virtual ~Aircraft() {}
+
+    // inputs to a model, as produced by the firmware and the SITL parameters
+    struct sitl_input {
+        uint16_t servos[11];    // PWM outputs in microseconds
+        struct {
+            float speed;        // m/s
+            float direction;    // degrees, the direction the wind is coming from
+            float turbulence;   // turbulence factor, the standard deviation of the speed multiplier
+        } wind;
+    };
+
+    // step the model by delta_time seconds
+    virtual void update(const struct sitl_input &input, float delta_time) = 0;
+
+    // fill in a FDM packet from the model state
+    void fill_fdm(struct sitl_fdm &fdm) const;
+
+    // body frame rotation rates in rad/s and the acceleration seen by
+    // the accelerometers in m/s/s
+    const Vector3f &get_gyro(void) const { return _gyro; }
+    const Vector3f &get_accel_body(void) const { return _accel_body; }
+
+    // seed the random numbers used for turbulence
+    void set_seed(uint32_t seed) { _random_seed = seed; }
+
+    // true if the home string could be parsed
+    bool home_valid(void) const { return _home_valid; }
+
+    // create a model by name, returning NULL if the name is unknown
+    static Aircraft *create(const char *model_str, const char *home_str);
+
+protected:
+    // true if the given position, relative to home, is on the ground
+    bool on_ground(const Vector3f &pos) const;
+
+    // height of the sensors above home when on the ground, meters
+    float ground_height(void) const { return _ground_level + _frame_height - _home_alt; }
+
+    // move the vehicle on by delta_time given its earth frame
+    // acceleration, and handle contact with the ground
+    void update_dynamics(const Vector3f &accel_earth, float delta_time);
+
+    // called by update_dynamics() when the vehicle is on the ground
+    virtual void ground_contact(void);
+
+    // a sample from a normal distribution
+    float rand_normal(float mean, float stddev);
+
+    // update the wind vector, including turbulence
+    void update_wind(const struct sitl_input &input, float delta_time);
+
+    double      _home_lat;          // degrees
+    double      _home_lng;          // degrees
+    float       _home_alt;          // meters AMSL
+    float       _ground_level;      // meters AMSL
+    float       _frame_height;      // height of the sensors above the ground when landed, meters
+    bool        _home_valid;
+
+    Matrix3f    _dcm;               // body to earth rotation
+    Vector3f    _gyro;              // body frame rotation rates, rad/s
+    Vector3f    _velocity_ef;       // earth frame velocity, m/s NED
+    Vector3f    _position;          // position relative to home, meters NED
+    Vector3f    _accel_body;        // acceleration seen by the accelerometers, m/s/s
+    Vector3f    _wind_ef;           // earth frame wind velocity, m/s NED
+    float       _airspeed;          // m/s
+    float       _mass;              // kg
+    float       _turbulence_mul;    // random walk multiplier on the wind speed
+    uint32_t    _random_seed;
+    uint64_t    _random_index;
+};
+
+} // namespace AVR_SITL
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+#endif // __AP_HAL_AVR_SITL_SIM_AIRCRAFT_H__
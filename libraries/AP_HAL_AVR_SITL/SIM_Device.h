@@ -0,0 +1,49 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  interfaces for the simulated sensor chips on the SITL SPI and I2C
+  buses. The chips are modelled at the register level, so the real
+  sensor drivers can talk to them
+ */
+
+#ifndef __AP_HAL_AVR_SITL_SIM_DEVICE_H__
+#define __AP_HAL_AVR_SITL_SIM_DEVICE_H__
+
+#include <stdint.h>
+
+namespace AVR_SITL {
+
+class SPISlave {
+public:
+    // chip select has been asserted, starting a new command
+    virtual void cs_assert(void) = 0;
+
+    // clock one byte to the chip, returning the byte clocked back
+    virtual uint8_t transfer(uint8_t tx) = 0;
+};
+
+class I2CSlave {
+public:
+    // a write of send_len bytes, then a read of recv_len bytes
+    // with a repeated start. Returns false if the chip does not
+    // acknowledge
+    virtual bool transfer(const uint8_t *send, uint8_t send_len,
+                          uint8_t *recv, uint8_t recv_len) = 0;
+};
+
+} // namespace AVR_SITL
+
+#endif // __AP_HAL_AVR_SITL_SIM_DEVICE_H__
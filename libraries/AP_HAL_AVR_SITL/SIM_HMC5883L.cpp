@@ -0,0 +1,178 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  HMC5883L simulator class
+
+  The configuration, gain, measurement modes, self test bias fields,
+  output rate and overflow handling are modelled. The driver reports
+  the field in units of 1/660 Gauss (see the note on gain_multiple in
+  AP_Compass_HMC5843.cpp), so the field is given to the model in those
+  units, which keeps the compass offsets in the SITL parameter files
+  valid. The chip is mounted so that the fixed rotation in the driver
+  gives the body frame
+ */
+
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include "SIM_HMC5883L.h"
+#include <string.h>
+
+using namespace AVR_SITL;
+
+extern const AP_HAL::HAL& hal;
+
+#define ConfigRegA      0x00
+#define ConfigRegB      0x01
+#define ModeRegister    0x02
+#define DataOutputXMSB  0x03
+#define DataOutputZMSB  0x05
+#define DataOutputYMSB  0x07
+#define StatusRegister  0x09
+#       define StatusReady  0x01
+#define NUM_REGISTERS   13
+
+#define ModeContinuous  0x00
+#define ModeSingle      0x01
+#define ModeIdle        0x03
+
+#define FIELD_UNITS_PER_GAUSS 660.0f
+
+HMC5883L::HMC5883L() :
+    _pointer(0),
+    _last_measurement_usec(0)
+{
+    memset(_regs, 0, sizeof(_regs));
+    _regs[ConfigRegA] = 0x10;
+    _regs[ConfigRegB] = 0x20;
+    _regs[ModeRegister] = ModeSingle;
+    _regs[10] = 'H';
+    _regs[11] = '4';
+    _regs[12] = '3';
+}
+
+// store a measurement as a big endian register pair, with -4096
+// marking an overflow as on the real chip
+static void put_axis(uint8_t *p, float v)
+{
+    int16_t i = -4096;
+    if (v >= -2048 && v <= 2047) {
+        i = v;
+    }
+    p[0] = (uint16_t)i >> 8;
+    p[1] = (uint16_t)i & 0xFF;
+}
+
+/*
+  take a measurement, using the self test field if a bias is selected
+ */
+void HMC5883L::measure(void)
+{
+    static const uint16_t lsb_per_gauss[8] = { 1370, 1090, 820, 660, 440, 390, 330, 230 };
+    float gain = lsb_per_gauss[_regs[ConfigRegB] >> 5];
+
+    Vector3f gauss;
+    switch (_regs[ConfigRegA] & 0x03) {
+    case 1:
+        // positive bias. The datasheet gives 1.16 Gauss on all
+        // axes, but the driver expects 1.08 on Y and Z
+        gauss = Vector3f(1.16f, 1.08f, 1.08f);
+        break;
+    case 2:
+        gauss = Vector3f(-1.16f, -1.08f, -1.08f);
+        break;
+    default:
+        gauss = Vector3f(-_field.y, -_field.x, -_field.z) / FIELD_UNITS_PER_GAUSS;
+        break;
+    }
+
+    // the data registers are in X, Z, Y order
+    put_axis(&_regs[DataOutputXMSB], gauss.x * gain);
+    put_axis(&_regs[DataOutputZMSB], gauss.z * gain);
+    put_axis(&_regs[DataOutputYMSB], gauss.y * gain);
+    _regs[StatusRegister] |= StatusReady;
+    _last_measurement_usec = hal.scheduler->micros64();
+}
+
+/*
+  take a new measurement if one is due in continuous mode
+ */
+void HMC5883L::update_measurement(void)
+{
+    if ((_regs[ModeRegister] & 0x03) != ModeContinuous) {
+        return;
+    }
+    static const uint32_t period_usec[8] = { 1333333, 666667, 333333, 133333,
+                                             66667, 33333, 13333, 13333 };
+    uint32_t period = period_usec[(_regs[ConfigRegA] >> 2) & 0x07];
+    if (_last_measurement_usec == 0 ||
+        hal.scheduler->micros64() - _last_measurement_usec >= period) {
+        measure();
+    }
+}
+
+void HMC5883L::write_register(uint8_t reg, uint8_t val)
+{
+    switch (reg) {
+    case ConfigRegA:
+    case ConfigRegB:
+        _regs[reg] = val;
+        break;
+    case ModeRegister:
+        _regs[reg] = val;
+        if ((val & 0x03) == ModeSingle) {
+            // one measurement, then idle
+            measure();
+            _regs[reg] = (val & ~0x03) | ModeIdle;
+        } else if ((val & 0x03) == ModeContinuous) {
+            _last_measurement_usec = 0;
+        }
+        break;
+    default:
+        // read only
+        break;
+    }
+}
+
+/*
+  an I2C transfer. The first byte sent sets the register pointer, and
+  the pointer increments for each byte written or read after it
+ */
+bool HMC5883L::transfer(const uint8_t *send, uint8_t send_len,
+                        uint8_t *recv, uint8_t recv_len)
+{
+    if (send_len > 0) {
+        _pointer = send[0] % NUM_REGISTERS;
+        for (uint8_t i=1; i<send_len; i++) {
+            write_register(_pointer, send[i]);
+            _pointer = (_pointer + 1) % NUM_REGISTERS;
+        }
+    }
+    if (recv_len > 0 && _pointer >= DataOutputXMSB && _pointer <= StatusRegister) {
+        update_measurement();
+    }
+    for (uint8_t i=0; i<recv_len; i++) {
+        recv[i] = _regs[_pointer];
+        if (_pointer >= DataOutputXMSB && _pointer < StatusRegister) {
+            _regs[StatusRegister] &= ~StatusReady;
+        }
+        _pointer = (_pointer + 1) % NUM_REGISTERS;
+    }
+    return true;
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
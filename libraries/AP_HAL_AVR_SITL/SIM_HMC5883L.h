@@ -0,0 +1,58 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  register level model of a Honeywell HMC5883L magnetometer on the
+  I2C bus, as driven by AP_Compass_HMC5843
+ */
+
+#ifndef __AP_HAL_AVR_SITL_SIM_HMC5883L_H__
+#define __AP_HAL_AVR_SITL_SIM_HMC5883L_H__
+
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include <AP_Math.h>
+#include "SIM_Device.h"
+
+namespace AVR_SITL {
+
+class HMC5883L : public I2CSlave {
+public:
+    HMC5883L();
+
+    bool transfer(const uint8_t *send, uint8_t send_len,
+                  uint8_t *recv, uint8_t recv_len);
+
+    // set the body frame field that the next measurements will
+    // show, in the units AP_Compass_HMC5843 reports
+    void set_field(const Vector3f &field) { _field = field; }
+
+private:
+    void write_register(uint8_t reg, uint8_t val);
+    void measure(void);
+    void update_measurement(void);
+
+    uint8_t     _regs[13];
+    uint8_t     _pointer;
+    Vector3f    _field;
+    uint64_t    _last_measurement_usec;
+};
+
+} // namespace AVR_SITL
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+#endif // __AP_HAL_AVR_SITL_SIM_HMC5883L_H__
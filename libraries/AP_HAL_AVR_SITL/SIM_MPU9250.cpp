@@ -0,0 +1,174 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  MPU9250 simulator class
+
+  The sensor registers, sample clock, full scale settings and data
+  ready handling are modelled. The low pass filter in the chip is
+  not, so the samples are the values last given to set_accel() and
+  set_gyro(). The chip is mounted so that the fixed rotation in
+  AP_InertialSensor_MPU9250 gives the body frame
+ */
+
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include "SIM_MPU9250.h"
+#include <string.h>
+
+using namespace AVR_SITL;
+
+extern const AP_HAL::HAL& hal;
+
+#define MPUREG_SMPLRT_DIV       0x19
+#define MPUREG_CONFIG           0x1A
+#define MPUREG_GYRO_CONFIG      0x1B
+#define MPUREG_ACCEL_CONFIG     0x1C
+#define MPUREG_INT_PIN_CFG      0x37
+#       define BIT_INT_RD_CLEAR     0x10
+#define MPUREG_INT_STATUS       0x3A
+#       define BIT_RAW_RDY_INT      0x01
+#define MPUREG_ACCEL_XOUT_H     0x3B
+#define MPUREG_TEMP_OUT_H       0x41
+#define MPUREG_GYRO_XOUT_H      0x43
+#define MPUREG_GYRO_ZOUT_L      0x48
+#define MPUREG_PWR_MGMT_1       0x6B
+#       define BIT_PWR_MGMT_1_SLEEP         0x40
+#       define BIT_PWR_MGMT_1_DEVICE_RESET  0x80
+#define MPUREG_WHOAMI           0x75
+#       define MPU9250_WHOAMI       0x71
+
+MPU9250::MPU9250() :
+    _temperature(25),
+    _last_sample_usec(0),
+    _byte_count(0),
+    _reg(0),
+    _is_read(false)
+{
+    reset();
+}
+
+/*
+  power on state of the registers
+ */
+void MPU9250::reset(void)
+{
+    memset(_regs, 0, sizeof(_regs));
+    _regs[MPUREG_PWR_MGMT_1] = BIT_PWR_MGMT_1_SLEEP;
+    _regs[MPUREG_WHOAMI] = MPU9250_WHOAMI;
+}
+
+void MPU9250::write_register(uint8_t reg, uint8_t val)
+{
+    if (reg == MPUREG_PWR_MGMT_1 && (val & BIT_PWR_MGMT_1_DEVICE_RESET)) {
+        reset();
+        return;
+    }
+    if (reg == MPUREG_WHOAMI ||
+        (reg >= MPUREG_INT_STATUS && reg <= MPUREG_GYRO_ZOUT_L)) {
+        // read only
+        return;
+    }
+    _regs[reg] = val;
+}
+
+/*
+  the sample period, from the sample rate divider and the gyro
+  output rate, which is 8kHz with the low pass filter off and 1kHz
+  with it on
+ */
+uint32_t MPU9250::sample_period_usec(void) const
+{
+    uint8_t dlpf_cfg = _regs[MPUREG_CONFIG] & 0x07;
+    uint32_t base_usec = (dlpf_cfg == 0 || dlpf_cfg == 7) ? 125 : 1000;
+    return base_usec * (1 + _regs[MPUREG_SMPLRT_DIV]);
+}
+
+// store a sample as a big endian 16 bit register pair, saturating
+// like the chip does
+static void put_int16(uint8_t *p, float v)
+{
+    int16_t i = constrain_float(v, -32768, 32767);
+    p[0] = (uint16_t)i >> 8;
+    p[1] = (uint16_t)i & 0xFF;
+}
+
+/*
+  load a new sample into the data registers if one is due
+ */
+void MPU9250::update_sample(void)
+{
+    if (_regs[MPUREG_PWR_MGMT_1] & BIT_PWR_MGMT_1_SLEEP) {
+        return;
+    }
+    uint64_t now = hal.scheduler->micros64();
+    if (_last_sample_usec != 0 && now - _last_sample_usec < sample_period_usec()) {
+        return;
+    }
+    _last_sample_usec = now;
+
+    static const float gyro_lsb_per_dps[4] = { 131.0f, 65.5f, 32.8f, 16.4f };
+    float accel_lsb = (16384 >> ((_regs[MPUREG_ACCEL_CONFIG] >> 3) & 3)) / GRAVITY_MSS;
+    float gyro_lsb = gyro_lsb_per_dps[(_regs[MPUREG_GYRO_CONFIG] >> 3) & 3] * RAD_TO_DEG;
+
+    put_int16(&_regs[MPUREG_ACCEL_XOUT_H],   _accel.x * accel_lsb);
+    put_int16(&_regs[MPUREG_ACCEL_XOUT_H+2], _accel.y * accel_lsb);
+    put_int16(&_regs[MPUREG_ACCEL_XOUT_H+4], _accel.z * accel_lsb);
+    put_int16(&_regs[MPUREG_TEMP_OUT_H],     (_temperature - 21) * 333.87f);
+    put_int16(&_regs[MPUREG_GYRO_XOUT_H],    _gyro.x * gyro_lsb);
+    put_int16(&_regs[MPUREG_GYRO_XOUT_H+2],  _gyro.y * gyro_lsb);
+    put_int16(&_regs[MPUREG_GYRO_XOUT_H+4],  _gyro.z * gyro_lsb);
+
+    _regs[MPUREG_INT_STATUS] |= BIT_RAW_RDY_INT;
+}
+
+void MPU9250::cs_assert(void)
+{
+    _byte_count = 0;
+}
+
+/*
+  clock a byte over SPI. The first byte of a transfer is the register,
+  with the top bit set for a read, and the register address increments
+  for each byte after it
+ */
+uint8_t MPU9250::transfer(uint8_t tx)
+{
+    if (_byte_count++ == 0) {
+        _reg = tx & 0x7F;
+        _is_read = (tx & 0x80) != 0;
+        if (_is_read && _reg >= MPUREG_INT_STATUS && _reg <= MPUREG_GYRO_ZOUT_L) {
+            // a burst read of the data registers gives one sample
+            update_sample();
+        }
+        return 0;
+    }
+
+    uint8_t reg = _reg;
+    _reg = (_reg + 1) & 0x7F;
+    if (!_is_read) {
+        write_register(reg, tx);
+        return 0;
+    }
+    uint8_t ret = _regs[reg];
+    if (reg == MPUREG_INT_STATUS || (_regs[MPUREG_INT_PIN_CFG] & BIT_INT_RD_CLEAR)) {
+        _regs[MPUREG_INT_STATUS] = 0;
+    }
+    return ret;
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
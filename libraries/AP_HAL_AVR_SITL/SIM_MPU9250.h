@@ -0,0 +1,65 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  register level model of an InvenSense MPU9250 on the SPI bus
+ */
+
+#ifndef __AP_HAL_AVR_SITL_SIM_MPU9250_H__
+#define __AP_HAL_AVR_SITL_SIM_MPU9250_H__
+
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include <AP_Math.h>
+#include "SIM_Device.h"
+
+namespace AVR_SITL {
+
+class MPU9250 : public SPISlave {
+public:
+    MPU9250();
+
+    void cs_assert(void);
+    uint8_t transfer(uint8_t tx);
+
+    // set the body frame acceleration in m/s/s and rotation rates in
+    // rad/s that the next samples will show
+    void set_accel(const Vector3f &accel) { _accel = accel; }
+    void set_gyro(const Vector3f &gyro) { _gyro = gyro; }
+
+private:
+    void reset(void);
+    void write_register(uint8_t reg, uint8_t val);
+    void update_sample(void);
+    uint32_t sample_period_usec(void) const;
+
+    uint8_t     _regs[128];
+    Vector3f    _accel;
+    Vector3f    _gyro;
+    float       _temperature;       // degrees C
+    uint64_t    _last_sample_usec;
+
+    // state of the current SPI transfer
+    uint16_t    _byte_count;
+    uint8_t     _reg;
+    bool        _is_read;
+};
+
+} // namespace AVR_SITL
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+#endif // __AP_HAL_AVR_SITL_SIM_MPU9250_H__
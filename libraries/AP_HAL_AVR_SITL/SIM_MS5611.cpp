@@ -0,0 +1,192 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  MS5611 simulator class
+
+  The PROM holds the example calibration from the datasheet, with a
+  valid CRC. Conversions take the datasheet maximum time for their
+  oversampling ratio, and an ADC read before a conversion has finished
+  gives zero, as on the real chip. The raw values are found by running
+  the compensation from the datasheet backwards
+ */
+
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include "SIM_MS5611.h"
+#include <AP_Math.h>
+#include <string.h>
+
+using namespace AVR_SITL;
+
+extern const AP_HAL::HAL& hal;
+
+#define CMD_MS5611_RESET        0x1E
+#define CMD_MS5611_CONVERT_D1   0x40
+#define CMD_MS5611_CONVERT_D2   0x50
+#define CMD_MS5611_ADC_READ     0x00
+#define CMD_MS5611_PROM_READ    0xA0
+
+MS5611::MS5611() :
+    _conversion(CONVERSION_NONE),
+    _conversion_done_usec(0),
+    _pressure(101325),
+    _temperature(20),
+    _byte_count(0)
+{
+    _prom[0] = 0;
+    _prom[1] = 40127;
+    _prom[2] = 36924;
+    _prom[3] = 23317;
+    _prom[4] = 23282;
+    _prom[5] = 33464;
+    _prom[6] = 28312;
+    _prom[7] = 0;
+    _prom[7] = crc4(_prom);
+}
+
+/*
+  the 4 bit CRC of the PROM, from AN520
+ */
+uint8_t MS5611::crc4(const uint16_t prom[8])
+{
+    uint16_t n_rem = 0;
+    for (uint8_t cnt = 0; cnt < 16; cnt++) {
+        uint16_t word = prom[cnt >> 1];
+        if (cnt == 15) {
+            // the CRC itself is not included
+            word &= 0xFF00;
+        }
+        if (cnt & 1) {
+            n_rem ^= (uint8_t)(word & 0x00FF);
+        } else {
+            n_rem ^= (uint8_t)(word >> 8);
+        }
+        for (uint8_t n_bit = 8; n_bit > 0; n_bit--) {
+            if (n_rem & 0x8000) {
+                n_rem = (n_rem << 1) ^ 0x3000;
+            } else {
+                n_rem = (n_rem << 1);
+            }
+        }
+    }
+    return (n_rem >> 12) & 0x0F;
+}
+
+/*
+  the raw pressure (D1) and temperature (D2) that the compensation in
+  the datasheet turns into the current pressure and temperature
+ */
+void MS5611::raw_values(uint32_t &D1, uint32_t &D2) const
+{
+    const double C1 = _prom[1], C2 = _prom[2], C3 = _prom[3];
+    const double C4 = _prom[4], C5 = _prom[5], C6 = _prom[6];
+
+    // TEMP is hundredths of a degree relative to 20C. Below 20C the
+    // second order term depends on dT, so iterate to find dT
+    double target = (_temperature - 20) * 100;
+    double dT = target * 8388608.0 / C6;
+    if (target < 0) {
+        for (uint8_t i=0; i<5; i++) {
+            dT = (target + dT*dT / 2147483648.0) * 8388608.0 / C6;
+        }
+    }
+    double TEMP = dT * C6 / 8388608.0;
+    double OFF = C2 * 65536.0 + (C4 * dT) / 128;
+    double SENS = C1 * 32768.0 + (C3 * dT) / 256;
+    if (TEMP < 0) {
+        double Aux = TEMP * TEMP;
+        OFF -= 2.5 * Aux;
+        SENS -= 1.25 * Aux;
+    }
+
+    double d1 = (_pressure * 32768.0 + OFF) * 2097152.0 / SENS;
+    double d2 = dT + C5 * 256;
+    D1 = constrain_float(d1, 0, 0xFFFFFF);
+    D2 = constrain_float(d2, 0, 0xFFFFFF);
+}
+
+void MS5611::start_conversion(enum conversion type, uint8_t osr)
+{
+    // maximum conversion times for OSR 256 to 4096
+    static const uint16_t conversion_usec[5] = { 600, 1170, 2280, 4540, 9040 };
+    if (osr > 4) {
+        osr = 4;
+    }
+    _conversion = type;
+    _conversion_done_usec = hal.scheduler->micros64() + conversion_usec[osr];
+}
+
+uint32_t MS5611::read_adc(void)
+{
+    if (_conversion == CONVERSION_NONE ||
+        hal.scheduler->micros64() < _conversion_done_usec) {
+        // no conversion, or it is still running
+        return 0;
+    }
+    uint32_t D1, D2;
+    raw_values(D1, D2);
+    uint32_t ret = (_conversion == CONVERSION_D1) ? D1 : D2;
+    _conversion = CONVERSION_NONE;
+    return ret;
+}
+
+/*
+  start a command, setting up the bytes of any reply
+ */
+void MS5611::command(uint8_t cmd)
+{
+    memset(_reply, 0, sizeof(_reply));
+
+    if (cmd == CMD_MS5611_RESET) {
+        _conversion = CONVERSION_NONE;
+    } else if ((cmd & 0xF0) == CMD_MS5611_CONVERT_D1) {
+        start_conversion(CONVERSION_D1, (cmd & 0x0F) >> 1);
+    } else if ((cmd & 0xF0) == CMD_MS5611_CONVERT_D2) {
+        start_conversion(CONVERSION_D2, (cmd & 0x0F) >> 1);
+    } else if (cmd == CMD_MS5611_ADC_READ) {
+        uint32_t adc = read_adc();
+        _reply[0] = adc >> 16;
+        _reply[1] = adc >> 8;
+        _reply[2] = adc;
+    } else if ((cmd & 0xF0) == CMD_MS5611_PROM_READ) {
+        uint16_t word = _prom[(cmd >> 1) & 7];
+        _reply[0] = word >> 8;
+        _reply[1] = word;
+    }
+}
+
+void MS5611::cs_assert(void)
+{
+    _byte_count = 0;
+}
+
+/*
+  clock a byte over SPI. The first byte of a transfer is the command,
+  and the reply follows it
+ */
+uint8_t MS5611::transfer(uint8_t tx)
+{
+    if (_byte_count++ == 0) {
+        command(tx);
+        return 0;
+    }
+    uint16_t idx = _byte_count - 2;
+    return idx < sizeof(_reply) ? _reply[idx] : 0;
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
@@ -0,0 +1,73 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  command level model of a Measurement Specialties MS5611 barometer
+  on the SPI bus
+ */
+
+#ifndef __AP_HAL_AVR_SITL_SIM_MS5611_H__
+#define __AP_HAL_AVR_SITL_SIM_MS5611_H__
+
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include "SIM_Device.h"
+
+namespace AVR_SITL {
+
+class MS5611 : public SPISlave {
+public:
+    MS5611();
+
+    void cs_assert(void);
+    uint8_t transfer(uint8_t tx);
+
+    // set the pressure in Pascal and temperature in degrees C that
+    // the next conversions will measure
+    void set_pressure(float pressure, float temperature) {
+        _pressure = pressure;
+        _temperature = temperature;
+    }
+
+private:
+    enum conversion {
+        CONVERSION_NONE,
+        CONVERSION_D1,
+        CONVERSION_D2
+    };
+
+    void command(uint8_t cmd);
+    void start_conversion(enum conversion type, uint8_t osr);
+    uint32_t read_adc(void);
+    void raw_values(uint32_t &D1, uint32_t &D2) const;
+    static uint8_t crc4(const uint16_t prom[8]);
+
+    uint16_t        _prom[8];
+    enum conversion _conversion;
+    uint64_t        _conversion_done_usec;
+    float           _pressure;      // Pa
+    float           _temperature;   // degrees C
+
+    // state of the current SPI transfer
+    uint16_t        _byte_count;
+    uint8_t         _reply[3];
+};
+
+} // namespace AVR_SITL
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+#endif // __AP_HAL_AVR_SITL_SIM_MS5611_H__
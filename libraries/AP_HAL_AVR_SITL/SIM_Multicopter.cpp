@@ -0,0 +1,189 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  multicopter simulator class
+ */
+
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include "SIM_Multicopter.h"
+#include <string.h>
+
+using namespace AVR_SITL;
+
+// maximum rotational accelerations from the motors, degrees/s/s
+#define MULTICOPTER_ROLL_PITCH_ACCEL    5000.0f
+#define MULTICOPTER_YAW_ACCEL           400.0f
+
+static const MultiCopter::motor quad_plus_motors[] = {
+    {  90, false,  1 },
+    { 270, false,  2 },
+    {   0, true,   3 },
+    { 180, true,   4 },
+};
+
+static const MultiCopter::motor quad_x_motors[] = {
+    {  45, false,  1 },
+    { 225, false,  2 },
+    { -45, true,   3 },
+    { 135, true,   4 },
+};
+
+static const MultiCopter::motor y6_motors[] = {
+    {  60, false,  1 },
+    {  60, true,   7 },
+    { 180, true,   4 },
+    { 180, false,  8 },
+    { -60, true,   2 },
+    { -60, false,  3 },
+};
+
+static const MultiCopter::motor hexa_motors[] = {
+    {   0, true,   1 },
+    {  60, false,  4 },
+    { 120, true,   8 },
+    { 180, false,  2 },
+    { 240, true,   3 },
+    { 300, false,  7 },
+};
+
+static const MultiCopter::motor hexax_motors[] = {
+    {  30, false,  7 },
+    {  90, true,   1 },
+    { 150, false,  4 },
+    { 210, true,   8 },
+    { 270, false,  2 },
+    { 330, true,   3 },
+};
+
+static const MultiCopter::motor octa_motors[] = {
+    {    0, true,  1 },
+    {  180, true,  2 },
+    {   45, false, 3 },
+    {  135, false, 4 },
+    {  -45, false, 7 },
+    { -135, false, 8 },
+    {  270, true, 10 },
+    {   90, true, 11 },
+};
+
+static const MultiCopter::motor octax_motors[] = {
+    {   22.5f, true,  1 },
+    {  202.5f, true,  2 },
+    {   67.5f, false, 3 },
+    {  157.5f, false, 4 },
+    {  -22.5f, false, 7 },
+    { -112.5f, false, 8 },
+    {  292.5f, true, 10 },
+    {  112.5f, true, 11 },
+};
+
+#define MULTICOPTER_FRAME(name, motors) { name, sizeof(motors)/sizeof(motors[0]), motors }
+
+static const MultiCopter::frame supported_frames[] = {
+    MULTICOPTER_FRAME("+",     quad_plus_motors),
+    MULTICOPTER_FRAME("quad",  quad_plus_motors),
+    MULTICOPTER_FRAME("x",     quad_x_motors),
+    MULTICOPTER_FRAME("y6",    y6_motors),
+    MULTICOPTER_FRAME("hexa",  hexa_motors),
+    MULTICOPTER_FRAME("hexa+", hexa_motors),
+    MULTICOPTER_FRAME("hexax", hexax_motors),
+    MULTICOPTER_FRAME("octa",  octa_motors),
+    MULTICOPTER_FRAME("octa+", octa_motors),
+    MULTICOPTER_FRAME("octax", octax_motors),
+};
+
+const MultiCopter::frame *MultiCopter::find_frame(const char *frame_str)
+{
+    for (uint8_t i=0; i<sizeof(supported_frames)/sizeof(supported_frames[0]); i++) {
+        if (strcasecmp(frame_str, supported_frames[i].name) == 0) {
+            return &supported_frames[i];
+        }
+    }
+    return NULL;
+}
+
+bool MultiCopter::frame_valid(const char *frame_str)
+{
+    return find_frame(frame_str) != NULL;
+}
+
+MultiCopter::MultiCopter(const char *home_str, const char *frame_str) :
+    Aircraft(home_str),
+    _frame(find_frame(frame_str)),
+    _hover_throttle(0.45f),
+    _terminal_velocity(15.0f),
+    _terminal_rotation_rate(radians(4*360.0f))
+{
+    _mass = 1.5f;
+    _frame_height = 0.1f;
+
+    // scaling from total motor power to Newtons. Allows the copter
+    // to hover against gravity when each motor is at hover_throttle
+    _thrust_scale = (_mass * GRAVITY_MSS) / (_frame->num_motors * _hover_throttle);
+}
+
+/*
+  update the multicopter simulation by one time step
+ */
+void MultiCopter::update(const struct sitl_input &input, float delta_time)
+{
+    // rotational acceleration, in rad/s/s, in body frame
+    Vector3f rot_accel;
+    float thrust = 0.0f;
+
+    for (uint8_t i=0; i<_frame->num_motors; i++) {
+        const struct motor &m = _frame->motors[i];
+        float motor_speed = (input.servos[m.servo-1] - 1000) / 1000.0f;
+        if (motor_speed <= 0.0f) {
+            motor_speed = 0.0f;
+        }
+        float angle = radians(m.angle);
+        rot_accel.x += -radians(MULTICOPTER_ROLL_PITCH_ACCEL) * sinf(angle) * motor_speed;
+        rot_accel.y +=  radians(MULTICOPTER_ROLL_PITCH_ACCEL) * cosf(angle) * motor_speed;
+        if (m.clockwise) {
+            rot_accel.z -= motor_speed * radians(MULTICOPTER_YAW_ACCEL);
+        } else {
+            rot_accel.z += motor_speed * radians(MULTICOPTER_YAW_ACCEL);
+        }
+        thrust += motor_speed * _thrust_scale; // newtons
+    }
+
+    // rotational air resistance
+    rot_accel.x -= _gyro.x * radians(MULTICOPTER_ROLL_PITCH_ACCEL) / _terminal_rotation_rate;
+    rot_accel.y -= _gyro.y * radians(MULTICOPTER_ROLL_PITCH_ACCEL) / _terminal_rotation_rate;
+    rot_accel.z -= _gyro.z * radians(MULTICOPTER_YAW_ACCEL) / _terminal_rotation_rate;
+
+    // update rotational rates in body frame
+    _gyro += rot_accel * delta_time;
+
+    // air resistance, which acts on the velocity relative to the wind
+    update_wind(input, delta_time);
+    Vector3f air_velocity = _velocity_ef - _wind_ef;
+    Vector3f air_resistance = air_velocity * (-GRAVITY_MSS / _terminal_velocity);
+
+    Vector3f accel_earth = _dcm * Vector3f(0, 0, -thrust / _mass);
+    accel_earth += Vector3f(0, 0, GRAVITY_MSS);
+    accel_earth += air_resistance;
+
+    update_dynamics(accel_earth, delta_time);
+
+    _airspeed = pythagorous2(air_velocity.x, air_velocity.y);
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
@@ -0,0 +1,64 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  multicopter simulator class, a port of Tools/autotest/pysim/multicopter.py
+ */
+
+#ifndef __AP_HAL_AVR_SITL_SIM_MULTICOPTER_H__
+#define __AP_HAL_AVR_SITL_SIM_MULTICOPTER_H__
+
+#include "SIM_Aircraft.h"
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+namespace AVR_SITL {
+
+class MultiCopter : public Aircraft {
+public:
+    MultiCopter(const char *home_str, const char *frame_str);
+
+    // update the model by delta_time seconds
+    void update(const struct sitl_input &input, float delta_time);
+
+    // true if frame_str names a known frame
+    static bool frame_valid(const char *frame_str);
+
+    struct motor {
+        float angle;        // degrees from the nose
+        bool clockwise;
+        uint8_t servo;      // servo output driving this motor, 1 based
+    };
+
+    struct frame {
+        const char *name;
+        uint8_t num_motors;
+        const struct motor *motors;
+    };
+
+private:
+    static const struct frame *find_frame(const char *frame_str);
+
+    const struct frame *_frame;
+    float _hover_throttle;
+    float _terminal_velocity;
+    float _terminal_rotation_rate;
+    float _thrust_scale;
+};
+
+} // namespace AVR_SITL
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+#endif // __AP_HAL_AVR_SITL_SIM_MULTICOPTER_H__
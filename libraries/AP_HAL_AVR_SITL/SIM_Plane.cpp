@@ -0,0 +1,150 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simple fixed wing simulator class
+ */
+
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include "SIM_Plane.h"
+
+using namespace AVR_SITL;
+
+#define PLANE_AIR_DENSITY       1.225f  // kg/m^3
+#define PLANE_CL0               0.2f    // lift coefficient at zero angle of attack
+#define PLANE_CL_ALPHA          4.0f    // lift curve slope, per radian
+#define PLANE_ALPHA_STALL       radians(15)
+#define PLANE_CD0               0.03f   // parasitic drag coefficient
+#define PLANE_CD_INDUCED        0.06f   // induced drag factor
+#define PLANE_CY_BETA           0.5f    // side force per radian of sideslip
+#define PLANE_ALPHA_STABILITY   4.0f    // pitch rate per radian of angle of attack
+#define PLANE_BETA_STABILITY    4.0f    // yaw rate per radian of sideslip
+#define PLANE_ROLLING_FRICTION  0.03f   // fraction of the weight
+
+Plane::Plane(const char *home_str) :
+    Aircraft(home_str),
+    _wing_area(0.45f),
+    _cruise_speed(20),
+    _max_thrust(15),
+    _max_prop_speed(40),
+    _max_roll_rate(radians(180)),
+    _max_pitch_rate(radians(90)),
+    _max_yaw_rate(radians(45)),
+    _rate_time_constant(0.15f)
+{
+    _mass = 2.0f;
+    _frame_height = 0.1f;
+}
+
+/*
+  update the plane simulation by one time step
+ */
+void Plane::update(const struct sitl_input &input, float delta_time)
+{
+    // the SITL parameter files reverse the elevator and rudder, so
+    // positive here is nose down and nose left
+    float aileron  = (input.servos[0] - 1500) / 500.0f;
+    float elevator = (input.servos[1] - 1500) / 500.0f;
+    float throttle = constrain_float((input.servos[2] - 1000) / 1000.0f, 0, 1);
+    float rudder   = (input.servos[3] - 1500) / 500.0f;
+
+    // velocity relative to the air, in body frame
+    update_wind(input, delta_time);
+    Vector3f air_body = _dcm.mul_transpose(_velocity_ef - _wind_ef);
+    float speed = air_body.length();
+    float alpha = 0, beta = 0;
+    if (air_body.x > 0.1f) {
+        alpha = atan2f(air_body.z, air_body.x);
+        beta = atan2f(air_body.y, air_body.x);
+    }
+    float qbar_area = 0.5f * PLANE_AIR_DENSITY * speed * speed * _wing_area;
+
+    // the controls and the weathervane stability both get stronger
+    // with dynamic pressure
+    float effectiveness = constrain_float(sq(speed / _cruise_speed), 0, 2);
+    Vector3f rate_target(aileron * _max_roll_rate,
+                         -elevator * _max_pitch_rate - PLANE_ALPHA_STABILITY * alpha,
+                         -rudder * _max_yaw_rate + PLANE_BETA_STABILITY * beta);
+    rate_target *= effectiveness;
+    _gyro += (rate_target - _gyro) * constrain_float(delta_time / _rate_time_constant, 0, 1);
+
+    // lift, falling off past the stall
+    float cl;
+    if (fabsf(alpha) <= PLANE_ALPHA_STALL) {
+        cl = PLANE_CL0 + PLANE_CL_ALPHA * alpha;
+    } else {
+        float cl_max = PLANE_CL0 + PLANE_CL_ALPHA * (alpha > 0 ? PLANE_ALPHA_STALL : -PLANE_ALPHA_STALL);
+        cl = cl_max * constrain_float(1.0f - (fabsf(alpha) - PLANE_ALPHA_STALL) / PLANE_ALPHA_STALL, 0, 1);
+    }
+    float cd = PLANE_CD0 + PLANE_CD_INDUCED * cl * cl;
+
+    Vector3f force;
+    float xz_speed = pythagorous2(air_body.x, air_body.z);
+    if (xz_speed > 0.1f) {
+        // lift is at right angles to the airflow, drag is against it
+        Vector3f lift_dir(air_body.z / xz_speed, 0, -air_body.x / xz_speed);
+        force += lift_dir * (cl * qbar_area);
+        force -= air_body * (cd * qbar_area / speed);
+    }
+    force.y -= PLANE_CY_BETA * beta * qbar_area;
+
+    // thrust from the propeller falls off with airspeed
+    force.x += throttle * _max_thrust * constrain_float(1.0f - air_body.x / _max_prop_speed, 0, 1);
+
+    // rolling friction on the wheels
+    float ground_speed = _dcm.mul_transpose(_velocity_ef).x;
+    if (on_ground(_position) && fabsf(ground_speed) > 0.1f) {
+        float friction = PLANE_ROLLING_FRICTION * _mass * GRAVITY_MSS;
+        force.x -= (ground_speed > 0) ? friction : -friction;
+    }
+
+    Vector3f accel_earth = _dcm * (force / _mass);
+    accel_earth += Vector3f(0, 0, GRAVITY_MSS);
+
+    update_dynamics(accel_earth, delta_time);
+
+    // the pitot tube sees the airflow along the body
+    _airspeed = air_body.x > 0 ? air_body.x : 0;
+}
+
+/*
+  on the ground the wheels stop the plane sinking or sliding sideways,
+  and hold the wings level. The nose can rise for takeoff
+ */
+void Plane::ground_contact(void)
+{
+    float roll, pitch, yaw;
+    _dcm.to_euler(&roll, &pitch, &yaw);
+    if (pitch < 0) {
+        pitch = 0;
+        if (_gyro.y < 0) {
+            _gyro.y = 0;
+        }
+    }
+    _dcm.from_euler(0, pitch, yaw);
+    _gyro.x = 0;
+
+    if (_velocity_ef.z > 0) {
+        _velocity_ef.z = 0;
+    }
+    float forward = _velocity_ef.x * cosf(yaw) + _velocity_ef.y * sinf(yaw);
+    _velocity_ef.x = forward * cosf(yaw);
+    _velocity_ef.y = forward * sinf(yaw);
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
@@ -0,0 +1,57 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  simple fixed wing simulator class. The control surfaces set first
+  order rate responses, and lift, drag and thrust come from simple
+  coefficient models. It is much cruder than JSBSim, but is enough to
+  test the flight modes and navigation
+ */
+
+#ifndef __AP_HAL_AVR_SITL_SIM_PLANE_H__
+#define __AP_HAL_AVR_SITL_SIM_PLANE_H__
+
+#include "SIM_Aircraft.h"
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+namespace AVR_SITL {
+
+class Plane : public Aircraft {
+public:
+    Plane(const char *home_str);
+
+    // update the model by delta_time seconds
+    void update(const struct sitl_input &input, float delta_time);
+
+protected:
+    // the plane rolls along the ground on its wheels
+    void ground_contact(void);
+
+private:
+    float _wing_area;           // m^2
+    float _cruise_speed;        // m/s, where the control rates are at their maximum
+    float _max_thrust;          // N, static thrust at full throttle
+    float _max_prop_speed;      // m/s, airspeed at which the propeller gives no thrust
+    float _max_roll_rate;       // rad/s
+    float _max_pitch_rate;      // rad/s
+    float _max_yaw_rate;        // rad/s
+    float _rate_time_constant;  // seconds
+};
+
+} // namespace AVR_SITL
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+#endif // __AP_HAL_AVR_SITL_SIM_PLANE_H__
@@ -0,0 +1,127 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  rover simulator class
+ */
+
+#include <AP_HAL.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include "SIM_Rover.h"
+
+using namespace AVR_SITL;
+
+Rover::Rover(const char *home_str, bool skid_steering) :
+    Aircraft(home_str),
+    _max_speed(20),
+    _max_accel(30),
+    _max_wheel_turn(35),
+    _turning_circle(1.8f),
+    _skid_turn_rate(140),
+    _skid_steering(skid_steering)
+{
+    if (_skid_steering) {
+        // these are taken from a 6V wild thumper with skid steering,
+        // with a sabertooth controller
+        _max_accel = 14;
+        _max_speed = 4;
+    }
+}
+
+/*
+  return turning circle (diameter) in meters for a steering
+  proportion between -1 and 1
+ */
+float Rover::turn_circle(float steering) const
+{
+    if (fabsf(steering) < 1.0e-6f) {
+        return 0;
+    }
+    return _turning_circle * sinf(radians(_max_wheel_turn)) / sinf(radians(steering*_max_wheel_turn));
+}
+
+/*
+  return yaw rate in degrees/second given steering and speed
+ */
+float Rover::yaw_rate(float steering, float speed) const
+{
+    if (_skid_steering) {
+        return steering * _skid_turn_rate;
+    }
+    if (fabsf(steering) < 1.0e-6f || fabsf(speed) < 1.0e-6f) {
+        return 0;
+    }
+    float d = turn_circle(steering);
+    float c = PI * d;
+    float t = c / speed;
+    return 360.0f / t;
+}
+
+/*
+  update the rover simulation by one time step
+ */
+void Rover::update(const struct sitl_input &input, float delta_time)
+{
+    // map steering and throttle to -1/1
+    float steering = (input.servos[0] - 1500) / 500.0f;
+    float throttle = (input.servos[2] - 1500) / 500.0f;
+
+    // in skid steering mode the steering and throttle outputs drive
+    // the left and right motors
+    if (_skid_steering) {
+        float motor1 = steering;
+        float motor2 = throttle;
+        steering = motor1 - motor2;
+        throttle = 0.5f*(motor1 + motor2);
+    }
+
+    // speed along x axis, +ve is forward
+    Vector3f velocity_body = _dcm.mul_transpose(_velocity_ef);
+    float speed = velocity_body.x;
+
+    float rate = yaw_rate(steering, speed);
+
+    // linear acceleration in m/s/s - very crude model
+    float target_speed = throttle * _max_speed;
+    float accel = _max_accel * (target_speed - speed) / _max_speed;
+
+    _gyro = Vector3f(0, 0, radians(rate));
+
+    // accel in body frame due to motor, plus accel due to direction change
+    Vector3f accel_body(accel, radians(rate) * speed, 0);
+
+    // the ground holds the rover up, so there is no vertical acceleration
+    Vector3f accel_earth = _dcm * accel_body;
+    accel_earth.z = 0;
+
+    update_dynamics(accel_earth, delta_time);
+
+    _airspeed = fabsf(speed);
+}
+
+/*
+  the rover stays on the ground and keeps its speed
+ */
+void Rover::ground_contact(void)
+{
+    float roll, pitch, yaw;
+    _velocity_ef.z = 0;
+    _dcm.to_euler(&roll, &pitch, &yaw);
+    _dcm.from_euler(0, 0, yaw);
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
@@ -0,0 +1,55 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  rover simulator class, a port of Tools/autotest/pysim/rover.py
+ */
+
+#ifndef __AP_HAL_AVR_SITL_SIM_ROVER_H__
+#define __AP_HAL_AVR_SITL_SIM_ROVER_H__
+
+#include "SIM_Aircraft.h"
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+namespace AVR_SITL {
+
+class Rover : public Aircraft {
+public:
+    Rover(const char *home_str, bool skid_steering);
+
+    // update the model by delta_time seconds
+    void update(const struct sitl_input &input, float delta_time);
+
+protected:
+    // the rover keeps rolling on the ground
+    void ground_contact(void);
+
+private:
+    float turn_circle(float steering) const;
+    float yaw_rate(float steering, float speed) const;
+
+    float _max_speed;       // m/s
+    float _max_accel;       // m/s/s
+    float _max_wheel_turn;  // degrees
+    float _turning_circle;  // meters, at full steering
+    float _skid_turn_rate;  // degrees/s
+    bool _skid_steering;
+};
+
+} // namespace AVR_SITL
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+#endif // __AP_HAL_AVR_SITL_SIM_ROVER_H__
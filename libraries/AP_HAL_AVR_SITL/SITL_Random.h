@@ -0,0 +1,66 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+/*
+  counter based random numbers for the simulated sensors.
+
+  Each sample is a hash of the seed, a stream number and the index of
+  the sample within its stream, so there is no generator state to
+  carry between calls. Every sensor has its own stream, which means
+  that the noise on one sensor does not change when another sensor is
+  sampled more or less often, and a run can be repeated exactly from
+  its seed.
+ */
+
+#ifndef __AP_HAL_AVR_SITL_RANDOM_H__
+#define __AP_HAL_AVR_SITL_RANDOM_H__
+
+#include <stdint.h>
+
+namespace AVR_SITL {
+
+enum sitl_random_stream {
+    SITL_RANDOM_BARO = 0,
+    SITL_RANDOM_GYRO,
+    SITL_RANDOM_ACCEL,
+    SITL_RANDOM_MAG,
+    SITL_RANDOM_AIRSPEED,
+    SITL_RANDOM_SONAR,
+    SITL_RANDOM_GPS,
+    SITL_RANDOM_WIND,
+    SITL_RANDOM_NUM_STREAMS
+};
+
+/*
+  the sample with the given index in a stream, from the splitmix64
+  finalizer applied to the packed seed, stream and index
+ */
+static inline uint64_t sitl_random64(uint32_t seed, uint8_t stream, uint64_t index)
+{
+    uint64_t z = index ^ ((uint64_t)stream << 56) ^ ((uint64_t)seed * 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+// a sample between -1 and 1
+static inline float sitl_random_float(uint32_t seed, uint8_t stream, uint64_t index)
+{
+    return (int32_t)(sitl_random64(seed, stream, index) >> 32) * (1.0f / 2147483648.0f);
+}
+
+} // namespace AVR_SITL
+
+#endif // __AP_HAL_AVR_SITL_RANDOM_H__
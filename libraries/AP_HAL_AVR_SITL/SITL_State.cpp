@@ -18,6 +18,7 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <sys/select.h>
+#include <sys/time.h>
 
 #include <AP_Param.h>
 
@@ -58,16 +59,42 @@ struct sockaddr_in SITL_State::_rcout_addr;
 pid_t SITL_State::_parent_pid;
 uint32_t SITL_State::_update_count;
 bool SITL_State::_motors_on;
+bool SITL_State::_lockstep;
+uint64_t SITL_State::_lockstep_frame_usec;
+Aircraft *SITL_State::_sitl_model;
+Aircraft::sitl_input SITL_State::_model_input;
+bool SITL_State::_have_model_input;
+SITL_State::imu_sample SITL_State::_imu_fifo[IMU_FIFO_SIZE];
+uint16_t SITL_State::_imu_fifo_head;
+uint16_t SITL_State::_imu_fifo_count;
+uint64_t SITL_State::_imu_next_usec;
+float SITL_State::_vib_phase;
+float SITL_State::_throttle;
+uint32_t SITL_State::_random_seed;
+uint64_t SITL_State::_random_index[SITL_RANDOM_NUM_STREAMS];
+SITL_State::fault_event SITL_State::_fault_events[MAX_FAULT_EVENTS];
+uint8_t SITL_State::_num_fault_events;
+uint8_t SITL_State::_next_fault_event;
 uint16_t SITL_State::sonar_pin_value;
 uint16_t SITL_State::airspeed_pin_value;
 uint16_t SITL_State::voltage_pin_value;
 uint16_t SITL_State::current_pin_value;
 float SITL_State::_current;
 
+#if SITL_SENSOR_DRIVERS
+AP_Baro *SITL_State::_barometer;
+AP_InertialSensor *SITL_State::_ins;
+SITLScheduler *SITL_State::_scheduler;
+Compass *SITL_State::_compass;
+#else
 AP_Baro_HIL *SITL_State::_barometer;
 AP_InertialSensor *SITL_State::_ins;
 SITLScheduler *SITL_State::_scheduler;
 AP_Compass_HIL *SITL_State::_compass;
+#endif
+MPU9250 SITL_State::_sim_mpu9250;
+MS5611 SITL_State::_sim_ms5611;
+HMC5883L SITL_State::_sim_hmc5883l;
 
 int SITL_State::_sitl_fd;
 SITL *SITL_State::_sitl;
@@ -91,11 +118,22 @@ void SITL_State::_usage(void)
 	fprintf(stdout, "\t-H HEIGHT   initial barometric height\n");
 	fprintf(stdout, "\t-C          use console instead of TCP ports\n");
 	fprintf(stdout, "\t-I          set instance of SITL (adds 10*instance to all port numbers)\n");
+	fprintf(stdout, "\t-L          run in lockstep with the simulator, as fast as the CPU allows\n");
+	fprintf(stdout, "\t-M MODEL    use the built in simulator MODEL (+, x, hexa, octa, y6, plane, rover ...)\n");
+	fprintf(stdout, "\t-O HOME     home location for the built in simulator (lat,lng,alt,heading)\n");
+	fprintf(stdout, "\t-S SEED     seed for the simulated sensor noise\n");
+	fprintf(stdout, "\t-F FILE     fault injection timeline, lines of TIME_SECONDS SIM_PARAM VALUE\n");
 }
 
 void SITL_State::_parse_command_line(int argc, char * const argv[])
 {
 	int opt;
+	const char *model_str = NULL;
+	const char *home_str = NULL;
+	const char *fault_file = NULL;
+	uint8_t instance = 0;
+	uint32_t seed = 0;
+	bool have_seed = false;
 
 	signal(SIGFPE, _sig_fpe);
 	// No-op SIGPIPE handler
@@ -104,7 +142,7 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
     setvbuf(stdout, (char *)0, _IONBF, 0);
     setvbuf(stderr, (char *)0, _IONBF, 0);
 
-	while ((opt = getopt(argc, argv, "swhr:H:CI:P:")) != -1) {
+	while ((opt = getopt(argc, argv, "swhr:H:CI:P:LM:O:S:F:")) != -1) {
 		switch (opt) {
 		case 'w':
 			AP_Param::erase_all();
@@ -119,22 +157,68 @@ void SITL_State::_parse_command_line(int argc, char * const argv[])
 		case 'C':
 			AVR_SITL::SITLUARTDriver::_console = true;
 			break;
-		case 'I': {
-            uint8_t instance = atoi(optarg);
+		case 'I':
+            instance = atoi(optarg);
             _base_port  += instance * 10;
             _rcout_port += instance * 10;
             _simin_port += instance * 10;
-        }
 			break;
 		case 'P':
             _set_param_default(optarg);
 			break;
+		case 'L':
+#ifndef HIL_MODE
+            _lockstep = true;
+#endif
+			break;
+		case 'M':
+			model_str = optarg;
+			break;
+		case 'O':
+			home_str = optarg;
+			break;
+		case 'S':
+			seed = strtoul(optarg, NULL, 0);
+			have_seed = true;
+			break;
+		case 'F':
+			fault_file = optarg;
+			break;
 		default:
 			_usage();
 			exit(1);
 		}
 	}
 
+	if (!have_seed) {
+		struct timeval tv;
+		gettimeofday(&tv, NULL);
+		seed = tv.tv_sec ^ tv.tv_usec ^ getpid();
+	}
+	fprintf(stdout, "Using random seed %u, repeat with -S %u\n", (unsigned)seed, (unsigned)seed);
+	// each instance gets its own noise from the same seed
+	_random_seed = seed ^ (instance * 0x9E3779B9UL);
+
+	if (fault_file != NULL) {
+		_load_faults(fault_file);
+	}
+
+#ifndef HIL_MODE
+	if (model_str != NULL) {
+		_sitl_model = Aircraft::create(model_str, home_str);
+		if (_sitl_model == NULL) {
+			fprintf(stderr, "Unknown simulator model '%s'\n", model_str);
+			exit(1);
+		}
+		if (!_sitl_model->home_valid()) {
+			fprintf(stderr, "Built in simulator needs -O lat,lng,alt,heading\n");
+			exit(1);
+		}
+		_sitl_model->set_seed(_random_seed);
+		fprintf(stdout, "Using built in simulator model '%s'\n", model_str);
+	}
+#endif
+
 	fprintf(stdout, "Starting sketch '%s'\n", SKETCH);
 
 	if (strcmp(SKETCH, "ArduCopter") == 0) {
@@ -175,19 +259,47 @@ void SITL_State::_set_param_default(char *parm)
         printf("Unknown parameter %s\n", parm);
         exit(1);        
     }
+    if (!_set_param(vp, var_type, value, true)) {
+        printf("Unable to set parameter %s\n", parm);
+        exit(1);
+    }
+    printf("Set parameter %s to %f\n", parm, value);
+}
+
+/*
+  set a parameter by type, optionally saving it. Returns false if the
+  parameter type can't be set from a float
+ */
+bool SITL_State::_set_param(AP_Param *vp, enum ap_var_type var_type, float value, bool save)
+{
     if (var_type == AP_PARAM_FLOAT) {
-        ((AP_Float *)vp)->set_and_save(value);
+        if (save) {
+            ((AP_Float *)vp)->set_and_save(value);
+        } else {
+            ((AP_Float *)vp)->set(value);
+        }
     } else if (var_type == AP_PARAM_INT32) {
-        ((AP_Int32 *)vp)->set_and_save(value);
+        if (save) {
+            ((AP_Int32 *)vp)->set_and_save(value);
+        } else {
+            ((AP_Int32 *)vp)->set(value);
+        }
     } else if (var_type == AP_PARAM_INT16) {
-        ((AP_Int16 *)vp)->set_and_save(value);
+        if (save) {
+            ((AP_Int16 *)vp)->set_and_save(value);
+        } else {
+            ((AP_Int16 *)vp)->set(value);
+        }
     } else if (var_type == AP_PARAM_INT8) {
-        ((AP_Int8 *)vp)->set_and_save(value);
+        if (save) {
+            ((AP_Int8 *)vp)->set_and_save(value);
+        } else {
+            ((AP_Int8 *)vp)->set(value);
+        }
     } else {
-        printf("Unable to set parameter %s\n", parm);
-        exit(1);
+        return false;
     }
-    printf("Set parameter %s to %f\n", parm, value);
+    return true;
 }
 
 
@@ -203,7 +315,16 @@ void SITL_State::_sitl_setup(void)
 	_rcout_addr.sin_port = htons(_rcout_port);
 	inet_pton(AF_INET, "127.0.0.1", &_rcout_addr.sin_addr);
 
-	_setup_timer();
+#ifndef HIL_MODE
+	if (_lockstep) {
+		// no timer, time only moves when the simulator sends a frame
+		SITLScheduler::set_lockstep(_lockstep_wait);
+		fprintf(stdout, "Running in lockstep with the simulator\n");
+	}
+#endif
+	if (!_lockstep) {
+		_setup_timer();
+	}
 #ifndef HIL_MODE
 	_setup_fdm();
 #endif
@@ -211,9 +332,15 @@ void SITL_State::_sitl_setup(void)
 
 	// find the barometer object if it exists
 	_sitl = (SITL *)AP_Param::find_object("SIM_");
+#if SITL_SENSOR_DRIVERS
+	_barometer = (AP_Baro *)AP_Param::find_object("GND_");
+	_ins = (AP_InertialSensor *)AP_Param::find_object("INS_");
+	_compass = (Compass *)AP_Param::find_object("COMPASS_");
+#else
 	_barometer = (AP_Baro_HIL *)AP_Param::find_object("GND_");
 	_ins = (AP_InertialSensor *)AP_Param::find_object("INS_");
 	_compass = (AP_Compass_HIL *)AP_Param::find_object("COMPASS_");
+#endif
 
     if (_sitl != NULL) {
         // setup some initial values
@@ -270,9 +397,6 @@ void SITL_State::_setup_fdm(void)
  */
 void SITL_State::_timer_handler(int signum)
 {
-	static uint32_t last_update_count;
-    static uint32_t last_pwm_input;
-
 	static bool in_timer;
 
 	if (in_timer || _scheduler->interrupts_are_blocked() || _sitl == NULL){
@@ -301,12 +425,6 @@ void SITL_State::_timer_handler(int signum)
 	}
 #endif
 
-    // simulate RC input at 50Hz
-    if (hal.scheduler->millis() - last_pwm_input >= 20 && _sitl->rc_fail == 0) {
-        last_pwm_input = hal.scheduler->millis();
-        new_rc_input = true;
-    }
-
 #ifndef HIL_MODE
 	/* check for packet from flight sim */
 	_fdm_input();
@@ -315,21 +433,45 @@ void SITL_State::_timer_handler(int signum)
 	_simulator_output();
 #endif
 
+    _timer_update();
+
+    _scheduler->sitl_end_atomic();
+	in_timer = false;
+}
+
+/*
+  update the simulated sensors if a new FDM packet has arrived, then
+  run the timers. Called from the 1kHz timer, or once per frame when
+  in lockstep
+ */
+void SITL_State::_timer_update(void)
+{
+	static uint32_t last_update_count;
+    static uint32_t last_pwm_input;
+
+    _update_faults();
+
+#ifndef HIL_MODE
+    _step_model();
+#endif
+
+    // simulate RC input at 50Hz
+    if (hal.scheduler->millis() - last_pwm_input >= 20 && _sitl->rc_fail == 0) {
+        last_pwm_input = hal.scheduler->millis();
+        new_rc_input = true;
+    }
+
 	if (_update_count == 0 && _sitl != NULL) {
 #ifndef HIL_MODE
 		_update_gps(0, 0, 0, 0, 0, 0, false);
 		_update_barometer(0);
 #endif
 		_scheduler->timer_event();
-        _scheduler->sitl_end_atomic();
-		in_timer = false;
 		return;
 	}
 
 	if (_update_count == last_update_count) {
 		_scheduler->timer_event();
-        _scheduler->sitl_end_atomic();
-		in_timer = false;
 		return;
 	}
 	last_update_count = _update_count;
@@ -353,15 +495,17 @@ void SITL_State::_timer_handler(int signum)
 	// interrupts, which can lead to recursion
 	_scheduler->timer_event();
 
-    _scheduler->sitl_end_atomic();
-	in_timer = false;
+#if SITL_SENSOR_DRIVERS
+    _timer_load_report();
+#endif
 }
 
 #ifndef HIL_MODE
 /*
-  check for a SITL FDM packet
+  check for a SITL FDM packet. Returns true if a new FDM frame was
+  received
  */
-void SITL_State::_fdm_input(void)
+bool SITL_State::_fdm_input(void)
 {
 	ssize_t size;
 	struct pwm_packet {
@@ -369,25 +513,45 @@ void SITL_State::_fdm_input(void)
 	};
 	union {
 		struct sitl_fdm fg_pkt;
+		struct sitl_fdm_lockstep lockstep_pkt;
 		struct pwm_packet pwm_pkt;
 	} d;
 
 	size = recv(_sitl_fd, &d, sizeof(d), MSG_DONTWAIT);
 	switch (size) {
-	case 140:
+	case sizeof(struct sitl_fdm_lockstep):
+	case sizeof(struct sitl_fdm):
 		static uint32_t last_report;
 		static uint32_t count;
 
+		if (_sitl_model != NULL) {
+			// the built in model provides the FDM
+			return false;
+		}
+
 		if (d.fg_pkt.magic != 0x4c56414f) {
 			fprintf(stdout, "Bad FDM packet - magic=0x%08x\n", d.fg_pkt.magic);
-			return;
+			return false;
 		}
 
 		if (d.fg_pkt.latitude == 0 ||
 		    d.fg_pkt.longitude == 0 ||
 		    d.fg_pkt.altitude <= 0) {
 			// garbage input
-			return;
+			return false;
+		}
+
+		if (size == sizeof(struct sitl_fdm_lockstep)) {
+			if (d.lockstep_pkt.timestamp_us <= _lockstep_frame_usec &&
+			    _update_count != 0) {
+				// a repeat of a frame we already have
+				return false;
+			}
+			_lockstep_frame_usec = d.lockstep_pkt.timestamp_us;
+		} else if (_lockstep) {
+			// the simulator is not running in lockstep, so assume
+			// each frame is one frame period on from the last
+			_lockstep_frame_usec += 1000000UL / _framerate;
 		}
 
         if (_sitl != NULL) {
@@ -408,7 +572,7 @@ void SITL_State::_fdm_input(void)
 			count = 0;
 			last_report = hal.scheduler->millis();
 		}
-		break;
+		return true;
 
 	case 16: {
 		// a packet giving the receiver PWM inputs
@@ -422,7 +586,7 @@ void SITL_State::_fdm_input(void)
 		break;
 	}
 	}
-
+	return false;
 }
 #endif
 
@@ -458,9 +622,10 @@ void SITL_State::_apply_servo_filter(float deltat)
 void SITL_State::_simulator_output(void)
 {
 	static uint32_t last_update_usec;
-	struct {
+	struct PACKED {
 		uint16_t pwm[11];
 		uint16_t speed, direction, turbulance;
+		uint64_t timestamp_us; // only sent in lockstep
 	} control;
 	/* this maps the registers used for PWM outputs. The RC
 	 * driver updates these whenever it wants the channel output
@@ -488,15 +653,17 @@ void SITL_State::_simulator_output(void)
         return;
     }
 
-	// output at chosen framerate
+	// output at chosen framerate, or in lockstep once for each frame
     uint32_t now = hal.scheduler->micros();
-	if (last_update_usec != 0 && now - last_update_usec < 1000000/_framerate) {
+	if (!_lockstep && last_update_usec != 0 && now - last_update_usec < 1000000/_framerate) {
 		return;
 	}
-    float deltat = (now - last_update_usec) * 1.0e-6f;
+    float deltat = last_update_usec == 0 ? 0 : (now - last_update_usec) * 1.0e-6f;
 	last_update_usec = now;
 
-    _apply_servo_filter(deltat);
+    if (deltat > 0) {
+        _apply_servo_filter(deltat);
+    }
 
 	for (i=0; i<11; i++) {
 		if (pwm_output[i] == 0xFFFF) {
@@ -539,6 +706,7 @@ void SITL_State::_simulator_output(void)
 	}
 
     float throttle = _motors_on?(control.pwm[2]-1000) / 1000.0f:0;
+    _throttle = throttle;
     // lose 0.7V at full throttle
     float voltage = _sitl->batt_voltage - 0.7f*throttle;
     // assume 50A at full throttle
@@ -569,8 +737,180 @@ void SITL_State::_simulator_output(void)
 		control.speed = 0;
 	}
 
-	sendto(_sitl_fd, (void*)&control, sizeof(control), MSG_DONTWAIT, (const sockaddr *)&_rcout_addr, sizeof(_rcout_addr));
+	if (_sitl_model != NULL) {
+		Aircraft::sitl_input input;
+		memcpy(input.servos, control.pwm, sizeof(input.servos));
+		input.wind.speed = control.speed * 0.01f;
+		input.wind.direction = control.direction * 0.01f;
+		input.wind.turbulence = control.turbulance * 0.01f;
+		if (_substepping()) {
+			// the model is stepped from the timer
+			_model_input = input;
+			_have_model_input = true;
+		} else {
+			_update_model(input, deltat);
+		}
+		return;
+	}
+
+	// in lockstep the outputs are tagged with the frame they respond
+	// to, so the simulator can tell them from stale outputs
+	size_t len = sizeof(control);
+	if (_lockstep) {
+		control.timestamp_us = _lockstep_frame_usec;
+	} else {
+		len -= sizeof(control.timestamp_us);
+	}
+
+	sendto(_sitl_fd, (void*)&control, len, MSG_DONTWAIT, (const sockaddr *)&_rcout_addr, sizeof(_rcout_addr));
+}
+
+/*
+  step the built in simulator model and take the FDM state from it, in
+  place of a packet from an external simulator
+ */
+void SITL_State::_update_model(const Aircraft::sitl_input &input, float deltat)
+{
+    _sitl_model->update(input, deltat);
+    _sitl_model->fill_fdm(_sitl->state);
+    _update_count++;
+}
+
+/*
+  true if the built in model runs at SIM_PHYS_RATE rather than once
+  per frame
+ */
+bool SITL_State::_substepping(void)
+{
+    return _sitl_model != NULL && _sitl != NULL && _sitl->phys_rate > 0;
+}
+
+/*
+  step the built in model up to the current time at SIM_PHYS_RATE,
+  with the servo outputs from the last frame. The IMU samples are
+  synthesised after each step, so they see the motion within a frame
+ */
+void SITL_State::_step_model(void)
+{
+    static uint64_t last_step_usec;
+
+    if (!_substepping() || !_have_model_input) {
+        return;
+    }
+    uint64_t now = hal.scheduler->micros64();
+    uint32_t step_usec = 1000000UL / _sitl->phys_rate;
+    if (step_usec == 0) {
+        step_usec = 1;
+    }
+    if (last_step_usec == 0 || now - last_step_usec > 1000000UL) {
+        // first step, or we have been stopped for a long time
+        last_step_usec = now - step_usec;
+    }
+    if (now - last_step_usec < step_usec) {
+        return;
+    }
+    while (now - last_step_usec >= step_usec) {
+        last_step_usec += step_usec;
+        _sitl_model->update(_model_input, step_usec * 1.0e-6f);
+        _imu_synthesise(last_step_usec, _sitl_model->get_accel_body(), _sitl_model->get_gyro());
+    }
+    _sitl_model->fill_fdm(_sitl->state);
+    _update_count++;
+}
+
+#ifndef HIL_MODE
+/*
+  in lockstep mode, called whenever the firmware waits for time to
+  pass. Sends the servo outputs for the latest frame to the simulator,
+  waits for it to step its physics and send the next frame, then moves
+  time on to that frame, running the timers every millisecond on the
+  way
+ */
+void SITL_State::_lockstep_wait(void)
+{
+    uint64_t last_frame_usec = _lockstep_frame_usec;
+    bool new_frame = false;
+
+    if (_sitl_model != NULL) {
+        // the built in model is stepped once the time has moved on,
+        // there is nothing to wait for except RC input
+        _fdm_input();
+        _lockstep_frame_usec += 1000000UL / _framerate;
+        new_frame = true;
+    } else {
+        _simulator_output();
+    }
+
+    while (!new_frame) {
+        fd_set fds;
+        struct timeval tv;
+        FD_ZERO(&fds);
+        FD_SET(_sitl_fd, &fds);
+        tv.tv_sec = 1;
+        tv.tv_usec = 0;
+        if (select(_sitl_fd+1, &fds, NULL, NULL, &tv) != 1) {
+#ifndef __CYGWIN__
+            /* make sure we die if our parent dies */
+            if (kill(_parent_pid, 0) != 0) {
+                exit(1);
+            }
+#endif
+            // the simulator may have started after our last output
+            _simulator_output();
+            continue;
+        }
+        new_frame = _fdm_input() && _lockstep_frame_usec > last_frame_usec;
+    }
+
+    uint64_t now = SITLScheduler::_micros64();
+    while (now + 1000 < _lockstep_frame_usec) {
+        now += 1000;
+        SITLScheduler::set_lockstep_time(now);
+        if (_substepping()) {
+            // the sensors see the model move within the frame
+            _timer_update();
+        } else {
+            _scheduler->timer_event();
+        }
+    }
+    if (now < _lockstep_frame_usec) {
+        SITLScheduler::set_lockstep_time(_lockstep_frame_usec);
+    }
+    if (_sitl_model != NULL) {
+        _simulator_output();
+    }
+    _timer_update();
+
+    _lockstep_report();
+}
+
+/*
+  report how much faster than realtime the lockstep simulation runs
+ */
+void SITL_State::_lockstep_report(void)
+{
+    static uint64_t last_wall_usec;
+    static uint64_t last_sim_usec;
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    uint64_t wall_usec = tv.tv_sec*1000000ULL + tv.tv_usec;
+    uint64_t sim_usec = SITLScheduler::_micros64();
+    if (last_wall_usec == 0) {
+        last_wall_usec = wall_usec;
+        last_sim_usec = sim_usec;
+        return;
+    }
+    if (wall_usec - last_wall_usec < 10000000ULL) {
+        return;
+    }
+    fprintf(stdout, "Lockstep: %.1fs simulated, speedup %.1fx\n",
+            sim_usec * 1.0e-6,
+            (double)(sim_usec - last_sim_usec) / (wall_usec - last_wall_usec));
+    last_wall_usec = wall_usec;
+    last_sim_usec = sim_usec;
 }
+#endif
 
 
 /*
@@ -594,24 +934,66 @@ void SITL_State::_setup_timer(void)
 	setitimer(ITIMER_REAL, &it, NULL);
 }
 
-// generate a random float between -1 and 1
-float SITL_State::_rand_float(void)
+// generate a random float between -1 and 1 from the given noise stream
+float SITL_State::_rand_float(uint8_t stream)
 {
-    return ((((unsigned)random()) % 2000000) - 1.0e6) / 1.0e6;
+    return sitl_random_float(_random_seed, stream, _random_index[stream]++);
 }
 
-// generate a random Vector3f of size 1
-Vector3f SITL_State::_rand_vec3f(void)
+// generate a random Vector3f of size 1 from the given noise stream
+Vector3f SITL_State::_rand_vec3f(uint8_t stream)
 {
-	Vector3f v = Vector3f(_rand_float(),
-                          _rand_float(),
-                          _rand_float());
+	Vector3f v = Vector3f(_rand_float(stream),
+                          _rand_float(stream),
+                          _rand_float(stream));
 	if (v.length() != 0.0) {
 		v.normalize();
 	}
 	return v;
 }
 
+/*
+  the simulated chip at an I2C address, or NULL if there is none
+ */
+I2CSlave *SITL_State::i2c_device(uint8_t addr)
+{
+    if (addr == 0x1E) {
+        return &_sim_hmc5883l;
+    }
+    return NULL;
+}
+
+#if SITL_SENSOR_DRIVERS
+/*
+  report the wall clock time the timer procs take, which with the
+  real sensor drivers is the load they would put on the timer
+ */
+void SITL_State::_timer_load_report(void)
+{
+    static uint64_t last_wall_usec;
+    struct timeval tv;
+
+    gettimeofday(&tv, NULL);
+    uint64_t wall_usec = tv.tv_sec*1000000ULL + tv.tv_usec;
+    if (last_wall_usec == 0) {
+        last_wall_usec = wall_usec;
+        return;
+    }
+    if (wall_usec - last_wall_usec < 10000000ULL) {
+        return;
+    }
+    uint32_t count, max_usec;
+    uint64_t total_usec;
+    SITLScheduler::timer_proc_stats(count, total_usec, max_usec);
+    if (count != 0) {
+        fprintf(stdout, "Timer procs: %u calls, average %.1fus, max %uus, %.2f%% of wall time\n",
+                (unsigned)count, (double)total_usec / count, (unsigned)max_usec,
+                100.0 * total_usec / (wall_usec - last_wall_usec));
+    }
+    last_wall_usec = wall_usec;
+}
+#endif // SITL_SENSOR_DRIVERS
+
 
 void SITL_State::init(int argc, char * const argv[])
 {
@@ -657,7 +1039,9 @@ void SITL_State::loop_hook(void)
         max_fd = max(fd, max_fd);
     }
     tv.tv_sec = 0;
-    tv.tv_usec = 100;
+    // in lockstep time only passes while waiting for the simulator,
+    // so don't wait here
+    tv.tv_usec = _lockstep ? 0 : 100;
     fflush(stdout);
     fflush(stderr);
     select(max_fd+1, &fds, NULL, NULL, &tv);
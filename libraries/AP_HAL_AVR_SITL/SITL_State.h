@@ -20,6 +20,11 @@
 #include "../AP_InertialSensor/AP_InertialSensor.h"
 #include "../AP_Compass/AP_Compass.h"
 #include "../SITL/SITL.h"
+#include "SIM_Aircraft.h"
+#include "SIM_MPU9250.h"
+#include "SIM_MS5611.h"
+#include "SIM_HMC5883L.h"
+#include "SITL_Random.h"
 
 class HAL_AVR_SITL;
 
@@ -49,6 +54,11 @@ public:
     static uint16_t voltage_pin_value;  // pin 13
     static uint16_t current_pin_value;  // pin 12
 
+    // simulated sensor chips on the SPI and I2C buses
+    static SPISlave *spi_mpu9250(void) { return &_sim_mpu9250; }
+    static SPISlave *spi_ms5611(void) { return &_sim_ms5611; }
+    static I2CSlave *i2c_device(uint8_t addr);
+
 private:
     void _parse_command_line(int argc, char * const argv[]);
     void _set_param_default(char *parm);
@@ -97,18 +107,45 @@ private:
 			    double rollRate, 	double pitchRate,double yawRate,	// Local to plane
 			    double xAccel, 	double yAccel, 	double zAccel,		// Local to plane
 			    float airspeed,	float altitude);
-    static void _fdm_input(void);
+    static bool _fdm_input(void);
     static void _simulator_output(void);
+    static void _update_model(const Aircraft::sitl_input &input, float deltat);
+    static void _step_model(void);
+    static bool _substepping(void);
+    static void _imu_synthesise(uint64_t until_usec, const Vector3f &accel, const Vector3f &gyro);
+    static void _add_vibration(float dt, Vector3f &accel, Vector3f &gyro);
+    static bool _imu_fifo_read(Vector3f &accel, Vector3f &gyro);
+    static void _lockstep_wait(void);
+    static void _lockstep_report(void);
     static void _apply_servo_filter(float deltat);
     static uint16_t _airspeed_sensor(float airspeed);
     static uint16_t _ground_sonar(float altitude);
     static float _gyro_drift(void);
-    static float _rand_float(void);
-    static Vector3f _rand_vec3f(void);
+    static float _rand_float(uint8_t stream);
+    static Vector3f _rand_vec3f(uint8_t stream);
+
+    // fault injection timeline
+    struct fault_event {
+        uint32_t time_ms;
+        AP_Param *vp;
+        enum ap_var_type var_type;
+        float value;
+    };
+    #define MAX_FAULT_EVENTS 64
+    static fault_event _fault_events[MAX_FAULT_EVENTS];
+    static uint8_t _num_fault_events;
+    static uint8_t _next_fault_event;
+    static void _load_faults(const char *filename);
+    static void _update_faults(void);
+    static bool _set_param(AP_Param *vp, enum ap_var_type var_type, float value, bool save);
+#if SITL_SENSOR_DRIVERS
+    static void _timer_load_report(void);
+#endif
 
     // signal handlers
     static void _sig_fpe(int signum);
     static void _timer_handler(int signum);
+    static void _timer_update(void);
 
     // internal state
     static enum vehicle_type _vehicle;
@@ -119,11 +156,42 @@ private:
     static pid_t _parent_pid;
     static uint32_t _update_count;
     static bool _motors_on;
-
+    static bool _lockstep;
+    static uint64_t _lockstep_frame_usec;
+    static Aircraft *_sitl_model;
+    static Aircraft::sitl_input _model_input;
+    static bool _have_model_input;
+
+    // IMU samples synthesised at SIM_IMU_RATE, waiting to be read
+    struct imu_sample {
+        Vector3f accel;
+        Vector3f gyro;
+    };
+    #define IMU_FIFO_SIZE 512
+    static imu_sample _imu_fifo[IMU_FIFO_SIZE];
+    static uint16_t _imu_fifo_head;
+    static uint16_t _imu_fifo_count;
+    static uint64_t _imu_next_usec;
+    static float _vib_phase;
+    static float _throttle;
+    static uint32_t _random_seed;
+    static uint64_t _random_index[SITL_RANDOM_NUM_STREAMS];
+
+#if SITL_SENSOR_DRIVERS
+    // the real drivers read the simulated chips
+    static AP_Baro *_barometer;
+    static AP_InertialSensor *_ins;
+    static SITLScheduler *_scheduler;
+    static Compass *_compass;
+#else
     static AP_Baro_HIL *_barometer;
     static AP_InertialSensor *_ins;
     static SITLScheduler *_scheduler;
     static AP_Compass_HIL *_compass;
+#endif
+    static MPU9250 _sim_mpu9250;
+    static MS5611 _sim_ms5611;
+    static HMC5883L _sim_hmc5883l;
 
     static int _sitl_fd;
     static SITL *_sitl;
@@ -0,0 +1,70 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#include <AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include "SPIDriver.h"
+#include "SITL_State.h"
+#include <string.h>
+
+using namespace AVR_SITL;
+
+void SITLSPIDeviceDriver::transaction(const uint8_t *tx, uint8_t *rx, uint16_t len)
+{
+    if (_slave == NULL) {
+        if (rx != NULL) {
+            memset(rx, 0, len);
+        }
+        return;
+    }
+    _slave->cs_assert();
+    for (uint16_t i=0; i<len; i++) {
+        uint8_t b = _slave->transfer(tx[i]);
+        if (rx != NULL) {
+            rx[i] = b;
+        }
+    }
+}
+
+void SITLSPIDeviceDriver::cs_assert()
+{
+    if (_slave != NULL) {
+        _slave->cs_assert();
+    }
+}
+
+uint8_t SITLSPIDeviceDriver::transfer(uint8_t data)
+{
+    if (_slave == NULL) {
+        return 0;
+    }
+    return _slave->transfer(data);
+}
+
+void SITLSPIDeviceDriver::transfer(const uint8_t *data, uint16_t len)
+{
+    for (uint16_t i=0; i<len; i++) {
+        transfer(data[i]);
+    }
+}
+
+void SITLSPIDeviceManager::init(void *)
+{
+    _mpu9250.setup(_sitlState->spi_mpu9250(), &_semaphore);
+    _ms5611.setup(_sitlState->spi_ms5611(), &_semaphore);
+    _no_device.setup(NULL, &_semaphore);
+}
+
+AP_HAL::SPIDeviceDriver* SITLSPIDeviceManager::device(enum AP_HAL::SPIDevice dev)
+{
+    switch (dev) {
+    case AP_HAL::SPIDevice_MPU9250:
+        return &_mpu9250;
+    case AP_HAL::SPIDevice_MS5611:
+        return &_ms5611;
+    default:
+        return &_no_device;
+    }
+}
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
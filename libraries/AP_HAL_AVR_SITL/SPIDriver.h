@@ -0,0 +1,59 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#ifndef __AP_HAL_AVR_SITL_SPIDRIVER_H__
+#define __AP_HAL_AVR_SITL_SPIDRIVER_H__
+
+#include <AP_HAL.h>
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+#include "AP_HAL_AVR_SITL_Namespace.h"
+#include "SIM_Device.h"
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_Empty_Private.h>
+
+/*
+  a chip select on the simulated SPI bus. Transfers go to a simulated
+  chip, or read as zero if there is no chip on this select
+ */
+class AVR_SITL::SITLSPIDeviceDriver : public AP_HAL::SPIDeviceDriver {
+public:
+    SITLSPIDeviceDriver() : _slave(NULL), _semaphore(NULL) {}
+
+    void setup(SPISlave *slave, AP_HAL::Semaphore *semaphore) {
+        _slave = slave;
+        _semaphore = semaphore;
+    }
+
+    void init() {}
+    AP_HAL::Semaphore* get_semaphore() { return _semaphore; }
+    void transaction(const uint8_t *tx, uint8_t *rx, uint16_t len);
+
+    void cs_assert();
+    void cs_release() {}
+    uint8_t transfer (uint8_t data);
+    void transfer (const uint8_t *data, uint16_t len);
+
+private:
+    SPISlave *_slave;
+    AP_HAL::Semaphore *_semaphore;
+};
+
+/*
+  the simulated SPI bus, with the MPU9250 and MS5611 from SITL_State
+  on it. All chip selects share one bus semaphore, as on a real board
+ */
+class AVR_SITL::SITLSPIDeviceManager : public AP_HAL::SPIDeviceManager {
+public:
+    SITLSPIDeviceManager(SITL_State *sitlState) : _sitlState(sitlState) {}
+    void init(void *);
+    AP_HAL::SPIDeviceDriver* device(enum AP_HAL::SPIDevice);
+
+private:
+    SITL_State *_sitlState;
+    SITLSPIDeviceDriver _mpu9250;
+    SITLSPIDeviceDriver _ms5611;
+    SITLSPIDeviceDriver _no_device;
+    Empty::EmptySemaphore _semaphore;
+};
+
+#endif // CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+#endif // __AP_HAL_AVR_SITL_SPIDRIVER_H__
@@ -6,6 +6,7 @@
 #include "AP_HAL_AVR_SITL.h"
 #include "Scheduler.h"
 #include <sys/time.h>
+#include <time.h>
 #include <unistd.h>
 
 #ifdef __CYGWIN__
@@ -36,7 +37,15 @@ AP_HAL::MemberProc SITLScheduler::_io_proc[SITL_SCHEDULER_MAX_TIMER_PROCS] = {NU
 uint8_t SITLScheduler::_num_io_procs = 0;
 bool SITLScheduler::_in_io_proc = false;
 
-struct timeval SITLScheduler::_sketch_start_time;
+AP_HAL::Proc SITLScheduler::_lockstep_wait = NULL;
+uint64_t SITLScheduler::_lockstep_time_usec = 0;
+#if SITL_SENSOR_DRIVERS
+uint32_t SITLScheduler::_timer_proc_count = 0;
+uint64_t SITLScheduler::_timer_proc_usec = 0;
+uint32_t SITLScheduler::_timer_proc_max_usec = 0;
+#endif
+
+struct timespec SITLScheduler::_sketch_start_time;
 
 #ifdef __CYGWIN__
 double SITLScheduler::_cyg_freq = 0;
@@ -48,7 +57,7 @@ SITLScheduler::SITLScheduler()
 
 void SITLScheduler::init(void *unused) 
 {
-	gettimeofday(&_sketch_start_time,NULL);
+	clock_gettime(CLOCK_MONOTONIC, &_sketch_start_time);
 
 #ifdef __CYGWIN__
 	LARGE_INTEGER lFreq, lCnt;
@@ -70,20 +79,33 @@ double SITLScheduler::_cyg_sec()
 }
 #endif
 
-uint64_t SITLScheduler::_micros64() 
+/*
+  time since startup in nanoseconds. In lockstep this is the time the
+  simulator has moved the clock on to
+ */
+uint64_t SITLScheduler::_nanos64() 
 {
+    if (_lockstep_wait != NULL) {
+        return _lockstep_time_usec * 1000ULL;
+    }
 #ifdef __CYGWIN__
-	return (uint64_t)(_cyg_sec() * 1.0e6);
-#else   
-	struct timeval tp;
-	gettimeofday(&tp,NULL);
-	uint64_t ret = 1.0e6*((tp.tv_sec + (tp.tv_usec*1.0e-6)) - 
-                          (_sketch_start_time.tv_sec +
-                           (_sketch_start_time.tv_usec*1.0e-6)));
-    return ret;
+	return (uint64_t)(_cyg_sec() * 1.0e9);
+#else
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)(ts.tv_sec - _sketch_start_time.tv_sec)*1000000000ULL +
+        ts.tv_nsec - _sketch_start_time.tv_nsec;
 #endif
 }
 
+uint64_t SITLScheduler::_micros64() 
+{
+    if (_lockstep_wait != NULL) {
+        return _lockstep_time_usec;
+    }
+    return _nanos64() / 1000ULL;
+}
+
 uint64_t SITLScheduler::micros64() 
 {
     return _micros64();
@@ -96,17 +118,7 @@ uint32_t SITLScheduler::micros()
 
 uint64_t SITLScheduler::millis64() 
 {
-#ifdef __CYGWIN__
-	// 1000 ms in a second
-	return (uint64_t)(_cyg_sec() * 1000);
-#else
-	struct timeval tp;
-	gettimeofday(&tp,NULL);
-	uint64_t ret = 1.0e3*((tp.tv_sec + (tp.tv_usec*1.0e-6)) - 
-                          (_sketch_start_time.tv_sec +
-                           (_sketch_start_time.tv_usec*1.0e-6)));
-    return ret;
-#endif
+    return _micros64() / 1000ULL;
 }
 
 uint32_t SITLScheduler::millis() 
@@ -117,6 +129,10 @@ uint32_t SITLScheduler::millis()
 void SITLScheduler::delay_microseconds(uint16_t usec) 
 {
 	uint64_t start = micros64();
+    if (_lockstep_wait != NULL) {
+        _lockstep_wait_until(start + usec);
+        return;
+    }
 	while (micros64() - start < usec) {
 		usleep(usec - (micros64() - start));
 	}
@@ -137,6 +153,27 @@ void SITLScheduler::delay(uint16_t ms)
                 _delay_cb();
             }
         }
+        if (_lockstep_wait != NULL && ms > 0) {
+            _lockstep_wait_until(start + 1000);
+        }
+    }
+}
+
+/*
+  in lockstep mode wait for the simulator to move time on to at
+  least time_usec
+ */
+void SITLScheduler::_lockstep_wait_until(uint64_t time_usec)
+{
+    while (_lockstep_time_usec < time_usec) {
+        if (_in_timer_proc || _in_io_proc) {
+            // the simulator can't be waited for from inside a timer
+            // callback, as the wait runs the timers, so let the time
+            // pass without it
+            _lockstep_time_usec = time_usec;
+            return;
+        }
+        _lockstep_wait();
     }
 }
 
@@ -244,11 +281,27 @@ void SITLScheduler::_run_timer_procs(bool called_from_isr)
 
     if (!_timer_suspended) {
         // now call the timer based drivers
+#if SITL_SENSOR_DRIVERS
+        // time them against the wall clock as the simulated clock may
+        // not move
+        struct timeval tv;
+        gettimeofday(&tv, NULL);
+        uint64_t start_usec = tv.tv_sec*1000000ULL + tv.tv_usec;
+#endif
         for (int i = 0; i < _num_timer_procs; i++) {
             if (_timer_proc[i] != NULL) {
                 _timer_proc[i]();
             }
         }
+#if SITL_SENSOR_DRIVERS
+        gettimeofday(&tv, NULL);
+        uint32_t dt = (tv.tv_sec*1000000ULL + tv.tv_usec) - start_usec;
+        _timer_proc_count++;
+        _timer_proc_usec += dt;
+        if (dt > _timer_proc_max_usec) {
+            _timer_proc_max_usec = dt;
+        }
+#endif
     } else if (called_from_isr) {
         _timer_event_missed = true;
     }
@@ -261,6 +314,18 @@ void SITLScheduler::_run_timer_procs(bool called_from_isr)
     _in_timer_proc = false;
 }
 
+#if SITL_SENSOR_DRIVERS
+void SITLScheduler::timer_proc_stats(uint32_t &count, uint64_t &total_usec, uint32_t &max_usec)
+{
+    count = _timer_proc_count;
+    total_usec = _timer_proc_usec;
+    max_usec = _timer_proc_max_usec;
+    _timer_proc_count = 0;
+    _timer_proc_usec = 0;
+    _timer_proc_max_usec = 0;
+}
+#endif
+
 void SITLScheduler::_run_io_procs(bool called_from_isr) 
 {
     if (_in_io_proc) {
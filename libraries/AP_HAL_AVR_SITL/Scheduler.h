@@ -21,6 +21,7 @@ public:
     uint32_t micros();
     uint64_t millis64();
     uint64_t micros64();
+    uint64_t nanos64() { return _nanos64(); }
     void     delay_microseconds(uint16_t us);
     void     register_delay_callback(AP_HAL::Proc, uint16_t min_time_ms);
 
@@ -46,17 +47,32 @@ public:
 
     // callable from interrupt handler
     static uint64_t _micros64();
+    static uint64_t _nanos64();
     static void timer_event() { _run_timer_procs(true); _run_io_procs(true); }
 
+    // lockstep support. Once a wait function is set, time only moves
+    // when it is advanced by set_lockstep_time(), and waiting for time
+    // to pass calls the wait function instead of sleeping
+    static void set_lockstep(AP_HAL::Proc wait_proc) { _lockstep_wait = wait_proc; }
+    static bool lockstep(void) { return _lockstep_wait != NULL; }
+    static void set_lockstep_time(uint64_t time_usec) { _lockstep_time_usec = time_usec; }
+
+#if SITL_SENSOR_DRIVERS
+    // wall clock time spent in the timer procs since the last call,
+    // to measure the load the sensor drivers put on the timer
+    static void timer_proc_stats(uint32_t &count, uint64_t &total_usec, uint32_t &max_usec);
+#endif
+
 private:
     uint8_t _nested_atomic_ctr;
     AP_HAL::Proc _delay_cb;
     uint16_t _min_delay_cb_ms;
-    static struct timeval _sketch_start_time;
+    static struct timespec _sketch_start_time;
     static AP_HAL::Proc _failsafe;
 
     static void _run_timer_procs(bool called_from_isr);
     static void _run_io_procs(bool called_from_isr);
+    static void _lockstep_wait_until(uint64_t time_usec);
 
     static volatile bool _timer_suspended;
     static volatile bool _timer_event_missed;
@@ -66,6 +82,13 @@ private:
     static uint8_t _num_io_procs;
     static bool    _in_timer_proc;
     static bool    _in_io_proc;
+    static AP_HAL::Proc _lockstep_wait;
+    static uint64_t _lockstep_time_usec;
+#if SITL_SENSOR_DRIVERS
+    static uint32_t _timer_proc_count;
+    static uint64_t _timer_proc_usec;
+    static uint32_t _timer_proc_max_usec;
+#endif
 #ifdef __CYGWIN__
     static double _cyg_freq;
     static long _cyg_start;
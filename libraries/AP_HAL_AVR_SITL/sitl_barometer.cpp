@@ -43,20 +43,29 @@ void SITL_State::_update_barometer(float altitude)
             return;
         }
 
-	// 80Hz, to match the real APM2 barometer
         uint32_t now = hal.scheduler->millis();
+#if !SITL_SENSOR_DRIVERS
+	// 80Hz, to match the real APM2 barometer. The simulated MS5611
+	// sets its own rate from the conversions the driver asks for
 	if ((now - last_update) < 12) {
 		return;
 	}
+#endif
 	last_update = now;
 
 	sim_alt += _sitl->baro_drift * now / 1000;
-	sim_alt += _sitl->baro_noise * _rand_float();
+	sim_alt += _sitl->baro_noise * _rand_float(SITL_RANDOM_BARO);
 
 	// add baro glitch
 	sim_alt += _sitl->baro_glitch;
 
+#if SITL_SENSOR_DRIVERS
+	float pressure, temperature;
+	AP_Baro_HIL::altitude_to_pressure(sim_alt, pressure, temperature);
+	_sim_ms5611.set_pressure(pressure, temperature);
+#else
 	_barometer->setHIL(sim_alt);
+#endif
 }
 
 #endif
@@ -38,10 +38,21 @@ void SITL_State::_update_compass(float rollDeg, float pitchDeg, float yawDeg)
 	if (yawDeg < -180.0f) {
 		yawDeg += 360.0f;
 	}
-	_compass->setHIL(radians(rollDeg), radians(pitchDeg), radians(yawDeg));
-	Vector3f noise = _rand_vec3f() * _sitl->mag_noise;
+	Vector3f noise = _rand_vec3f(SITL_RANDOM_MAG) * _sitl->mag_noise;
     Vector3f motor = _sitl->mag_mot.get() * _current;
+#if SITL_SENSOR_DRIVERS
+    // the same earth field and offsets as AP_Compass_HIL, so the
+    // COMPASS_OFS values in the SITL parameter files still apply
+    Matrix3f R;
+    R.from_euler(0, ToRad(66), _compass->get_declination());
+    Vector3f Bearth = R * Vector3f(400, 0, 0);
+    R.from_euler(radians(rollDeg), radians(pitchDeg), radians(yawDeg));
+    Vector3f field = R.mul_transpose(Bearth) - Vector3f(5, 13, -18);
+    _sim_hmc5883l.set_field(field + noise + motor);
+#else
+	_compass->setHIL(radians(rollDeg), radians(pitchDeg), radians(yawDeg));
     _compass->setHIL(_compass->getHIL() + noise+motor);
+#endif
 }
 
 #endif
@@ -0,0 +1,105 @@
+/*
+  SITL handling
+
+  This injects faults at set times, by changing SIM_ parameters from
+  a timeline file. Each line of the file is
+
+    TIME_SECONDS PARAMETER VALUE
+
+  for example
+
+    # lose GPS for 20 seconds, then glitch the barometer
+    30  SIM_GPS_DISABLE 1
+    50  SIM_GPS_DISABLE 0
+    60  SIM_BARO_GLITCH 20
+    90  SIM_ACCEL_FAIL  1
+    120 SIM_RC_FAIL     1
+
+  Times are from the start of the simulation, so in lockstep the
+  faults land on the same frame on every run
+ */
+
+#include <AP_HAL.h>
+#include <AP_Math.h>
+
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
+
+#include "AP_HAL_AVR_SITL.h"
+
+using namespace AVR_SITL;
+
+extern const AP_HAL::HAL& hal;
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+/*
+  load a fault timeline. The events must be in time order
+ */
+void SITL_State::_load_faults(const char *filename)
+{
+    FILE *f = fopen(filename, "r");
+    if (f == NULL) {
+        fprintf(stderr, "Unable to open fault file %s\n", filename);
+        exit(1);
+    }
+
+    char line[100];
+    uint16_t line_num = 0;
+    uint32_t last_time_ms = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        float time_s, value;
+        char name[AP_MAX_NAME_SIZE+1];
+        line_num++;
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (sscanf(line, "%f %16s %f", &time_s, name, &value) != 3) {
+            fprintf(stderr, "%s:%u: expected TIME PARAMETER VALUE\n", filename, (unsigned)line_num);
+            exit(1);
+        }
+        if (_num_fault_events == MAX_FAULT_EVENTS) {
+            fprintf(stderr, "%s:%u: too many fault events\n", filename, (unsigned)line_num);
+            exit(1);
+        }
+        struct fault_event &e = _fault_events[_num_fault_events];
+        e.time_ms = time_s * 1000;
+        e.value = value;
+        e.vp = AP_Param::find(name, &e.var_type);
+        if (e.vp == NULL) {
+            fprintf(stderr, "%s:%u: unknown parameter %s\n", filename, (unsigned)line_num, name);
+            exit(1);
+        }
+        if (e.time_ms < last_time_ms) {
+            fprintf(stderr, "%s:%u: events must be in time order\n", filename, (unsigned)line_num);
+            exit(1);
+        }
+        last_time_ms = e.time_ms;
+        _num_fault_events++;
+    }
+    fclose(f);
+
+    fprintf(stdout, "Loaded %u fault events from %s\n", (unsigned)_num_fault_events, filename);
+}
+
+/*
+  apply any fault events which are now due. The parameters are set but
+  not saved, so the timeline does not change the stored parameters
+ */
+void SITL_State::_update_faults(void)
+{
+    uint32_t now = hal.scheduler->millis();
+    while (_next_fault_event < _num_fault_events &&
+           _fault_events[_next_fault_event].time_ms <= now) {
+        struct fault_event &e = _fault_events[_next_fault_event];
+        if (!_set_param(e.vp, e.var_type, e.value, false)) {
+            fprintf(stderr, "Unable to set fault parameter\n");
+        } else {
+            fprintf(stdout, "Fault at %.3fs: parameter set to %f\n", now * 0.001f, e.value);
+        }
+        _next_fault_event++;
+    }
+}
+
+#endif
@@ -105,7 +105,7 @@ void SITL_State::_gps_write(const uint8_t *p, uint16_t size)
 {
 	while (size--) {
 		if (_sitl->gps_byteloss > 0.0) {
-			float r = ((((unsigned)random()) % 1000000)) / 1.0e4;
+			float r = (_rand_float(SITL_RANDOM_GPS) + 1.0f) * 50.0f;
 			if (r < _sitl->gps_byteloss) {
 				// lose the byte
 				p++;
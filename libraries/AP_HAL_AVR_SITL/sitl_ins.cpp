@@ -75,13 +75,13 @@ uint16_t SITL_State::_ground_sonar(float altitude)
             // adjust for apparent altitude with roll
             altitude /= cos(radians(_sitl->state.rollDeg)) * cos(radians(_sitl->state.pitchDeg));
 
-            altitude += _sitl->sonar_noise * _rand_float();
+            altitude += _sitl->sonar_noise * _rand_float(SITL_RANDOM_SONAR);
 
             // Altitude in in m, scaler in meters/volt
             voltage = altitude / _sitl->sonar_scale;
             voltage = constrain_float(voltage, 0, 5.0f);
 
-            if (_sitl->sonar_glitch >= (_rand_float() + 1.0f)/2.0f) {
+            if (_sitl->sonar_glitch >= (_rand_float(SITL_RANDOM_SONAR) + 1.0f)/2.0f) {
                 voltage = 5.0f;
             }
         }
@@ -89,6 +89,92 @@ uint16_t SITL_State::_ground_sonar(float altitude)
         return 1023*(voltage / 5.0f);
 }
 
+/*
+  add motor vibration to an IMU sample. The vibration is at the motor
+  rotation frequency and its first two harmonics, and the rotation
+  frequency scales with throttle up to SIM_VIB_FREQ
+ */
+void SITL_State::_add_vibration(float dt, Vector3f &accel, Vector3f &gyro)
+{
+	if (!_motors_on || _sitl->vib_freq <= 0) {
+		return;
+	}
+	_vib_phase = fmodf(_vib_phase + 2 * PI * _sitl->vib_freq * _throttle * dt, 2 * PI);
+
+	const Vector3f &vib_accel = _sitl->vib_accel.get();
+	const Vector3f vib_gyro = _sitl->vib_gyro.get() * DEG_TO_RAD;
+	for (uint8_t h=1; h<=3; h++) {
+		float s = sinf(h * _vib_phase) / h;
+		float c = cosf(h * _vib_phase) / h;
+		accel += Vector3f(vib_accel.x * s, vib_accel.y * c, vib_accel.z * s);
+		gyro  += Vector3f(vib_gyro.x * c, vib_gyro.y * s, vib_gyro.z * c);
+	}
+}
+
+/*
+  add IMU samples at SIM_IMU_RATE to the FIFO, up to the given time,
+  holding the given body frame acceleration and rotation rates. When
+  the FIFO is full the oldest samples are lost
+ */
+void SITL_State::_imu_synthesise(uint64_t until_usec, const Vector3f &accel, const Vector3f &gyro)
+{
+	if (_sitl->imu_rate <= 0) {
+		return;
+	}
+	uint32_t period_usec = 1000000UL / _sitl->imu_rate;
+	if (period_usec == 0) {
+		period_usec = 1;
+	}
+	if (_imu_next_usec == 0 || _imu_next_usec + 1000000UL < until_usec) {
+		// first sample, or we have been stopped for a long time
+		_imu_next_usec = until_usec;
+	}
+	while (_imu_next_usec <= until_usec) {
+		imu_sample &sample = _imu_fifo[(_imu_fifo_head + _imu_fifo_count) % IMU_FIFO_SIZE];
+		sample.accel = accel;
+		sample.gyro = gyro;
+		_add_vibration(period_usec * 1.0e-6f, sample.accel, sample.gyro);
+		if (_imu_fifo_count < IMU_FIFO_SIZE) {
+			_imu_fifo_count++;
+		} else {
+			_imu_fifo_head = (_imu_fifo_head + 1) % IMU_FIFO_SIZE;
+		}
+		_imu_next_usec += period_usec;
+	}
+}
+
+/*
+  empty the IMU FIFO, returning false if it had no samples. The HIL
+  sensor stands in for a driver that averages all the samples since
+  its last read. The simulated MPU9250 data registers hold the newest
+  sample, so vibration above half the rate the driver reads at
+  aliases, as it does on the real chip without its low pass filter
+ */
+bool SITL_State::_imu_fifo_read(Vector3f &accel, Vector3f &gyro)
+{
+	if (_imu_fifo_count == 0) {
+		return false;
+	}
+#if SITL_SENSOR_DRIVERS
+	const imu_sample &sample = _imu_fifo[(_imu_fifo_head + _imu_fifo_count - 1) % IMU_FIFO_SIZE];
+	accel = sample.accel;
+	gyro = sample.gyro;
+#else
+	accel.zero();
+	gyro.zero();
+	for (uint16_t i=0; i<_imu_fifo_count; i++) {
+		const imu_sample &sample = _imu_fifo[(_imu_fifo_head + i) % IMU_FIFO_SIZE];
+		accel += sample.accel;
+		gyro += sample.gyro;
+	}
+	accel /= _imu_fifo_count;
+	gyro /= _imu_fifo_count;
+#endif
+	_imu_fifo_head = (_imu_fifo_head + _imu_fifo_count) % IMU_FIFO_SIZE;
+	_imu_fifo_count = 0;
+	return true;
+}
+
 /*
   setup the INS input channels with new input
 
@@ -138,6 +224,24 @@ void SITL_State::_update_ins(float roll, 	float pitch, 	float yaw,		// Relative
 				 rollRate, pitchRate, yawRate,
 				 &p, &q, &r);
 
+	if (_sitl->imu_rate > 0) {
+		if (!_substepping()) {
+			// hold the state from this frame over the IMU samples
+			// since the last one
+			_imu_synthesise(_scheduler->_micros64(),
+					Vector3f(xAccel, yAccel, zAccel), Vector3f(p, q, r));
+		}
+		Vector3f accel, gyro;
+		if (_imu_fifo_read(accel, gyro)) {
+			xAccel = accel.x;
+			yAccel = accel.y;
+			zAccel = accel.z;
+			p = gyro.x;
+			q = gyro.y;
+			r = gyro.z;
+		}
+	}
+
 	// minimum noise levels are 2 bits, but averaged over many
 	// samples, giving around 0.01 m/s/s
 	float accel_noise = 0.01;
@@ -150,13 +254,16 @@ void SITL_State::_update_ins(float roll, 	float pitch, 	float yaw,		// Relative
 	}
 	// get accel bias (add only to first accelerometer)
 	Vector3f accel_bias = _sitl->accel_bias.get();
-	float xAccel1 = xAccel + accel_noise * _rand_float() + accel_bias.x;
-	float yAccel1 = yAccel + accel_noise * _rand_float() + accel_bias.y;
-	float zAccel1 = zAccel + accel_noise * _rand_float() + accel_bias.z;
-
-	float xAccel2 = xAccel + accel_noise * _rand_float();
-	float yAccel2 = yAccel + accel_noise * _rand_float();
-	float zAccel2 = zAccel + accel_noise * _rand_float();
+	float xAccel1 = xAccel + accel_noise * _rand_float(SITL_RANDOM_ACCEL) + accel_bias.x;
+	float yAccel1 = yAccel + accel_noise * _rand_float(SITL_RANDOM_ACCEL) + accel_bias.y;
+	float zAccel1 = zAccel + accel_noise * _rand_float(SITL_RANDOM_ACCEL) + accel_bias.z;
+
+#if !SITL_SENSOR_DRIVERS
+	// the simulated MPU9250 is a single IMU
+	float xAccel2 = xAccel + accel_noise * _rand_float(SITL_RANDOM_ACCEL);
+	float yAccel2 = yAccel + accel_noise * _rand_float(SITL_RANDOM_ACCEL);
+	float zAccel2 = zAccel + accel_noise * _rand_float(SITL_RANDOM_ACCEL);
+#endif
 
         if (fabs(_sitl->accel_fail) > 1.0e-6) {
             xAccel1 = _sitl->accel_fail;
@@ -164,27 +271,37 @@ void SITL_State::_update_ins(float roll, 	float pitch, 	float yaw,		// Relative
             zAccel1 = _sitl->accel_fail;
         }
 
+#if SITL_SENSOR_DRIVERS
+	_sim_mpu9250.set_accel(Vector3f(xAccel1, yAccel1, zAccel1) + _ins->get_accel_offsets(0));
+#else
 	_ins->set_accel(0, Vector3f(xAccel1, yAccel1, zAccel1) + _ins->get_accel_offsets(0));
 	_ins->set_accel(1, Vector3f(xAccel2, yAccel2, zAccel2) + _ins->get_accel_offsets(1));
+#endif
 
 	p += _gyro_drift();
 	q += _gyro_drift();
 	r += _gyro_drift();
 
-	float p1 = p + gyro_noise * _rand_float();
-	float q1 = q + gyro_noise * _rand_float();
-	float r1 = r + gyro_noise * _rand_float();
+	float p1 = p + gyro_noise * _rand_float(SITL_RANDOM_GYRO);
+	float q1 = q + gyro_noise * _rand_float(SITL_RANDOM_GYRO);
+	float r1 = r + gyro_noise * _rand_float(SITL_RANDOM_GYRO);
 
-	float p2 = p + gyro_noise * _rand_float();
-	float q2 = q + gyro_noise * _rand_float();
-	float r2 = r + gyro_noise * _rand_float();
+#if !SITL_SENSOR_DRIVERS
+	float p2 = p + gyro_noise * _rand_float(SITL_RANDOM_GYRO);
+	float q2 = q + gyro_noise * _rand_float(SITL_RANDOM_GYRO);
+	float r2 = r + gyro_noise * _rand_float(SITL_RANDOM_GYRO);
+#endif
 
+#if SITL_SENSOR_DRIVERS
+	_sim_mpu9250.set_gyro(Vector3f(p1, q1, r1) + _ins->get_gyro_offsets(0));
+#else
 	_ins->set_gyro(0, Vector3f(p1, q1, r1) + _ins->get_gyro_offsets(0));
 	_ins->set_gyro(1, Vector3f(p2, q2, r2) + _ins->get_gyro_offsets(1));
+#endif
 
 
         sonar_pin_value    = _ground_sonar(altitude);
-        airspeed_pin_value = _airspeed_sensor(airspeed + (_sitl->aspd_noise * _rand_float()));
+        airspeed_pin_value = _airspeed_sensor(airspeed + (_sitl->aspd_noise * _rand_float(SITL_RANDOM_AIRSPEED)));
 }
 
 #endif
@@ -23,8 +23,10 @@ extern const AP_HAL::HAL& hal;
 #define APM_LINUX_RCIN_PRIORITY     12
 #define APM_LINUX_MAIN_PRIORITY     11
 #define APM_LINUX_IO_PRIORITY       10
+#define APM_LINUX_BACKGROUND_PRIORITY 10
 
-LinuxScheduler::LinuxScheduler()
+LinuxScheduler::LinuxScheduler() :
+    _num_background_procs(0)
 {}
 
 typedef void *(*pthread_startroutine_t)(void *);
@@ -113,16 +115,23 @@ void LinuxScheduler::delay(uint16_t ms)
     }
 }
 
-uint64_t LinuxScheduler::millis64() 
+uint64_t LinuxScheduler::nanos64() 
 {
     if (stopped_clock_usec) {
-        return stopped_clock_usec/1000;
+        return stopped_clock_usec*1000ULL;
     }
     struct timespec ts;
     clock_gettime(CLOCK_MONOTONIC, &ts);
-    return 1.0e3*((ts.tv_sec + (ts.tv_nsec*1.0e-9)) - 
-                  (_sketch_start_time.tv_sec +
-                   (_sketch_start_time.tv_nsec*1.0e-9)));
+    return (uint64_t)(ts.tv_sec - _sketch_start_time.tv_sec)*1000000000ULL +
+        ts.tv_nsec - _sketch_start_time.tv_nsec;
+}
+
+uint64_t LinuxScheduler::millis64() 
+{
+    if (stopped_clock_usec) {
+        return stopped_clock_usec/1000;
+    }
+    return nanos64() / 1000000ULL;
 }
 
 uint64_t LinuxScheduler::micros64() 
@@ -130,11 +139,7 @@ uint64_t LinuxScheduler::micros64()
     if (stopped_clock_usec) {
         return stopped_clock_usec;
     }
-    struct timespec ts;
-    clock_gettime(CLOCK_MONOTONIC, &ts);
-    return 1.0e6*((ts.tv_sec + (ts.tv_nsec*1.0e-9)) - 
-                  (_sketch_start_time.tv_sec +
-                   (_sketch_start_time.tv_nsec*1.0e-9)));
+    return nanos64() / 1000ULL;
 }
 
 uint32_t LinuxScheduler::millis() 
@@ -260,6 +265,74 @@ void *LinuxScheduler::_timer_thread(void)
     return NULL;
 }
 
+/*
+  start a thread running proc at rate_hz below the main loop priority,
+  so it only gets the CPU time the main loop leaves free. It shares the
+  IO thread's priority. The scheduling is set explicitly, as by default
+  a new thread inherits the main thread's priority
+ */
+bool LinuxScheduler::register_background_process(AP_HAL::Proc proc, uint16_t rate_hz)
+{
+    if (_num_background_procs >= LINUX_SCHEDULER_MAX_BACKGROUND_PROCS ||
+        proc == NULL || rate_hz == 0) {
+        return false;
+    }
+    struct background_proc &bg = _background_proc[_num_background_procs];
+    bg.scheduler = this;
+    bg.proc = proc;
+    bg.period_usec = 1000000UL / rate_hz;
+
+    pthread_attr_t thread_attr;
+    struct sched_param param;
+
+    memset(&param, 0, sizeof(param));
+    param.sched_priority = APM_LINUX_BACKGROUND_PRIORITY;
+    if (pthread_attr_init(&thread_attr) != 0) {
+        return false;
+    }
+    bool ret = (pthread_attr_setinheritsched(&thread_attr, PTHREAD_EXPLICIT_SCHED) == 0 &&
+                pthread_attr_setschedpolicy(&thread_attr, SCHED_FIFO) == 0 &&
+                pthread_attr_setschedparam(&thread_attr, &param) == 0 &&
+                pthread_create(&bg.ctx, &thread_attr, &LinuxScheduler::_background_thread, &bg) == 0);
+    pthread_attr_destroy(&thread_attr);
+    if (!ret) {
+        return false;
+    }
+    _num_background_procs++;
+    return true;
+}
+
+void *LinuxScheduler::_background_thread(void *arg)
+{
+    struct background_proc *bg = (struct background_proc *)arg;
+    bg->scheduler->_setup_realtime(32768);
+    bg->scheduler->_run_periodic(bg->proc, bg->period_usec);
+    return NULL;
+}
+
+/*
+  call proc every period_usec once the system is initialised, with the
+  same drift free timing as the timer thread
+ */
+void LinuxScheduler::_run_periodic(AP_HAL::Proc proc, uint32_t period_usec)
+{
+    while (system_initializing()) {
+        poll(NULL, 0, 1);
+    }
+    uint64_t next_run_usec = micros64() + period_usec;
+    while (true) {
+        uint64_t dt = next_run_usec - micros64();
+        if (dt > 2*period_usec) {
+            // we've lost sync - restart
+            next_run_usec = micros64();
+        } else {
+            _microsleep(dt);
+        }
+        next_run_usec += period_usec;
+        proc();
+    }
+}
+
 void LinuxScheduler::_run_io(void)
 {
     if (_in_io_proc) {
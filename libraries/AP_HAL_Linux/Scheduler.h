@@ -10,6 +10,7 @@
 #include <pthread.h>
 
 #define LINUX_SCHEDULER_MAX_TIMER_PROCS 10
+#define LINUX_SCHEDULER_MAX_BACKGROUND_PROCS 4
 
 class Linux::LinuxScheduler : public AP_HAL::Scheduler {
 public:
@@ -20,6 +21,7 @@ public:
     uint32_t micros();
     uint64_t millis64();
     uint64_t micros64();
+    uint64_t nanos64();
     void     delay_microseconds(uint16_t us);
     void     register_delay_callback(AP_HAL::Proc,
                 uint16_t min_time_ms);
@@ -44,6 +46,8 @@ public:
 
     void     stop_clock(uint64_t time_usec);
 
+    bool     register_background_process(AP_HAL::Proc, uint16_t rate_hz);
+
 private:
     struct timespec _sketch_start_time;    
     void _timer_handler(int signum);
@@ -76,13 +80,23 @@ private:
     void *_io_thread(void);
     void *_rcin_thread(void);
     void *_uart_thread(void);
+    static void *_background_thread(void *arg);
 
     void _run_timers(bool called_from_timer_thread);
     void _run_io(void);
     void _setup_realtime(uint32_t size);
+    void _run_periodic(AP_HAL::Proc proc, uint32_t period_usec);
 
     uint64_t stopped_clock_usec;
 
+    struct background_proc {
+        LinuxScheduler *scheduler;
+        AP_HAL::Proc proc;
+        uint32_t period_usec;
+        pthread_t ctx;
+    } _background_proc[LINUX_SCHEDULER_MAX_BACKGROUND_PROCS];
+    uint8_t _num_background_procs;
+
     LinuxSemaphore _timer_semaphore;
 };
 
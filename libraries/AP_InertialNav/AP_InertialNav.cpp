@@ -108,16 +108,8 @@ void AP_InertialNav::update(float dt)
     // calculate new velocity
     _velocity += velocity_increase;
 
-    // store 3rd order estimate (i.e. estimated vertical position) for future use
-    _hist_position_estimate_z.push_back(_position_base.z);
-
-    // store 3rd order estimate (i.e. horizontal position) for future use at 10hz
-    _historic_xy_counter++;
-    if( _historic_xy_counter >= AP_INTERTIALNAV_SAVE_POS_AFTER_ITERATIONS ) {
-        _historic_xy_counter = 0;
-        _hist_position_estimate_x.push_back(_position_base.x);
-        _hist_position_estimate_y.push_back(_position_base.y);
-    }
+    // store 3rd order estimate (i.e. position) for future use
+    save_position_base(hal.scheduler->millis());
 }
 
 //
@@ -149,9 +141,8 @@ void AP_InertialNav::check_home() {
         _position.x -= x_offset_cm;
 
         // update historic positions
-        for (uint8_t i = 0; i < _hist_position_estimate_x.size(); i++) {
-            float &x = _hist_position_estimate_x.peek_mutable(i);
-            x -= x_offset_cm;
+        for (uint8_t i = 0; i < AP_INTERTIALNAV_HIST_LEN; i++) {
+            _hist_position[i].position_base.x -= x_offset_cm;
         }
 
         // update lon scaling
@@ -167,9 +158,8 @@ void AP_InertialNav::check_home() {
         _position.y -= y_offset_cm;
 
         // update historic positions
-        for (uint8_t i = 0; i < _hist_position_estimate_y.size(); i++) {
-            float &y = _hist_position_estimate_y.peek_mutable(i);
-            y -= y_offset_cm;
+        for (uint8_t i = 0; i < AP_INTERTIALNAV_HIST_LEN; i++) {
+            _hist_position[i].position_base.y -= y_offset_cm;
         }
     }
 
@@ -188,7 +178,8 @@ void AP_InertialNav::check_gps()
     if(gps.last_fix_time_ms() != _gps_last_time ) {
 
         // call position correction method
-        correct_with_gps(now, gps.location().lng, gps.location().lat);
+        uint32_t meas_time = gps.last_fix_time_ms() - AP_INTERTIALNAV_GPS_LAG_MS;
+        correct_with_gps(now, meas_time, gps.location().lng, gps.location().lat);
 
         // record gps time and system time of this update
         _gps_last_time = gps.last_fix_time_ms();
@@ -206,10 +197,9 @@ void AP_InertialNav::check_gps()
 }
 
 // correct_with_gps - modifies accelerometer offsets using gps
-void AP_InertialNav::correct_with_gps(uint32_t now, int32_t lon, int32_t lat)
+void AP_InertialNav::correct_with_gps(uint32_t now, uint32_t meas_time, int32_t lon, int32_t lat)
 {
     float dt,x,y;
-    float hist_position_base_x, hist_position_base_y;
 
     // calculate time since last gps reading
     dt = (float)(now - _gps_last_update) * 0.001f;
@@ -239,19 +229,13 @@ void AP_InertialNav::correct_with_gps(uint32_t now, int32_t lon, int32_t lat)
             _position_error.x = 0.0f;
             _position_error.y = 0.0f;
         }else{
-            // ublox gps positions are delayed by 400ms
-            // we store historical position at 10hz so 4 iterations ago
-            if( _hist_position_estimate_x.is_full()) {
-                hist_position_base_x = _hist_position_estimate_x.front();
-                hist_position_base_y = _hist_position_estimate_y.front();
-            }else{
-                hist_position_base_x = _position_base.x;
-                hist_position_base_y = _position_base.y;
-            }
+            // gps positions are delayed so compare them with our
+            // estimate from the time the gps measured them
+            Vector3f hist_position_base = get_historic_position_base(meas_time);
 
             // calculate error in position from gps with our historical estimate
-            _position_error.x = x - (hist_position_base_x + _position_correction.x);
-            _position_error.y = y - (hist_position_base_y + _position_correction.y);
+            _position_error.x = x - (hist_position_base.x + _position_correction.x);
+            _position_error.y = y - (hist_position_base.y + _position_correction.y);
         }
     }
 
@@ -297,9 +281,13 @@ void AP_InertialNav::setup_home_position(void)
     _last_home_lat = _ahrs.get_home().lat;
     _last_home_lng = _ahrs.get_home().lng;
 
-    // clear historic estimates
-    _hist_position_estimate_x.clear();
-    _hist_position_estimate_y.clear();
+    // clear historic estimates. The saved times and altitudes stay valid
+    // for the baro, and the zeroed xy positions match _position_base, so
+    // the next gps reading is compared with the new origin
+    for (uint8_t i = 0; i < AP_INTERTIALNAV_HIST_LEN; i++) {
+        _hist_position[i].position_base.x = 0.0f;
+        _hist_position[i].position_base.y = 0.0f;
+    }
 
     // set xy as enabled
     _xy_enabled = true;
@@ -353,15 +341,16 @@ void AP_InertialNav::check_baro()
     baro_update_time = _baro.get_last_update();
     if( baro_update_time != _baro_last_update ) {
         const float dt = (float)(baro_update_time - _baro_last_update) * 0.001f; // in seconds
+        uint32_t meas_time = baro_update_time - (uint32_t)(_baro.get_lag() * 1000.0f);
         // call correction method
-        correct_with_baro(_baro.get_altitude()*100.0f, dt);
+        correct_with_baro(_baro.get_altitude()*100.0f, meas_time, dt);
         _baro_last_update = baro_update_time;
     }
 }
 
 
 // correct_with_baro - modifies accelerometer offsets using barometer.  dt is time since last baro reading
-void AP_InertialNav::correct_with_baro(float baro_alt, float dt)
+void AP_InertialNav::correct_with_baro(float baro_alt, uint32_t meas_time, float dt)
 {
     static uint8_t first_reads = 0;
 
@@ -387,17 +376,12 @@ void AP_InertialNav::correct_with_baro(float baro_alt, float dt)
             set_altitude(baro_alt);
             _position_error.z = 0.0f;
         }else{
-            // 3rd order samples (i.e. position from baro) are delayed by 150ms (15 iterations at 100hz)
+            // 3rd order samples (i.e. position from baro) are delayed
             // so we should calculate error using historical estimates
-            float hist_position_base_z;
-            if (_hist_position_estimate_z.is_full()) {
-                hist_position_base_z = _hist_position_estimate_z.front();
-            } else {
-                hist_position_base_z = _position_base.z;
-            }
+            Vector3f hist_position_base = get_historic_position_base(meas_time);
 
             // calculate error in position from baro with our estimate
-            _position_error.z = baro_alt - (hist_position_base_z + _position_correction.z);
+            _position_error.z = baro_alt - (hist_position_base.z + _position_correction.z);
         }
     }
 
@@ -411,7 +395,11 @@ void AP_InertialNav::set_altitude( float new_altitude)
     _position_base.z = new_altitude;
     _position_correction.z = 0;
     _position.z = new_altitude; // _position = _position_base + _position_correction
-    _hist_position_estimate_z.clear(); // reset z history to avoid fake z velocity at next baro calibration (next rearm)
+
+    // reset z history to avoid fake z velocity at next baro calibration (next rearm)
+    for (uint8_t i = 0; i < AP_INTERTIALNAV_HIST_LEN; i++) {
+        _hist_position[i].position_base.z = new_altitude;
+    }
 }
 
 //
@@ -456,11 +444,57 @@ void AP_InertialNav::set_position_xy(float x, float y)
     _position_correction.y = 0.0f;
 
     // clear historic estimates
-    _hist_position_estimate_x.clear();
-    _hist_position_estimate_y.clear();
+    for (uint8_t i = 0; i < AP_INTERTIALNAV_HIST_LEN; i++) {
+        _hist_position[i].position_base.x = x;
+        _hist_position[i].position_base.y = y;
+    }
+}
+
+// save_position_base - save the uncorrected position estimate for later comparison to laggy gps and baro readings
+void AP_InertialNav::save_position_base(uint32_t now)
+{
+    _position_base_time = now;
+
+    // save at most once per interval so the buffer covers the same
+    // time at any main loop rate
+    if (_hist_count > 0 && now - _hist_position[_hist_newest].time < AP_INTERTIALNAV_HIST_INTERVAL_MS) {
+        return;
+    }
+    _hist_newest = (_hist_newest + 1) % AP_INTERTIALNAV_HIST_LEN;
+    _hist_position[_hist_newest].time = now;
+    _hist_position[_hist_newest].position_base = _position_base;
+    if (_hist_count < AP_INTERTIALNAV_HIST_LEN) {
+        _hist_count++;
+    }
+}
+
+// get_historic_position_base - return the uncorrected position estimate at an earlier time
+Vector3f AP_InertialNav::get_historic_position_base(uint32_t time) const
+{
+    // start with the latest estimate and step back through the
+    // saved positions until we pass the requested time
+    uint32_t newer_time = _position_base_time;
+    Vector3f newer_position = _position_base;
+    if ((int32_t)(time - newer_time) >= 0) {
+        return newer_position;
+    }
+    uint8_t idx = _hist_newest;
+    for (uint8_t i = 0; i < _hist_count; i++) {
+        const struct hist_position &older = _hist_position[idx];
+        if ((int32_t)(time - older.time) >= 0) {
+            // interpolate between the positions either side of the time
+            uint32_t span = newer_time - older.time;
+            if (span == 0) {
+                return older.position_base;
+            }
+            float ratio = (float)(time - older.time) / (float)span;
+            return older.position_base + (newer_position - older.position_base) * ratio;
+        }
+        newer_time = older.time;
+        newer_position = older.position_base;
+        idx = (idx + AP_INTERTIALNAV_HIST_LEN - 1) % AP_INTERTIALNAV_HIST_LEN;
+    }
 
-    // add new position for future use
-    _historic_xy_counter = 0;
-    _hist_position_estimate_x.push_back(_position_base.x);
-    _hist_position_estimate_y.push_back(_position_base.y);
+    // the time is before the oldest saved position, use the oldest
+    return newer_position;
 }
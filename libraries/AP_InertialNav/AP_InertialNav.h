@@ -6,7 +6,6 @@
 #include <AP_AHRS.h>
 #include <AP_InertialSensor.h>          // ArduPilot Mega IMU Library
 #include <AP_Baro.h>                    // ArduPilot Mega Barometer Library
-#include <AP_Buffer.h>                  // FIFO buffer library
 #include <AP_GPS_Glitch.h>              // GPS Glitch detection library
 #include <AP_Baro_Glitch.h>             // Baro Glitch detection library
 
@@ -14,9 +13,10 @@
 #define AP_INTERTIALNAV_TC_Z    5.0f // default time constant for complementary filter's Z axis
 
 // #defines to control how often historical accel based positions are saved
-// so they can later be compared to laggy gps readings
-#define AP_INTERTIALNAV_SAVE_POS_AFTER_ITERATIONS   10
-#define AP_INTERTIALNAV_GPS_LAG_IN_10HZ_INCREMENTS  4       // must not be larger than size of _hist_position_estimate_x and _hist_position_estimate_y
+// so they can later be compared to laggy gps and baro readings
+#define AP_INTERTIALNAV_HIST_INTERVAL_MS            20      // minimum time between saved positions
+#define AP_INTERTIALNAV_HIST_LEN                    24      // number of saved positions, must cover the gps and baro lag
+#define AP_INTERTIALNAV_GPS_LAG_MS                  400     // time from a gps position to its report arriving
 #define AP_INTERTIALNAV_GPS_TIMEOUT_MS              300     // timeout after which position error from GPS will fall to zero
 
 /*
@@ -47,12 +47,14 @@ public:
         _k3_xy(0.0f),
         _gps_last_update(0),
         _gps_last_time(0),
-        _historic_xy_counter(0),
         _lon_to_cm_scaling(LATLON_TO_CM),
         _k1_z(0.0f),
         _k2_z(0.0f),
         _k3_z(0.0f),
         _baro_last_update(0),
+        _hist_newest(0),
+        _hist_count(0),
+        _position_base_time(0),
         _glitch_detector(gps_glitch),
         _baro_glitch(baro_glitch),
         _error_count(0)
@@ -208,10 +210,11 @@ protected:
      * correct_with_gps - calculates horizontal position error using gps
      *
      * @param now : current time since boot in milliseconds
+     * @param meas_time : time since boot in milliseconds that the gps measured the position
      * @param lon : longitude in 100 nano degrees (i.e. degree value multiplied by 10,000,000)
      * @param lat : latitude  in 100 nano degrees (i.e. degree value multiplied by 10,000,000)
      */
-    void        correct_with_gps(uint32_t now, int32_t lon, int32_t lat);
+    void        correct_with_gps(uint32_t now, uint32_t meas_time, int32_t lon, int32_t lat);
 
     /**
      * check_home - checks if the home position has moved and offsets everything so it still lines up
@@ -237,9 +240,26 @@ protected:
      * correct_with_baro - calculates vertical position error using barometer.
      *
      * @param baro_alt : altitude in cm
+     * @param meas_time : time since boot in milliseconds that the barometer measured the altitude
      * @param dt : time since last baro reading in s
      */
-    void        correct_with_baro(float baro_alt, float dt);
+    void        correct_with_baro(float baro_alt, uint32_t meas_time, float dt);
+
+    /**
+     * save_position_base - saves the uncorrected position estimate for later comparison
+     * to laggy gps and baro readings, if enough time has passed since the last one was saved
+     *
+     * @param now : current time since boot in milliseconds
+     */
+    void        save_position_base(uint32_t now);
+
+    /**
+     * get_historic_position_base - returns the uncorrected position estimate at an earlier time,
+     * interpolated between the saved positions
+     *
+     * @param time : time since boot in milliseconds
+     */
+    Vector3f    get_historic_position_base(uint32_t time) const;
 
 
     /**
@@ -278,9 +298,6 @@ protected:
     float                   _k3_xy;                     // gain for horizontal accelerometer offset correction
     uint32_t                _gps_last_update;           // system time of last gps update in ms
     uint32_t                _gps_last_time;             // time of last gps update according to the gps itself in ms
-    uint8_t                 _historic_xy_counter;       // counter used to slow saving of position estimates for later comparison to gps
-    AP_BufferFloat_Size5    _hist_position_estimate_x;  // buffer of historic accel based position to account for gpslag
-    AP_BufferFloat_Size5    _hist_position_estimate_y;  // buffer of historic accel based position to account for gps lag
     float                   _lon_to_cm_scaling;         // conversion of longitude to centimeters
 
     // Z Axis specific variables
@@ -288,7 +305,15 @@ protected:
     float                   _k2_z;                      // gain for vertical velocity correction
     float                   _k3_z;                      // gain for vertical accelerometer offset correction
     uint32_t                _baro_last_update;          // time of last barometer update in ms
-    AP_BufferFloat_Size15   _hist_position_estimate_z;  // buffer of historic accel based altitudes to account for barometer lag
+
+    // historic accel based positions to account for gps and barometer lag
+    struct hist_position {
+        uint32_t            time;                       // time since boot in ms
+        Vector3f            position_base;              // _position_base at that time in cm
+    }                       _hist_position[AP_INTERTIALNAV_HIST_LEN];
+    uint8_t                 _hist_newest;               // index of the newest saved position
+    uint8_t                 _hist_count;                // number of saved positions
+    uint32_t                _position_base_time;        // time of the last update of _position_base in ms
 
     // general variables
     Vector3f                _position_base;             // (uncorrected) position estimate in cm - relative to the home location (_base_lat, _base_lon, 0)
@@ -25,12 +25,13 @@ void AP_InertialNav_NavEKF::init()
 void AP_InertialNav_NavEKF::update(float dt)
 {
     AP_InertialNav::update(dt);
-    _ahrs_ekf.get_NavEKF().getPosNED(_relpos_cm);
+    const AP_AHRS_NavEKF::ekf_outputs &ekf = _ahrs_ekf.get_ekf_outputs();
+    _relpos_cm = ekf.pos_ned;
     _relpos_cm *= 100; // convert to cm
 
     _haveabspos = _ahrs.get_position(_abspos);
 
-    _ahrs_ekf.get_NavEKF().getVelNED(_velocity_cm);
+    _velocity_cm = ekf.vel_ned;
     _velocity_cm *= 100; // convert to cm/s
 
     // InertialNav is NEU
@@ -7,15 +7,19 @@
 AP_InertialSensor_Backend::AP_InertialSensor_Backend(AP_InertialSensor &imu) :
     _imu(imu),
     _product_id(AP_PRODUCT_ID_NONE)
-{}
+{
+    _sensor_rotation[0] = ROTATION_NONE;
+    _sensor_rotation[1] = ROTATION_NONE;
+}
 
 /*
   rotate gyro vector and add the gyro offset
  */
 void AP_InertialSensor_Backend::_rotate_and_offset_gyro(uint8_t instance, const Vector3f &gyro)
 {
+    _update_rotation();
     _imu._gyro[instance] = gyro;
-    _imu._gyro[instance].rotate(_imu._board_orientation);
+    _rotation.rotate(_imu._gyro[instance]);
     _imu._gyro[instance] -= _imu._gyro_offset[instance];
     _imu._gyro_healthy[instance] = true;
 }
@@ -25,8 +29,9 @@ void AP_InertialSensor_Backend::_rotate_and_offset_gyro(uint8_t instance, const
  */
 void AP_InertialSensor_Backend::_rotate_and_offset_accel(uint8_t instance, const Vector3f &accel)
 {
+    _update_rotation();
     _imu._accel[instance] = accel;
-    _imu._accel[instance].rotate(_imu._board_orientation);
+    _rotation.rotate(_imu._accel[instance]);
 
     const Vector3f &accel_scale = _imu._accel_scale[instance].get();
     _imu._accel[instance].x *= accel_scale.x;
@@ -67,12 +67,29 @@ protected:
     // rotate accel vector, scale and offset
     void _rotate_and_offset_accel(uint8_t instance, const Vector3f &accel);
 
+    // set the fixed rotation of the sensor on the board. It is folded
+    // together with the board orientation, so drivers should call
+    // this once at init rather than rotating each sample themselves
+    void _set_sensor_rotation(enum Rotation r1, enum Rotation r2 = ROTATION_NONE) {
+        _sensor_rotation[0] = r1;
+        _sensor_rotation[1] = r2;
+    }
+
     // backend should fill in its product ID from AP_PRODUCT_ID_*
     int16_t _product_id;
 
     // return the default filter frequency in Hz for the sample rate
     uint8_t _default_filter(void) const;
 
+private:
+    // update the combined sensor and board rotation
+    void _update_rotation(void) {
+        _rotation.set(_sensor_rotation[0], _sensor_rotation[1], _imu._board_orientation);
+    }
+
+    enum Rotation _sensor_rotation[2];
+    RotationCache _rotation;
+
     // note that each backend is also expected to have a static detect()
     // function which instantiates an instance of the backend sensor
     // driver if the sensor is available
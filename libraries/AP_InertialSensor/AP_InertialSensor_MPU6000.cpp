@@ -181,12 +181,7 @@ AP_InertialSensor_MPU6000::AP_InertialSensor_MPU6000(AP_InertialSensor &imu) :
     _last_filter_hz(0),
     _error_count(0),
 #if MPU6000_FAST_SAMPLING
-    _accel_filter_x(1000, 15),
-    _accel_filter_y(1000, 15),
-    _accel_filter_z(1000, 15),
-    _gyro_filter_x(1000, 15),
-    _gyro_filter_y(1000, 15),
-    _gyro_filter_z(1000, 15),    
+    _imu_filter(1000, 15),
 #else
     _sample_count(0),
     _accel_sum(),
@@ -376,13 +371,16 @@ void AP_InertialSensor_MPU6000::_read_data_transaction() {
 
 #define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
 #if MPU6000_FAST_SAMPLING
-    _accel_filtered = Vector3f(_accel_filter_x.apply(int16_val(rx.v, 1)), 
-                               _accel_filter_y.apply(int16_val(rx.v, 0)), 
-                               _accel_filter_z.apply(-int16_val(rx.v, 2)));
-
-    _gyro_filtered = Vector3f(_gyro_filter_x.apply(int16_val(rx.v, 5)), 
-                              _gyro_filter_y.apply(int16_val(rx.v, 4)), 
-                              _gyro_filter_z.apply(-int16_val(rx.v, 6)));
+    float samples[6] = { (float)int16_val(rx.v, 1),
+                         (float)int16_val(rx.v, 0),
+                         (float)-int16_val(rx.v, 2),
+                         (float)int16_val(rx.v, 5),
+                         (float)int16_val(rx.v, 4),
+                         (float)-int16_val(rx.v, 6) };
+    _imu_filter.apply(samples, samples);
+
+    _accel_filtered = Vector3f(samples[0], samples[1], samples[2]);
+    _gyro_filtered = Vector3f(samples[3], samples[4], samples[5]);
 #else
     _accel_sum.x += int16_val(rx.v, 1);
     _accel_sum.y += int16_val(rx.v, 0);
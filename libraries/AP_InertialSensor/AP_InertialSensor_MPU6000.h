@@ -21,7 +21,7 @@
 
 #if MPU6000_FAST_SAMPLING
 #include <Filter.h>
-#include <LowPassFilter2p.h>
+#include <LowPassFilter2pBank.h>
 #endif
 
 class AP_InertialSensor_MPU6000 : public AP_InertialSensor_Backend
@@ -79,13 +79,8 @@ private:
     Vector3f _accel_filtered;
     Vector3f _gyro_filtered;
 
-    // Low Pass filters for gyro and accel 
-    LowPassFilter2p _accel_filter_x;
-    LowPassFilter2p _accel_filter_y;
-    LowPassFilter2p _accel_filter_z;
-    LowPassFilter2p _gyro_filter_x;
-    LowPassFilter2p _gyro_filter_y;
-    LowPassFilter2p _gyro_filter_z;
+    // Low Pass filters for accel x,y,z then gyro x,y,z, run together
+    LowPassFilter2pBank<6> _imu_filter;
 #else
     // accumulation in timer - must be read with timer disabled
     // the sum of the values since last read
@@ -17,10 +17,12 @@
 */
 
 #include <AP_HAL.h>
-#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX || CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL
 
 #include "AP_InertialSensor_MPU9250.h"
+#if CONFIG_HAL_BOARD == HAL_BOARD_LINUX
 #include "../AP_HAL_Linux/GPIO.h"
+#endif
 
 extern const AP_HAL::HAL& hal;
 
@@ -175,12 +177,7 @@ AP_InertialSensor_MPU9250::AP_InertialSensor_MPU9250(AP_InertialSensor &imu) :
 	AP_InertialSensor_Backend(imu),
     _last_filter_hz(-1),
     _shared_data_idx(0),
-    _accel_filter_x(1000, 15),
-    _accel_filter_y(1000, 15),
-    _accel_filter_z(1000, 15),
-    _gyro_filter_x(1000, 15),
-    _gyro_filter_y(1000, 15),
-    _gyro_filter_z(1000, 15),
+    _imu_filter(1000, 15),
     _have_sample_available(false)
 {
 }
@@ -251,6 +248,14 @@ bool AP_InertialSensor_MPU9250::_init_sensor(void)
 
     _product_id = AP_PRODUCT_ID_MPU9250;
 
+#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_PXF
+    // rotate for bbone default, PXF has an additional YAW 180
+    _set_sensor_rotation(ROTATION_ROLL_180_YAW_90, ROTATION_YAW_180);
+#else
+    // rotate for bbone default
+    _set_sensor_rotation(ROTATION_ROLL_180_YAW_90);
+#endif
+
     // start the timer process to read samples
     hal.scheduler->register_timer_process(AP_HAL_MEMBERPROC(&AP_InertialSensor_MPU9250::_poll_data));
 
@@ -275,16 +280,6 @@ bool AP_InertialSensor_MPU9250::update( void )
     accel *= MPU9250_ACCEL_SCALE_1G;
     gyro *= GYRO_SCALE;
 
-    // rotate for bbone default
-    accel.rotate(ROTATION_ROLL_180_YAW_90);
-    gyro.rotate(ROTATION_ROLL_180_YAW_90);
-
-#if CONFIG_HAL_BOARD_SUBTYPE == HAL_BOARD_SUBTYPE_LINUX_PXF
-    // PXF has an additional YAW 180
-    accel.rotate(ROTATION_YAW_180);
-    gyro.rotate(ROTATION_YAW_180);
-#endif
-
     _rotate_and_offset_gyro(_gyro_instance, gyro);
     _rotate_and_offset_accel(_accel_instance, accel);
 
@@ -333,13 +328,16 @@ void AP_InertialSensor_MPU9250::_read_data_transaction()
 
 #define int16_val(v, idx) ((int16_t)(((uint16_t)v[2*idx] << 8) | v[2*idx+1]))
 
-    Vector3f _accel_filtered = Vector3f(_accel_filter_x.apply(int16_val(rx.v, 1)), 
-                                        _accel_filter_y.apply(int16_val(rx.v, 0)), 
-                                        _accel_filter_z.apply(-int16_val(rx.v, 2)));
+    float samples[6] = { (float)int16_val(rx.v, 1),
+                         (float)int16_val(rx.v, 0),
+                         (float)-int16_val(rx.v, 2),
+                         (float)int16_val(rx.v, 5),
+                         (float)int16_val(rx.v, 4),
+                         (float)-int16_val(rx.v, 6) };
+    _imu_filter.apply(samples, samples);
 
-    Vector3f _gyro_filtered = Vector3f(_gyro_filter_x.apply(int16_val(rx.v, 5)), 
-                                       _gyro_filter_y.apply(int16_val(rx.v, 4)), 
-                                       _gyro_filter_z.apply(-int16_val(rx.v, 6)));
+    Vector3f _accel_filtered = Vector3f(samples[0], samples[1], samples[2]);
+    Vector3f _gyro_filtered = Vector3f(samples[3], samples[4], samples[5]);
     // update the shared buffer
     uint8_t idx = _shared_data_idx ^ 1;
     _shared_data[idx]._accel_filtered = _accel_filtered;
@@ -387,13 +385,7 @@ void AP_InertialSensor_MPU9250::_set_filter(uint8_t filter_hz)
         filter_hz = _default_filter_hz;
     }
 
-    _accel_filter_x.set_cutoff_frequency(1000, filter_hz);
-    _accel_filter_y.set_cutoff_frequency(1000, filter_hz);
-    _accel_filter_z.set_cutoff_frequency(1000, filter_hz);
-
-    _gyro_filter_x.set_cutoff_frequency(1000, filter_hz);
-    _gyro_filter_y.set_cutoff_frequency(1000, filter_hz);
-    _gyro_filter_z.set_cutoff_frequency(1000, filter_hz);    
+    _imu_filter.set_cutoff_frequency(1000, filter_hz);
 }
 
 
@@ -8,7 +8,7 @@
 #include <AP_Math.h>
 #include <AP_Progmem.h>
 #include <Filter.h>
-#include <LowPassFilter2p.h>
+#include <LowPassFilter2pBank.h>
 #include "AP_InertialSensor.h"
 
 // enable debug to see a register dump on startup
@@ -59,13 +59,8 @@ private:
     } _shared_data[2];
     volatile uint8_t _shared_data_idx;
 
-    // Low Pass filters for gyro and accel 
-    LowPassFilter2p _accel_filter_x;
-    LowPassFilter2p _accel_filter_y;
-    LowPassFilter2p _accel_filter_z;
-    LowPassFilter2p _gyro_filter_x;
-    LowPassFilter2p _gyro_filter_y;
-    LowPassFilter2p _gyro_filter_z;
+    // Low Pass filters for accel x,y,z then gyro x,y,z, run together
+    LowPassFilter2pBank<6> _imu_filter;
 
     // do we currently have a sample pending?
     bool _have_sample_available;
@@ -192,18 +192,18 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
 		Vector2f A_air_unit = (A_air).normalized(); // Unit vector from WP A to aircraft
 		xtrackVel = _groundspeed_vector % (-A_air_unit); // Velocity across line
 		ltrackVel = _groundspeed_vector * (-A_air_unit); // Velocity along line
-		Nu = atan2f(xtrackVel,ltrackVel);
+		Nu = fast_atan2_precise(xtrackVel,ltrackVel);
 
         _prevent_indecision(Nu);
 
-		_nav_bearing = atan2f(-A_air_unit.y , -A_air_unit.x); // bearing (radians) from AC to L1 point
+		_nav_bearing = fast_atan2_precise(-A_air_unit.y , -A_air_unit.x); // bearing (radians) from AC to L1 point
 
 	} else { //Calc Nu to fly along AB line
 			
 		//Calculate Nu2 angle (angle of velocity vector relative to line connecting waypoints)
 		xtrackVel = _groundspeed_vector % AB; // Velocity cross track
 		ltrackVel = _groundspeed_vector * AB; // Velocity along track
-		float Nu2 = atan2f(xtrackVel,ltrackVel);
+		float Nu2 = fast_atan2_precise(xtrackVel,ltrackVel);
 		//Calculate Nu1 angle (Angle to L1 reference point)
 		float xtrackErr = A_air % AB;
 		float sine_Nu1 = xtrackErr/max(_L1_dist, 0.1f);
@@ -211,14 +211,14 @@ void AP_L1_Control::update_waypoint(const struct Location &prev_WP, const struct
 		sine_Nu1 = constrain_float(sine_Nu1, -0.7071f, 0.7071f);
 		float Nu1 = asinf(sine_Nu1);
 		Nu = Nu1 + Nu2;
-		_nav_bearing = atan2f(AB.y, AB.x) + Nu1; // bearing (radians) from AC to L1 point		
+		_nav_bearing = fast_atan2_precise(AB.y, AB.x) + Nu1; // bearing (radians) from AC to L1 point		
 	}	
 
     _last_Nu = Nu;
 			
 	//Limit Nu to +-pi
 	Nu = constrain_float(Nu, -1.5708f, +1.5708f);
-	_latAccDem = K_L1 * groundSpeed * groundSpeed / _L1_dist * sinf(Nu);
+	_latAccDem = K_L1 * groundSpeed * groundSpeed / _L1_dist * fast_sinf(Nu);
 	
 	// Waypoint capture status is always false during waypoint following
 	_WPcircle = false;
@@ -282,7 +282,7 @@ void AP_L1_Control::update_loiter(const struct Location &center_WP, float radius
 	//Calculate Nu to capture center_WP
 	float xtrackVelCap = A_air_unit % _groundspeed_vector; // Velocity across line - perpendicular to radial inbound to WP
 	float ltrackVelCap = - (_groundspeed_vector * A_air_unit); // Velocity along line - radial inbound to WP
-	float Nu = atan2f(xtrackVelCap,ltrackVelCap);
+	float Nu = fast_atan2_precise(xtrackVelCap,ltrackVelCap);
 
     _prevent_indecision(Nu);
     _last_Nu = Nu;
@@ -290,7 +290,7 @@ void AP_L1_Control::update_loiter(const struct Location &center_WP, float radius
 	Nu = constrain_float(Nu, -M_PI_2, M_PI_2); //Limit Nu to +- Pi/2
 
 	//Calculate lat accln demand to capture center_WP (use L1 guidance law)
-	float latAccDemCap = K_L1 * groundSpeed * groundSpeed / _L1_dist * sinf(Nu);
+	float latAccDemCap = K_L1 * groundSpeed * groundSpeed / _L1_dist * fast_sinf(Nu);
 	
 	//Calculate radial position and velocity errors
 	float xtrackVelCirc = -ltrackVelCap; // Radial outbound velocity - reuse previous radial inbound velocity
@@ -323,12 +323,12 @@ void AP_L1_Control::update_loiter(const struct Location &center_WP, float radius
 		_latAccDem = latAccDemCap;
 		_WPcircle = false;
 		_bearing_error = Nu; // angle between demanded and achieved velocity vector, +ve to left of track
-		_nav_bearing = atan2f(-A_air_unit.y , -A_air_unit.x); // bearing (radians) from AC to L1 point
+		_nav_bearing = fast_atan2_precise(-A_air_unit.y , -A_air_unit.x); // bearing (radians) from AC to L1 point
 	} else {
 		_latAccDem = latAccDemCirc;
 		_WPcircle = true;
 		_bearing_error = 0.0f; // bearing error (radians), +ve to left of track
-		_nav_bearing = atan2f(-A_air_unit.y , -A_air_unit.x); // bearing (radians)from AC to L1 point
+		_nav_bearing = fast_atan2_precise(-A_air_unit.y , -A_air_unit.x); // bearing (radians)from AC to L1 point
 	}
 }
 
@@ -16,8 +16,10 @@
 #include "vector2.h"
 #include "vector3.h"
 #include "matrix3.h"
+#include "rotation_cache.h"
 #include "quaternion.h"
 #include "polygon.h"
+#include "fast_math.h"
 #include "edc.h"
 
 #ifndef M_PI_F
@@ -127,6 +129,33 @@ void        location_offset(struct Location &loc, float ofs_north, float ofs_eas
  */
 Vector2f location_diff(const struct Location &loc1, const struct Location &loc2);
 
+/*
+  a local tangent plane frame around an origin location. The frame
+  holds the longitude scaling of the origin so callers comparing many
+  locations against the same origin calculate it once, and do not
+  depend on the longitude_scale() cache
+ */
+struct Location_Frame {
+    int32_t lat;
+    int32_t lng;
+    float lon_scale;
+};
+
+// setup a frame around an origin location
+void        location_frame_init(struct Location_Frame &frame, const struct Location &origin);
+
+// return distance in meters from the frame origin to a location
+float       get_distance(const struct Location_Frame &frame, const struct Location &loc);
+
+// return bearing in centi-degrees from the frame origin to a location
+int32_t     get_bearing_cd(const struct Location_Frame &frame, const struct Location &loc);
+
+// return the N/E distance in meters from the frame origin to a location
+Vector2f    location_diff(const struct Location_Frame &frame, const struct Location &loc);
+
+// extrapolate latitude/longitude of a location near the frame origin given distances north and east
+void        location_offset(const struct Location_Frame &frame, struct Location &loc, float ofs_north, float ofs_east);
+
 /*
   wrap an angle in centi-degrees
  */
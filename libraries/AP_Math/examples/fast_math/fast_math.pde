@@ -0,0 +1,234 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Accuracy and speed tests for the AP_Math fast math kernels
+//
+
+#include <AP_HAL.h>
+#include <stdlib.h>
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Empty.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_Math.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define NUM_SAMPLES 20000
+#define ARRAY_SIZE  64
+
+static bool all_passed = true;
+
+// volatile sink so the speed loops are not optimised away
+static volatile float sink;
+
+static float test_x[ARRAY_SIZE];
+static float test_y[ARRAY_SIZE];
+static float out_a[ARRAY_SIZE];
+static float out_b[ARRAY_SIZE];
+
+// errors are printed in millionths to avoid %e on AVR
+static void check_error(const char *name, double max_error, double limit)
+{
+    bool ok = max_error <= limit;
+    hal.console->printf_P(PSTR("%-22s max error %9.3f e-6 limit %9.3f e-6 %s\n"),
+                          name, max_error*1.0e6, limit*1.0e6, ok ? "PASS" : "FAIL");
+    if (!ok) {
+        all_passed = false;
+    }
+}
+
+static void test_sincos(const char *name, float range)
+{
+    double max_sin = 0, max_cos = 0, max_pair = 0;
+    for (uint32_t i=0; i<=NUM_SAMPLES; i++) {
+        float x = range * (2.0f*i/NUM_SAMPLES - 1.0f);
+        double s = sin((double)x);
+        double c = cos((double)x);
+        float fs, fc;
+        fast_sincosf(x, fs, fc);
+        max_sin = max(max_sin, fabs(fast_sinf(x) - s));
+        max_cos = max(max_cos, fabs(fast_cosf(x) - c));
+        max_pair = max(max_pair, max(fabs(fs - s), fabs(fc - c)));
+    }
+    hal.console->printf_P(PSTR("%s +-%.0f rad:\n"), name, range);
+    check_error("  fast_sinf", max_sin, 1.5e-7);
+    check_error("  fast_cosf", max_cos, 1.5e-7);
+    check_error("  fast_sincosf", max_pair, 1.5e-7);
+}
+
+static void test_atan2(void)
+{
+    double max_err = 0;
+    double max_err_old = 0;
+    for (uint32_t i=0; i<NUM_SAMPLES; i++) {
+        float angle = 2*PI*i/NUM_SAMPLES - PI;
+        float len = 0.01f + (i % 100);
+        float y = len * sinf(angle);
+        float x = len * cosf(angle);
+        double a = atan2((double)y, (double)x);
+        max_err = max(max_err, fabs(fast_atan2_precise(y, x) - a));
+        max_err_old = max(max_err_old, fabs(fast_atan2(y, x) - a));
+    }
+    check_error("fast_atan2_precise", max_err, 2.5e-6);
+    check_error("fast_atan2", max_err_old, 5.0e-3);
+    if (fast_atan2_precise(0, 0) != 0 ||
+        fabsf(fast_atan2_precise(1, 0) - PI/2) > 1.0e-6f ||
+        fabsf(fast_atan2_precise(0, -1) - PI) > 1.0e-6f) {
+        hal.console->println("fast_atan2_precise axes FAIL");
+        all_passed = false;
+    }
+}
+
+static void test_inv_sqrt(void)
+{
+    double max_err = 0;
+    for (uint32_t i=1; i<=NUM_SAMPLES; i++) {
+        // cover several decades
+        float x = i * 1.0e-3f * (1 + (i % 7) * 100);
+        double r = 1.0 / sqrt((double)x);
+        max_err = max(max_err, fabs(fast_inv_sqrtf(x) - r) / r);
+    }
+    check_error("fast_inv_sqrtf (rel)", max_err, 5.0e-6);
+    if (fast_inv_sqrtf(0) != 0 || fast_inv_sqrtf(-1) != 0) {
+        hal.console->println("fast_inv_sqrtf non-positive FAIL");
+        all_passed = false;
+    }
+}
+
+static void test_arrays(void)
+{
+    bool ok = true;
+    for (uint8_t i=0; i<ARRAY_SIZE; i++) {
+        test_x[i] = (i - ARRAY_SIZE/2) * 0.37f;
+        test_y[i] = i * 0.5f;
+    }
+    fast_sincosf_array(test_x, out_a, out_b, ARRAY_SIZE);
+    for (uint8_t i=0; i<ARRAY_SIZE; i++) {
+        float s, c;
+        fast_sincosf(test_x[i], s, c);
+        if (s != out_a[i] || c != out_b[i]) {
+            ok = false;
+        }
+    }
+    fast_inv_sqrtf_array(test_y, out_a, ARRAY_SIZE);
+    for (uint8_t i=0; i<ARRAY_SIZE; i++) {
+        if (out_a[i] != fast_inv_sqrtf(test_y[i])) {
+            ok = false;
+        }
+    }
+    hal.console->printf_P(PSTR("array variants match  %s\n"), ok ? "PASS" : "FAIL");
+    if (!ok) {
+        all_passed = false;
+    }
+}
+
+static void print_speed(const char *name, uint32_t libm_us, uint32_t fast_us, uint32_t count)
+{
+    hal.console->printf_P(PSTR("%-22s libm %7.3f us fast %7.3f us\n"),
+                          name, (float)libm_us/count, (float)fast_us/count);
+}
+
+static void test_speed(void)
+{
+    const uint32_t count = 200;
+    float sum = 0;
+    uint32_t t0, t1, t2;
+
+    for (uint8_t i=0; i<ARRAY_SIZE; i++) {
+        test_x[i] = (i - ARRAY_SIZE/2) * 0.1f;
+        test_y[i] = 0.5f + i;
+    }
+
+    hal.console->printf_P(PSTR("\nspeed per call, %u calls:\n"), (unsigned)(count*ARRAY_SIZE));
+
+    t0 = hal.scheduler->micros();
+    for (uint32_t n=0; n<count; n++) {
+        for (uint8_t i=0; i<ARRAY_SIZE; i++) {
+            sum += sinf(test_x[i]) + cosf(test_x[i]);
+        }
+    }
+    t1 = hal.scheduler->micros();
+    for (uint32_t n=0; n<count; n++) {
+        for (uint8_t i=0; i<ARRAY_SIZE; i++) {
+            float s, c;
+            fast_sincosf(test_x[i], s, c);
+            sum += s + c;
+        }
+    }
+    t2 = hal.scheduler->micros();
+    print_speed("sinf+cosf / sincos", t1-t0, t2-t1, count*ARRAY_SIZE);
+
+    t0 = hal.scheduler->micros();
+    for (uint32_t n=0; n<count; n++) {
+        for (uint8_t i=0; i<ARRAY_SIZE; i++) {
+            out_a[i] = sinf(test_x[i]);
+            out_b[i] = cosf(test_x[i]);
+        }
+        sum += out_a[n % ARRAY_SIZE];
+    }
+    t1 = hal.scheduler->micros();
+    for (uint32_t n=0; n<count; n++) {
+        fast_sincosf_array(test_x, out_a, out_b, ARRAY_SIZE);
+        sum += out_a[n % ARRAY_SIZE];
+    }
+    t2 = hal.scheduler->micros();
+    print_speed("sincos array", t1-t0, t2-t1, count*ARRAY_SIZE);
+
+    t0 = hal.scheduler->micros();
+    for (uint32_t n=0; n<count; n++) {
+        for (uint8_t i=0; i<ARRAY_SIZE; i++) {
+            sum += atan2f(test_x[i], test_y[i]);
+        }
+    }
+    t1 = hal.scheduler->micros();
+    for (uint32_t n=0; n<count; n++) {
+        for (uint8_t i=0; i<ARRAY_SIZE; i++) {
+            sum += fast_atan2_precise(test_x[i], test_y[i]);
+        }
+    }
+    t2 = hal.scheduler->micros();
+    print_speed("atan2f", t1-t0, t2-t1, count*ARRAY_SIZE);
+
+    t0 = hal.scheduler->micros();
+    for (uint32_t n=0; n<count; n++) {
+        for (uint8_t i=0; i<ARRAY_SIZE; i++) {
+            sum += 1.0f / sqrtf(test_y[i]);
+        }
+    }
+    t1 = hal.scheduler->micros();
+    for (uint32_t n=0; n<count; n++) {
+        for (uint8_t i=0; i<ARRAY_SIZE; i++) {
+            sum += fast_inv_sqrtf(test_y[i]);
+        }
+    }
+    t2 = hal.scheduler->micros();
+    print_speed("1/sqrtf", t1-t0, t2-t1, count*ARRAY_SIZE);
+
+    sink = sum;
+}
+
+void setup(void)
+{
+    hal.console->println("fast math unit tests\n");
+
+    test_sincos("attitude angles", PI);
+    test_sincos("unwrapped angles", 100);
+    test_sincos("large angles", FAST_MATH_MAX_ANGLE);
+    test_atan2();
+    test_inv_sqrt();
+    test_arrays();
+    test_speed();
+
+    hal.console->println(all_passed ? "\nALL TESTS PASSED" : "\nTEST FAILED");
+}
+
+void loop(void)
+{
+    hal.scheduler->delay(1000);
+}
+
+AP_HAL_MAIN();
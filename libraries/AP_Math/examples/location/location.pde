@@ -113,6 +113,14 @@ static void test_one_offset(const struct Location &loc,
         hal.console->printf("Failed offset test brg_error=%f dist_error=%f\n",
                       brg_error, dist-dist2);
     }
+
+    // the frame functions should agree with the plain ones
+    struct Location_Frame frame;
+    location_frame_init(frame, loc);
+    if (fabsf(get_distance(frame, loc2) - dist2) > 1.0 ||
+        labs(wrap_180_cd(get_bearing_cd(frame, loc2) - get_bearing_cd(loc, loc2))) > 100) {
+        hal.console->printf("Failed frame offset test\n");
+    }
 }
 
 static const struct {
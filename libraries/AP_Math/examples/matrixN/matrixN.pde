@@ -0,0 +1,266 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Unit tests and benchmark for the AP_Math MatrixN code
+//
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_Math.h>
+#include <matrixN.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Linux.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+// same size as the NavEKF state
+#define NSTATES 22
+
+typedef MatrixN<float,NSTATES,NSTATES> Matrix22;
+typedef MatrixN<float,NSTATES,1> Column22;
+typedef MatrixN<float,1,NSTATES> Row22;
+
+static Matrix22 P, P2, KHP;
+static Column22 K;
+static Row22 H;
+static float P_array[NSTATES][NSTATES];
+static float KH_array[NSTATES][NSTATES];
+static float KHP_array[NSTATES][NSTATES];
+
+static bool all_passed = true;
+
+static void check(const char *name, float err, float tolerance)
+{
+    bool ok = fabsf(err) <= tolerance;
+    hal.console->printf_P(PSTR("%-30s err=%g %s\n"), name, err, ok ? "PASS" : "FAIL");
+    if (!ok) {
+        all_passed = false;
+    }
+}
+
+// pseudo-random float in the range -1 to 1
+static float rand_float(void)
+{
+    static uint32_t seed = 12345;
+    seed = seed * 1664525UL + 1013904223UL;
+    return ((int32_t)(seed >> 8) - 0x800000) / (float)0x800000;
+}
+
+// fill P with a symmetric positive definite matrix, like a covariance
+static void fill_covariance(void)
+{
+    Matrix22 A;
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            A(i,j) = rand_float();
+        }
+    }
+    Matrix22 ident;
+    ident.identity();
+    P = A * A.transposed() * 0.1f + ident;
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            P_array[i][j] = P(i,j);
+        }
+        K(i,0) = rand_float();
+        H(0,i) = rand_float();
+    }
+}
+
+static float max_diff(const Matrix22 &m, float a[NSTATES][NSTATES])
+{
+    float err = 0;
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            err = max(err, fabsf(m(i,j) - a[i][j]));
+        }
+    }
+    return err;
+}
+
+// covariance update written out as in the NavEKF fusion code
+static void fuse_by_hand(void)
+{
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            KH_array[i][j] = K(i,0) * H(0,j);
+        }
+    }
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            KHP_array[i][j] = 0;
+            for (uint8_t k=0; k<NSTATES; k++) {
+                KHP_array[i][j] = KHP_array[i][j] + KH_array[i][k] * P_array[k][j];
+            }
+        }
+    }
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            P_array[i][j] = P_array[i][j] - KHP_array[i][j];
+        }
+    }
+}
+
+static void test_expressions(void)
+{
+    hal.console->println("Expression tests:");
+    fill_covariance();
+
+    // the same update in the same order
+    KHP = (K * H) * P;
+    P2 = P - KHP;
+    fuse_by_hand();
+    check("P - (K*H)*P", max_diff(P2, P_array), 1.0e-4f);
+
+    // K*(H*P) is a rank one update, with H*P evaluated once
+    P2 = P;
+    P2 -= K * (H * P);
+    check("P -= K*(H*P)", max_diff(P2, P_array), 1.0e-4f);
+
+    // aliased assignment must give the same answer as via a temporary
+    Matrix22 F;
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            F(i,j) = rand_float();
+        }
+    }
+    Matrix22 expected = F * P * F.transposed();
+    P2 = P;
+    P2 = F * P2 * transpose(F);
+    float err = 0;
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            err = max(err, fabsf(P2(i,j) - expected(i,j)));
+        }
+    }
+    check("aliased F*P*F'", err, 1.0e-3f);
+
+    // symmetric storage only computes the upper triangle
+    MatrixSym<float,NSTATES> Ps;
+    Ps = F * P * F.transposed();
+    err = 0;
+    for (uint8_t i=0; i<NSTATES; i++) {
+        for (uint8_t j=0; j<NSTATES; j++) {
+            err = max(err, fabsf(Ps(i,j) - expected(i,j)));
+        }
+    }
+    check("symmetric F*P*F'", err, 1.0e-3f);
+
+    // block views
+    Matrix22 B;
+    B.block<3,3>(4,7) = P.block<3,3>(0,0) * 2.0f;
+    err = 0;
+    for (uint8_t i=0; i<3; i++) {
+        for (uint8_t j=0; j<3; j++) {
+            err = max(err, fabsf(B(4+i,7+j) - 2*P(i,j)));
+        }
+    }
+    err = max(err, fabsf(B(3,7)) + fabsf(B(4,6)) + fabsf(B(7,10)));
+    check("block", err, 1.0e-6f);
+}
+
+static void test_solvers(void)
+{
+    hal.console->println("Solver tests:");
+    fill_covariance();
+
+    VectorN<float,NSTATES> x_true, b, x, D;
+    for (uint8_t i=0; i<NSTATES; i++) {
+        x_true[i] = rand_float();
+    }
+    b = P * x_true;
+
+    MatrixLower<float,NSTATES> L;
+    float err = 0;
+    if (!matrix_cholesky(P, L)) {
+        hal.console->println("cholesky failed");
+        all_passed = false;
+    }
+    matrix_cholesky_solve(L, b, x);
+    for (uint8_t i=0; i<NSTATES; i++) {
+        err = max(err, fabsf(x[i] - x_true[i]));
+    }
+    check("cholesky solve", err, 1.0e-3f);
+
+    // L*L' must reconstruct P
+    Matrix22 LLt = L * transpose(L);
+    check("cholesky L*L'", max_diff(LLt, P_array), 1.0e-3f);
+
+    if (!matrix_ldlt(P, L, D)) {
+        hal.console->println("ldlt failed");
+        all_passed = false;
+    }
+    matrix_ldlt_solve(L, D, b, x);
+    err = 0;
+    for (uint8_t i=0; i<NSTATES; i++) {
+        err = max(err, fabsf(x[i] - x_true[i]));
+    }
+    check("ldlt solve", err, 1.0e-3f);
+
+    // an indefinite matrix has no Cholesky factor
+    MatrixN<float,2,2> M;
+    M(0,0) = 1; M(0,1) = 2;
+    M(1,0) = 2; M(1,1) = 1;
+    MatrixLower<float,2> L2;
+    check("cholesky rejects indefinite", matrix_cholesky(M, L2) ? 1 : 0, 0);
+}
+
+static void benchmark(void)
+{
+    const uint16_t count = 100;
+    uint32_t start_time;
+
+    hal.console->println("Benchmark, 22 state covariance update:");
+    fill_covariance();
+
+    start_time = hal.scheduler->micros();
+    for (uint16_t n=0; n<count; n++) {
+        fuse_by_hand();
+    }
+    hal.console->printf("hand written loops: %u usec/call\n",
+                        (unsigned)((hal.scheduler->micros() - start_time)/count));
+
+    start_time = hal.scheduler->micros();
+    for (uint16_t n=0; n<count; n++) {
+        KHP = (K * H) * P;
+        P -= KHP;
+    }
+    hal.console->printf("P -= (K*H)*P: %u usec/call\n",
+                        (unsigned)((hal.scheduler->micros() - start_time)/count));
+
+    start_time = hal.scheduler->micros();
+    for (uint16_t n=0; n<count; n++) {
+        P -= K * (H * P);
+    }
+    hal.console->printf("P -= K*(H*P): %u usec/call\n",
+                        (unsigned)((hal.scheduler->micros() - start_time)/count));
+
+    fill_covariance();
+    VectorN<float,NSTATES> b, x, D;
+    MatrixLower<float,NSTATES> L;
+    start_time = hal.scheduler->micros();
+    for (uint16_t n=0; n<count; n++) {
+        matrix_ldlt(P, L, D);
+        matrix_ldlt_solve(L, D, b, x);
+    }
+    hal.console->printf("ldlt decompose and solve: %u usec/call\n",
+                        (unsigned)((hal.scheduler->micros() - start_time)/count));
+}
+
+void setup(void)
+{
+    hal.console->println("MatrixN unit tests\n");
+
+    test_expressions();
+    test_solvers();
+    benchmark();
+
+    hal.console->println(all_passed ? "ALL TESTS PASSED" : "TEST FAILED");
+}
+
+void loop(void){}
+
+AP_HAL_MAIN();
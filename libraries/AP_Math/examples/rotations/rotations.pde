@@ -176,6 +176,47 @@ static void missing_rotations(void)
             }
 }
 
+/*
+  test that a RotationCache gives the same result as applying each
+  rotation in turn, and time the two approaches
+ */
+static void test_rotation_cache(void)
+{
+    hal.console->println("testing RotationCache");
+    uint16_t failures = 0;
+    for (uint8_t r1=ROTATION_NONE; r1<ROTATION_MAX; r1++) {
+        for (uint8_t r2=ROTATION_NONE; r2<ROTATION_MAX; r2++) {
+            RotationCache cache;
+            cache.set((enum Rotation)r1, (enum Rotation)r2);
+            Vector3f v1(1, 2, 3), v2(1, 2, 3);
+            v1.rotate((enum Rotation)r1);
+            v1.rotate((enum Rotation)r2);
+            cache.rotate(v2);
+            if ((v1 - v2).length() > 1.0e-5f) {
+                hal.console->printf("RotationCache mismatch for %u,%u\n", (unsigned)r1, (unsigned)r2);
+                failures++;
+            }
+        }
+    }
+
+    RotationCache cache;
+    cache.set(ROTATION_ROLL_180_YAW_90, ROTATION_YAW_180, ROTATION_YAW_45);
+    Vector3f v(1, 2, 3);
+    uint32_t t0 = hal.scheduler->micros();
+    for (uint16_t i=0; i<1000; i++) {
+        v.rotate(ROTATION_ROLL_180_YAW_90);
+        v.rotate(ROTATION_YAW_180);
+        v.rotate(ROTATION_YAW_45);
+    }
+    uint32_t t1 = hal.scheduler->micros();
+    for (uint16_t i=0; i<1000; i++) {
+        cache.rotate(v);
+    }
+    uint32_t t2 = hal.scheduler->micros();
+    hal.console->printf("rotate chain: %u usec/1000  RotationCache: %u usec/1000  failures=%u\n",
+                        (unsigned)(t1-t0), (unsigned)(t2-t1), (unsigned)failures);
+}
+
 /*
  *  rotation tests
  */
@@ -185,6 +226,7 @@ void setup(void)
     test_rotation_accuracy();
     test_eulers();
     missing_rotations();
+    test_rotation_cache();
     hal.console->println("rotation unit tests done\n");
 }
 
@@ -0,0 +1,177 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+ * fast_math.cpp
+ *
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Math.h"
+
+// pi/2 split into three parts for Cody-Waite range reduction. The
+// first two have few enough mantissa bits that k*part is exact for
+// |k| up to FAST_MATH_MAX_ANGLE/(pi/2)
+#define FAST_MATH_2_BY_PI   0.63661977236758134f
+#define FAST_MATH_PIBY2     1.57079632679489662f
+#define FAST_MATH_PIBY2_1   1.5703125f
+#define FAST_MATH_PIBY2_2   4.837512969970703125e-4f
+#define FAST_MATH_PIBY2_3   7.54978995489188216e-8f
+
+// minimax polynomials for sin and cos on [-pi/4, pi/4], from the Cephes
+// library sinf/cosf
+#define FAST_MATH_SIN_1     -1.6666654611e-1f
+#define FAST_MATH_SIN_2     8.3321608736e-3f
+#define FAST_MATH_SIN_3     -1.9515295891e-4f
+#define FAST_MATH_COS_1     4.166664568298827e-2f
+#define FAST_MATH_COS_2     -1.388731625493765e-3f
+#define FAST_MATH_COS_3     2.443315711809948e-5f
+
+// minimax polynomial for atan on [0, 1], absolute error 1.8e-6
+#define FAST_MATH_ATAN_1    0.99997726f
+#define FAST_MATH_ATAN_3    -0.33262347f
+#define FAST_MATH_ATAN_5    0.19354346f
+#define FAST_MATH_ATAN_7    -0.11643287f
+#define FAST_MATH_ATAN_9    0.05265332f
+#define FAST_MATH_ATAN_11   -0.01172120f
+
+/*
+  sine and cosine of x, which must be within +-FAST_MATH_MAX_ANGLE. x is
+  reduced to r in [-pi/4, pi/4] plus a quadrant k, both polynomials are
+  evaluated on r, and the quadrant picks which one is the sine and the
+  signs. The quadrant selection is written as conditional moves so
+  callers looping over arrays stay branch free
+ */
+static inline void sincos_kernel(float x, float &sin_x, float &cos_x)
+{
+    float kf = x * FAST_MATH_2_BY_PI;
+    int32_t k = (int32_t)(kf + (kf >= 0.0f ? 0.5f : -0.5f));
+    kf = (float)k;
+
+    float r = x - kf * FAST_MATH_PIBY2_1;
+    r -= kf * FAST_MATH_PIBY2_2;
+    r -= kf * FAST_MATH_PIBY2_3;
+
+    float r2 = r * r;
+    float s = r + r * r2 * (FAST_MATH_SIN_1 + r2 * (FAST_MATH_SIN_2 + r2 * FAST_MATH_SIN_3));
+    float c = 1.0f - 0.5f * r2 + r2 * r2 * (FAST_MATH_COS_1 + r2 * (FAST_MATH_COS_2 + r2 * FAST_MATH_COS_3));
+
+    // odd quadrants swap sine and cosine
+    float sq = (k & 1) ? c : s;
+    float cq = (k & 1) ? s : c;
+    sin_x = (k & 2) ? -sq : sq;
+    cos_x = ((k + 1) & 2) ? -cq : cq;
+}
+
+float fast_sinf(float x)
+{
+    if (fabsf(x) > FAST_MATH_MAX_ANGLE) {
+        return sinf(x);
+    }
+    float s, c;
+    sincos_kernel(x, s, c);
+    return s;
+}
+
+float fast_cosf(float x)
+{
+    if (fabsf(x) > FAST_MATH_MAX_ANGLE) {
+        return cosf(x);
+    }
+    float s, c;
+    sincos_kernel(x, s, c);
+    return c;
+}
+
+void fast_sincosf(float x, float &sin_x, float &cos_x)
+{
+    if (fabsf(x) > FAST_MATH_MAX_ANGLE) {
+        sin_x = sinf(x);
+        cos_x = cosf(x);
+        return;
+    }
+    sincos_kernel(x, sin_x, cos_x);
+}
+
+void fast_sincosf_array(const float *x, float *sin_x, float *cos_x, uint16_t n)
+{
+    for (uint16_t i=0; i<n; i++) {
+        sincos_kernel(x[i], sin_x[i], cos_x[i]);
+    }
+}
+
+/*
+  atan2 by octant reduction: the polynomial is evaluated on the ratio
+  of the smaller to the larger of |x| and |y|, which is always in [0, 1],
+  and the result is then reflected into the right octant
+ */
+float fast_atan2_precise(float y, float x)
+{
+    float ax = fabsf(x);
+    float ay = fabsf(y);
+    float mx = (ay > ax) ? ay : ax;
+    float mn = (ay > ax) ? ax : ay;
+    if (mx == 0.0f) {
+        return 0.0f;
+    }
+
+    float a = mn / mx;
+    float s = a * a;
+    float r = a * (FAST_MATH_ATAN_1 + s * (FAST_MATH_ATAN_3 + s * (FAST_MATH_ATAN_5 +
+                   s * (FAST_MATH_ATAN_7 + s * (FAST_MATH_ATAN_9 + s * FAST_MATH_ATAN_11)))));
+
+    if (ay > ax) {
+        r = FAST_MATH_PIBY2 - r;
+    }
+    if (x < 0.0f) {
+        r = PI - r;
+    }
+    if (y < 0.0f) {
+        r = -r;
+    }
+    return r;
+}
+
+/*
+  1/sqrt(x) from the exponent halving integer trick followed by two
+  Newton-Raphson steps
+ */
+static inline float inv_sqrt_kernel(float x)
+{
+    union {
+        float f;
+        uint32_t i;
+    } u;
+    u.f = x;
+    u.i = 0x5f375a86UL - (u.i >> 1);
+    float y = u.f;
+    float half_x = 0.5f * x;
+    y = y * (1.5f - half_x * y * y);
+    y = y * (1.5f - half_x * y * y);
+    return y;
+}
+
+float fast_inv_sqrtf(float x)
+{
+    if (x <= 0.0f) {
+        return 0.0f;
+    }
+    return inv_sqrt_kernel(x);
+}
+
+void fast_inv_sqrtf_array(const float *x, float *out, uint16_t n)
+{
+    for (uint16_t i=0; i<n; i++) {
+        float y = inv_sqrt_kernel(x[i]);
+        out[i] = (x[i] > 0.0f) ? y : 0.0f;
+    }
+}
@@ -0,0 +1,67 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+ * fast_math.h
+ *
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  Polynomial approximations of the trig and square root functions.
+
+  Each kernel has a fixed, documented error bound and no data
+  dependent slow path, unlike the libm versions which handle every
+  input to the last bit. They are not drop-in replacements: callers
+  opt in where the error bound is well inside their own error budget.
+  The errors below were measured against double precision libm by
+  examples/fast_math. The sine and cosine range reduction relies on
+  the order of its float operations, so the bounds do not hold if this
+  file is built with -ffast-math.
+ */
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+
+#include <stdint.h>
+
+// largest angle in radians for which fast_sinf(), fast_cosf() and
+// fast_sincosf() meet their error bound. Larger angles fall back to libm
+#define FAST_MATH_MAX_ANGLE 8192.0f
+
+// fast_sinf, fast_cosf - sine and cosine of an angle in radians
+//      absolute error is < 1.5e-7 for |x| <= FAST_MATH_MAX_ANGLE
+float           fast_sinf(float x);
+float           fast_cosf(float x);
+
+// fast_sincosf - sine and cosine of the same angle, sharing one range
+// reduction.  Same error bound as fast_sinf
+void            fast_sincosf(float x, float &sin_x, float &cos_x);
+
+// fast_sincosf_array - fast_sincosf over n angles.  The loop has no
+// branches on the angle, so it can be vectorised by the compiler.
+// All angles must be within +-FAST_MATH_MAX_ANGLE
+void            fast_sincosf_array(const float *x, float *sin_x, float *cos_x, uint16_t n);
+
+// fast_atan2_precise - atan2 with absolute error < 2.5e-6 radians
+// (0.00015 degrees), for use where the 0.005 radian error of fast_atan2()
+// is too large.  Returns 0 when both arguments are 0
+float           fast_atan2_precise(float y, float x);
+
+// fast_inv_sqrtf - 1/sqrt(x) for x > 0 with relative error < 5e-6.
+// Replaces a square root and a divide when normalising vectors.
+// Returns 0 for x <= 0
+float           fast_inv_sqrtf(float x);
+
+// fast_inv_sqrtf_array - fast_inv_sqrtf over n values, vectorisable
+void            fast_inv_sqrtf_array(const float *x, float *out, uint16_t n);
+
+#endif // FAST_MATH_H
@@ -35,6 +35,7 @@
 
 float longitude_scale(const struct Location &loc)
 {
+#if HAL_CPU_CLASS < HAL_CPU_CLASS_75
     static int32_t last_lat;
     static float scale = 1.0;
     if (labs(last_lat - loc.lat) < 100000) {
@@ -47,6 +48,13 @@ float longitude_scale(const struct Location &loc)
     scale = constrain_float(scale, 0.01f, 1.0f);
     last_lat = loc.lat;
     return scale;
+#else
+    // no shared cache on faster CPUs, where location math may run in
+    // more than one thread. Callers needing the scale often should
+    // hold a Location_Frame
+    float scale = cosf(loc.lat * 1.0e-7f * DEG_TO_RAD);
+    return constrain_float(scale, 0.01f, 1.0f);
+#endif
 }
 
 
@@ -152,6 +160,59 @@ Vector2f location_diff(const struct Location &loc1, const struct Location &loc2)
                     (loc2.lng - loc1.lng) * LOCATION_SCALING_FACTOR * longitude_scale(loc1));
 }
 
+/*
+  setup a local frame around an origin location
+ */
+void location_frame_init(struct Location_Frame &frame, const struct Location &origin)
+{
+    frame.lat = origin.lat;
+    frame.lng = origin.lng;
+    frame.lon_scale = constrain_float(cosf(origin.lat * 1.0e-7f * DEG_TO_RAD), 0.01f, 1.0f);
+}
+
+// return distance in meters from the frame origin to a location
+float get_distance(const struct Location_Frame &frame, const struct Location &loc)
+{
+    float dlat              = (float)(loc.lat - frame.lat);
+    float dlong             = ((float)(loc.lng - frame.lng)) * frame.lon_scale;
+    return pythagorous2(dlat, dlong) * LOCATION_SCALING_FACTOR;
+}
+
+// return bearing in centi-degrees from the frame origin to a location
+int32_t get_bearing_cd(const struct Location_Frame &frame, const struct Location &loc)
+{
+    int32_t off_x = loc.lng - frame.lng;
+    int32_t off_y = (loc.lat - frame.lat) / frame.lon_scale;
+    int32_t bearing = 9000 + atan2f(-off_y, off_x) * 5729.57795f;
+    if (bearing < 0) bearing += 36000;
+    return bearing;
+}
+
+/*
+  return the distance in meters in North/East plane as a N/E vector
+  from the frame origin to loc
+ */
+Vector2f location_diff(const struct Location_Frame &frame, const struct Location &loc)
+{
+    return Vector2f((loc.lat - frame.lat) * LOCATION_SCALING_FACTOR,
+                    (loc.lng - frame.lng) * LOCATION_SCALING_FACTOR * frame.lon_scale);
+}
+
+/*
+  extrapolate latitude/longitude given distances north and east,
+  using the longitude scaling of the frame. The location should be
+  close to the frame origin
+ */
+void location_offset(const struct Location_Frame &frame, struct Location &loc, float ofs_north, float ofs_east)
+{
+    if (ofs_north != 0 || ofs_east != 0) {
+        int32_t dlat = ofs_north * LOCATION_SCALING_FACTOR_INV;
+        int32_t dlng = (ofs_east * LOCATION_SCALING_FACTOR_INV) / frame.lon_scale;
+        loc.lat += dlat;
+        loc.lng += dlng;
+    }
+}
+
 /*
   wrap an angle in centi-degrees to 0..35999
  */
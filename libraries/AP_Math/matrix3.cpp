@@ -60,6 +60,20 @@ void Matrix3<T>::to_euler(float *roll, float *pitch, float *yaw) const
     }
 }
 
+// create a matrix equivalent to a standard rotation. The columns of
+// the matrix are the rotated unit vectors
+template <typename T>
+void Matrix3<T>::from_rotation(enum Rotation rotation)
+{
+    Vector3<T> x(1,0,0), y(0,1,0), z(0,0,1);
+    x.rotate(rotation);
+    y.rotate(rotation);
+    z.rotate(rotation);
+    a = Vector3<T>(x.x, y.x, z.x);
+    b = Vector3<T>(x.y, y.y, z.y);
+    c = Vector3<T>(x.z, y.z, z.z);
+}
+
 // apply an additional rotation from a body frame gyro vector
 // to a rotation matrix.
 template <typename T>
@@ -183,6 +197,7 @@ template void Matrix3<float>::rotateXY(const Vector3<float> &g);
 template void Matrix3<float>::rotateXYinv(const Vector3<float> &g);
 template void Matrix3<float>::from_euler(float roll, float pitch, float yaw);
 template void Matrix3<float>::to_euler(float *roll, float *pitch, float *yaw) const;
+template void Matrix3<float>::from_rotation(enum Rotation rotation);
 template Vector3<float> Matrix3<float>::operator *(const Vector3<float> &v) const;
 template Vector3<float> Matrix3<float>::mul_transpose(const Vector3<float> &v) const;
 template Matrix3<float> Matrix3<float>::operator *(const Matrix3<float> &m) const;
@@ -208,6 +208,9 @@ public:
     // create eulers from a rotation matrix
     void        to_euler(float *roll, float *pitch, float *yaw) const;
 
+    // create a matrix which does the same as Vector3::rotate() for a standard rotation
+    void        from_rotation(enum Rotation rotation);
+
     // apply an additional rotation from a body frame gyro vector
     // to a rotation matrix.
     void        rotate(const Vector3<T> &g);
@@ -0,0 +1,633 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  Fixed size matrices for estimator code.
+
+  Arithmetic on matrices builds lightweight expression objects rather
+  than new matrices. Nothing is computed until the expression is
+  assigned, at which point each element of the destination is
+  calculated in a single pass, so a chain such as P + K*H*P - Q needs
+  no temporary matrices for the sums, differences and scaling.
+
+  Operands of a product that are themselves compound expressions are
+  evaluated once into a temporary, as otherwise each element of the
+  operand would be recalculated for every element of the product.
+  Assigning an expression that reads the destination (for example
+  P = F*P) also goes through a temporary.
+
+  MatrixSym stores only the upper triangle of a symmetric matrix and
+  only calculates that triangle on assignment, halving the work of a
+  covariance update. MatrixLower stores a lower triangular matrix, as
+  produced by the Cholesky and LDLT decompositions.
+
+  The sizes are template parameters, so a 22x22 float matrix is 1936
+  bytes. Be careful with temporaries on small stacks.
+ */
+
+#ifndef MATRIXN_H
+#define MATRIXN_H
+
+#include <math.h>
+#include <string.h>
+#if MATH_CHECK_INDEXES
+#include <assert.h>
+#endif
+#include "vectorN.h"
+
+template <typename T, uint8_t R, uint8_t C> class MatrixN;
+
+// base of all matrix expressions, E is the derived expression type
+template <typename T, uint8_t R, uint8_t C, typename E>
+class MatrixExpr
+{
+public:
+    typedef T value_type;
+
+    // element access, calculating the element if needed
+    T operator()(uint8_t i, uint8_t j) const {
+        return static_cast<const E &>(*this)(i, j);
+    }
+
+    // true if evaluating the expression reads from the given matrix
+    bool aliases(const void *m) const {
+        return static_cast<const E &>(*this).aliases(m);
+    }
+
+    const E &derived(void) const {
+        return static_cast<const E &>(*this);
+    }
+};
+
+// how an expression is held inside another expression. Expressions
+// are small so are held by value, matrices by reference
+template <typename E>
+struct MatrixOperand {
+    typedef const E type;
+};
+template <typename T, uint8_t R, uint8_t C>
+struct MatrixOperand<MatrixN<T,R,C> > {
+    typedef const MatrixN<T,R,C> &type;
+};
+
+// how an expression is held as an operand of a product. Anything that
+// does more than read elements is evaluated once into a matrix
+template <typename T, uint8_t R, uint8_t C, typename E>
+struct MatrixProductOperand {
+    typedef const MatrixN<T,R,C> type;
+};
+template <typename T, uint8_t R, uint8_t C>
+struct MatrixProductOperand<T,R,C,MatrixN<T,R,C> > {
+    typedef const MatrixN<T,R,C> &type;
+};
+
+// element-wise sum of two expressions
+template <typename T, uint8_t R, uint8_t C, typename A, typename B>
+class MatrixSum : public MatrixExpr<T,R,C,MatrixSum<T,R,C,A,B> >
+{
+public:
+    MatrixSum(const A &a, const B &b) : _a(a), _b(b) {}
+    T operator()(uint8_t i, uint8_t j) const { return _a(i,j) + _b(i,j); }
+    bool aliases(const void *m) const { return _a.aliases(m) || _b.aliases(m); }
+private:
+    typename MatrixOperand<A>::type _a;
+    typename MatrixOperand<B>::type _b;
+};
+
+// element-wise difference of two expressions
+template <typename T, uint8_t R, uint8_t C, typename A, typename B>
+class MatrixDifference : public MatrixExpr<T,R,C,MatrixDifference<T,R,C,A,B> >
+{
+public:
+    MatrixDifference(const A &a, const B &b) : _a(a), _b(b) {}
+    T operator()(uint8_t i, uint8_t j) const { return _a(i,j) - _b(i,j); }
+    bool aliases(const void *m) const { return _a.aliases(m) || _b.aliases(m); }
+private:
+    typename MatrixOperand<A>::type _a;
+    typename MatrixOperand<B>::type _b;
+};
+
+// expression scaled by a constant
+template <typename T, uint8_t R, uint8_t C, typename A>
+class MatrixScaled : public MatrixExpr<T,R,C,MatrixScaled<T,R,C,A> >
+{
+public:
+    MatrixScaled(const A &a, T s) : _a(a), _s(s) {}
+    T operator()(uint8_t i, uint8_t j) const { return _a(i,j) * _s; }
+    bool aliases(const void *m) const { return _a.aliases(m); }
+private:
+    typename MatrixOperand<A>::type _a;
+    T _s;
+};
+
+// transpose of an expression with C rows and R columns
+template <typename T, uint8_t R, uint8_t C, typename A>
+class MatrixTransposed : public MatrixExpr<T,R,C,MatrixTransposed<T,R,C,A> >
+{
+public:
+    MatrixTransposed(const A &a) : _a(a) {}
+    T operator()(uint8_t i, uint8_t j) const { return _a(j,i); }
+    bool aliases(const void *m) const { return _a.aliases(m); }
+private:
+    typename MatrixOperand<A>::type _a;
+};
+
+// a transposed matrix is only a view, so can be read directly by a product
+template <typename T, uint8_t R, uint8_t C>
+struct MatrixProductOperand<T,R,C,MatrixTransposed<T,R,C,MatrixN<T,C,R> > > {
+    typedef const MatrixTransposed<T,R,C,MatrixN<T,C,R> > type;
+};
+
+// product of an RxK and a KxC expression
+template <typename T, uint8_t R, uint8_t K, uint8_t C, typename A, typename B>
+class MatrixProduct : public MatrixExpr<T,R,C,MatrixProduct<T,R,K,C,A,B> >
+{
+public:
+    MatrixProduct(const A &a, const B &b) : _a(a), _b(b) {}
+    T operator()(uint8_t i, uint8_t j) const {
+        T sum = 0;
+        for (uint8_t k=0; k<K; k++) {
+            sum += _a(i,k) * _b(k,j);
+        }
+        return sum;
+    }
+    bool aliases(const void *m) const { return _a.aliases(m) || _b.aliases(m); }
+private:
+    typename MatrixProductOperand<T,R,K,A>::type _a;
+    typename MatrixProductOperand<T,K,C,B>::type _b;
+};
+
+// an R by C window into a PR by PC matrix
+template <typename T, uint8_t R, uint8_t C, uint8_t PR, uint8_t PC>
+class MatrixBlock : public MatrixExpr<T,R,C,MatrixBlock<T,R,C,PR,PC> >
+{
+public:
+    MatrixBlock(MatrixN<T,PR,PC> &m, uint8_t r0, uint8_t c0) : _m(m), _r0(r0), _c0(c0) {
+#if MATH_CHECK_INDEXES
+        assert(r0 + R <= PR && c0 + C <= PC);
+#endif
+    }
+
+    T operator()(uint8_t i, uint8_t j) const { return _m(_r0+i, _c0+j); }
+    T &operator()(uint8_t i, uint8_t j) { return _m(_r0+i, _c0+j); }
+    bool aliases(const void *m) const { return m == (const void *)&_m; }
+
+    // assign an expression to the block
+    template <typename E>
+    MatrixBlock &operator =(const MatrixExpr<T,R,C,E> &e) {
+        if (e.aliases(&_m)) {
+            MatrixN<T,R,C> tmp(e);
+            return *this = tmp;
+        }
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                (*this)(i,j) = e(i,j);
+            }
+        }
+        return *this;
+    }
+
+private:
+    MatrixN<T,PR,PC> &_m;
+    uint8_t _r0, _c0;
+};
+
+// a matrix with R rows and C columns
+template <typename T, uint8_t R, uint8_t C>
+class MatrixN : public MatrixExpr<T,R,C,MatrixN<T,R,C> >
+{
+public:
+    // trivial ctor
+    MatrixN() {
+        zero();
+    }
+
+    // evaluate an expression
+    template <typename E>
+    MatrixN(const MatrixExpr<T,R,C,E> &e) {
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                _m[i][j] = e(i,j);
+            }
+        }
+    }
+
+    // assign an expression, going through a temporary if it reads this matrix
+    template <typename E>
+    MatrixN<T,R,C> &operator =(const MatrixExpr<T,R,C,E> &e) {
+        if (e.aliases(this)) {
+            MatrixN<T,R,C> tmp(e);
+            return *this = tmp;
+        }
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                _m[i][j] = e(i,j);
+            }
+        }
+        return *this;
+    }
+
+    MatrixN<T,R,C> &operator =(const MatrixN<T,R,C> &m) {
+        memcpy(_m, m._m, sizeof(_m));
+        return *this;
+    }
+
+    MatrixN(const MatrixN<T,R,C> &m) : MatrixExpr<T,R,C,MatrixN<T,R,C> >() {
+        memcpy(_m, m._m, sizeof(_m));
+    }
+
+    // in place updates, going through a temporary if the expression reads this matrix
+    template <typename E>
+    MatrixN<T,R,C> &operator +=(const MatrixExpr<T,R,C,E> &e) {
+        if (e.aliases(this)) {
+            MatrixN<T,R,C> tmp(e);
+            return *this += tmp;
+        }
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                _m[i][j] += e(i,j);
+            }
+        }
+        return *this;
+    }
+
+    template <typename E>
+    MatrixN<T,R,C> &operator -=(const MatrixExpr<T,R,C,E> &e) {
+        if (e.aliases(this)) {
+            MatrixN<T,R,C> tmp(e);
+            return *this -= tmp;
+        }
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                _m[i][j] -= e(i,j);
+            }
+        }
+        return *this;
+    }
+
+    MatrixN<T,R,C> &operator *=(const T num) {
+        for (uint8_t i=0; i<R; i++) {
+            for (uint8_t j=0; j<C; j++) {
+                _m[i][j] *= num;
+            }
+        }
+        return *this;
+    }
+
+    T operator()(uint8_t i, uint8_t j) const {
+#if MATH_CHECK_INDEXES
+        assert(i < R && j < C);
+#endif
+        return _m[i][j];
+    }
+
+    T &operator()(uint8_t i, uint8_t j) {
+#if MATH_CHECK_INDEXES
+        assert(i < R && j < C);
+#endif
+        return _m[i][j];
+    }
+
+    // row access, so a MatrixN can be indexed like a 2D array
+    T *operator[](uint8_t i) {
+#if MATH_CHECK_INDEXES
+        assert(i < R);
+#endif
+        return _m[i];
+    }
+
+    const T *operator[](uint8_t i) const {
+#if MATH_CHECK_INDEXES
+        assert(i < R);
+#endif
+        return _m[i];
+    }
+
+    bool aliases(const void *m) const { return m == (const void *)this; }
+
+    // zero the matrix
+    void zero(void) {
+        memset(_m, 0, sizeof(_m));
+    }
+
+    // setup the identity matrix
+    void identity(void) {
+        const uint8_t n = R < C ? R : C;
+        zero();
+        for (uint8_t i=0; i<n; i++) {
+            _m[i][i] = 1;
+        }
+    }
+
+    // view of the matrix as its transpose
+    MatrixTransposed<T,C,R,MatrixN<T,R,C> > transposed(void) const {
+        return MatrixTransposed<T,C,R,MatrixN<T,R,C> >(*this);
+    }
+
+    // view of a BR by BC block starting at row r0, column c0
+    template <uint8_t BR, uint8_t BC>
+    MatrixBlock<T,BR,BC,R,C> block(uint8_t r0, uint8_t c0) {
+        return MatrixBlock<T,BR,BC,R,C>(*this, r0, c0);
+    }
+
+    // make a square matrix exactly symmetric by averaging the off-diagonal pairs
+    void force_symmetry(void) {
+        for (uint8_t i=1; i<R; i++) {
+            for (uint8_t j=0; j<i; j++) {
+                T v = 0.5f * (_m[i][j] + _m[j][i]);
+                _m[i][j] = v;
+                _m[j][i] = v;
+            }
+        }
+    }
+
+private:
+    T _m[R][C];
+};
+
+// symmetric N by N matrix, storing only the upper triangle
+template <typename T, uint8_t N>
+class MatrixSym : public MatrixExpr<T,N,N,MatrixSym<T,N> >
+{
+public:
+    MatrixSym() {
+        zero();
+    }
+
+    // evaluate the upper triangle of an expression known to be symmetric
+    template <typename E>
+    MatrixSym<T,N> &operator =(const MatrixExpr<T,N,N,E> &e) {
+        if (e.aliases(this)) {
+            MatrixN<T,N,N> tmp(e);
+            return *this = tmp;
+        }
+        for (uint8_t i=0; i<N; i++) {
+            for (uint8_t j=i; j<N; j++) {
+                _m[index(i,j)] = e(i,j);
+            }
+        }
+        return *this;
+    }
+
+    T operator()(uint8_t i, uint8_t j) const {
+        return _m[i <= j ? index(i,j) : index(j,i)];
+    }
+
+    // access to element i,j and its mirror j,i
+    T &operator()(uint8_t i, uint8_t j) {
+        return _m[i <= j ? index(i,j) : index(j,i)];
+    }
+
+    bool aliases(const void *m) const { return m == (const void *)this; }
+
+    void zero(void) {
+        memset(_m, 0, sizeof(_m));
+    }
+
+private:
+    static uint16_t index(uint8_t i, uint8_t j) {
+#if MATH_CHECK_INDEXES
+        assert(i <= j && j < N);
+#endif
+        return (uint16_t)i*N - (uint16_t)i*(i-1)/2 + (j - i);
+    }
+
+    T _m[(uint16_t)N*(N+1)/2];
+};
+
+// lower triangular N by N matrix
+template <typename T, uint8_t N>
+class MatrixLower : public MatrixExpr<T,N,N,MatrixLower<T,N> >
+{
+public:
+    MatrixLower() {
+        zero();
+    }
+
+    T operator()(uint8_t i, uint8_t j) const {
+        return i >= j ? _m[index(i,j)] : 0;
+    }
+
+    // access to element i,j, which must be on or below the diagonal
+    T &operator()(uint8_t i, uint8_t j) {
+        return _m[index(i,j)];
+    }
+
+    bool aliases(const void *m) const { return m == (const void *)this; }
+
+    void zero(void) {
+        memset(_m, 0, sizeof(_m));
+    }
+
+private:
+    static uint16_t index(uint8_t i, uint8_t j) {
+#if MATH_CHECK_INDEXES
+        assert(j <= i && i < N);
+#endif
+        return (uint16_t)i*(i+1)/2 + j;
+    }
+
+    T _m[(uint16_t)N*(N+1)/2];
+};
+
+// packed matrices are read in place rather than copied
+template <typename T, uint8_t N>
+struct MatrixOperand<MatrixSym<T,N> > {
+    typedef const MatrixSym<T,N> &type;
+};
+template <typename T, uint8_t N>
+struct MatrixProductOperand<T,N,N,MatrixSym<T,N> > {
+    typedef const MatrixSym<T,N> &type;
+};
+template <typename T, uint8_t N>
+struct MatrixOperand<MatrixLower<T,N> > {
+    typedef const MatrixLower<T,N> &type;
+};
+template <typename T, uint8_t N>
+struct MatrixProductOperand<T,N,N,MatrixLower<T,N> > {
+    typedef const MatrixLower<T,N> &type;
+};
+
+/*
+  operators building expressions
+ */
+template <typename T, uint8_t R, uint8_t C, typename A, typename B>
+inline MatrixSum<T,R,C,A,B> operator +(const MatrixExpr<T,R,C,A> &a, const MatrixExpr<T,R,C,B> &b)
+{
+    return MatrixSum<T,R,C,A,B>(a.derived(), b.derived());
+}
+
+template <typename T, uint8_t R, uint8_t C, typename A, typename B>
+inline MatrixDifference<T,R,C,A,B> operator -(const MatrixExpr<T,R,C,A> &a, const MatrixExpr<T,R,C,B> &b)
+{
+    return MatrixDifference<T,R,C,A,B>(a.derived(), b.derived());
+}
+
+template <typename T, uint8_t R, uint8_t C, typename A>
+inline MatrixScaled<T,R,C,A> operator *(const MatrixExpr<T,R,C,A> &a, typename MatrixExpr<T,R,C,A>::value_type s)
+{
+    return MatrixScaled<T,R,C,A>(a.derived(), s);
+}
+
+template <typename T, uint8_t R, uint8_t C, typename A>
+inline MatrixScaled<T,R,C,A> operator *(typename MatrixExpr<T,R,C,A>::value_type s, const MatrixExpr<T,R,C,A> &a)
+{
+    return MatrixScaled<T,R,C,A>(a.derived(), s);
+}
+
+template <typename T, uint8_t R, uint8_t C, typename A>
+inline MatrixScaled<T,R,C,A> operator -(const MatrixExpr<T,R,C,A> &a)
+{
+    return MatrixScaled<T,R,C,A>(a.derived(), -1);
+}
+
+template <typename T, uint8_t R, uint8_t K, uint8_t C, typename A, typename B>
+inline MatrixProduct<T,R,K,C,A,B> operator *(const MatrixExpr<T,R,K,A> &a, const MatrixExpr<T,K,C,B> &b)
+{
+    return MatrixProduct<T,R,K,C,A,B>(a.derived(), b.derived());
+}
+
+// transpose of any expression
+template <typename T, uint8_t R, uint8_t C, typename A>
+inline MatrixTransposed<T,C,R,A> transpose(const MatrixExpr<T,R,C,A> &a)
+{
+    return MatrixTransposed<T,C,R,A>(a.derived());
+}
+
+// matrix times vector, evaluated immediately
+template <typename T, uint8_t R, uint8_t C, typename A>
+inline VectorN<T,R> operator *(const MatrixExpr<T,R,C,A> &a, const VectorN<T,C> &v)
+{
+    VectorN<T,R> ret;
+    for (uint8_t i=0; i<R; i++) {
+        T sum = 0;
+        for (uint8_t j=0; j<C; j++) {
+            sum += a(i,j) * v[j];
+        }
+        ret[i] = sum;
+    }
+    return ret;
+}
+
+/*
+  Cholesky decomposition A = L*L' of a symmetric positive definite
+  matrix. Only the lower triangle of A is read. Returns false if A is
+  not positive definite
+ */
+template <typename T, uint8_t N, typename E>
+bool matrix_cholesky(const MatrixExpr<T,N,N,E> &A, MatrixLower<T,N> &L)
+{
+    for (uint8_t j=0; j<N; j++) {
+        T d = A(j,j);
+        for (uint8_t k=0; k<j; k++) {
+            d -= L(j,k) * L(j,k);
+        }
+        if (!(d > 0)) {
+            return false;
+        }
+        d = sqrtf(d);
+        L(j,j) = d;
+        for (uint8_t i=j+1; i<N; i++) {
+            T s = A(i,j);
+            for (uint8_t k=0; k<j; k++) {
+                s -= L(i,k) * L(j,k);
+            }
+            L(i,j) = s / d;
+        }
+    }
+    return true;
+}
+
+// solve A*x = b given the Cholesky factor L of A
+template <typename T, uint8_t N>
+void matrix_cholesky_solve(const MatrixLower<T,N> &L, const VectorN<T,N> &b, VectorN<T,N> &x)
+{
+    // forward substitution L*y = b
+    for (uint8_t i=0; i<N; i++) {
+        T s = b[i];
+        for (uint8_t k=0; k<i; k++) {
+            s -= L(i,k) * x[k];
+        }
+        x[i] = s / L(i,i);
+    }
+    // back substitution L'*x = y
+    for (int16_t i=N-1; i>=0; i--) {
+        T s = x[i];
+        for (uint8_t k=i+1; k<N; k++) {
+            s -= L(k,i) * x[k];
+        }
+        x[i] = s / L(i,i);
+    }
+}
+
+/*
+  LDLT decomposition A = L*D*L' of a symmetric matrix, with L unit
+  lower triangular and D diagonal. Unlike Cholesky this needs no
+  square roots and copes with positive semi-definite matrices, as
+  long as no pivot is zero. Only the lower triangle of A is read.
+  Returns false if a pivot is zero
+ */
+template <typename T, uint8_t N, typename E>
+bool matrix_ldlt(const MatrixExpr<T,N,N,E> &A, MatrixLower<T,N> &L, VectorN<T,N> &D)
+{
+    for (uint8_t j=0; j<N; j++) {
+        T d = A(j,j);
+        for (uint8_t k=0; k<j; k++) {
+            d -= L(j,k) * L(j,k) * D[k];
+        }
+        if (d == 0) {
+            return false;
+        }
+        D[j] = d;
+        L(j,j) = 1;
+        for (uint8_t i=j+1; i<N; i++) {
+            T s = A(i,j);
+            for (uint8_t k=0; k<j; k++) {
+                s -= L(i,k) * L(j,k) * D[k];
+            }
+            L(i,j) = s / d;
+        }
+    }
+    return true;
+}
+
+// solve A*x = b given the LDLT decomposition of A
+template <typename T, uint8_t N>
+void matrix_ldlt_solve(const MatrixLower<T,N> &L, const VectorN<T,N> &D, const VectorN<T,N> &b, VectorN<T,N> &x)
+{
+    // forward substitution L*y = b
+    for (uint8_t i=0; i<N; i++) {
+        T s = b[i];
+        for (uint8_t k=0; k<i; k++) {
+            s -= L(i,k) * x[k];
+        }
+        x[i] = s;
+    }
+    // diagonal
+    for (uint8_t i=0; i<N; i++) {
+        x[i] /= D[i];
+    }
+    // back substitution L'*x = z
+    for (int16_t i=N-1; i>=0; i--) {
+        T s = x[i];
+        for (uint8_t k=i+1; k<N; k++) {
+            s -= L(k,i) * x[k];
+        }
+        x[i] = s;
+    }
+}
+
+#endif // MATRIXN_H
@@ -0,0 +1,78 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+ * rotation_cache.cpp
+ *
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "AP_Math.h"
+
+RotationCache::RotationCache() :
+    _identity(true)
+{
+    for (uint8_t i=0; i<ROTATION_CACHE_MAX_ROTATIONS; i++) {
+        _rotation[i] = ROTATION_NONE;
+    }
+#if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
+    _matrix.identity();
+#endif
+}
+
+/*
+  set the chain of rotations, rebuilding the combined matrix if it
+  has changed
+ */
+void RotationCache::set(enum Rotation r1, enum Rotation r2, enum Rotation r3, enum Rotation r4)
+{
+    if (_rotation[0] == r1 && _rotation[1] == r2 &&
+        _rotation[2] == r3 && _rotation[3] == r4) {
+        return;
+    }
+    _rotation[0] = r1;
+    _rotation[1] = r2;
+    _rotation[2] = r3;
+    _rotation[3] = r4;
+
+#if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
+    // later rotations multiply on the left
+    Matrix3f m;
+    _matrix.identity();
+    for (uint8_t i=0; i<ROTATION_CACHE_MAX_ROTATIONS; i++) {
+        if (_rotation[i] != ROTATION_NONE) {
+            m.from_rotation((enum Rotation)_rotation[i]);
+            _matrix = m * _matrix;
+        }
+    }
+    Matrix3f ident;
+    ident.identity();
+    _identity = (_matrix == ident);
+#else
+    _identity = (r1 == ROTATION_NONE && r2 == ROTATION_NONE &&
+                 r3 == ROTATION_NONE && r4 == ROTATION_NONE);
+#endif
+}
+
+/*
+  rotate an array of vectors, for drivers that collect several
+  samples per update
+ */
+void RotationCache::rotate(Vector3f *v, uint16_t count) const
+{
+    if (_identity) {
+        return;
+    }
+    for (uint16_t i=0; i<count; i++) {
+        rotate(v[i]);
+    }
+}
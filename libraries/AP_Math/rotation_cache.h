@@ -0,0 +1,80 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+ * rotation_cache.h
+ *
+ * This file is free software: you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This file is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.
+ * See the GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+  A chain of up to four standard rotations, as applied by sensor
+  drivers (chip orientation, board type, user orientation and
+  AHRS_ORIENTATION).
+
+  On CPUs with an FPU the chain is folded into a single matrix when it
+  changes, so each sample costs one branch-free matrix multiply no
+  matter how many rotations are involved. On AVR the rotations are
+  applied one by one with Vector3::rotate(), which is cheaper there
+  than the float multiplies of a matrix.
+ */
+#ifndef ROTATION_CACHE_H
+#define ROTATION_CACHE_H
+
+#include "vector3.h"
+#include "matrix3.h"
+
+#define ROTATION_CACHE_MAX_ROTATIONS 4
+
+class RotationCache {
+public:
+    RotationCache();
+
+    // set the rotations, applied in order r1, r2, r3 then r4. This is
+    // cheap when the rotations have not changed, so can be called
+    // before every use
+    void set(enum Rotation r1,
+             enum Rotation r2 = ROTATION_NONE,
+             enum Rotation r3 = ROTATION_NONE,
+             enum Rotation r4 = ROTATION_NONE);
+
+    // true if the rotations cancel out
+    bool is_identity(void) const { return _identity; }
+
+    // rotate a vector
+    void rotate(Vector3f &v) const {
+        if (_identity) {
+            return;
+        }
+#if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
+        v = Vector3f(_matrix.a.x*v.x + _matrix.a.y*v.y + _matrix.a.z*v.z,
+                     _matrix.b.x*v.x + _matrix.b.y*v.y + _matrix.b.z*v.z,
+                     _matrix.c.x*v.x + _matrix.c.y*v.y + _matrix.c.z*v.z);
+#else
+        for (uint8_t i=0; i<ROTATION_CACHE_MAX_ROTATIONS; i++) {
+            v.rotate((enum Rotation)_rotation[i]);
+        }
+#endif
+    }
+
+    // rotate an array of vectors in place
+    void rotate(Vector3f *v, uint16_t count) const;
+
+private:
+    uint8_t _rotation[ROTATION_CACHE_MAX_ROTATIONS];
+    bool _identity;
+#if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
+    Matrix3f _matrix;
+#endif
+};
+
+#endif // ROTATION_CACHE_H
@@ -0,0 +1,519 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file    AP_MissionEstimator.cpp
+/// @brief   Estimates the length, flight time, energy use and terrain
+///          clearance of the stored mission
+
+#include "AP_MissionEstimator.h"
+
+extern const AP_HAL::HAL& hal;
+
+const AP_Param::GroupInfo AP_MissionEstimator::var_info[] PROGMEM = {
+    // @Param: CLR_MIN
+    // @DisplayName: Minimum mission terrain clearance
+    // @Description: Arming is refused if any leg of the mission is estimated to pass closer than this to the terrain. Zero disables the check. Arming is also refused if terrain data is unavailable along the mission
+    // @Units: Meters
+    // @Range: 0 1000
+    // @Increment: 1
+    // @User: Standard
+    AP_GROUPINFO("CLR_MIN",     0, AP_MissionEstimator, _clearance_min, 0),
+
+    // @Param: CURR
+    // @DisplayName: Expected mission current
+    // @Description: Average current drawn while flying the mission, used to estimate the mission's battery use. Zero disables the battery check
+    // @Units: Amps
+    // @Range: 0 200
+    // @Increment: 0.1
+    // @User: Standard
+    AP_GROUPINFO("CURR",        1, AP_MissionEstimator, _current, 0),
+
+    // @Param: RSV_PCT
+    // @DisplayName: Mission battery reserve
+    // @Description: Percentage of the remaining battery capacity which should be left at the end of the mission
+    // @Units: Percent
+    // @Range: 0 50
+    // @Increment: 1
+    // @User: Standard
+    AP_GROUPINFO("RSV_PCT",     2, AP_MissionEstimator, _reserve_pct, 20),
+
+    AP_GROUPEND
+};
+
+// Constructor
+AP_MissionEstimator::AP_MissionEstimator(const AP_Mission &mission) :
+    _mission(mission),
+#if AP_TERRAIN_AVAILABLE
+    _terrain(NULL),
+#endif
+    _have_home(false),
+    _mission_change_ms(0),
+    _state(STATE_IDLE),
+    _next_index(0),
+    _steps(0),
+    _prev_alt_cm(0),
+    _prev_terrain_alt(false),
+    _moving(false),
+    _leg_terrain_alt(false),
+    _leg_start_alt_cm(0),
+    _leg_end_alt_cm(0),
+    _leg_samples(0),
+    _leg_sample_idx(0),
+    _last_complete_ms(0)
+{
+    AP_Param::setup_object_defaults(this, var_info);
+    memset(&_limits, 0, sizeof(_limits));
+    memset(&_estimate, 0, sizeof(_estimate));
+}
+
+/// set_limits - set the vehicle limits used for the estimate.  Restarts the estimate if they changed
+void AP_MissionEstimator::set_limits(const Vehicle_Limits &limits)
+{
+    if (memcmp(&limits, &_limits, sizeof(_limits)) != 0) {
+        _limits = limits;
+        restart();
+    }
+}
+
+/// set_home - set the home location.  Restarts the estimate if it moved
+void AP_MissionEstimator::set_home(const Location &home)
+{
+    if (!_have_home || home.lat != _home.lat || home.lng != _home.lng || home.alt != _home.alt) {
+        _home = home;
+        _have_home = true;
+        restart();
+    }
+}
+
+/// update - continue the estimate.  Should be called at 10hz or faster
+void AP_MissionEstimator::update(void)
+{
+    // start again if the mission has changed
+    if (_mission_change_ms != _mission.last_change_time_ms()) {
+        _mission_change_ms = _mission.last_change_time_ms();
+        restart();
+    }
+
+    switch (_state) {
+    case STATE_IDLE:
+        break;
+
+    case STATE_WALK_MISSION:
+        walk_mission();
+        break;
+
+    case STATE_SAMPLE_TERRAIN:
+        sample_terrain();
+        break;
+
+    case STATE_COMPLETE:
+        // terrain data may have arrived since, so try again after a while
+        if (_estimate.terrain_missing > 0 && hal.scheduler->millis() - _last_complete_ms > AP_MISSION_ESTIMATOR_RETRY_MS) {
+            restart();
+        }
+        break;
+    }
+}
+
+/// get_leg - returns the result for the leg with the given number.  Returns false if it was not stored
+bool AP_MissionEstimator::get_leg(uint16_t leg_num, Leg &leg) const
+{
+    if (_state != STATE_COMPLETE || leg_num >= _estimate.num_legs || leg_num >= AP_MISSION_ESTIMATOR_MAX_LEGS) {
+        return false;
+    }
+    leg = _legs[leg_num];
+    return true;
+}
+
+/// check - returns true if the estimate passes the parameter limits.  Fills in failure_msg otherwise
+bool AP_MissionEstimator::check(float battery_remaining_mah, const prog_char_t *&failure_msg) const
+{
+    // nothing to check if the checks are disabled or there is no mission
+    if ((_current <= 0 && _clearance_min <= 0) || _mission.num_commands() <= 1) {
+        return true;
+    }
+    if (_state != STATE_COMPLETE) {
+        failure_msg = PSTR("Mission estimate not ready");
+        return false;
+    }
+    if (_current > 0 && !_estimate.unbounded &&
+        _estimate.energy_mah > battery_remaining_mah * (100 - _reserve_pct) * 0.01f) {
+        failure_msg = PSTR("Mission needs more battery");
+        return false;
+    }
+    if (_clearance_min > 0) {
+        // without terrain data the clearance is unknown, so refuse
+        // rather than pass on the AP_MISSION_ESTIMATOR_CLEARANCE_UNKNOWN sentinel
+#if AP_TERRAIN_AVAILABLE
+        bool terrain_missing = (_terrain == NULL || _estimate.terrain_missing > 0);
+#else
+        bool terrain_missing = true;
+#endif
+        if (terrain_missing) {
+            failure_msg = PSTR("Mission terrain data missing");
+            return false;
+        }
+    }
+    if (_clearance_min > 0 && _estimate.clearance_m < _clearance_min) {
+        failure_msg = PSTR("Mission too close to terrain");
+        return false;
+    }
+    return true;
+}
+
+/// restart - start the estimate again from the first command
+void AP_MissionEstimator::restart()
+{
+    memset(&_estimate, 0, sizeof(_estimate));
+    _estimate.clearance_m = AP_MISSION_ESTIMATOR_CLEARANCE_UNKNOWN;
+    memset(_jumps, 0, sizeof(_jumps));
+
+    if (!_have_home) {
+        _state = STATE_IDLE;
+        return;
+    }
+
+    // the vehicle starts landed at home
+    _prev_loc = _home;
+    _prev_alt_cm = 0;
+    _prev_terrain_alt = false;
+    _moving = false;
+    _next_index = 1;
+    _steps = 0;
+    _state = STATE_WALK_MISSION;
+}
+
+/// walk_mission - handle up to AP_MISSION_ESTIMATOR_CMDS_PER_UPDATE mission commands
+void AP_MissionEstimator::walk_mission()
+{
+    for (uint8_t i=0; i<AP_MISSION_ESTIMATOR_CMDS_PER_UPDATE && _state == STATE_WALK_MISSION; i++) {
+        AP_Mission::Mission_Command cmd;
+        if (_steps >= AP_MISSION_ESTIMATOR_MAX_STEPS) {
+            // too many commands walked, so treat the mission as never ending
+            _estimate.unbounded = true;
+        }
+        if (_estimate.unbounded || _next_index >= _mission.num_commands() ||
+            !_mission.read_cmd_from_storage(_next_index, cmd)) {
+            // end of the mission
+            _estimate.energy_mah = _estimate.time_s * _current * (1000.0f / 3600.0f);
+            _last_complete_ms = hal.scheduler->millis();
+            _state = STATE_COMPLETE;
+            return;
+        }
+        _steps++;
+        _next_index++;
+
+        if (cmd.id == MAV_CMD_DO_JUMP) {
+            // repeat forever means the mission never ends
+            if (cmd.content.jump.num_times < 0) {
+                _estimate.unbounded = true;
+                continue;
+            }
+            // find or allocate this jump's counter
+            for (uint8_t j=0; j<AP_MISSION_MAX_NUM_DO_JUMP_COMMANDS; j++) {
+                if (_jumps[j].index == 0) {
+                    _jumps[j].index = cmd.index;
+                }
+                if (_jumps[j].index == cmd.index) {
+                    if (_jumps[j].num_times_run < cmd.content.jump.num_times) {
+                        _jumps[j].num_times_run++;
+                        _next_index = cmd.content.jump.target;
+                    }
+                    break;
+                }
+            }
+            continue;
+        }
+
+        process_cmd(cmd);
+    }
+}
+
+/// process_cmd - add the leg or delay for a single command
+void AP_MissionEstimator::process_cmd(const AP_Mission::Mission_Command &cmd)
+{
+    Location loc = cmd.content.location;
+
+    // a location of zero means the vehicle's current position
+    if (AP_Mission::is_nav_cmd(cmd) && loc.lat == 0 && loc.lng == 0) {
+        loc.lat = _prev_loc.lat;
+        loc.lng = _prev_loc.lng;
+    }
+
+    switch (cmd.id) {
+    case MAV_CMD_NAV_WAYPOINT:
+    case MAV_CMD_NAV_SPLINE_WAYPOINT:
+        // p1 holds the delay at the waypoint in seconds
+        add_leg(cmd.index, loc, cmd.p1, cmd.p1 > 0);
+        break;
+
+    case MAV_CMD_NAV_LOITER_TIME:
+        add_leg(cmd.index, loc, cmd.p1, true);
+        break;
+
+    case MAV_CMD_NAV_LOITER_TURNS: {
+        // radius in meters is held in the high byte of p1 and the number of turns in the low byte
+        float radius_cm = HIGHBYTE(cmd.p1) * 100.0f;
+        if (radius_cm <= 0) {
+            radius_cm = _limits.loiter_radius_cm;
+        }
+        float delay_s = 0;
+        if (_limits.speed_cms > 0) {
+            delay_s = LOWBYTE(cmd.p1) * 2.0f * PI * radius_cm / _limits.speed_cms;
+        }
+        add_leg(cmd.index, loc, delay_s, true);
+        break;
+    }
+
+    case MAV_CMD_NAV_LOITER_UNLIM:
+        add_leg(cmd.index, loc, 0, true);
+        _estimate.unbounded = true;
+        break;
+
+    case MAV_CMD_NAV_TAKEOFF:
+        // climb straight up from the current position, so there is no horizontal speed at the end
+        loc.lat = _prev_loc.lat;
+        loc.lng = _prev_loc.lng;
+        add_leg(cmd.index, loc, 0, true);
+        break;
+
+    case MAV_CMD_NAV_LAND: {
+        // fly to the landing point, then descend at the landing speed
+        loc.options = 0;
+        loc.alt = _prev_alt_cm;
+        loc.flags.relative_alt = true;
+        loc.flags.terrain_alt = _prev_terrain_alt;
+        add_leg(cmd.index, loc, 0, true);
+        if (_limits.land_speed_cms > 0) {
+            add_time(loc.alt / _limits.land_speed_cms);
+        }
+        _prev_alt_cm = 0;
+        _prev_terrain_alt = false;
+        break;
+    }
+
+    case MAV_CMD_NAV_RETURN_TO_LAUNCH: {
+        // climb to the return altitude, fly home and land. An altitude
+        // above terrain is not compared with the return altitude, as
+        // the two only match over flat ground
+        loc = _home;
+        loc.options = 0;
+        loc.alt = _prev_terrain_alt ? _limits.rtl_alt_cm : max(_prev_alt_cm, _limits.rtl_alt_cm);
+        loc.flags.relative_alt = true;
+        add_leg(cmd.index, loc, 0, true);
+        if (_limits.land_speed_cms > 0) {
+            add_time(loc.alt / _limits.land_speed_cms);
+        }
+        _prev_alt_cm = 0;
+        _prev_terrain_alt = false;
+        break;
+    }
+
+    case MAV_CMD_CONDITION_DELAY:
+        add_time(cmd.content.delay.seconds);
+        break;
+
+    default:
+        // do commands do not move the vehicle
+        break;
+    }
+}
+
+/// add_leg - model flying from the previous location to loc, then waiting delay_s seconds
+void AP_MissionEstimator::add_leg(uint16_t cmd_index, const Location &loc, float delay_s, bool stop_at_end)
+{
+    float alt_cm = alt_above_home_cm(loc);
+    float start_alt_cm = _prev_alt_cm;
+    bool terrain_alt = loc.flags.terrain_alt;
+
+    // altitudes above terrain and above home can only be interpolated
+    // once both ends of the leg are in the same frame, so convert the
+    // end above terrain to one above home
+    bool frames_match = (terrain_alt == _prev_terrain_alt);
+    if (!frames_match) {
+        if (terrain_alt) {
+            frames_match = terrain_alt_to_home_cm(loc, alt_cm);
+        } else {
+            frames_match = terrain_alt_to_home_cm(_prev_loc, start_alt_cm);
+        }
+        if (frames_match) {
+            terrain_alt = false;
+        }
+    }
+
+    float dist_cm = get_distance_cm(_prev_loc, loc);
+    float climb_cm = alt_cm - start_alt_cm;
+
+    // horizontal time, accelerating from a stop and decelerating to one where needed
+    float speed = _limits.speed_cms;
+    float time_s = leg_time(dist_cm, speed, _limits.accel_cmss, _moving ? speed : 0, stop_at_end ? 0 : speed);
+
+    // the vertical and horizontal motion happen together, so the slower one sets the time
+    float climb_rate = climb_cm > 0 ? _limits.climb_cms : _limits.descent_cms;
+    if (climb_rate > 0) {
+        time_s = max(time_s, fabsf(climb_cm) / climb_rate);
+    }
+
+    _leg.cmd_index = cmd_index;
+    _leg.distance_m = safe_sqrt(sq(dist_cm) + sq(climb_cm)) * 0.01f;
+    _leg.time_s = time_s + delay_s;
+    _leg.clearance_m = AP_MISSION_ESTIMATOR_CLEARANCE_UNKNOWN;
+    _leg_start = _prev_loc;
+    _leg_end = loc;
+    _leg_terrain_alt = terrain_alt;
+    _leg_start_alt_cm = start_alt_cm;
+    _leg_end_alt_cm = alt_cm;
+    if (frames_match) {
+        _leg_samples = (uint16_t)(dist_cm * 0.01f / AP_MISSION_ESTIMATOR_SAMPLE_SPACING) + 2;
+    } else {
+        // without terrain data for the conversion the clearance stays unknown
+        _leg_samples = 0;
+    }
+    _leg_sample_idx = 0;
+
+    _prev_loc = loc;
+    _prev_alt_cm = alt_cm;
+    _prev_terrain_alt = terrain_alt;
+    _moving = !stop_at_end;
+    _state = STATE_SAMPLE_TERRAIN;
+
+    // record the leg immediately if there is no terrain to sample
+#if AP_TERRAIN_AVAILABLE
+    if (_terrain == NULL) {
+        finish_leg();
+    }
+#else
+    finish_leg();
+#endif
+}
+
+/// add_time - add time at the current location to the current leg and totals
+void AP_MissionEstimator::add_time(float time_s)
+{
+    if (_state == STATE_SAMPLE_TERRAIN) {
+        // the leg has not been recorded yet
+        _leg.time_s += time_s;
+        return;
+    }
+    _estimate.time_s += time_s;
+    if (_estimate.num_legs > 0 && _estimate.num_legs <= AP_MISSION_ESTIMATOR_MAX_LEGS) {
+        _legs[_estimate.num_legs-1].time_s += time_s;
+    }
+}
+
+/// finish_leg - store the current leg and fold it into the totals
+void AP_MissionEstimator::finish_leg()
+{
+    if (_estimate.num_legs < AP_MISSION_ESTIMATOR_MAX_LEGS) {
+        _legs[_estimate.num_legs] = _leg;
+    }
+    _estimate.num_legs++;
+    _estimate.distance_m += _leg.distance_m;
+    _estimate.time_s += _leg.time_s;
+    if (_leg.clearance_m < _estimate.clearance_m) {
+        _estimate.clearance_m = _leg.clearance_m;
+    }
+    _state = STATE_WALK_MISSION;
+}
+
+/// sample_terrain - take up to AP_MISSION_ESTIMATOR_SAMPLES_PER_UPDATE terrain samples along the current leg
+void AP_MissionEstimator::sample_terrain()
+{
+#if AP_TERRAIN_AVAILABLE
+    Vector2f leg_ne = location_diff(_leg_start, _leg_end);
+    float home_amsl_m = _home.alt * 0.01f;
+
+    for (uint8_t i=0; i<AP_MISSION_ESTIMATOR_SAMPLES_PER_UPDATE && _leg_sample_idx < _leg_samples; i++) {
+        float fraction = _leg_sample_idx / (float)(_leg_samples - 1);
+        _leg_sample_idx++;
+
+        Location loc = _leg_start;
+        location_offset(loc, leg_ne.x * fraction, leg_ne.y * fraction);
+        float alt_m = (_leg_start_alt_cm + (_leg_end_alt_cm - _leg_start_alt_cm) * fraction) * 0.01f;
+
+        float clearance_m;
+        if (_leg_terrain_alt) {
+            // altitudes above terrain are the clearance
+            clearance_m = alt_m;
+        } else {
+            float terrain_amsl_m;
+            if (!_terrain->height_amsl(loc, terrain_amsl_m)) {
+                _estimate.terrain_missing++;
+                continue;
+            }
+            clearance_m = home_amsl_m + alt_m - terrain_amsl_m;
+        }
+        if (clearance_m < _leg.clearance_m) {
+            _leg.clearance_m = clearance_m;
+        }
+    }
+#endif
+
+    if (_leg_sample_idx >= _leg_samples) {
+        finish_leg();
+    }
+}
+
+/// leg_time - time to travel distance with the given speed and acceleration, starting and ending at the given speeds
+float AP_MissionEstimator::leg_time(float distance, float speed, float accel, float start_speed, float end_speed)
+{
+    if (distance <= 0 || speed <= 0) {
+        return 0;
+    }
+    if (accel <= 0) {
+        return distance / speed;
+    }
+
+    // distances needed to reach cruise speed and to slow down from it
+    float accel_dist = (sq(speed) - sq(start_speed)) / (2.0f * accel);
+    float decel_dist = (sq(speed) - sq(end_speed)) / (2.0f * accel);
+    if (accel_dist + decel_dist <= distance) {
+        return (speed - start_speed) / accel + (speed - end_speed) / accel + (distance - accel_dist - decel_dist) / speed;
+    }
+
+    // too short to reach cruise speed, so find the peak speed of the triangular profile
+    float peak_speed = safe_sqrt(accel * distance + (sq(start_speed) + sq(end_speed)) * 0.5f);
+    peak_speed = max(peak_speed, max(start_speed, end_speed));
+    return (peak_speed - start_speed) / accel + (peak_speed - end_speed) / accel;
+}
+
+/// alt_above_home_cm - altitude of a command location in cm above home, or above terrain for terrain altitudes
+float AP_MissionEstimator::alt_above_home_cm(const Location &loc) const
+{
+    if (loc.flags.relative_alt || loc.flags.terrain_alt) {
+        return loc.alt;
+    }
+    return loc.alt - _home.alt;
+}
+
+/// terrain_alt_to_home_cm - convert an altitude above terrain at loc to one above home.  Returns false if there is no terrain data
+bool AP_MissionEstimator::terrain_alt_to_home_cm(const Location &loc, float &alt_cm)
+{
+#if AP_TERRAIN_AVAILABLE
+    if (_terrain == NULL) {
+        return false;
+    }
+    float terrain_amsl_m;
+    if (!_terrain->height_amsl(loc, terrain_amsl_m)) {
+        _estimate.terrain_missing++;
+        return false;
+    }
+    alt_cm += terrain_amsl_m * 100.0f - _home.alt;
+    return true;
+#else
+    return false;
+#endif
+}
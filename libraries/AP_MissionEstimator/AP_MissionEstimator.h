@@ -0,0 +1,205 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/// @file    AP_MissionEstimator.h
+/// @brief   Estimates the length, flight time, energy use and terrain
+///          clearance of the stored mission
+
+/*
+ *   The estimator walks the mission in the same order the vehicle
+ *   will fly it, following DO_JUMP commands, and models each leg
+ *   with the vehicle's speed and acceleration limits. When terrain
+ *   data is available each leg is sampled for clearance.
+ *
+ *   The work is time sliced: each call to update() handles a small
+ *   number of commands and terrain samples, so it can run from the
+ *   main loop scheduler.
+ */
+
+#ifndef AP_MISSIONESTIMATOR_H
+#define AP_MISSIONESTIMATOR_H
+
+#include <AP_HAL.h>
+#include <AP_Common.h>
+#include <AP_Math.h>
+#include <AP_Param.h>
+#include <AP_Mission.h>
+#include <AP_Terrain.h>
+
+#if HAL_CPU_CLASS < HAL_CPU_CLASS_75
+ # define AP_MISSION_ESTIMATOR_MAX_LEGS         16      // number of legs with stored results on low speed CPUs
+#else
+ # define AP_MISSION_ESTIMATOR_MAX_LEGS         64      // number of legs with stored results on high speed CPUs
+#endif
+#define AP_MISSION_ESTIMATOR_CMDS_PER_UPDATE    4       // maximum number of mission commands handled in each update
+#define AP_MISSION_ESTIMATOR_SAMPLES_PER_UPDATE 8       // maximum number of terrain samples taken in each update
+#define AP_MISSION_ESTIMATOR_SAMPLE_SPACING     50.0f   // distance in meters between terrain samples along a leg
+#define AP_MISSION_ESTIMATOR_MAX_STEPS          1000    // maximum number of commands walked, to bound missions with many jumps
+#define AP_MISSION_ESTIMATOR_RETRY_MS           10000   // time before estimating again when terrain data was missing
+#define AP_MISSION_ESTIMATOR_CLEARANCE_UNKNOWN  99999.0f // clearance reported when there is no terrain data
+
+class AP_MissionEstimator
+{
+public:
+    // vehicle limits used to model each leg
+    struct Vehicle_Limits {
+        float speed_cms;            // horizontal cruise speed in cm/s
+        float accel_cmss;           // horizontal acceleration in cm/s/s
+        float climb_cms;            // climb rate in cm/s
+        float descent_cms;          // descent rate in cm/s
+        float land_speed_cms;       // final descent rate when landing in cm/s
+        float loiter_radius_cm;     // radius used for loiter turns when the command gives none
+        float rtl_alt_cm;           // minimum altitude above home for returning to launch
+    };
+
+    // result for one leg, ending at the nav command with index cmd_index
+    struct Leg {
+        uint16_t cmd_index;         // index of the mission command that ends this leg
+        float distance_m;           // distance flown along the leg in meters
+        float time_s;               // time to fly the leg, including any delay at its end, in seconds
+        float clearance_m;          // lowest height above terrain along the leg in meters, AP_MISSION_ESTIMATOR_CLEARANCE_UNKNOWN if no terrain data
+    };
+
+    // totals for the whole mission
+    struct Estimate {
+        float distance_m;           // total distance in meters
+        float time_s;               // total time in seconds
+        float energy_mah;           // total battery use in mAh at the expected current draw
+        float clearance_m;          // lowest height above terrain in meters
+        uint16_t num_legs;          // number of legs in the mission
+        uint16_t terrain_missing;   // number of terrain samples without data
+        bool unbounded;             // true if the mission never ends (unlimited loiter or jump)
+    };
+
+    /// Constructor
+    AP_MissionEstimator(const AP_Mission &mission);
+
+    /// set_limits - set the vehicle limits used for the estimate.  Restarts the estimate if they changed
+    void set_limits(const Vehicle_Limits &limits);
+
+    /// set_home - set the home location.  Restarts the estimate if it moved
+    void set_home(const Location &home);
+
+#if AP_TERRAIN_AVAILABLE
+    /// set_terrain - provide the terrain database used for clearance estimates
+    void set_terrain(AP_Terrain &terrain) { _terrain = &terrain; }
+#endif
+
+    /// update - continue the estimate.  Should be called at 10hz or faster
+    void update(void);
+
+    /// complete - true once the estimate covers the current mission
+    bool complete() const { return _state == STATE_COMPLETE; }
+
+    /// get_estimate - returns the totals for the mission.  Only valid once complete() returns true
+    const Estimate &get_estimate() const { return _estimate; }
+
+    /// get_leg - returns the result for the leg with the given number.  Returns false if it was not stored
+    bool get_leg(uint16_t leg_num, Leg &leg) const;
+
+    /// check - returns true if the estimate passes the parameter limits.  Fills in failure_msg otherwise
+    bool check(float battery_remaining_mah, const prog_char_t *&failure_msg) const;
+
+    /// last_change_time_ms - returns the time the estimate was last completed
+    uint32_t last_change_time_ms(void) const { return _last_complete_ms; }
+
+    static const struct AP_Param::GroupInfo var_info[];
+
+private:
+    enum estimate_state {
+        STATE_IDLE = 0,         // waiting for home
+        STATE_WALK_MISSION,     // reading the next command
+        STATE_SAMPLE_TERRAIN,   // sampling terrain along the current leg
+        STATE_COMPLETE          // estimate covers the current mission
+    };
+
+    /// restart - start the estimate again from the first command
+    void restart();
+
+    /// walk_mission - handle up to AP_MISSION_ESTIMATOR_CMDS_PER_UPDATE mission commands
+    void walk_mission();
+
+    /// process_cmd - add the leg or delay for a single command
+    void process_cmd(const AP_Mission::Mission_Command &cmd);
+
+    /// add_leg - model flying from the previous location to loc, then waiting delay_s seconds
+    void add_leg(uint16_t cmd_index, const Location &loc, float delay_s, bool stop_at_end);
+
+    /// add_time - add time at the current location to the current leg and totals
+    void add_time(float time_s);
+
+    /// finish_leg - store the current leg and fold it into the totals
+    void finish_leg();
+
+    /// sample_terrain - take up to AP_MISSION_ESTIMATOR_SAMPLES_PER_UPDATE terrain samples along the current leg
+    void sample_terrain();
+
+    /// leg_time - time to travel distance with the given speed and acceleration, starting and ending at the given speeds
+    static float leg_time(float distance, float speed, float accel, float start_speed, float end_speed);
+
+    /// alt_above_home_cm - altitude of a command location in cm above home, or above terrain for terrain altitudes
+    float alt_above_home_cm(const Location &loc) const;
+
+    /// terrain_alt_to_home_cm - convert an altitude above terrain at loc to one above home.  Returns false if there is no terrain data
+    bool terrain_alt_to_home_cm(const Location &loc, float &alt_cm);
+
+    // parameters
+    AP_Float        _clearance_min;     // minimum allowed terrain clearance in meters
+    AP_Float        _current;           // expected average current draw in amps
+    AP_Int8         _reserve_pct;       // battery reserve in percent
+
+    // references
+    const AP_Mission &_mission;
+#if AP_TERRAIN_AVAILABLE
+    AP_Terrain      *_terrain;
+#endif
+
+    // inputs
+    Vehicle_Limits  _limits;
+    Location        _home;
+    bool            _have_home;
+    uint32_t        _mission_change_ms;
+
+    // walk state
+    estimate_state  _state;
+    uint16_t        _next_index;        // next command to read
+    uint16_t        _steps;             // number of commands walked
+    Location        _prev_loc;          // location at the end of the previous leg
+    float           _prev_alt_cm;       // altitude above home at the end of the previous leg
+    bool            _prev_terrain_alt;  // true if _prev_alt_cm is above terrain rather than above home
+    bool            _moving;            // true if the vehicle is expected to pass the previous location without stopping
+    struct jump_tracking {
+        uint16_t index;                 // index of the do-jump command
+        int16_t num_times_run;          // number of times the jump has been taken
+    } _jumps[AP_MISSION_MAX_NUM_DO_JUMP_COMMANDS];
+
+    // current leg, including its terrain sampling progress
+    Leg             _leg;
+    Location        _leg_start;
+    Location        _leg_end;
+    bool            _leg_terrain_alt;   // true if both of the leg's altitudes are above terrain rather than above home
+    float           _leg_start_alt_cm;
+    float           _leg_end_alt_cm;
+    uint16_t        _leg_samples;       // number of terrain samples along the current leg
+    uint16_t        _leg_sample_idx;    // next terrain sample to take
+
+    // results
+    Leg             _legs[AP_MISSION_ESTIMATOR_MAX_LEGS];
+    Estimate        _estimate;
+    uint32_t        _last_complete_ms;
+};
+
+#endif // AP_MISSIONESTIMATOR_H
@@ -0,0 +1,173 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Unit tests for the AP_MissionEstimator library
+//
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Math.h>
+#include <AP_Param.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+#include <SITL.h>
+#include <AP_Rally.h>
+#include <GCS_MAVLink.h>
+#include <AP_Notify.h>
+#include <AP_Vehicle.h>
+#include <DataFlash.h>
+#include <AP_Mission.h>
+#include <AP_MissionEstimator.h>
+#include <AP_NavEKF.h>
+#include <StorageManager.h>
+#include <AP_Terrain.h>
+#include <AP_GPS.h>
+#include <AP_GPS_Glitch.h>
+#include <AP_ADC.h>
+#include <AP_ADC_AnalogSource.h>
+#include <AP_Baro.h>
+#include <Filter.h>
+#include <AP_Compass.h>
+#include <AP_Declination.h>
+#include <AP_InertialSensor.h>
+#include <AP_AHRS.h>
+#include <AP_Airspeed.h>
+#include <AP_Buffer.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+AP_InertialSensor ins;
+AP_Baro_HIL baro;
+static AP_GPS gps;
+AP_AHRS_DCM ahrs(ins, baro, gps);
+
+static bool start_cmd(const AP_Mission::Mission_Command& cmd) { return true; }
+static bool verify_cmd(const AP_Mission::Mission_Command& cmd) { return true; }
+static void mission_complete(void) {}
+
+AP_Mission mission(ahrs, &start_cmd, &verify_cmd, &mission_complete);
+static AP_MissionEstimator estimator(mission);
+
+// 100m in units of 1e-7 degrees of latitude
+#define LAT_100M 8983
+
+static bool all_passed = true;
+
+static void check(const char *name, float value, float expected, float tolerance)
+{
+    bool ok = fabsf(value - expected) <= tolerance;
+    hal.console->printf_P(PSTR("%-20s %8.2f expected %8.2f %s\n"), name, value, expected, ok ? "PASS" : "FAIL");
+    if (!ok) {
+        all_passed = false;
+    }
+}
+
+static void add_cmd(uint16_t id, int32_t lat, int32_t lng, int32_t alt_cm, uint16_t p1)
+{
+    AP_Mission::Mission_Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.id = id;
+    cmd.p1 = p1;
+    cmd.content.location.flags.relative_alt = true;
+    cmd.content.location.lat = lat;
+    cmd.content.location.lng = lng;
+    cmd.content.location.alt = alt_cm;
+    if (!mission.add_cmd(cmd)) {
+        hal.console->printf_P(PSTR("failed to add command %u\n"), (unsigned)id);
+        all_passed = false;
+    }
+}
+
+static void add_jump(uint16_t target, int16_t num_times)
+{
+    AP_Mission::Mission_Command cmd;
+    memset(&cmd, 0, sizeof(cmd));
+    cmd.id = MAV_CMD_DO_JUMP;
+    cmd.content.jump.target = target;
+    cmd.content.jump.num_times = num_times;
+    if (!mission.add_cmd(cmd)) {
+        hal.console->println("failed to add jump");
+        all_passed = false;
+    }
+}
+
+void setup(void)
+{
+    hal.console->println("AP_MissionEstimator unit tests\n");
+
+    Location home;
+    memset(&home, 0, sizeof(home));
+    home.lat = -353632620;
+    home.lng = 1491652370;
+    home.alt = 58400;
+    int32_t lng_100m = LAT_100M / longitude_scale(home);
+
+    // take off to 20m, fly a 100m square corner twice, then return home
+    mission.clear();
+    add_cmd(MAV_CMD_NAV_WAYPOINT, home.lat, home.lng, 0, 0);
+    add_cmd(MAV_CMD_NAV_TAKEOFF, 0, 0, 2000, 0);
+    add_cmd(MAV_CMD_NAV_WAYPOINT, home.lat + LAT_100M, home.lng, 2000, 0);
+    add_cmd(MAV_CMD_NAV_WAYPOINT, home.lat + LAT_100M, home.lng + lng_100m, 2000, 5);
+    add_jump(2, 1);
+    add_cmd(MAV_CMD_NAV_RETURN_TO_LAUNCH, 0, 0, 0, 0);
+
+    AP_MissionEstimator::Vehicle_Limits limits;
+    limits.speed_cms = 500;
+    limits.accel_cmss = 100;
+    limits.climb_cms = 250;
+    limits.descent_cms = 150;
+    limits.land_speed_cms = 50;
+    limits.loiter_radius_cm = 1000;
+    limits.rtl_alt_cm = 1500;
+    estimator.set_limits(limits);
+    estimator.set_home(home);
+
+    uint32_t start_time = hal.scheduler->micros();
+    uint16_t updates = 0;
+    while (!estimator.complete() && updates < 1000) {
+        estimator.update();
+        updates++;
+    }
+    uint32_t elapsed = hal.scheduler->micros() - start_time;
+
+    const AP_MissionEstimator::Estimate &estimate = estimator.get_estimate();
+    for (uint16_t i=0; i<estimate.num_legs; i++) {
+        AP_MissionEstimator::Leg leg;
+        if (estimator.get_leg(i, leg)) {
+            hal.console->printf_P(PSTR("leg %u cmd %u: %.1fm %.1fs\n"),
+                                  (unsigned)i, (unsigned)leg.cmd_index, leg.distance_m, leg.time_s);
+        }
+    }
+
+    // takeoff, the corner twice with the jump back between, and the return home
+    check("legs", estimate.num_legs, 6, 0);
+    check("distance m", estimate.distance_m, 20 + 4*100 + 141.4f, 2);
+
+    // takeoff is 20m at 2.5m/s
+    AP_MissionEstimator::Leg leg;
+    estimator.get_leg(0, leg);
+    check("takeoff s", leg.time_s, 8, 0.1f);
+
+    // first 100m leg starts from a stop and flies through: 5s to reach 5m/s over 12.5m, then 87.5m at 5m/s
+    estimator.get_leg(1, leg);
+    check("first leg s", leg.time_s, 5 + 17.5f, 0.5f);
+
+    // the corner waypoint has a 5 second delay, so the vehicle slows to a stop over the last 12.5m
+    estimator.get_leg(2, leg);
+    check("corner leg s", leg.time_s, 17.5f + 5 + 5, 0.5f);
+
+    check("unbounded", estimate.unbounded ? 1 : 0, 0, 0);
+
+    hal.console->printf_P(PSTR("%u updates, %lu usec\n"), (unsigned)updates, (unsigned long)elapsed);
+    hal.console->println(all_passed ? "ALL TESTS PASSED" : "TEST FAILED");
+}
+
+void loop(void)
+{
+    hal.scheduler->delay(1000);
+}
+
+AP_HAL_MAIN();
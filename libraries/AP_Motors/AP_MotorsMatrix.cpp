@@ -118,24 +118,35 @@ uint16_t AP_MotorsMatrix::get_motor_mask()
     return mask;
 }
 
+// boards without an FPU keep the mix in integer pwm, faster boards mix in float
+#if HAL_CPU_CLASS < HAL_CPU_CLASS_75
+typedef int16_t mix_pwm_t;
+#else
+typedef float mix_pwm_t;
+#endif
+
 // output_armed - sends commands to the motors
 // includes new scaling stability patch
+// the mix runs over the packed factors of the enabled motors. Each step of the
+// roll-pitch over yaw over throttle priority is solved directly from the range
+// of the motor commands, so the cost is three short passes whatever the frame
 void AP_MotorsMatrix::output_armed()
 {
-    int8_t i;
+    uint8_t i;
+    const uint8_t num_motors = _mix_num_motors;
     int16_t out_min_pwm = _rc_throttle.radio_min + _min_throttle;      // minimum pwm value we can send to the motors
     int16_t out_max_pwm = _rc_throttle.radio_max;                      // maximum pwm value we can send to the motors
     int16_t out_mid_pwm = (out_min_pwm+out_max_pwm)/2;                  // mid pwm value we can send to the motors
-    int16_t out_best_thr_pwm;  // the is the best throttle we can come up which provides good control without climbing
-    float rpy_scale = 1.0; // this is used to scale the roll, pitch and yaw to fit within the motor limits
+    mix_pwm_t out_best_thr_pwm;  // the is the best throttle we can come up which provides good control without climbing
+    float rpy_scale = 1.0f; // this is used to scale the roll, pitch and yaw to fit within the motor limits
 
-    int16_t rpy_out[AP_MOTORS_MAX_NUM_MOTORS]; // buffer so we don't have to multiply coefficients multiple times.
-    int16_t motor_out[AP_MOTORS_MAX_NUM_MOTORS];    // final outputs sent to the motors
+    mix_pwm_t rpy_out[AP_MOTORS_MAX_NUM_MOTORS];    // roll, pitch and yaw command for each packed motor
+    int16_t motor_out[AP_MOTORS_MAX_NUM_MOTORS];    // final outputs sent to the packed motors
 
-    int16_t rpy_low = 0;    // lowest motor value
-    int16_t rpy_high = 0;   // highest motor value
-    int16_t yaw_allowed;    // amount of yaw we can fit in
-    int16_t thr_adj;        // the difference between the pilot's desired throttle and out_best_thr_pwm (the throttle that is actually provided)
+    mix_pwm_t rpy_low = 0;  // lowest motor value
+    mix_pwm_t rpy_high = 0; // highest motor value
+    mix_pwm_t yaw_allowed;  // amount of yaw we can fit in
+    mix_pwm_t thr_adj;      // the difference between the pilot's desired throttle and out_best_thr_pwm (the throttle that is actually provided)
 
     // initialize limits flag
     limit.roll_pitch = false;
@@ -169,11 +180,9 @@ void AP_MotorsMatrix::output_armed()
         if (_spin_when_armed_ramped > _min_throttle) {
             _spin_when_armed_ramped = _min_throttle;
         }
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        for (i=0; i<num_motors; i++) {
             // spin motors at minimum
-            if (motor_enabled[i]) {
-                motor_out[i] = _rc_throttle.radio_min + _spin_when_armed_ramped;
-            }
+            motor_out[i] = _rc_throttle.radio_min + _spin_when_armed_ramped;
         }
 
         // Every thing is limited
@@ -182,6 +191,11 @@ void AP_MotorsMatrix::output_armed()
 
     } else {
 
+        const mix_pwm_t roll_pwm = _rc_roll.pwm_out;
+        const mix_pwm_t pitch_pwm = _rc_pitch.pwm_out;
+        const mix_pwm_t yaw_pwm = _rc_yaw.pwm_out;
+        const mix_pwm_t thr_pwm = _rc_throttle.radio_out;
+
         // check if throttle is below limit
         if (_rc_throttle.servo_out <= _min_throttle) {  // perhaps being at min throttle itself is not a problem, only being under is
             limit.throttle_lower = true;
@@ -189,20 +203,11 @@ void AP_MotorsMatrix::output_armed()
 
         // calculate roll and pitch for each motor
         // set rpy_low and rpy_high to the lowest and highest values of the motors
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-            if (motor_enabled[i]) {
-                rpy_out[i] = _rc_roll.pwm_out * _roll_factor[i] +
-                             _rc_pitch.pwm_out * _pitch_factor[i];
-
-                // record lowest roll pitch command
-                if (rpy_out[i] < rpy_low) {
-                    rpy_low = rpy_out[i];
-                }
-                // record highest roll pich command
-                if (rpy_out[i] > rpy_high) {
-                    rpy_high = rpy_out[i];
-                }
-            }
+        for (i=0; i<num_motors; i++) {
+            mix_pwm_t rp = roll_pwm * _mix_roll[i] + pitch_pwm * _mix_pitch[i];
+            rpy_out[i] = rp;
+            rpy_low = min(rpy_low, rp);
+            rpy_high = max(rpy_high, rp);
         }
 
         // calculate throttle that gives most possible room for yaw (range 1000 ~ 2000) which is the lower of:
@@ -214,26 +219,26 @@ void AP_MotorsMatrix::output_armed()
         //      Situation #2b allows us to raise the throttle above what the pilot commanded but not so far that it would actually cause the copter to rise.
         //      We will choose #1 (the best throttle for yaw control) if that means reducing throttle to the motors (i.e. we favour reducing throttle *because* it provides better yaw control)
         //      We will choose #2 (a mix of pilot and hover throttle) only when the throttle is quite low.  We favour reducing throttle instead of better yaw control because the pilot has commanded it
-        int16_t motor_mid = (rpy_low+rpy_high)/2;
-        out_best_thr_pwm = min(out_mid_pwm - motor_mid, max(_rc_throttle.radio_out, (_rc_throttle.radio_out+_hover_out)/2));
+        mix_pwm_t motor_mid = (rpy_low+rpy_high)/2;
+        out_best_thr_pwm = min(out_mid_pwm - motor_mid, max(thr_pwm, (thr_pwm+_hover_out)/2));
 
         // calculate amount of yaw we can fit into the throttle range
         // this is always equal to or less than the requested yaw from the pilot or rate controller
         yaw_allowed = min(out_max_pwm - out_best_thr_pwm, out_best_thr_pwm - out_min_pwm) - (rpy_high-rpy_low)/2;
         yaw_allowed = max(yaw_allowed, AP_MOTORS_MATRIX_YAW_LOWER_LIMIT_PWM);
 
-        if (_rc_yaw.pwm_out >= 0) {
+        if (yaw_pwm >= 0) {
             // if yawing right
-            if (yaw_allowed > _rc_yaw.pwm_out) {
-                yaw_allowed = _rc_yaw.pwm_out; // to-do: this is bad form for yaw_allows to change meaning to become the amount that we are going to output
+            if (yaw_allowed > yaw_pwm) {
+                yaw_allowed = yaw_pwm; // to-do: this is bad form for yaw_allows to change meaning to become the amount that we are going to output
             }else{
                 limit.yaw = true;
             }
         }else{
             // if yawing left
             yaw_allowed = -yaw_allowed;
-            if( yaw_allowed < _rc_yaw.pwm_out ) {
-                yaw_allowed = _rc_yaw.pwm_out; // to-do: this is bad form for yaw_allows to change meaning to become the amount that we are going to output
+            if( yaw_allowed < yaw_pwm ) {
+                yaw_allowed = yaw_pwm; // to-do: this is bad form for yaw_allows to change meaning to become the amount that we are going to output
             }else{
                 limit.yaw = true;
             }
@@ -242,27 +247,18 @@ void AP_MotorsMatrix::output_armed()
         // add yaw to intermediate numbers for each motor
         rpy_low = 0;
         rpy_high = 0;
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-            if (motor_enabled[i]) {
-                rpy_out[i] =    rpy_out[i] +
-                                yaw_allowed * _yaw_factor[i];
-
-                // record lowest roll+pitch+yaw command
-                if( rpy_out[i] < rpy_low ) {
-                    rpy_low = rpy_out[i];
-                }
-                // record highest roll+pitch+yaw command
-                if( rpy_out[i] > rpy_high) {
-                    rpy_high = rpy_out[i];
-                }
-            }
+        for (i=0; i<num_motors; i++) {
+            mix_pwm_t rpy = rpy_out[i] + yaw_allowed * _mix_yaw[i];
+            rpy_out[i] = rpy;
+            rpy_low = min(rpy_low, rpy);
+            rpy_high = max(rpy_high, rpy);
         }
 
         // check everything fits
-        thr_adj = _rc_throttle.radio_out - out_best_thr_pwm;
+        thr_adj = thr_pwm - out_best_thr_pwm;
 
         // calc upper and lower limits of thr_adj
-        int16_t thr_adj_max = max(out_max_pwm-(out_best_thr_pwm+rpy_high),0);
+        mix_pwm_t thr_adj_max = max(out_max_pwm-(out_best_thr_pwm+rpy_high),0);
 
         // if we are increasing the throttle (situation #2 above)..
         if (thr_adj > 0) {
@@ -277,7 +273,7 @@ void AP_MotorsMatrix::output_armed()
             // decrease throttle as close as possible to requested throttle
             // without going under out_min_pwm or over out_max_pwm
             // earlier code ensures we can't break both boundaries
-            int16_t thr_adj_min = min(out_min_pwm-(out_best_thr_pwm+rpy_low),0);
+            mix_pwm_t thr_adj_min = min(out_min_pwm-(out_best_thr_pwm+rpy_low),0);
             if (thr_adj > thr_adj_max) {
                 thr_adj = thr_adj_max;
                 limit.throttle_upper = true;
@@ -289,48 +285,41 @@ void AP_MotorsMatrix::output_armed()
         }
 
         // do we need to reduce roll, pitch, yaw command
-        // earlier code does not allow both limit's to be passed simultainiously with abs(_yaw_factor)<1
-        if ((rpy_low+out_best_thr_pwm)+thr_adj < out_min_pwm){
+        // if both limits are passed the smaller scale brings the motors inside both
+        if (rpy_low < 0 && (rpy_low+out_best_thr_pwm)+thr_adj < out_min_pwm){
             rpy_scale = (float)(out_min_pwm-thr_adj-out_best_thr_pwm)/rpy_low;
             // we haven't even been able to apply full roll, pitch and minimal yaw without scaling
             limit.roll_pitch = true;
             limit.yaw = true;
-        }else if((rpy_high+out_best_thr_pwm)+thr_adj > out_max_pwm){
-            rpy_scale = (float)(out_max_pwm-thr_adj-out_best_thr_pwm)/rpy_high;
+        }
+        if (rpy_high > 0 && (rpy_high+out_best_thr_pwm)+thr_adj > out_max_pwm){
+            rpy_scale = min(rpy_scale, (float)(out_max_pwm-thr_adj-out_best_thr_pwm)/rpy_high);
             // we haven't even been able to apply full roll, pitch and minimal yaw without scaling
             limit.roll_pitch = true;
             limit.yaw = true;
         }
 
         // add scaled roll, pitch, constrained yaw and throttle for each motor
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-            if (motor_enabled[i]) {
-                motor_out[i] = out_best_thr_pwm+thr_adj +
-                               rpy_scale*rpy_out[i];
-            }
+        const mix_pwm_t thr_out = out_best_thr_pwm + thr_adj;
+        for (i=0; i<num_motors; i++) {
+            motor_out[i] = thr_out + rpy_scale*rpy_out[i];
         }
 
         // adjust for throttle curve
         if (_throttle_curve_enabled) {
-            for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-                if (motor_enabled[i]) {
-                    motor_out[i] = _throttle_curve.get_y(motor_out[i]);
-                }
+            for (i=0; i<num_motors; i++) {
+                motor_out[i] = _throttle_curve.get_y(motor_out[i]);
             }
         }
         // clip motor output if required (shouldn't be)
-        for (i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
-            if (motor_enabled[i]) {
-                motor_out[i] = constrain_int16(motor_out[i], out_min_pwm, out_max_pwm);
-            }
+        for (i=0; i<num_motors; i++) {
+            motor_out[i] = constrain_int16(motor_out[i], out_min_pwm, out_max_pwm);
         }
     }
 
     // send output to each motor
-    for( i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++ ) {
-        if( motor_enabled[i] ) {
-            hal.rcout->write(pgm_read_byte(&_motor_to_channel_map[i]), motor_out[i]);
-        }
+    for (i=0; i<num_motors; i++) {
+        hal.rcout->write(_mix_channel[i], motor_out[i]);
     }
 }
 
@@ -381,6 +370,9 @@ void AP_MotorsMatrix::add_motor_raw(int8_t motor_num, float roll_fac, float pitc
 
         // disable this channel from being used by RC_Channel_aux
         RC_Channel_aux::disable_aux_channel(_motor_to_channel_map[motor_num]);
+
+        // repack the mixer factors
+        update_mix();
     }
 }
 
@@ -411,6 +403,9 @@ void AP_MotorsMatrix::remove_motor(int8_t motor_num)
         _roll_factor[motor_num] = 0;
         _pitch_factor[motor_num] = 0;
         _yaw_factor[motor_num] = 0;
+
+        // repack the mixer factors
+        update_mix();
     }
 }
 
@@ -421,3 +416,18 @@ void AP_MotorsMatrix::remove_all_motors()
         remove_motor(i);
     }
 }
+
+// update_mix - packs the factors of the enabled motors into the arrays used by output_armed
+void AP_MotorsMatrix::update_mix()
+{
+    _mix_num_motors = 0;
+    for (uint8_t i=0; i<AP_MOTORS_MAX_NUM_MOTORS; i++) {
+        if (motor_enabled[i]) {
+            _mix_channel[_mix_num_motors] = pgm_read_byte(&_motor_to_channel_map[i]);
+            _mix_roll[_mix_num_motors] = _roll_factor[i];
+            _mix_pitch[_mix_num_motors] = _pitch_factor[i];
+            _mix_yaw[_mix_num_motors] = _yaw_factor[i];
+            _mix_num_motors++;
+        }
+    }
+}
@@ -22,7 +22,8 @@ public:
 
     /// Constructor
     AP_MotorsMatrix( RC_Channel& rc_roll, RC_Channel& rc_pitch, RC_Channel& rc_throttle, RC_Channel& rc_yaw, uint16_t speed_hz = AP_MOTORS_SPEED_DEFAULT) :
-        AP_Motors(rc_roll, rc_pitch, rc_throttle, rc_yaw, speed_hz)
+        AP_Motors(rc_roll, rc_pitch, rc_throttle, rc_yaw, speed_hz),
+        _mix_num_motors(0)
     {};
 
     // init
@@ -75,10 +76,20 @@ protected:
     // add_motor using raw roll, pitch, throttle and yaw factors
     void                add_motor_raw(int8_t motor_num, float roll_fac, float pitch_fac, float yaw_fac, uint8_t testing_order);
 
+    // update_mix - packs the factors of the enabled motors into the arrays used by output_armed
+    void                update_mix();
+
     float               _roll_factor[AP_MOTORS_MAX_NUM_MOTORS]; // each motors contribution to roll
     float               _pitch_factor[AP_MOTORS_MAX_NUM_MOTORS]; // each motors contribution to pitch
     float               _yaw_factor[AP_MOTORS_MAX_NUM_MOTORS];  // each motors contribution to yaw (normally 1 or -1)
     uint8_t             _test_order[AP_MOTORS_MAX_NUM_MOTORS];  // order of the motors in the test sequence
+
+    // factors of the enabled motors packed together so the mixer loops run without gaps or branches
+    uint8_t             _mix_num_motors;                            // number of enabled motors
+    uint8_t             _mix_channel[AP_MOTORS_MAX_NUM_MOTORS];     // output channel of each packed motor
+    float               _mix_roll[AP_MOTORS_MAX_NUM_MOTORS];        // packed roll factors
+    float               _mix_pitch[AP_MOTORS_MAX_NUM_MOTORS];       // packed pitch factors
+    float               _mix_yaw[AP_MOTORS_MAX_NUM_MOTORS];         // packed yaw factors
 };
 
 #endif  // AP_MOTORSMATRIX
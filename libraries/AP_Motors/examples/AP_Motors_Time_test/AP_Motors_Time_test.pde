@@ -88,9 +88,35 @@ void loop()
 {
     int16_t value;
 
+    mixer_time_test();
     motor_order_test();
 }
 
+// mixer_time_test - time the armed mixer with demands that saturate the motors
+void mixer_time_test()
+{
+    const uint16_t count = 1000;
+
+    motors.armed(true);
+    rc1.servo_out = 4500;
+    rc2.servo_out = -3000;
+    rc3.servo_out = 700;
+    rc4.servo_out = 4500;
+    uint32_t start = hal.scheduler->micros();
+    for (uint16_t i=0; i<count; i++) {
+        motors.output();
+    }
+    uint32_t elapsed = hal.scheduler->micros() - start;
+    motors.armed(false);
+    motors.output_min();
+    rc1.servo_out = 0;
+    rc2.servo_out = 0;
+    rc3.servo_out = 0;
+    rc4.servo_out = 0;
+    hal.console->printf_P(PSTR("Mixer: %u.%02uus per output\n"),
+                          (unsigned)(elapsed/count), (unsigned)((elapsed%count)/10));
+}
+
 // stability_test
 void motor_order_test()
 {
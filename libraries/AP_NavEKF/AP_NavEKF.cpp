@@ -45,6 +45,7 @@
 #define MAG_CAL_DEFAULT         1
 #define GLITCH_ACCEL_DEFAULT    150
 #define GLITCH_RADIUS_DEFAULT   15
+#define TAU_OUTPUT_DEFAULT      25
 
 #elif APM_BUILD_TYPE(APM_BUILD_APMrover2)
 // rover defaults
@@ -66,6 +67,7 @@
 #define MAG_CAL_DEFAULT         1
 #define GLITCH_ACCEL_DEFAULT    150
 #define GLITCH_RADIUS_DEFAULT   15
+#define TAU_OUTPUT_DEFAULT      25
 
 #else
 // generic defaults (and for plane)
@@ -87,6 +89,7 @@
 #define MAG_CAL_DEFAULT         0
 #define GLITCH_ACCEL_DEFAULT    150
 #define GLITCH_RADIUS_DEFAULT   15
+#define TAU_OUTPUT_DEFAULT      25
 
 #endif // APM_BUILD_DIRECTORY
 
@@ -301,6 +304,14 @@ const AP_Param::GroupInfo NavEKF::var_info[] PROGMEM = {
     // @User: Advanced
     AP_GROUPINFO("GLITCH_RAD",    24, NavEKF, _gpsGlitchRadiusMax, GLITCH_RADIUS_DEFAULT),
 
+    // @Param: TAU_OUTPUT
+    // @DisplayName: Output predictor time constant (centi-sec)
+    // @Description: This parameter sets the time constant used to pull the attitude, velocity and position given to the controllers towards the filter solution. Smaller values follow the filter more closely but pass on the steps made when measurements are fused. Larger values give a smoother output but let it drift further from the filter solution. Set to 0 to follow the filter solution without smoothing.
+    // @Range: 0 50
+    // @Increment: 5
+    // @User: Advanced
+    AP_GROUPINFO("TAU_OUTPUT",    25, NavEKF, _tauOutput, TAU_OUTPUT_DEFAULT),
+
     AP_GROUPEND
 };
 
@@ -318,7 +329,10 @@ NavEKF::NavEKF(const AP_AHRS *ahrs, AP_Baro &baro) :
     prevStaticMode(true),       // staticMode from previous filter update
     yawAligned(false),          // set true when heading or yaw angle has been aligned
     inhibitWindStates(true),    // inhibit wind state updates on startup
-    inhibitMagStates(true)      // inhibit magnetometer state updates on startup
+    inhibitMagStates(true),     // inhibit magnetometer state updates on startup
+    outputIndex(0),             // newest output predictor state
+    outputCorrectTime_ms(0),    // output predictor not yet corrected
+    outputInitialised(false)    // output predictor waits for the first filter solution
 
 #if CONFIG_HAL_BOARD == HAL_BOARD_PX4 || CONFIG_HAL_BOARD == HAL_BOARD_VRBRAIN
     ,_perf_UpdateFilter(perf_alloc(PC_ELAPSED, "EKF_UpdateFilter")),
@@ -400,7 +414,7 @@ void NavEKF::ResetPosition(void)
     if (staticMode) {
         state.position.x = 0;
         state.position.y = 0;
-    } else if (_ahrs->get_gps().status() >= AP_GPS::GPS_OK_FIX_3D) {
+    } else if (_frame.gps_status >= AP_GPS::GPS_OK_FIX_3D) {
 
         // read the GPS
         readGpsData();
@@ -422,7 +436,7 @@ void NavEKF::ResetVelocity(void)
          state.velocity.zero();
          state.vel1.zero();
          state.vel2.zero();
-    } else if (_ahrs->get_gps().status() >= AP_GPS::GPS_OK_FIX_3D) {
+    } else if (_frame.gps_status >= AP_GPS::GPS_OK_FIX_3D) {
         // read the GPS
         readGpsData();
         // Set vertical GPS velocity to 0 if mode > 0 (assume 0 if no VZ measurement)
@@ -463,11 +477,14 @@ void NavEKF::InitialiseFilterDynamic(void)
     // attitude we get the DCM attitude regardless of the state of AHRS_EKF_USE
     statesInitialised = false;
 
+    // read the sensors
+    captureSensors(_frame);
+
     // Set re-used variables to zero
     ZeroVariables();
 
     // get initial time deltat between IMU measurements (sec)
-    dtIMU = constrain_float(_ahrs->get_ins().get_delta_time(),0.001f,1.0f);
+    dtIMU = constrain_float(_frame.dtIMU,0.001f,1.0f);
 
     // set number of updates over which gps and baro measurements are applied to the velocity and position states
     gpsUpdateCountMaxInv = (dtIMU * 1000.0f)/float(_msecGpsAvg);
@@ -478,7 +495,7 @@ void NavEKF::InitialiseFilterDynamic(void)
     magUpdateCountMax = uint8_t(1.0f/magUpdateCountMaxInv);
 
     // calculate initial orientation and earth magnetic field states
-    state.quat = calcQuatAndFieldStates(_ahrs->roll, _ahrs->pitch);
+    state.quat = calcQuatAndFieldStates(_frame.roll, _frame.pitch);
 
     // write to state vector
     state.gyro_bias.zero();
@@ -497,7 +514,7 @@ void NavEKF::InitialiseFilterDynamic(void)
     CovarianceInit();
 
     // define Earth rotation vector in the NED navigation frame
-    calcEarthRateNED(earthRateNED, _ahrs->get_home().lat);
+    calcEarthRateNED(earthRateNED, _frame.home.lat);
 
     // initialise IMU pre-processing states
     readIMUData();
@@ -507,11 +524,21 @@ void NavEKF::InitialiseFilterDynamic(void)
 // This method can only be used when the vehicle is static
 void NavEKF::InitialiseFilterBootstrap(void)
 {
+    SensorFrame frame;
+    captureSensors(frame);
+    InitialiseFilterBootstrap(frame);
+}
+
+// Initialise the states from a previously captured sensor frame
+void NavEKF::InitialiseFilterBootstrap(const SensorFrame &frame)
+{
+    _frame = frame;
+
     // set re-used variables to zero
     ZeroVariables();
 
     // get initial time deltat between IMU measurements (sec)
-    dtIMU = constrain_float(_ahrs->get_ins().get_delta_time(),0.001f,1.0f);
+    dtIMU = constrain_float(_frame.dtIMU,0.001f,1.0f);
 
     // set number of updates over which gps and baro measurements are applied to the velocity and position states
     gpsUpdateCountMaxInv = (dtIMU * 1000.0f)/float(_msecGpsAvg);
@@ -525,7 +552,7 @@ void NavEKF::InitialiseFilterBootstrap(void)
     Vector3f initAccVec;
 
     // TODO we should average accel readings over several cycles
-    initAccVec = _ahrs->get_ins().get_accel();
+    initAccVec = _frame.accel1;
 
     // read the magnetometer data
     readMagData();
@@ -570,7 +597,7 @@ void NavEKF::InitialiseFilterBootstrap(void)
     CovarianceInit();
 
     // define Earth rotation vector in the NED navigation frame
-    calcEarthRateNED(earthRateNED, _ahrs->get_home().lat);
+    calcEarthRateNED(earthRateNED, _frame.home.lat);
 
     // initialise IMU pre-processing states
     readIMUData();
@@ -578,12 +605,22 @@ void NavEKF::InitialiseFilterBootstrap(void)
 
 // Update Filter States - this should be called whenever new IMU data is available
 void NavEKF::UpdateFilter()
+{
+    SensorFrame frame;
+    captureSensors(frame);
+    UpdateFilter(frame);
+}
+
+// Update Filter States from a previously captured sensor frame
+void NavEKF::UpdateFilter(const SensorFrame &frame)
 {
     // don't run filter updates if states have not been initialised
     if (!statesInitialised) {
         return;
     }
 
+    _frame = frame;
+
     // start the timer used for load measurement
     perf_begin(_perf_UpdateFilter);
 
@@ -624,7 +661,7 @@ void NavEKF::UpdateFilter()
         // clear the magnetometer failed status as the failure may have been
         // caused by external field disturbances associated with pre-flight activities
         magFailed = false;
-        calcQuatAndFieldStates(_ahrs->roll, _ahrs->pitch);
+        calcQuatAndFieldStates(_frame.roll, _frame.pitch);
         prevStaticMode = staticMode;
     }
 
@@ -2363,7 +2400,7 @@ void NavEKF::FuseAirspeed()
     float vd;
     float vwn;
     float vwe;
-    float EAS2TAS = _ahrs->get_EAS2TAS();
+    float EAS2TAS = _frame.EAS2TAS;
     const float R_TAS = sq(constrain_float(_easNoise, 0.5f, 5.0f) * constrain_float(EAS2TAS, 0.9f, 10.0f));
     Vector3f SH_TAS;
     float SK_TAS;
@@ -2859,9 +2896,9 @@ void NavEKF::getMagXYZ(Vector3f &magXYZ) const
 // return the last calculated latitude, longitude and height
 bool NavEKF::getLLH(struct Location &loc) const
 {
-    loc.lat = _ahrs->get_home().lat;
-    loc.lng = _ahrs->get_home().lng;
-    loc.alt = _ahrs->get_home().alt - state.position.z*100;
+    loc.lat = _frame.home.lat;
+    loc.lng = _frame.home.lng;
+    loc.alt = _frame.home.alt - state.position.z*100;
     loc.flags.relative_alt = 0;
     loc.flags.terrain_alt = 0;
     location_offset(loc, state.position.x, state.position.y);
@@ -2871,8 +2908,7 @@ bool NavEKF::getLLH(struct Location &loc) const
 // calculate whether the flight vehicle is on the ground or flying from height, airspeed and GPS speed
 void NavEKF::SetFlightAndFusionModes()
 {
-    const AP_Airspeed *airspeed = _ahrs->get_airspeed();
-    uint8_t highAirSpd = (airspeed && airspeed->use() && airspeed->get_airspeed() * airspeed->get_EAS2TAS() > 8.0f);
+    uint8_t highAirSpd = (_frame.tas_use && _frame.tas > 8.0f);
     float gndSpdSq = sq(velNED[0]) + sq(velNED[1]);
     uint8_t highGndSpdStage1 = (uint8_t)(gndSpdSq > 9.0f);
     uint8_t highGndSpdStage2 = (uint8_t)(gndSpdSq > 36.0f);
@@ -3024,62 +3060,106 @@ void NavEKF::ConstrainStates()
     for (uint8_t i=19; i<=21; i++) states[i] = constrain_float(states[i],-0.5f,0.5f);
 }
 
-// update IMU delta angle and delta velocity measurements
-void NavEKF::readIMUData()
+// copy the current sensor data into a frame
+void NavEKF::captureSensors(SensorFrame &frame) const
 {
-    Vector3f angRate;   // angular rate vector in XYZ body axes measured by the IMU (rad/s)
-    Vector3f accel1;    // acceleration vector in XYZ body axes measured by IMU1 (m/s^2)
-    Vector3f accel2;    // acceleration vector in XYZ body axes measured by IMU2 (m/s^2)
-
-    // the imu sample time is sued as a common time reference throughout the filter
-    imuSampleTime_ms = hal.scheduler->millis();
+    const AP_InertialSensor &ins = _ahrs->get_ins();
 
-    // limit IMU delta time to prevent numerical problems elsewhere
-    dtIMU = constrain_float(_ahrs->get_ins().get_delta_time(), 0.001f, 1.0f);
+    // the imu sample time is used as a common time reference throughout the filter
+    frame.imu_time_ms = hal.scheduler->millis();
+    frame.dtIMU = ins.get_delta_time();
 
     // get accels and gyro data from dual sensors if healthy
-    if (_ahrs->get_ins().get_accel_health(0) && _ahrs->get_ins().get_accel_health(1)) {
-        accel1 = _ahrs->get_ins().get_accel(0);
-        accel2 = _ahrs->get_ins().get_accel(1);
+    if (ins.get_accel_health(0) && ins.get_accel_health(1)) {
+        frame.accel1 = ins.get_accel(0);
+        frame.accel2 = ins.get_accel(1);
     } else {
-        accel1 = _ahrs->get_ins().get_accel();
-        accel2 = accel1;
+        frame.accel1 = ins.get_accel();
+        frame.accel2 = frame.accel1;
     }
 
     // average the available gyro sensors
-    angRate.zero();
+    frame.angRate.zero();
     uint8_t gyro_count = 0;
-    for (uint8_t i = 0; i<_ahrs->get_ins().get_gyro_count(); i++) {
-        if (_ahrs->get_ins().get_gyro_health(i)) {
-            angRate += _ahrs->get_ins().get_gyro(i);
+    for (uint8_t i = 0; i<ins.get_gyro_count(); i++) {
+        if (ins.get_gyro_health(i)) {
+            frame.angRate += ins.get_gyro(i);
             gyro_count++;
         }
     }
     if (gyro_count != 0) {
-        angRate /= gyro_count;
+        frame.angRate /= gyro_count;
+    }
+
+    frame.roll = _ahrs->roll;
+    frame.pitch = _ahrs->pitch;
+    frame.EAS2TAS = _ahrs->get_EAS2TAS();
+    frame.home = _ahrs->get_home();
+
+    const AP_GPS &gps = _ahrs->get_gps();
+    frame.gps_time_ms = gps.last_message_time_ms();
+    frame.gps_status = gps.status();
+    frame.gps_num_sats = gps.num_sats();
+    frame.gps_have_vz = gps.have_vertical_velocity();
+    frame.gps_vel = gps.velocity();
+    frame.gps_loc = gps.location();
+
+    frame.hgt_time = _baro.get_last_update();
+    frame.hgt = _baro.get_altitude();
+
+    const Compass *compass = _ahrs->get_compass();
+    if (compass != NULL) {
+        frame.mag_time = compass->last_update;
+        frame.mag_field = compass->get_field();
+        frame.mag_offsets = compass->get_offsets();
+    } else {
+        frame.mag_time = 0;
+        frame.mag_field.zero();
+        frame.mag_offsets.zero();
     }
 
+    const AP_Airspeed *aspeed = _ahrs->get_airspeed();
+    if (aspeed != NULL && aspeed->use()) {
+        frame.tas_use = true;
+        frame.tas_time_ms = aspeed->last_update_ms();
+        frame.tas = aspeed->get_airspeed() * aspeed->get_EAS2TAS();
+    } else {
+        frame.tas_use = false;
+        frame.tas_time_ms = 0;
+        frame.tas = 0;
+    }
+}
+
+// update IMU delta angle and delta velocity measurements
+void NavEKF::readIMUData()
+{
+    // the imu sample time is sued as a common time reference throughout the filter
+    imuSampleTime_ms = _frame.imu_time_ms;
+
+    // limit IMU delta time to prevent numerical problems elsewhere
+    dtIMU = constrain_float(_frame.dtIMU, 0.001f, 1.0f);
+
     // trapezoidal integration
-    dAngIMU     = (angRate + lastAngRate) * dtIMU * 0.5f;
-    lastAngRate = angRate;
-    dVelIMU1    = (accel1 + lastAccel1) * dtIMU * 0.5f;
-    lastAccel1  = accel1;
-    dVelIMU2    = (accel2 + lastAccel2) * dtIMU * 0.5f;
-    lastAccel2  = accel2;
+    dAngIMU     = (_frame.angRate + lastAngRate) * dtIMU * 0.5f;
+    lastAngRate = _frame.angRate;
+    dVelIMU1    = (_frame.accel1 + lastAccel1) * dtIMU * 0.5f;
+    lastAccel1  = _frame.accel1;
+    dVelIMU2    = (_frame.accel2 + lastAccel2) * dtIMU * 0.5f;
+    lastAccel2  = _frame.accel2;
 }
 
 // check for new valid GPS data and update stored measurement if available
 void NavEKF::readGpsData()
 {
     // check for new GPS data
-    if ((_ahrs->get_gps().last_message_time_ms() != lastFixTime_ms) &&
-            (_ahrs->get_gps().status() >= AP_GPS::GPS_OK_FIX_3D))
+    if ((_frame.gps_time_ms != lastFixTime_ms) &&
+            (_frame.gps_status >= AP_GPS::GPS_OK_FIX_3D))
     {
         // store fix time from previous read
         secondLastFixTime_ms = lastFixTime_ms;
 
         // get current fix time
-        lastFixTime_ms = _ahrs->get_gps().last_message_time_ms();
+        lastFixTime_ms = _frame.gps_time_ms;
 
         // set flag that lets other functions know that new GPS data has arrived
         newDataGps = true;
@@ -3090,19 +3170,19 @@ void NavEKF::readGpsData()
         RecallStates(statesAtPosTime, (imuSampleTime_ms - constrain_int16(_msecPosDelay, 0, 500)));
 
         // read the NED velocity from the GPS
-        velNED = _ahrs->get_gps().velocity();
+        velNED = _frame.gps_vel;
 
         // check if we have enough GPS satellites and increase the gps noise scaler if we don't
-        if (_ahrs->get_gps().num_sats() >= 6) {
+        if (_frame.gps_num_sats >= 6) {
             gpsNoiseScaler = 1.0f;
-        } else if (_ahrs->get_gps().num_sats() == 5) {
+        } else if (_frame.gps_num_sats == 5) {
             gpsNoiseScaler = 1.4f;
         } else { // <= 4 satellites
             gpsNoiseScaler = 2.0f;
         }
 
         // Check if GPS can output vertical velocity and set GPS fusion mode accordingly
-        if (!_ahrs->get_gps().have_vertical_velocity()) {
+        if (!_frame.gps_have_vz) {
             // vertical velocity should not be fused
             if (_fusionModeGPS == 0) {
                 _fusionModeGPS = 1;
@@ -3110,8 +3190,7 @@ void NavEKF::readGpsData()
         }
 
         // read latitutde and longitude from GPS and convert to NE position
-        const struct Location &gpsloc = _ahrs->get_gps().location();
-        gpsPosNE = location_diff(_ahrs->get_home(), gpsloc);
+        gpsPosNE = location_diff(_frame.home, _frame.gps_loc);
         // decay and limit the position offset which is applied to NE position wherever it is used throughout code to allow GPS position jumps to be accommodated gradually
         decayGpsOffset();
     }
@@ -3121,15 +3200,15 @@ void NavEKF::readGpsData()
 void NavEKF::readHgtData()
 {
     // check to see if baro measurement has changed so we know if a new measurement has arrived
-    if (_baro.get_last_update() != lastHgtMeasTime) {
+    if (_frame.hgt_time != lastHgtMeasTime) {
         // time stamp used to check for new measurement
-        lastHgtMeasTime = _baro.get_last_update();
+        lastHgtMeasTime = _frame.hgt_time;
 
         // time stamp used to check for timeout
         lastHgtTime_ms = imuSampleTime_ms;
 
         // get measurement and set flag to let other functions know new data has arrived
-        hgtMea = _baro.get_altitude();
+        hgtMea = _frame.hgt;
         newDataHgt = true;
 
         // get states that wer stored at the time closest to the measurement time, taking measurement delay into account
@@ -3142,15 +3221,15 @@ void NavEKF::readHgtData()
 // check for new magnetometer data and update store measurements if available
 void NavEKF::readMagData()
 {
-    if (use_compass() && _ahrs->get_compass()->last_update != lastMagUpdate) {
+    if (use_compass() && _frame.mag_time != lastMagUpdate) {
         // store time of last measurement update
-        lastMagUpdate = _ahrs->get_compass()->last_update;
+        lastMagUpdate = _frame.mag_time;
 
         // read compass data and assign to bias and uncorrected measurement
         // body fixed magnetic bias is opposite sign to APM compass offsets
         // we scale compass data to improve numerical conditioning
-        magBias = -_ahrs->get_compass()->get_offsets() * 0.001f;
-        magData = _ahrs->get_compass()->get_field() * 0.001f + magBias;
+        magBias = -_frame.mag_offsets * 0.001f;
+        magData = _frame.mag_field * 0.001f + magBias;
 
         // get states stored at time closest to measurement time after allowance for measurement delay
         RecallStates(statesAtMagMeasTime, (imuSampleTime_ms - _msecMagDelay));
@@ -3168,12 +3247,10 @@ void NavEKF::readAirSpdData()
     // if airspeed reading is valid and is set by the user to be used and has been updated then
     // we take a new reading, convert from EAS to TAS and set the flag letting other functions
     // know a new measurement is available
-    const AP_Airspeed *aspeed = _ahrs->get_airspeed();
-    if (aspeed &&
-        aspeed->use() &&
-        aspeed->last_update_ms() != lastAirspeedUpdate) {
-        VtasMeas = aspeed->get_airspeed() * aspeed->get_EAS2TAS();
-        lastAirspeedUpdate = aspeed->last_update_ms();
+    if (_frame.tas_use &&
+        _frame.tas_time_ms != lastAirspeedUpdate) {
+        VtasMeas = _frame.tas;
+        lastAirspeedUpdate = _frame.tas_time_ms;
         newDataTas = true;
         RecallStates(statesAtVtasMeasTime, (imuSampleTime_ms - _msecTasDelay));
     } else {
@@ -3317,6 +3394,152 @@ void NavEKF::getRotationBodyToNED(Matrix3f &mat) const
     mat.rotateXYinv(trim);
 }
 
+// return the filter solution for correcting the output predictor
+void NavEKF::getFilterState(FilterState &fs) const
+{
+    fs.imu_time_ms = imuSampleTime_ms;
+    fs.quat = state.quat;
+    fs.velocity = state.velocity;
+    fs.position = state.position;
+    getGyroBias(fs.gyro_bias);
+    getAccelZBias(fs.accel_zbias1, fs.accel_zbias2);
+    fs.IMU1_weighting = IMU1_weighting;
+}
+
+// rotate a body to NED quaternion through a body frame delta angle
+static void rotateQuat(Quaternion &quat, const Vector3f &delAng)
+{
+    float rotationMag = delAng.length();
+    if (rotationMag < 1e-12f) {
+        return;
+    }
+    Quaternion deltaQuat;
+    float rotScaler = sinf(0.5f * rotationMag) / rotationMag;
+    deltaQuat[0] = cosf(0.5f * rotationMag);
+    deltaQuat[1] = delAng.x * rotScaler;
+    deltaQuat[2] = delAng.y * rotScaler;
+    deltaQuat[3] = delAng.z * rotScaler;
+    quat *= deltaQuat;
+    quat.normalize();
+}
+
+// propagate the output solution forward using an IMU frame
+void NavEKF::predictOutput(const SensorFrame &frame)
+{
+    if (!outputInitialised) {
+        return;
+    }
+    const Vector3f gravityNED(0, 0, GRAVITY_MSS); // NED gravity vector m/s^2
+    const output_elements &prev = outputStates[outputIndex];
+    float dtOut = constrain_float(frame.dtIMU, 0.001f, 1.0f);
+
+    // remove sensor bias errors using the latest filter estimates
+    Vector3f delAng = (frame.angRate - outputBias.gyro_bias) * dtOut;
+    Vector3f accel1 = frame.accel1;
+    Vector3f accel2 = frame.accel2;
+    accel1.z -= outputBias.accel_zbias1;
+    accel2.z -= outputBias.accel_zbias2;
+    Vector3f accel = accel1 * outputBias.IMU1_weighting + accel2 * (1.0f - outputBias.IMU1_weighting);
+
+    output_elements next;
+    next.imu_time_ms = frame.imu_time_ms;
+    next.quat = prev.quat;
+    rotateQuat(next.quat, delAng);
+
+    Matrix3f Tbn;
+    next.quat.rotation_matrix(Tbn);
+    next.velocity = prev.velocity + (Tbn*accel + gravityNED) * dtOut;
+    next.position = prev.position + (next.velocity + prev.velocity) * (dtOut*0.5f);
+
+    outputIndex = (outputIndex + 1) % NAVEKF_OUTPUT_BUFFER_LEN;
+    outputStates[outputIndex] = next;
+}
+
+/*
+  correct the output solution towards a filter solution. The filter
+  solution is compared with the output solution stored for the same
+  IMU frame, and a fraction of the difference set by the time constant
+  is added to that and all later output solutions
+ */
+void NavEKF::correctOutput(const FilterState &fs)
+{
+    if (outputInitialised && fs.imu_time_ms == outputCorrectTime_ms) {
+        // already corrected towards this solution
+        return;
+    }
+    float dtCorrect = (fs.imu_time_ms - outputCorrectTime_ms) * 0.001f;
+    outputCorrectTime_ms = fs.imu_time_ms;
+    outputBias = fs;
+
+    // find the output solution for the time of the filter solution
+    uint8_t index = outputIndex;
+    uint8_t count = 0;
+    while (outputStates[index].imu_time_ms != fs.imu_time_ms && count < NAVEKF_OUTPUT_BUFFER_LEN) {
+        index = (index + NAVEKF_OUTPUT_BUFFER_LEN - 1) % NAVEKF_OUTPUT_BUFFER_LEN;
+        count++;
+    }
+    const output_elements &delayed = outputStates[index];
+
+    if (!outputInitialised || count == NAVEKF_OUTPUT_BUFFER_LEN ||
+        delayed.quat.is_nan() || delayed.velocity.is_nan() || delayed.position.is_nan()) {
+        // start again from the filter solution
+        for (uint8_t i=0; i<NAVEKF_OUTPUT_BUFFER_LEN; i++) {
+            outputStates[i].imu_time_ms = fs.imu_time_ms;
+            outputStates[i].quat = fs.quat;
+            outputStates[i].velocity = fs.velocity;
+            outputStates[i].position = fs.position;
+        }
+        outputInitialised = true;
+        return;
+    }
+
+    float tau = _tauOutput * 0.01f;
+    float gain = (tau > dtCorrect) ? dtCorrect / tau : 1.0f;
+
+    // attitude error as a body frame rotation vector
+    Quaternion quatErr = delayed.quat.inverse() * fs.quat;
+    Vector3f delAngCorrection(quatErr[1], quatErr[2], quatErr[3]);
+    delAngCorrection *= (quatErr[0] >= 0 ? 2.0f : -2.0f) * gain;
+    Vector3f velCorrection = (fs.velocity - delayed.velocity) * gain;
+    Vector3f posCorrection = (fs.position - delayed.position) * gain;
+
+    for (uint8_t i=index; ; i=(i+1) % NAVEKF_OUTPUT_BUFFER_LEN) {
+        rotateQuat(outputStates[i].quat, delAngCorrection);
+        outputStates[i].velocity += velCorrection;
+        outputStates[i].position += posCorrection;
+        if (i == outputIndex) {
+            break;
+        }
+    }
+}
+
+// return the transformation matrix from XYZ (body) to NED axes of the output solution
+void NavEKF::getOutputRotationBodyToNED(Matrix3f &mat) const
+{
+    Vector3f trim = _ahrs->get_trim();
+    outputStates[outputIndex].quat.rotation_matrix(mat);
+    mat.rotateXYinv(trim);
+}
+
+// return the Euler roll, pitch and yaw angle in radians of the output solution
+void NavEKF::getOutputEulerAngles(Vector3f &euler) const
+{
+    outputStates[outputIndex].quat.to_euler(euler.x, euler.y, euler.z);
+    euler = euler - _ahrs->get_trim();
+}
+
+// return NED velocity of the output solution in m/s
+void NavEKF::getOutputVelNED(Vector3f &vel) const
+{
+    vel = outputStates[outputIndex].velocity;
+}
+
+// return NED position of the output solution relative to the reference point (m)
+void NavEKF::getOutputPosNED(Vector3f &pos) const
+{
+    pos = outputStates[outputIndex].position;
+}
+
 // return the innovations for the NED Pos, NED Vel, XYZ Mag and Vtas measurements
 void  NavEKF::getInnovations(Vector3f &velInnov, Vector3f &posInnov, Vector3f &magInnov, float &tasInnov) const
 {
@@ -3351,7 +3574,7 @@ void  NavEKF::getVariances(float &velVar, float &posVar, float &hgtVar, Vector3f
 void NavEKF::ZeroVariables()
 {
     // initialise time stamps
-    imuSampleTime_ms = hal.scheduler->millis();
+    imuSampleTime_ms = _frame.imu_time_ms;
     lastHealthyMagTime_ms = imuSampleTime_ms;
     TASmsecPrev = imuSampleTime_ms;
     BETAmsecPrev = imuSampleTime_ms;
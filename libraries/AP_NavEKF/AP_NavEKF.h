@@ -75,6 +75,39 @@ public:
     // Constructor
     NavEKF(const AP_AHRS *ahrs, AP_Baro &baro);
 
+    // the sensor data used by one filter update. The filter only reads
+    // its sensors through a frame, so a frame can be captured on the
+    // main thread and the filter run later on another thread
+    struct SensorFrame {
+        uint32_t imu_time_ms;       // time the IMU sample was taken (msec)
+        float dtIMU;                // IMU delta time (sec)
+        Vector3f angRate;           // average of the healthy gyros (rad/s)
+        Vector3f accel1;            // IMU1 acceleration, or the primary accel if either is unhealthy (m/s^2)
+        Vector3f accel2;            // IMU2 acceleration (m/s^2)
+        float roll;                 // DCM roll angle (rad)
+        float pitch;                // DCM pitch angle (rad)
+        float EAS2TAS;              // equivalent to true airspeed ratio
+        struct Location home;       // origin of the NED frame
+        uint32_t gps_time_ms;       // time of the last GPS message (msec)
+        uint8_t gps_status;         // AP_GPS::GPS_Status
+        uint8_t gps_num_sats;       // number of satellites used
+        bool gps_have_vz;           // true if the GPS reports vertical velocity
+        Vector3f gps_vel;           // GPS NED velocity (m/s)
+        struct Location gps_loc;    // GPS position
+        uint32_t hgt_time;          // time of the last barometer update
+        float hgt;                  // barometric altitude (m)
+        uint32_t mag_time;          // time of the last compass update
+        Vector3f mag_field;         // compass field with offsets applied
+        Vector3f mag_offsets;       // compass offsets
+        bool tas_use;               // true if the airspeed sensor is enabled for use
+        uint32_t tas_time_ms;       // time of the last airspeed update (msec)
+        float tas;                  // true airspeed (m/s)
+    };
+
+    // copy the current sensor data into a frame. This must be called
+    // on the thread that updates the sensors
+    void captureSensors(SensorFrame &frame) const;
+
     // This function is used to initialise the filter whilst moving, using the AHRS DCM solution
     // It should NOT be used to re-initialise after a timeout as DCM will also be corrupted
     void InitialiseFilterDynamic(void);
@@ -82,10 +115,56 @@ public:
     // Initialise the states from accelerometer and magnetometer data (if present)
     // This method can only be used when the vehicle is static
     void InitialiseFilterBootstrap(void);
+    void InitialiseFilterBootstrap(const SensorFrame &frame);
 
     // Update Filter States - this should be called whenever new IMU data is available
     void UpdateFilter(void);
 
+    // Update Filter States from a previously captured sensor frame
+    void UpdateFilter(const SensorFrame &frame);
+
+    // the filter solution at the time of the last frame it processed,
+    // used to correct the output predictor
+    struct FilterState {
+        uint32_t imu_time_ms;       // time of the frame the solution is for (msec)
+        Quaternion quat;            // body to NED rotation
+        Vector3f velocity;          // NED velocity (m/s)
+        Vector3f position;          // NED position relative to home (m)
+        Vector3f gyro_bias;         // gyro bias (rad/s)
+        float accel_zbias1;         // IMU1 Z accel bias (m/s^2)
+        float accel_zbias2;         // IMU2 Z accel bias (m/s^2)
+        float IMU1_weighting;       // weighting of IMU1 in the accel blend
+    };
+
+    // return the filter solution for correcting the output predictor
+    void getFilterState(FilterState &fs) const;
+
+    /*
+      output predictor. The filter solution lags the newest IMU data
+      by however long the filter takes to process it, and moves in
+      steps when measurements are fused. The output predictor
+      integrates every IMU frame as it is captured to give a solution
+      at the newest IMU time, and pulls it towards the filter solution
+      with a time constant of TAU_OUTPUT. These functions only use the
+      output predictor state, so they can be called from the thread
+      capturing the sensors while the filter runs on another
+     */
+
+    // propagate the output solution forward using an IMU frame
+    void predictOutput(const SensorFrame &frame);
+
+    // correct the output solution towards a filter solution
+    void correctOutput(const FilterState &fs);
+
+    // restart the output predictor from the next filter solution
+    void resetOutput(void) { outputInitialised = false; }
+
+    // return the output solution attitude, velocity and position
+    void getOutputRotationBodyToNED(Matrix3f &mat) const;
+    void getOutputEulerAngles(Vector3f &eulers) const;
+    void getOutputVelNED(Vector3f &vel) const;
+    void getOutputPosNED(Vector3f &pos) const;
+
     // Check basic filter health metrics and return a consolidated health status
     bool healthy(void) const;
 
@@ -165,6 +244,9 @@ private:
     const AP_AHRS *_ahrs;
     AP_Baro &_baro;
 
+    // sensor data for the current update
+    SensorFrame _frame;
+
     // the states are available in two forms, either as a Vector27, or
     // broken down as individual elements. Both are equivalent (same
     // memory)
@@ -332,6 +414,7 @@ private:
     AP_Int8  _magCal;               // Sets activation condition for in-flight magnetometer calibration
     AP_Int16 _gpsGlitchAccelMax;    // Maximum allowed discrepancy between inertial and GPS Horizontal acceleration before GPS data is ignored : cm/s^2
     AP_Int8 _gpsGlitchRadiusMax;    // Maximum allowed discrepancy between inertial and GPS Horizontal position before GPS glitch is declared : m
+    AP_Int8 _tauOutput;             // Time constant of the output predictor correction : csec
 
     // Tuning parameters
     AP_Float _gpsNEVelVarAccScale;  // scale factor applied to NE velocity measurement variance due to Vdot
@@ -484,6 +567,19 @@ private:
     uint8_t magUpdateCountMax;      // limit on the number of minor state corrections using Magnetometer data
     float magUpdateCountMaxInv;     // floating point inverse of magFilterCountMax
 
+    // output predictor states, one per IMU frame captured
+    #define NAVEKF_OUTPUT_BUFFER_LEN 32
+    struct output_elements {
+        uint32_t imu_time_ms;       // time of the frame (msec)
+        Quaternion quat;            // body to NED rotation
+        Vector3f velocity;          // NED velocity (m/s)
+        Vector3f position;          // NED position relative to home (m)
+    } outputStates[NAVEKF_OUTPUT_BUFFER_LEN];
+    uint8_t outputIndex;            // index of the newest output state
+    uint32_t outputCorrectTime_ms;  // time of the last filter solution corrected towards
+    bool outputInitialised;         // true once the output predictor has been set from the filter
+    FilterState outputBias;         // bias estimates used by the output predictor
+
     struct {
         bool bad_xmag:1;
         bool bad_ymag:1;
@@ -0,0 +1,425 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+#include <stdlib.h>
+#include "AP_PolyFence.h"
+
+// scaling factor from 1e-7 degrees to meters at equator
+#define POLYFENCE_LATLON_TO_M 0.011131884502145034f
+
+AP_PolyFence::AP_PolyFence() :
+    _num_polygons(0),
+    _num_edges(0),
+    _cell_size_x(1),
+    _cell_size_y(1),
+    _cols(0),
+    _rows(0),
+    _lon_scale(1.0f),
+    _cell_start(NULL),
+    _cell_edges(NULL),
+    _row_start(NULL),
+    _row_edges(NULL)
+{
+}
+
+/*
+  remove all polygons and free the edge index
+ */
+void AP_PolyFence::clear()
+{
+    free_index();
+    _num_polygons = 0;
+    _num_edges = 0;
+}
+
+void AP_PolyFence::free_index()
+{
+    free(_cell_start);
+    free(_cell_edges);
+    free(_row_start);
+    free(_row_edges);
+    _cell_start = NULL;
+    _cell_edges = NULL;
+    _row_start = NULL;
+    _row_edges = NULL;
+    _rows = 0;
+    _cols = 0;
+}
+
+/*
+  add a closed polygon to the fence. The index is invalidated until
+  build_index() is called again
+ */
+bool AP_PolyFence::add_polygon(const Vector2l *points, uint16_t num_points, bool inclusion)
+{
+    if (_num_polygons >= AP_POLYFENCE_MAX_POLYGONS || points == NULL) {
+        return false;
+    }
+    if (!Polygon_complete(points, num_points)) {
+        return false;
+    }
+    if ((uint32_t)_num_edges + num_points - 1 > 0xFFFF) {
+        return false;
+    }
+    free_index();
+
+    // grow the bounding box of all points
+    if (_num_polygons == 0) {
+        _min = points[0];
+        _max = points[0];
+    }
+    for (uint16_t i=0; i<num_points; i++) {
+        _min.x = min(_min.x, points[i].x);
+        _min.y = min(_min.y, points[i].y);
+        _max.x = max(_max.x, points[i].x);
+        _max.y = max(_max.y, points[i].y);
+    }
+
+    // scale longitude at the centre of the fence for distance calculations
+    int32_t centre_lat = _min.x + (int32_t)(((int64_t)_max.x - _min.x) / 2);
+    _lon_scale = constrain_float(cosf(centre_lat * 1.0e-7f * DEG_TO_RAD), 0.01f, 1.0f);
+
+    Polygon &poly = _polygons[_num_polygons++];
+    poly.points = points;
+    poly.num_points = num_points;
+    poly.first_edge = _num_edges;
+    poly.inclusion = inclusion;
+    _num_edges += num_points - 1;
+    return true;
+}
+
+/*
+  return the polygon that an edge belongs to
+ */
+uint8_t AP_PolyFence::edge_polygon(uint16_t edge) const
+{
+    uint8_t i = _num_polygons - 1;
+    while (i > 0 && edge < _polygons[i].first_edge) {
+        i--;
+    }
+    return i;
+}
+
+/*
+  return the two points of an edge. Edge i of a polygon runs from
+  point i to point i+1
+ */
+void AP_PolyFence::get_edge(uint16_t edge, const Vector2l *&v1, const Vector2l *&v2) const
+{
+    const Polygon &poly = _polygons[edge_polygon(edge)];
+    v1 = &poly.points[edge - poly.first_edge];
+    v2 = v1 + 1;
+}
+
+uint8_t AP_PolyFence::cell_col(int32_t x) const
+{
+    if (x <= _min.x) {
+        return 0;
+    }
+    int64_t col = ((int64_t)x - _min.x) / _cell_size_x;
+    return col >= _cols ? _cols - 1 : (uint8_t)col;
+}
+
+uint8_t AP_PolyFence::cell_row(int32_t y) const
+{
+    if (y <= _min.y) {
+        return 0;
+    }
+    int64_t row = ((int64_t)y - _min.y) / _cell_size_y;
+    return row >= _rows ? _rows - 1 : (uint8_t)row;
+}
+
+/*
+  build the grid index over all polygon edges.
+
+  Each edge is listed in every cell its bounding box overlaps, which is
+  used for nearest edge queries. Each non-horizontal edge is also listed
+  in every grid row its y range spans, which is all that is needed for
+  the ray crossing test as a ray along x can only cross edges which
+  straddle the point's y.
+ */
+bool AP_PolyFence::build_index()
+{
+    free_index();
+
+    if (_num_edges == 0) {
+        return false;
+    }
+
+    // aim for roughly one edge per cell
+    uint16_t grid_size = (uint16_t)ceilf(safe_sqrt(_num_edges));
+    grid_size = constrain_int16(grid_size, 1, AP_POLYFENCE_GRID_MAX);
+    _cols = grid_size;
+    _rows = grid_size;
+    _cell_size_x = (int32_t)(((int64_t)_max.x - _min.x) / _cols + 1);
+    _cell_size_y = (int32_t)(((int64_t)_max.y - _min.y) / _rows + 1);
+
+    // count the entries needed so we can bail out before allocating
+    uint32_t cell_total = 0;
+    uint32_t row_total = 0;
+    for (uint16_t e=0; e<_num_edges; e++) {
+        const Vector2l *v1, *v2;
+        get_edge(e, v1, v2);
+        uint8_t c1 = cell_col(min(v1->x, v2->x)), c2 = cell_col(max(v1->x, v2->x));
+        uint8_t r1 = cell_row(min(v1->y, v2->y)), r2 = cell_row(max(v1->y, v2->y));
+        cell_total += (uint32_t)(c2 - c1 + 1) * (r2 - r1 + 1);
+        if (v1->y != v2->y) {
+            row_total += r2 - r1 + 1;
+        }
+    }
+    if (cell_total > 0xFFFF || row_total > 0xFFFF) {
+        _rows = _cols = 0;
+        return false;
+    }
+
+    uint16_t num_cells = (uint16_t)_rows * _cols;
+    _cell_start = (uint16_t *)calloc(num_cells+1, sizeof(uint16_t));
+    _cell_edges = (uint16_t *)calloc(max(cell_total, 1U), sizeof(uint16_t));
+    _row_start  = (uint16_t *)calloc(_rows+1, sizeof(uint16_t));
+    _row_edges  = (uint16_t *)calloc(max(row_total, 1U), sizeof(uint16_t));
+    if (_cell_start == NULL || _cell_edges == NULL || _row_start == NULL || _row_edges == NULL) {
+        free_index();
+        return false;
+    }
+
+    // count entries per cell and row
+    for (uint16_t e=0; e<_num_edges; e++) {
+        const Vector2l *v1, *v2;
+        get_edge(e, v1, v2);
+        uint8_t c1 = cell_col(min(v1->x, v2->x)), c2 = cell_col(max(v1->x, v2->x));
+        uint8_t r1 = cell_row(min(v1->y, v2->y)), r2 = cell_row(max(v1->y, v2->y));
+        for (uint8_t r=r1; r<=r2; r++) {
+            for (uint8_t c=c1; c<=c2; c++) {
+                _cell_start[r*_cols+c]++;
+            }
+            if (v1->y != v2->y) {
+                _row_start[r]++;
+            }
+        }
+    }
+
+    // convert counts to the end offset of each list
+    for (uint16_t i=1; i<=num_cells; i++) {
+        _cell_start[i] += _cell_start[i-1];
+    }
+    for (uint8_t i=1; i<=_rows; i++) {
+        _row_start[i] += _row_start[i-1];
+    }
+
+    // fill lists from the back, leaving each offset at the start of its list
+    for (uint16_t e=0; e<_num_edges; e++) {
+        const Vector2l *v1, *v2;
+        get_edge(e, v1, v2);
+        uint8_t c1 = cell_col(min(v1->x, v2->x)), c2 = cell_col(max(v1->x, v2->x));
+        uint8_t r1 = cell_row(min(v1->y, v2->y)), r2 = cell_row(max(v1->y, v2->y));
+        for (uint8_t r=r1; r<=r2; r++) {
+            for (uint8_t c=c1; c<=c2; c++) {
+                _cell_edges[--_cell_start[r*_cols+c]] = e;
+            }
+            if (v1->y != v2->y) {
+                _row_edges[--_row_start[r]] = e;
+            }
+        }
+    }
+
+    return true;
+}
+
+/*
+  test whether a ray from point in the +x direction crosses the edge
+  v1->v2. This is the per-edge step of Polygon_outside(), so
+  parity of the crossings gives the same answer
+ */
+bool AP_PolyFence::edge_crosses(const Vector2l &point, const Vector2l &v1, const Vector2l &v2)
+{
+    if ((v1.y > point.y) == (v2.y > point.y)) {
+        return false;
+    }
+    int64_t dx1 = (int64_t)point.x - v1.x;
+    int64_t dx2 = (int64_t)v2.x - v1.x;
+    int64_t dy1 = (int64_t)point.y - v1.y;
+    int64_t dy2 = (int64_t)v2.y - v1.y;
+    if (dy2 < 0) {
+        return dx1 * dy2 > dx2 * dy1;
+    }
+    return dx1 * dy2 < dx2 * dy1;
+}
+
+/*
+  return a bitmask of the polygons containing point
+ */
+uint8_t AP_PolyFence::crossing_mask(const Vector2l &point) const
+{
+    uint8_t mask = 0;
+    const Vector2l *v1, *v2;
+
+    if (!index_valid()) {
+        // no index, check every edge
+        for (uint16_t e=0; e<_num_edges; e++) {
+            get_edge(e, v1, v2);
+            if (edge_crosses(point, *v1, *v2)) {
+                mask ^= (1U<<edge_polygon(e));
+            }
+        }
+        return mask;
+    }
+
+    // outside the bounding box no edge can straddle the point
+    if (point.y < _min.y || point.y > _max.y) {
+        return 0;
+    }
+
+    uint8_t row = cell_row(point.y);
+    for (uint16_t i=_row_start[row]; i<_row_start[row+1]; i++) {
+        uint16_t e = _row_edges[i];
+        get_edge(e, v1, v2);
+        if (edge_crosses(point, *v1, *v2)) {
+            mask ^= (1U<<edge_polygon(e));
+        }
+    }
+    return mask;
+}
+
+/*
+  return true if point is outside the given polygon
+ */
+bool AP_PolyFence::outside_polygon(uint8_t polygon_idx, const Vector2l &point) const
+{
+    if (polygon_idx >= _num_polygons) {
+        return true;
+    }
+    return (crossing_mask(point) & (1U<<polygon_idx)) == 0;
+}
+
+/*
+  return true if point is outside the allowed area of the fence
+ */
+bool AP_PolyFence::breached(const Vector2l &point) const
+{
+    if (_num_polygons == 0) {
+        return false;
+    }
+
+    uint8_t inside = crossing_mask(point);
+    uint8_t inclusion = 0;
+    for (uint8_t i=0; i<_num_polygons; i++) {
+        if (_polygons[i].inclusion) {
+            inclusion |= (1U<<i);
+        }
+    }
+
+    // inside an exclusion zone
+    if ((inside & ~inclusion) != 0) {
+        return true;
+    }
+    // outside all inclusion zones
+    return inclusion != 0 && (inside & inclusion) == 0;
+}
+
+/*
+  squared distance in meters from point to an edge
+ */
+float AP_PolyFence::edge_distance_sq(const Vector2l &point, uint16_t edge) const
+{
+    const Vector2l *v1, *v2;
+    get_edge(edge, v1, v2);
+
+    // work in meters relative to point
+    float ax = ((int64_t)v1->x - point.x) * POLYFENCE_LATLON_TO_M;
+    float ay = ((int64_t)v1->y - point.y) * POLYFENCE_LATLON_TO_M * _lon_scale;
+    float dx = ((int64_t)v2->x - v1->x) * POLYFENCE_LATLON_TO_M;
+    float dy = ((int64_t)v2->y - v1->y) * POLYFENCE_LATLON_TO_M * _lon_scale;
+
+    float len_sq = dx*dx + dy*dy;
+    float t = 0;
+    if (len_sq > 0) {
+        t = constrain_float(-(ax*dx + ay*dy) / len_sq, 0.0f, 1.0f);
+    }
+    float cx = ax + t*dx;
+    float cy = ay + t*dy;
+    return cx*cx + cy*cy;
+}
+
+/*
+  return distance in meters to the closest fence edge
+
+  The search starts in the cell holding the point and moves outwards
+  one ring of cells at a time, stopping once the closest edge found is
+  nearer than anything outside the rings already searched
+ */
+float AP_PolyFence::nearest_edge_distance(const Vector2l &point) const
+{
+    if (_num_edges == 0) {
+        return -1.0f;
+    }
+
+    float best_sq = -1.0f;
+
+    if (!index_valid()) {
+        for (uint16_t e=0; e<_num_edges; e++) {
+            float d_sq = edge_distance_sq(point, e);
+            if (best_sq < 0 || d_sq < best_sq) {
+                best_sq = d_sq;
+            }
+        }
+        return sqrtf(best_sq);
+    }
+
+    int16_t col0 = cell_col(point.x);
+    int16_t row0 = cell_row(point.y);
+    int16_t max_ring = max(max(col0, _cols - 1 - col0), max(row0, _rows - 1 - row0));
+
+    for (int16_t ring=0; ring<=max_ring; ring++) {
+        for (int16_t r=row0-ring; r<=row0+ring; r++) {
+            if (r < 0 || r >= _rows) {
+                continue;
+            }
+            // only the cells on the edge of the ring are new
+            int16_t step = (r == row0-ring || r == row0+ring) ? 1 : 2*ring;
+            for (int16_t c=col0-ring; c<=col0+ring; c+=step) {
+                if (c < 0 || c >= _cols) {
+                    continue;
+                }
+                uint16_t cell = r*_cols + c;
+                for (uint16_t i=_cell_start[cell]; i<_cell_start[cell+1]; i++) {
+                    float d_sq = edge_distance_sq(point, _cell_edges[i]);
+                    if (best_sq < 0 || d_sq < best_sq) {
+                        best_sq = d_sq;
+                    }
+                }
+            }
+        }
+
+        if (best_sq < 0) {
+            continue;
+        }
+
+        // distance from point to the nearest cell outside the searched
+        // rings. Sides with no more cells do not limit the search
+        float bound = -1.0f;
+        if (col0-ring > 0) {
+            int64_t edge_x = (int64_t)_min.x + (int64_t)(col0-ring) * _cell_size_x;
+            float d = max((int64_t)point.x - edge_x, 0) * POLYFENCE_LATLON_TO_M;
+            bound = (bound < 0) ? d : min(bound, d);
+        }
+        if (col0+ring < _cols-1) {
+            int64_t edge_x = (int64_t)_min.x + (int64_t)(col0+ring+1) * _cell_size_x;
+            float d = max(edge_x - point.x, 0) * POLYFENCE_LATLON_TO_M;
+            bound = (bound < 0) ? d : min(bound, d);
+        }
+        if (row0-ring > 0) {
+            int64_t edge_y = (int64_t)_min.y + (int64_t)(row0-ring) * _cell_size_y;
+            float d = max((int64_t)point.y - edge_y, 0) * POLYFENCE_LATLON_TO_M * _lon_scale;
+            bound = (bound < 0) ? d : min(bound, d);
+        }
+        if (row0+ring < _rows-1) {
+            int64_t edge_y = (int64_t)_min.y + (int64_t)(row0+ring+1) * _cell_size_y;
+            float d = max(edge_y - point.y, 0) * POLYFENCE_LATLON_TO_M * _lon_scale;
+            bound = (bound < 0) ? d : min(bound, d);
+        }
+        if (bound < 0 || best_sq <= bound*bound) {
+            break;
+        }
+    }
+
+    return sqrtf(best_sq);
+}
@@ -0,0 +1,121 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/// @file    AP_PolyFence.h
+/// @brief   Spatially indexed polygon geofence used by plane
+
+/*
+ * The AP_PolyFence library:
+ *
+ * - holds a set of closed inclusion and exclusion polygons
+ * - builds a grid index over the polygon edges whenever the fence changes
+ * - answers point containment and nearest edge distance queries by
+ *   only looking at the edges in the grid row or cells near the point
+ *
+ * The polygon points are not copied, the caller must keep them
+ * allocated for as long as they are used by the fence.
+ */
+#ifndef AP_POLYFENCE_H
+#define AP_POLYFENCE_H
+
+#include <AP_Common.h>
+#include <AP_Math.h>
+
+// maximum number of polygons that can make up a fence
+#define AP_POLYFENCE_MAX_POLYGONS       8
+
+// maximum number of grid rows and columns used by the edge index
+#if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
+ # define AP_POLYFENCE_GRID_MAX         64
+#else
+ # define AP_POLYFENCE_GRID_MAX         8
+#endif
+
+/// @class    AP_PolyFence
+/// @brief    Multi-polygon fence with a precomputed edge index
+class AP_PolyFence {
+
+public:
+    AP_PolyFence();
+
+    /// clear - remove all polygons and free the edge index
+    void clear();
+
+    /// add_polygon - add a closed polygon (last point equal to the first) to the fence
+    ///     inclusion polygons define the allowed area, exclusion polygons are holes in it
+    ///     returns false if the polygon is not complete or there is no room for it
+    bool add_polygon(const Vector2l *points, uint16_t num_points, bool inclusion);
+
+    /// num_polygons - returns the number of polygons in the fence
+    uint8_t num_polygons() const { return _num_polygons; }
+
+    /// build_index - (re)build the edge index, must be called after the polygons change
+    ///     returns false if memory for the index could not be allocated, in which case
+    ///     queries fall back to checking every edge
+    bool build_index();
+
+    /// index_valid - returns true if the edge index is up to date
+    bool index_valid() const { return _cell_start != NULL; }
+
+    /// outside_polygon - returns true if point is outside the given polygon
+    bool outside_polygon(uint8_t polygon_idx, const Vector2l &point) const;
+
+    /// breached - returns true if the point is outside all inclusion polygons or inside an exclusion polygon
+    ///     a fence with no inclusion polygons allows everything outside the exclusion polygons
+    bool breached(const Vector2l &point) const;
+
+    /// nearest_edge_distance - returns distance in meters from point to the closest fence edge
+    ///     returns -1 if the fence is empty
+    float nearest_edge_distance(const Vector2l &point) const;
+
+private:
+
+    struct Polygon {
+        const Vector2l *points;
+        uint16_t num_points;
+        uint16_t first_edge;    // global index of the polygon's first edge
+        bool inclusion;
+    };
+
+    // edge_crosses - returns true if a ray from point in the +x direction crosses the edge
+    static bool edge_crosses(const Vector2l &point, const Vector2l &v1, const Vector2l &v2);
+
+    // edge_polygon - returns the polygon index holding a global edge index
+    uint8_t edge_polygon(uint16_t edge) const;
+
+    // get_edge - look up the two end points of a global edge index
+    void get_edge(uint16_t edge, const Vector2l *&v1, const Vector2l *&v2) const;
+
+    // crossing_mask - bitmask of polygons the point is inside, from the parity of edge crossings
+    uint8_t crossing_mask(const Vector2l &point) const;
+
+    // edge_distance_sq - squared distance in meters from point to an edge
+    float edge_distance_sq(const Vector2l &point, uint16_t edge) const;
+
+    // grid helpers
+    uint8_t cell_col(int32_t x) const;
+    uint8_t cell_row(int32_t y) const;
+    void free_index();
+
+    Polygon     _polygons[AP_POLYFENCE_MAX_POLYGONS];
+    uint8_t     _num_polygons;
+    uint16_t    _num_edges;
+
+    // bounding box of all polygons and the grid laid over it
+    Vector2l    _min;
+    Vector2l    _max;
+    int32_t     _cell_size_x;
+    int32_t     _cell_size_y;
+    uint8_t     _cols;
+    uint8_t     _rows;
+    float       _lon_scale;     // longitude scaling at the centre of the fence
+
+    // edges overlapping each grid cell, indexed by row*_cols+col
+    uint16_t    *_cell_start;   // _rows*_cols+1 offsets into _cell_edges
+    uint16_t    *_cell_edges;
+
+    // edges spanning each grid row, used for the crossing test
+    uint16_t    *_row_start;    // _rows+1 offsets into _row_edges
+    uint16_t    *_row_edges;
+};
+
+#endif // AP_POLYFENCE_H
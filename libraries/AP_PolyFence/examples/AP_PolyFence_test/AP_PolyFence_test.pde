@@ -0,0 +1,164 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Unit tests for the AP_PolyFence library
+//
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_Math.h>
+#include <AP_PolyFence.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_Linux.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+/*
+ *  this is the boundary of the 2010 outback challenge
+ */
+static const Vector2l OBC_boundary[] = {
+    Vector2l(-265695640, 1518373730),
+    Vector2l(-265699560, 1518394050),
+    Vector2l(-265768230, 1518411420),
+    Vector2l(-265773080, 1518403440),
+    Vector2l(-265815110, 1518419500),
+    Vector2l(-265784860, 1518474690),
+    Vector2l(-265994890, 1518528860),
+    Vector2l(-266092110, 1518747420),
+    Vector2l(-266454780, 1518820530),
+    Vector2l(-266435720, 1518303500),
+    Vector2l(-265875990, 1518344050),
+    Vector2l(-265695640, 1518373730)
+};
+
+/*
+ *  a no-fly zone inside the OBC boundary
+ */
+static const Vector2l exclusion_zone[] = {
+    Vector2l(-266300000, 1518500000),
+    Vector2l(-266300000, 1518600000),
+    Vector2l(-266200000, 1518600000),
+    Vector2l(-266200000, 1518500000),
+    Vector2l(-266300000, 1518500000)
+};
+
+static const struct {
+    Vector2l point;
+    bool breached;
+} test_points[] = {
+    { Vector2l(-266398870, 1518220000), true },
+    { Vector2l(-266418700, 1518709260), false },
+    { Vector2l(-350000000, 1490000000), true },
+    { Vector2l(0, 0),                   true },
+    { Vector2l(-265768150, 1518408250), false },
+    { Vector2l(-265774060, 1518405860), true },
+    { Vector2l(-266435630, 1518303440), true },
+    { Vector2l(-266435650, 1518313540), false },
+    { Vector2l(-265875990, 1518344049), true },
+    { Vector2l(-265875990, 1518344051), false },
+    { Vector2l(-266250000, 1518550000), true },
+    { Vector2l(-266250000, 1518450000), false },
+    { Vector2l(-266199999, 1518550000), false },
+};
+
+/*
+ *  distances in meters to the nearest edge of either polygon, worked
+ *  out separately by checking every edge
+ */
+static const struct {
+    Vector2l point;
+    float distance;
+} distance_points[] = {
+    { Vector2l(-266250000, 1518550000), 497.65f },  // centre of the exclusion zone
+    { Vector2l(-266250000, 1518480000), 199.06f },  // west of the exclusion zone
+    { Vector2l(-266199999, 1518550000),   0.01f },  // just outside the exclusion zone
+    { Vector2l(-266092110, 1518747420),   0.0f  },  // on a boundary vertex
+    { Vector2l(-266398870, 1518220000), 855.85f },  // outside the boundary
+    { Vector2l(-266418700, 1518709260), 355.67f },  // inside the boundary
+};
+
+#define DISTANCE_TOLERANCE 1.0f // meters
+
+#define ARRAY_LENGTH(x) (sizeof((x))/sizeof((x)[0]))
+
+static AP_PolyFence fence;
+
+void setup(void)
+{
+    unsigned i, count;
+    bool all_passed = true;
+    uint32_t start_time;
+
+    hal.console->println("AP_PolyFence unit tests\n");
+
+    if (!fence.add_polygon(OBC_boundary, ARRAY_LENGTH(OBC_boundary), true) ||
+        !fence.add_polygon(exclusion_zone, ARRAY_LENGTH(exclusion_zone), false)) {
+        hal.console->println("failed to add polygons");
+        all_passed = false;
+    }
+    if (fence.add_polygon(OBC_boundary, ARRAY_LENGTH(OBC_boundary)-1, true)) {
+        hal.console->println("incomplete polygon accepted");
+        all_passed = false;
+    }
+    if (!fence.build_index()) {
+        hal.console->println("failed to build index");
+        all_passed = false;
+    }
+
+    for (i=0; i<ARRAY_LENGTH(test_points); i++) {
+        bool result = fence.breached(test_points[i].point);
+        hal.console->printf_P(PSTR("%10f,%10f  %s  dist=%.1fm  %s\n"),
+                        1.0e-7*test_points[i].point.x,
+                        1.0e-7*test_points[i].point.y,
+                        result ? "BREACHED" : "OK      ",
+                        fence.nearest_edge_distance(test_points[i].point),
+                        result == test_points[i].breached ? "PASS" : "FAIL");
+        if (result != test_points[i].breached) {
+            all_passed = false;
+        }
+    }
+
+    for (i=0; i<ARRAY_LENGTH(distance_points); i++) {
+        float distance = fence.nearest_edge_distance(distance_points[i].point);
+        bool passed = fabsf(distance - distance_points[i].distance) <= DISTANCE_TOLERANCE;
+        hal.console->printf_P(PSTR("%10f,%10f  dist=%.2fm expected %.2fm  %s\n"),
+                        1.0e-7*distance_points[i].point.x,
+                        1.0e-7*distance_points[i].point.y,
+                        distance,
+                        distance_points[i].distance,
+                        passed ? "PASS" : "FAIL");
+        if (!passed) {
+            all_passed = false;
+        }
+    }
+    hal.console->println(all_passed ? "TEST PASSED" : "TEST FAILED");
+
+    hal.console->println("Speed test:");
+    start_time = hal.scheduler->micros();
+    for (count=0; count<1000; count++) {
+        for (i=0; i<ARRAY_LENGTH(test_points); i++) {
+            if (fence.breached(test_points[i].point) != test_points[i].breached) {
+                all_passed = false;
+            }
+        }
+    }
+    hal.console->printf("breached: %u usec/call\n", (unsigned)((hal.scheduler->micros()
+                    - start_time)/(count*ARRAY_LENGTH(test_points))));
+
+    start_time = hal.scheduler->micros();
+    for (count=0; count<1000; count++) {
+        for (i=0; i<ARRAY_LENGTH(test_points); i++) {
+            fence.nearest_edge_distance(test_points[i].point);
+        }
+    }
+    hal.console->printf("nearest_edge_distance: %u usec/call\n", (unsigned)((hal.scheduler->micros()
+                    - start_time)/(count*ARRAY_LENGTH(test_points))));
+    hal.console->println(all_passed ? "ALL TESTS PASSED" : "TEST FAILED");
+}
+
+void loop(void){}
+
+AP_HAL_MAIN();
@@ -110,13 +110,17 @@ bool AP_Rally::find_nearest_rally_point(const Location &current_loc, RallyLocati
     float min_dis = -1;
     const struct Location &home_loc = _ahrs.get_home();
 
+    // all distances are measured from the current location
+    struct Location_Frame frame;
+    location_frame_init(frame, current_loc);
+
     for (uint8_t i = 0; i < (uint8_t) _rally_point_total_count; i++) {
         RallyLocation next_rally;
         if (!get_rally_point_with_index(i, next_rally)) {
             continue;
         }
         Location rally_loc = rally_location_to_location(next_rally);
-        float dis = get_distance(current_loc, rally_loc);
+        float dis = get_distance(frame, rally_loc);
 
         if (dis < min_dis || min_dis < 0) {
             min_dis = dis;
@@ -124,7 +128,7 @@ bool AP_Rally::find_nearest_rally_point(const Location &current_loc, RallyLocati
         }
     }
 
-    if ((_rally_limit_km > 0) && (min_dis > _rally_limit_km*1000.0f) && (get_distance(current_loc, home_loc) < min_dis)) {
+    if ((_rally_limit_km > 0) && (min_dis > _rally_limit_km*1000.0f) && (get_distance(frame, home_loc) < min_dis)) {
         return false; // use home position
     }
 
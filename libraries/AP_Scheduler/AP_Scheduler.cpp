@@ -24,6 +24,12 @@
 #include <AP_Scheduler.h>
 #include <AP_Param.h>
 
+#if SCHEDULER_LOOPTIME
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+#endif
+
 extern const AP_HAL::HAL& hal;
 
 int8_t AP_Scheduler::current_task = -1;
@@ -35,6 +41,16 @@ const AP_Param::GroupInfo AP_Scheduler::var_info[] PROGMEM = {
     // @Values: 0:Disabled,2:ShowSlips,3:ShowOverruns
     // @User: Advanced
     AP_GROUPINFO("DEBUG",    0, AP_Scheduler, _debug, 0),
+
+#if SCHEDULER_LOOPTIME
+    // @Param: LOOPTIME
+    // @DisplayName: Record loop times
+    // @Description: Set to 1 to record the CPU time taken by the main loop, the fast loop and each scheduler task. Every 10 seconds the count, median, 99th percentile and maximum of each are written to looptime.json in the current directory. Only available on the SITL and Linux boards
+    // @Values: 0:Disabled,1:Enabled
+    // @User: Advanced
+    AP_GROUPINFO("LOOPTIME", 1, AP_Scheduler, _looptime_enable, 0),
+#endif
+
     AP_GROUPEND
 };
 
@@ -48,10 +64,39 @@ void AP_Scheduler::init(const AP_Scheduler::Task *tasks, uint8_t num_tasks)
     _tick_counter = 0;
 }
 
+// the main loop has started
+void AP_Scheduler::loop_started(void)
+{
+#if HAL_CPU_CLASS >= HAL_CPU_CLASS_75
+    // the loop start time is only read by the terrain cache, which
+    // the slow boards don't have, so they skip the clock read
+    hal.scheduler->set_loop_start_time();
+#endif
+
+#if SCHEDULER_LOOPTIME
+    if (_looptime_enable == 0) {
+        _looptime_loop_start_ns = 0;
+        return;
+    }
+    if (_looptime == NULL) {
+        _looptime = new looptime_hist[_num_tasks+2];
+        memset(_looptime, 0, sizeof(_looptime[0]) * (_num_tasks+2));
+        _looptime_last_write_ms = hal.scheduler->millis();
+    }
+    _looptime_loop_start_ns = _looptime_ns();
+#endif
+}
+
 // one tick has passed
 void AP_Scheduler::tick(void)
 {
     _tick_counter++;
+
+#if SCHEDULER_LOOPTIME
+    if (_looptime_loop_start_ns != 0) {
+        _looptime_record(1, _looptime_ns() - _looptime_loop_start_ns);
+    }
+#endif
 }
 
 /*
@@ -86,7 +131,15 @@ void AP_Scheduler::run(uint16_t time_available)
                 _task_time_started = now;
                 task_fn_t func = (task_fn_t)pgm_read_pointer(&_tasks[i].function);
                 current_task = i;
+#if SCHEDULER_LOOPTIME
+                uint64_t task_started_ns = _looptime_loop_start_ns != 0 ? _looptime_ns() : 0;
                 func();
+                if (_looptime_loop_start_ns != 0) {
+                    _looptime_record(i+2, _looptime_ns() - task_started_ns);
+                }
+#else
+                func();
+#endif
                 current_task = -1;
                 
                 // record the tick counter when we ran. This drives
@@ -123,6 +176,17 @@ update_spare_ticks:
         _spare_ticks /= 2;
         _spare_micros /= 2;
     }
+
+#if SCHEDULER_LOOPTIME
+    if (_looptime_loop_start_ns != 0) {
+        _looptime_record(0, _looptime_ns() - _looptime_loop_start_ns);
+        _looptime_loop_start_ns = 0;
+        if (hal.scheduler->millis() - _looptime_last_write_ms >= 10000) {
+            _looptime_last_write_ms = hal.scheduler->millis();
+            _looptime_write();
+        }
+    }
+#endif
 }
 
 /*
@@ -148,3 +212,115 @@ float AP_Scheduler::load_average(uint32_t tick_time_usec) const
     uint32_t used_time = tick_time_usec - (_spare_micros/_spare_ticks);
     return used_time / (float)tick_time_usec;
 }
+
+#if SCHEDULER_LOOPTIME
+/*
+  CPU time of the main thread in nanoseconds. This is used rather than
+  micros() as in lockstep SITL micros() is the simulated time, and so
+  time spent by other processes on the same CPU is not counted
+ */
+uint64_t AP_Scheduler::_looptime_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return ts.tv_sec*1000000000ULL + ts.tv_nsec;
+}
+
+/*
+  histogram bin for a time in nanoseconds. Times below 32ns get a bin
+  each, above that each power of two is split into 32 bins, so every
+  bin is within 3% of the times in it
+ */
+uint16_t AP_Scheduler::_looptime_bin(uint64_t ns)
+{
+    if (ns < 32) {
+        return ns;
+    }
+    if (ns >= (1ULL<<26)) {
+        return SCHEDULER_LOOPTIME_BINS-1;
+    }
+    uint8_t msb = 31 - __builtin_clz((uint32_t)ns);
+    return (msb-4)*32 + ((ns >> (msb-5)) & 31);
+}
+
+/*
+  the time in nanoseconds at the middle of a histogram bin
+ */
+uint32_t AP_Scheduler::_looptime_bin_ns(uint16_t bin)
+{
+    if (bin < 32) {
+        return bin;
+    }
+    uint8_t shift = bin/32 - 1;
+    return ((32U + bin%32) << shift) + (1U << shift)/2;
+}
+
+/*
+  the time below which the given fraction of the recorded times lie
+ */
+uint32_t AP_Scheduler::_looptime_percentile(const struct looptime_hist &h, float fraction)
+{
+    uint32_t target = ceilf(h.count * fraction);
+    uint32_t total = 0;
+    for (uint16_t b=0; b<SCHEDULER_LOOPTIME_BINS; b++) {
+        total += h.bins[b];
+        if (total >= target && total != 0) {
+            uint32_t ns = _looptime_bin_ns(b);
+            return ns < h.max_ns ? ns : h.max_ns;
+        }
+    }
+    return h.max_ns;
+}
+
+/*
+  add one time to a histogram
+ */
+void AP_Scheduler::_looptime_record(uint8_t idx, uint64_t ns)
+{
+    struct looptime_hist &h = _looptime[idx];
+    h.count++;
+    if (ns > h.max_ns) {
+        h.max_ns = ns > 0xFFFFFFFFULL ? 0xFFFFFFFF : ns;
+    }
+    h.bins[_looptime_bin(ns)]++;
+}
+
+/*
+  write the loop time summary to looptime.json. The file is replaced in
+  one step so a reader never sees it half written
+ */
+void AP_Scheduler::_looptime_write(void)
+{
+    FILE *f = fopen("looptime.json.tmp", "w");
+    if (f == NULL) {
+        return;
+    }
+    fprintf(f, "{\"time_ms\": %lu, \"timers\": [\n", (unsigned long)hal.scheduler->millis());
+    for (uint8_t i=0; i<_num_tasks+2; i++) {
+        const struct looptime_hist &h = _looptime[i];
+        const char *name;
+        char task_name[12];
+        if (i == 0) {
+            name = "loop";
+        } else if (i == 1) {
+            name = "fast_loop";
+        } else {
+            name = (const char *)pgm_read_pointer(&_tasks[i-2].name);
+            if (name == NULL) {
+                snprintf(task_name, sizeof(task_name), "task%u", (unsigned)(i-2));
+                name = task_name;
+            }
+        }
+        fprintf(f, "  {\"name\": \"%s\", \"count\": %lu, \"p50_usec\": %.2f, \"p99_usec\": %.2f, \"max_usec\": %.2f}%s\n",
+                name,
+                (unsigned long)h.count,
+                _looptime_percentile(h, 0.5f)*1.0e-3f,
+                _looptime_percentile(h, 0.99f)*1.0e-3f,
+                h.max_ns*1.0e-3f,
+                i == _num_tasks+1 ? "" : ",");
+    }
+    fprintf(f, "]}\n");
+    fclose(f);
+    rename("looptime.json.tmp", "looptime.json");
+}
+#endif // SCHEDULER_LOOPTIME
@@ -25,6 +25,27 @@
 
 #include <AP_Param.h>
 
+// on the native boards the scheduler can record how long the main
+// loop and each task take, see SCHED_LOOPTIME
+#if CONFIG_HAL_BOARD == HAL_BOARD_AVR_SITL || CONFIG_HAL_BOARD == HAL_BOARD_LINUX
+#define SCHEDULER_LOOPTIME 1
+#else
+#define SCHEDULER_LOOPTIME 0
+#endif
+
+// number of bins in a loop time histogram, enough for times up to 67ms
+#define SCHEDULER_LOOPTIME_BINS 704
+
+/*
+  an entry in a task table. On boards that record loop times the task
+  name is kept too, for the report
+ */
+#if SCHEDULER_LOOPTIME
+#define SCHED_TASK(func, interval_ticks, max_time_micros) { func, interval_ticks, max_time_micros, #func }
+#else
+#define SCHED_TASK(func, interval_ticks, max_time_micros) { func, interval_ticks, max_time_micros }
+#endif
+
 /*
   A task scheduler for APM main loops
 
@@ -44,11 +65,20 @@ public:
 		task_fn_t function;
 		uint16_t interval_ticks;
 		uint16_t max_time_micros;
+#if SCHEDULER_LOOPTIME
+		const char *name;
+#endif
 	};
 
 	// initialise scheduler
 	void init(const Task *tasks, uint8_t num_tasks);
 
+	// call at the start of each main loop, once the INS sample has
+	// arrived. This sets the HAL loop start time, and for
+	// SCHED_LOOPTIME the time from here to tick() is recorded as the
+	// fast loop and from here to the end of run() as the whole loop
+	void loop_started(void);
+
 	// call when one tick has passed
 	void tick(void);
 
@@ -101,6 +131,37 @@ private:
 
     // number of ticks that _spare_micros is counted over
     uint8_t _spare_ticks;
+
+#if SCHEDULER_LOOPTIME
+    // record loop and task times and write looptime.json
+    AP_Int8 _looptime_enable;
+
+    // histogram of the times of one task, the fast loop or the whole
+    // loop. The bins are log-linear in nanoseconds, see _looptime_bin()
+    struct looptime_hist {
+        uint32_t count;
+        uint32_t max_ns;
+        uint32_t bins[SCHEDULER_LOOPTIME_BINS];
+    };
+
+    // the whole loop, the fast loop then one for each task. NULL until
+    // recording starts
+    struct looptime_hist *_looptime;
+
+    // thread CPU time at the start of the current loop, 0 if the loop
+    // start was not marked
+    uint64_t _looptime_loop_start_ns;
+
+    // time in milliseconds that looptime.json was last written
+    uint32_t _looptime_last_write_ms;
+
+    static uint64_t _looptime_ns(void);
+    static uint16_t _looptime_bin(uint64_t ns);
+    static uint32_t _looptime_bin_ns(uint16_t bin);
+    static uint32_t _looptime_percentile(const struct looptime_hist &h, float fraction);
+    void _looptime_record(uint8_t idx, uint64_t ns);
+    void _looptime_write(void);
+#endif
 };
 
 #endif // AP_SCHEDULER_H
@@ -268,9 +268,16 @@ float AP_Terrain::lookahead(float bearing, float distance, float climb_ratio)
     float climb = 0;
     float lookahead_estimate = 0;
 
+    // the step is the same each time, so work out its north/east
+    // components and the longitude scaling once
+    struct Location_Frame frame;
+    location_frame_init(frame, loc);
+    float step_north = cosf(radians(bearing)) * grid_spacing;
+    float step_east  = sinf(radians(bearing)) * grid_spacing;
+
     // check for terrain at grid spacing intervals
     while (distance > 0) {
-        location_update(loc, bearing, grid_spacing);
+        location_offset(frame, loc, step_north, step_east);
         climb += climb_ratio * grid_spacing;
         distance -= grid_spacing;
         float height;
@@ -26,14 +26,20 @@
 void LowPassFilter2p::set_cutoff_frequency(float sample_freq, float cutoff_freq)
 {
     _cutoff_freq = cutoff_freq;
-    float fr = sample_freq/_cutoff_freq;
+    calc_coefficients(sample_freq, cutoff_freq, _b0, _b1, _b2, _a1, _a2);
+}
+
+void LowPassFilter2p::calc_coefficients(float sample_freq, float cutoff_freq,
+                                        float &b0, float &b1, float &b2, float &a1, float &a2)
+{
+    float fr = sample_freq/cutoff_freq;
     float ohm = tanf(PI/fr);
     float c = 1.0f+2.0f*cosf(PI/4.0f)*ohm + ohm*ohm;
-    _b0 = ohm*ohm/c;
-    _b1 = 2.0f*_b0;
-    _b2 = _b0;
-    _a1 = 2.0f*(ohm*ohm-1.0f)/c;
-    _a2 = (1.0f-2.0f*cosf(PI/4.0f)*ohm+ohm*ohm)/c;
+    b0 = ohm*ohm/c;
+    b1 = 2.0f*b0;
+    b2 = b0;
+    a1 = 2.0f*(ohm*ohm-1.0f)/c;
+    a2 = (1.0f-2.0f*cosf(PI/4.0f)*ohm+ohm*ohm)/c;
 }
 
 float LowPassFilter2p::apply(float sample)
@@ -35,6 +35,10 @@ public:
     // change parameters
     void set_cutoff_frequency(float sample_freq, float cutoff_freq);
 
+    // calculate the filter coefficients for a sample and cutoff frequency
+    static void calc_coefficients(float sample_freq, float cutoff_freq,
+                                  float &b0, float &b1, float &b2, float &a1, float &a2);
+
     // apply - Add a new raw value to the filter 
     // and retrieve the filtered result
     float apply(float sample);
@@ -0,0 +1,85 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef LOWPASSFILTER2PBANK_H
+#define LOWPASSFILTER2PBANK_H
+
+/// @file	LowPassFilter2pBank.h
+/// @brief	A bank of NUM_CHANNELS second order low pass filters sharing one
+///         set of coefficients. The filter state is held as one array per
+///         delay element, so each step runs all channels in a single loop
+///         which the compiler can vectorise.
+
+#include <AP_Math.h>
+#include "LowPassFilter2p.h"
+
+template <uint8_t NUM_CHANNELS>
+class LowPassFilter2pBank
+{
+public:
+    // constructor
+    LowPassFilter2pBank(float sample_freq, float cutoff_freq) {
+        set_cutoff_frequency(sample_freq, cutoff_freq);
+        reset();
+    }
+
+    // change parameters
+    void set_cutoff_frequency(float sample_freq, float cutoff_freq) {
+        _cutoff_freq = cutoff_freq;
+        LowPassFilter2p::calc_coefficients(sample_freq, cutoff_freq, _b0, _b1, _b2, _a1, _a2);
+    }
+
+    // clear the filter state of all channels
+    void reset(void) {
+        for (uint8_t i=0; i<NUM_CHANNELS; i++) {
+            _delay_element_1[i] = 0;
+            _delay_element_2[i] = 0;
+        }
+    }
+
+    // apply - add one new raw value to each channel and retrieve
+    // the filtered results.  samples and output may be the same array
+    void apply(const float *samples, float *output) {
+        for (uint8_t i=0; i<NUM_CHANNELS; i++) {
+            float delay_element_0 = samples[i] - _delay_element_1[i] * _a1 - _delay_element_2[i] * _a2;
+            if (isnan(delay_element_0) || isinf(delay_element_0)) {
+                // don't allow bad values to propogate via the filter
+                delay_element_0 = samples[i];
+            }
+            output[i] = delay_element_0 * _b0 + _delay_element_1[i] * _b1 + _delay_element_2[i] * _b2;
+            _delay_element_2[i] = _delay_element_1[i];
+            _delay_element_1[i] = delay_element_0;
+        }
+    }
+
+    // return the cutoff frequency
+    float get_cutoff_freq(void) const {
+        return _cutoff_freq;
+    }
+
+private:
+    float           _cutoff_freq;
+    float           _a1;
+    float           _a2;
+    float           _b0;
+    float           _b1;
+    float           _b2;
+    float           _delay_element_1[NUM_CHANNELS];     // buffered sample -1 of each channel
+    float           _delay_element_2[NUM_CHANNELS];     // buffered sample -2 of each channel
+};
+
+#endif // LOWPASSFILTER2PBANK_H
@@ -0,0 +1,215 @@
+// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+/*
+   This program is free software: you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation, either version 3 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   You should have received a copy of the GNU General Public License
+   along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+//
+/// @file	MedianFilter.h
+/// @brief	A class to return the median of the last FILTER_SIZE samples
+///
+/// The samples are kept in a max-heap of the lower half and a min-heap of
+/// the upper half, joined at the median, so each new sample replaces the
+/// oldest one in O(log FILTER_SIZE) steps instead of the O(FILTER_SIZE)
+/// insertion sort used by ModeFilter. Unlike ModeFilter, which drops the
+/// highest or lowest sample, the window always holds the most recent
+/// samples.
+/// FILTER_SIZE must be less than 128.
+
+#ifndef __MEDIAN_FILTER_H__
+#define __MEDIAN_FILTER_H__
+
+#include <inttypes.h>
+#include "FilterClass.h"
+
+template <class T, uint8_t FILTER_SIZE>
+class MedianFilter : public Filter<T>
+{
+public:
+    MedianFilter();
+
+    // apply - Add a new raw value to the filter, retrieve the filtered result
+    virtual T        apply(T sample);
+
+    // reset - clear the filter
+    virtual void     reset();
+
+private:
+    // heap position of sample i is _pos[i].  The median is at position 0,
+    // the max-heap of lower samples at negative positions and the min-heap
+    // of higher samples at positive positions
+    int8_t &        heap(int8_t position) { return _heap[position + FILTER_SIZE/2]; }
+    int8_t          min_count() const { return (_count - 1) / 2; }
+    int8_t          max_count() const { return _count / 2; }
+
+    bool            less(int8_t i, int8_t j) { return _samples[heap(i)] < _samples[heap(j)]; }
+    void            exchange(int8_t i, int8_t j);
+    bool            compare_exchange(int8_t i, int8_t j);
+    void            min_sort_down(int8_t i);
+    void            max_sort_down(int8_t i);
+    bool            min_sort_up(int8_t i);
+    bool            max_sort_up(int8_t i);
+
+    T               _samples[FILTER_SIZE];  // samples in arrival order, as a ring buffer
+    int8_t          _pos[FILTER_SIZE];      // heap position of each sample
+    int8_t          _heap[FILTER_SIZE];     // sample index at each heap position, offset by FILTER_SIZE/2
+    uint8_t         _sample_index;          // next sample to be replaced
+    uint8_t         _count;                 // number of samples held
+};
+
+// Typedef for convenience
+typedef MedianFilter<int16_t,5> MedianFilterInt16_Size5;
+typedef MedianFilter<int16_t,7> MedianFilterInt16_Size7;
+typedef MedianFilter<float,5> MedianFilterFloat_Size5;
+typedef MedianFilter<float,7> MedianFilterFloat_Size7;
+
+// Constructor    //////////////////////////////////////////////////////////////
+
+template <class T, uint8_t FILTER_SIZE>
+MedianFilter<T,FILTER_SIZE>::MedianFilter()
+{
+    reset();
+}
+
+// Public Methods //////////////////////////////////////////////////////////////
+
+template <class T, uint8_t FILTER_SIZE>
+void MedianFilter<T,FILTER_SIZE>::reset()
+{
+    // spread the empty slots alternately between the two heaps
+    for (uint8_t i=0; i<FILTER_SIZE; i++) {
+        _samples[i] = 0;
+        _pos[i] = ((i+1)/2) * ((i&1) ? -1 : 1);
+        heap(_pos[i]) = i;
+    }
+    _sample_index = 0;
+    _count = 0;
+}
+
+template <class T, uint8_t FILTER_SIZE>
+T MedianFilter<T,FILTER_SIZE>::apply(T sample)
+{
+    bool is_new = (_count < FILTER_SIZE);
+    int8_t p = _pos[_sample_index];
+    T old_sample = _samples[_sample_index];
+
+    _samples[_sample_index] = sample;
+    _sample_index++;
+    if (_sample_index >= FILTER_SIZE) {
+        _sample_index = 0;
+    }
+    if (is_new) {
+        _count++;
+    }
+
+    if (p > 0) {
+        // the replaced sample was in the min-heap
+        if (!is_new && old_sample < sample) {
+            min_sort_down(p*2);
+        } else if (min_sort_up(p)) {
+            max_sort_down(-1);
+        }
+    } else if (p < 0) {
+        // the replaced sample was in the max-heap
+        if (!is_new && sample < old_sample) {
+            max_sort_down(p*2);
+        } else if (max_sort_up(p)) {
+            min_sort_down(1);
+        }
+    } else {
+        // the replaced sample was the median
+        if (max_count() > 0) {
+            max_sort_down(-1);
+        }
+        if (min_count() > 0) {
+            min_sort_down(1);
+        }
+    }
+
+    return _samples[heap(0)];
+}
+
+// Private Methods /////////////////////////////////////////////////////////////
+
+template <class T, uint8_t FILTER_SIZE>
+void MedianFilter<T,FILTER_SIZE>::exchange(int8_t i, int8_t j)
+{
+    int8_t t = heap(i);
+    heap(i) = heap(j);
+    heap(j) = t;
+    _pos[heap(i)] = i;
+    _pos[heap(j)] = j;
+}
+
+// swaps the samples at heap positions i and j if sample i is less than sample j
+template <class T, uint8_t FILTER_SIZE>
+bool MedianFilter<T,FILTER_SIZE>::compare_exchange(int8_t i, int8_t j)
+{
+    if (less(i, j)) {
+        exchange(i, j);
+        return true;
+    }
+    return false;
+}
+
+// moves the parent of heap position i down the min-heap towards its leaves.
+// Position 1 is the top of the min-heap and its parent is the median
+template <class T, uint8_t FILTER_SIZE>
+void MedianFilter<T,FILTER_SIZE>::min_sort_down(int8_t i)
+{
+    for (; i <= min_count(); i*=2) {
+        if (i > 1 && i < min_count() && less(i+1, i)) {
+            i++;
+        }
+        if (!compare_exchange(i, i/2)) {
+            break;
+        }
+    }
+}
+
+// moves the parent of heap position i down the max-heap towards its leaves.
+// Position -1 is the top of the max-heap and its parent is the median
+template <class T, uint8_t FILTER_SIZE>
+void MedianFilter<T,FILTER_SIZE>::max_sort_down(int8_t i)
+{
+    for (; i >= -max_count(); i*=2) {
+        if (i < -1 && i > -max_count() && less(i, i-1)) {
+            i--;
+        }
+        if (!compare_exchange(i/2, i)) {
+            break;
+        }
+    }
+}
+
+// moves a sample up the min-heap.  Returns true if it reached the median
+template <class T, uint8_t FILTER_SIZE>
+bool MedianFilter<T,FILTER_SIZE>::min_sort_up(int8_t i)
+{
+    while (i > 0 && compare_exchange(i, i/2)) {
+        i /= 2;
+    }
+    return i == 0;
+}
+
+// moves a sample up the max-heap.  Returns true if it reached the median
+template <class T, uint8_t FILTER_SIZE>
+bool MedianFilter<T,FILTER_SIZE>::max_sort_up(int8_t i)
+{
+    while (i < 0 && compare_exchange(i/2, i)) {
+        i /= 2;
+    }
+    return i == 0;
+}
+
+#endif // __MEDIAN_FILTER_H__
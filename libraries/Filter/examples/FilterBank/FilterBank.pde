@@ -0,0 +1,146 @@
+/// -*- tab-width: 4; Mode: C++; c-basic-offset: 4; indent-tabs-mode: nil -*-
+//
+// Tests and benchmark for the LowPassFilter2pBank and MedianFilter classes
+//
+
+#include <AP_Common.h>
+#include <AP_Progmem.h>
+#include <AP_HAL.h>
+#include <AP_HAL_AVR.h>
+#include <AP_HAL_AVR_SITL.h>
+#include <AP_HAL_PX4.h>
+#include <AP_HAL_Linux.h>
+#include <AP_HAL_Empty.h>
+#include <AP_Param.h>
+#include <StorageManager.h>
+#include <AP_Math.h>
+#include <Filter.h>
+#include <LowPassFilter2p.h>
+#include <LowPassFilter2pBank.h>
+#include <ModeFilter.h>
+#include <MedianFilter.h>
+
+const AP_HAL::HAL& hal = AP_HAL_BOARD_DRIVER;
+
+#define NUM_SAMPLES 1000
+
+// one filter per axis, as the inertial sensor drivers used to have
+static LowPassFilter2p filters[6] = {
+    LowPassFilter2p(1000, 20), LowPassFilter2p(1000, 20), LowPassFilter2p(1000, 20),
+    LowPassFilter2p(1000, 20), LowPassFilter2p(1000, 20), LowPassFilter2p(1000, 20)
+};
+static LowPassFilter2pBank<6> filter_bank(1000, 20);
+
+static ModeFilter<int16_t,31> mode_filter(15);
+static MedianFilter<int16_t,31> median_filter;
+static MedianFilter<int16_t,7> median_filter7;
+
+static bool all_passed = true;
+
+// pseudo-random value in the range -1000 to 1000
+static int16_t rand_sample(void)
+{
+    static uint32_t seed = 12345;
+    seed = seed * 1664525UL + 1013904223UL;
+    return (int16_t)((seed >> 16) % 2001) - 1000;
+}
+
+static void test_bank(void)
+{
+    float max_err = 0;
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        float samples[6], bank_out[6];
+        for (uint8_t i=0; i<6; i++) {
+            samples[i] = rand_sample();
+        }
+        filter_bank.apply(samples, bank_out);
+        for (uint8_t i=0; i<6; i++) {
+            max_err = max(max_err, fabsf(filters[i].apply(samples[i]) - bank_out[i]));
+        }
+    }
+    bool ok = (max_err == 0);
+    hal.console->printf_P(PSTR("bank matches single filters: err=%f %s\n"), max_err, ok ? "PASS" : "FAIL");
+    all_passed &= ok;
+}
+
+static void test_median(void)
+{
+    int16_t window[7];
+    uint16_t errors = 0;
+    median_filter7.reset();
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        int16_t sample = rand_sample() / 100;
+        window[n % 7] = sample;
+        int16_t median = median_filter7.apply(sample);
+        if (n < 6) {
+            continue;
+        }
+        // count how many window samples lie on each side of the median
+        uint8_t below = 0, above = 0;
+        for (uint8_t i=0; i<7; i++) {
+            if (window[i] < median) {
+                below++;
+            } else if (window[i] > median) {
+                above++;
+            }
+        }
+        if (below > 3 || above > 3) {
+            errors++;
+        }
+    }
+    bool ok = (errors == 0);
+    hal.console->printf_P(PSTR("median of last 7 samples: errors=%u %s\n"), (unsigned)errors, ok ? "PASS" : "FAIL");
+    all_passed &= ok;
+}
+
+static void benchmark(void)
+{
+    float samples[6] = { 1, 2, 3, 4, 5, 6 };
+    uint32_t start_time;
+
+    start_time = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        for (uint8_t i=0; i<6; i++) {
+            samples[i] = filters[i].apply(samples[i]);
+        }
+    }
+    hal.console->printf_P(PSTR("6 x LowPassFilter2p: %lu usec/1000 samples\n"),
+                          (unsigned long)(hal.scheduler->micros() - start_time));
+
+    start_time = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        filter_bank.apply(samples, samples);
+    }
+    hal.console->printf_P(PSTR("LowPassFilter2pBank<6>: %lu usec/1000 samples\n"),
+                          (unsigned long)(hal.scheduler->micros() - start_time));
+
+    int16_t out = 0;
+    start_time = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        out += mode_filter.apply(rand_sample());
+    }
+    hal.console->printf_P(PSTR("ModeFilter<31>: %lu usec/1000 samples\n"),
+                          (unsigned long)(hal.scheduler->micros() - start_time));
+
+    start_time = hal.scheduler->micros();
+    for (uint16_t n=0; n<NUM_SAMPLES; n++) {
+        out += median_filter.apply(rand_sample());
+    }
+    hal.console->printf_P(PSTR("MedianFilter<31>: %lu usec/1000 samples (%d)\n"),
+                          (unsigned long)(hal.scheduler->micros() - start_time), (int)out);
+}
+
+void setup(void)
+{
+    hal.console->println("Filter bank tests\n");
+
+    test_bank();
+    test_median();
+    benchmark();
+
+    hal.console->println(all_passed ? "ALL TESTS PASSED" : "TEST FAILED");
+}
+
+void loop(void){}
+
+AP_HAL_MAIN();
@@ -61,6 +61,11 @@ const AP_Param::GroupInfo SITL::var_info[] PROGMEM = {
     AP_GROUPINFO("ACC_BIAS",      30, SITL,  accel_bias, 0),
     AP_GROUPINFO("BARO_GLITCH",   31, SITL,  baro_glitch, 0),
     AP_GROUPINFO("SONAR_SCALE",   32, SITL,  sonar_scale, 12.1212f),
+    AP_GROUPINFO("PHYS_RATE",     33, SITL,  phys_rate, 0),
+    AP_GROUPINFO("IMU_RATE",      34, SITL,  imu_rate, 0),
+    AP_GROUPINFO("VIB_FREQ",      35, SITL,  vib_freq, 0),
+    AP_GROUPINFO("VIB_ACC",       36, SITL,  vib_accel, 0),
+    AP_GROUPINFO("VIB_GYR",       37, SITL,  vib_gyro, 0),
     AP_GROUPEND
 };
 
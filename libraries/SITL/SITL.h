@@ -24,6 +24,14 @@ struct PACKED sitl_fdm {
 	uint32_t magic; // 0x4c56414f
 };
 
+struct PACKED sitl_fdm_lockstep {
+	// the packet sent by a simulator running in lockstep with the
+	// APM executable. The simulator steps its physics only after it
+	// has received the servo outputs for the previous frame
+	struct sitl_fdm fdm;
+	uint64_t timestamp_us; // simulation time of this frame
+};
+
 
 class SITL
 {
@@ -82,6 +90,13 @@ public:
 	AP_Int8  baro_disable; // disable simulated barometer
     AP_Int8  float_exception; // enable floating point exception checks
 
+    // high rate physics and IMU sampling
+    AP_Int16 phys_rate;   // built in model physics rate in Hz, 0 for one step per frame
+    AP_Int16 imu_rate;    // IMU sample rate in Hz, 0 for one sample per frame
+    AP_Float vib_freq;    // motor rotation frequency at full throttle in Hz
+    AP_Vector3f vib_accel;// motor vibration amplitude in m/s/s
+    AP_Vector3f vib_gyro; // motor vibration amplitude in degrees/second
+
     // wind control
     AP_Float wind_speed;
     AP_Float wind_direction;
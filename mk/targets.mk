@@ -74,6 +74,26 @@ apm2beta: apm2
 sitl-mount: EXTRAFLAGS += "-DMOUNT=ENABLED"
 sitl-mount: sitl
 
+sitl-drivers: EXTRAFLAGS += "-DSITL_SENSOR_DRIVERS=1 "
+sitl-drivers: sitl
+
+# SITL optimised like a flight build, for measuring loop times with
+# Tools/autotest/looptime.py
+sitl-looptime: OPTFLAGS = -O2 -g
+sitl-looptime: sitl
+
+# build optimised for the native Linux board and run, for
+# Tools/Benchmark. The results go to BENCHMARK_OUT, named for the
+# commit so runs on different commits can be compared with
+# Tools/scripts/benchmark_compare.py. Run "make clean" first if the
+# sketch was last built without optimisation
+BENCHMARK_OUT ?= $(BUILDROOT)/benchmark-$(GIT_VERSION).json
+benchmark: HAL_BOARD = HAL_BOARD_LINUX
+benchmark: TOOLCHAIN = NATIVE
+benchmark: OPTFLAGS = -O2 -g
+benchmark: all
+	$(SKETCHELF) $(BENCHMARK_OUT)
+
 .PHONY: etags
 etags:
 	cd .. && etags -f ArduCopter/TAGS --lang=c++ $$(git ls-files ArduCopter libraries)